@@ -169,14 +169,22 @@ PYBIND11_MODULE(_broker, m) {
   m.def("Infinite", [] { return broker::infinite; });
 
   py::class_<broker::publisher>(m, "Publisher")
+    .def("demand", &broker::publisher::demand)
     .def("buffered", &broker::publisher::buffered)
     .def("capacity", &broker::publisher::capacity)
+    .def("free_capacity", &broker::publisher::free_capacity)
     .def("fd", &broker::publisher::fd)
     .def("drop_all_on_destruction", &broker::publisher::drop_all_on_destruction)
-    .def("publish", (void(broker::publisher::*)(broker::data d))
-                      & broker::publisher::publish)
-    .def("publish_batch", [](broker::publisher& p,
-                             std::vector<broker::data> xs) { p.publish(xs); })
+    .def("publish",
+         (void(broker::publisher::*)(broker::data d))
+           & broker::publisher::publish,
+         py::call_guard<py::gil_scoped_release>())
+    .def(
+      "publish_batch",
+      [](broker::publisher& p, std::vector<broker::data> xs) {
+        p.publish(std::move(xs));
+      },
+      py::call_guard<py::gil_scoped_release>())
     .def("reset", &broker::publisher::reset);
 
   using topic_data_pair = std::pair<broker::topic, broker::data>;
@@ -197,7 +205,8 @@ PYBIND11_MODULE(_broker, m) {
          [](broker::subscriber& ep) -> topic_data_pair {
            auto res = ep.get();
            return std::make_pair(broker::get_topic(res), broker::get_data(res));
-         })
+         },
+         py::call_guard<py::gil_scoped_release>())
 
     .def("get",
          [](broker::subscriber& ep,
@@ -210,7 +219,8 @@ PYBIND11_MODULE(_broker, m) {
              rval = std::optional<topic_data_pair>(std::move(p));
            }
            return rval;
-         })
+         },
+         py::call_guard<py::gil_scoped_release>())
 
     .def("get",
          [](broker::subscriber& ep,
@@ -222,7 +232,8 @@ PYBIND11_MODULE(_broker, m) {
              rval.emplace_back(
                std::make_pair(broker::get_topic(e), broker::get_data(e)));
            return rval;
-         })
+         },
+         py::call_guard<py::gil_scoped_release>())
 
     .def("get",
          [](broker::subscriber& ep, size_t num,
@@ -234,7 +245,8 @@ PYBIND11_MODULE(_broker, m) {
              rval.emplace_back(
                std::make_pair(broker::get_topic(e), broker::get_data(e)));
            return rval;
-         })
+         },
+         py::call_guard<py::gil_scoped_release>())
 
     .def("poll",
          [](broker::subscriber& ep) -> std::vector<topic_data_pair> {
@@ -245,7 +257,8 @@ PYBIND11_MODULE(_broker, m) {
              rval.emplace_back(
                std::make_pair(broker::get_topic(e), broker::get_data(e)));
            return rval;
-         })
+         },
+         py::call_guard<py::gil_scoped_release>())
     .def("available", &broker::subscriber::available)
     .def("fd", &broker::subscriber::fd)
     .def("add_topic", &broker::subscriber::add_topic)
@@ -325,7 +338,9 @@ PYBIND11_MODULE(_broker, m) {
                    &broker::broker_options::disable_forwarding)
     .def_readwrite("ignore_broker_conf",
                    &broker::broker_options::ignore_broker_conf)
-    .def_readwrite("use_real_time", &broker::broker_options::use_real_time);
+    .def_readwrite("use_real_time", &broker::broker_options::use_real_time)
+    .def_readwrite("connector_threads",
+                   &broker::broker_options::connector_threads);
 
   // We need a configuration class here that's separate from
   // broker::configuration. When creating an endpoint one has to instantiate
@@ -406,6 +421,16 @@ PYBIND11_MODULE(_broker, m) {
            ep.publish(std::move(xs));
          })
     .def("make_publisher", &broker::endpoint::make_publisher)
+    .def(
+      "set_publish_limit",
+      [](broker::endpoint& ep, broker::topic prefix, double rate,
+         uint64_t burst, uint64_t sample, bool drop) {
+        ep.set_publish_limit(std::move(prefix),
+                             broker::publish_limit{rate, burst, sample, drop});
+      },
+      py::arg("prefix"), py::arg("rate") = 0.0, py::arg("burst") = 0,
+      py::arg("sample") = 1, py::arg("drop") = false)
+    .def("clear_publish_limit", &broker::endpoint::clear_publish_limit)
     .def("make_subscriber", &broker::endpoint::make_subscriber,
          py::arg("topics"), py::arg("max_qsize") = 20)
     .def(
@@ -5,6 +5,7 @@ except ImportError:
     import _broker
 
 import sys
+import asyncio
 import datetime
 import time
 import types
@@ -106,6 +107,21 @@ def _make_topics(ts):
 
     return _broker.VectorTopic(ts)
 
+async def _wait_readable(fd):
+    """Suspends the current coroutine until fd becomes readable."""
+    loop = asyncio.get_running_loop()
+    ready = loop.create_future()
+
+    def on_readable():
+        if not ready.done():
+            ready.set_result(None)
+
+    loop.add_reader(fd, on_readable)
+    try:
+        await ready
+    finally:
+        loop.remove_reader(fd)
+
 # This class does not derive from the internal class because we
 # need to pass in existing instances. That means we need to
 # wrap all methods, even those that just reuse the internal
@@ -149,6 +165,25 @@ class Subscriber:
         msgs = self._subscriber.poll()
         return [(d[0].string(), Data.to_py(d[1])) for d in msgs]
 
+    def _to_py(self, x):
+        return Data.to_py(x)
+
+    async def get_async(self, max_count=None):
+        """Awaits the next messages without blocking the event loop.
+
+        Suspends until at least one message is available and then returns a
+        list with all available messages, but no more than max_count. The
+        subscriber transfers the entire list in a single call to the C++
+        library."""
+        while True:
+            if max_count is None:
+                msgs = self._subscriber.poll()
+            else:
+                msgs = self._subscriber.get(max_count, 0.0)
+            if msgs:
+                return [(d[0].string(), self._to_py(d[1])) for d in msgs]
+            await _wait_readable(self.fd())
+
     def available(self):
         return self._subscriber.available()
 
@@ -171,6 +206,9 @@ class SafeSubscriber(Subscriber):
     work around this SafeSubscriber relies on ImmutableData rather than Data
     (used by regular Subscribers)."""
 
+    def _to_py(self, x):
+        return ImmutableData.to_py(x)
+
     def get(self, *args, **kwargs):
         msg = self._subscriber.get(*args, **kwargs)
 
@@ -280,6 +318,23 @@ class Publisher:
         batch = [Data.from_py(d) for d in batch]
         return self._publisher.publish_batch(_broker.Vector(batch))
 
+    async def publish_async(self, batch):
+        """Publishes all values in batch without blocking the event loop.
+
+        Whenever the Broker core has no demand for more messages, suspends
+        until the core signals new demand. Each call to the C++ library
+        transfers as many values as the core currently accepts."""
+        batch = [Data.from_py(d) for d in batch]
+        while batch:
+            await _wait_readable(self.fd())
+            n = self._publisher.demand()
+            if n == 0:
+                # A readable handle without demand means that the core
+                # stopped receiving messages. Publishing returns immediately.
+                n = len(batch)
+            self._publisher.publish_batch(_broker.Vector(batch[:n]))
+            batch = batch[n:]
+
 class Store:
     # This class does not derive from the internal class because we
     # need to pass in existing instances. That means we need to
@@ -439,6 +494,21 @@ class Endpoint(_broker.Endpoint):
         topics = _make_topics(topics)
         _broker.Endpoint.forward(self, topics)
 
+    def set_publish_limit(self, prefix, rate=0.0, burst=0, sample=1,
+                          drop=False):
+        """Limits how many messages local publishers may publish on topics
+        that start with the prefix: at most `rate` messages per second (0 =
+        unlimited) with bursts of up to `burst` messages and only one in
+        `sample` messages. The endpoint drops all other messages. Passing
+        `drop=True` drops all messages on matching topics."""
+        prefix = _make_topic(prefix)
+        _broker.Endpoint.set_publish_limit(self, prefix, float(rate), burst,
+                                           sample, bool(drop))
+
+    def clear_publish_limit(self, prefix):
+        prefix = _make_topic(prefix)
+        _broker.Endpoint.clear_publish_limit(self, prefix)
+
     def publish(self, topic, data):
         topic = _make_topic(topic)
         data =  Data.from_py(data)
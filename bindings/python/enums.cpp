@@ -72,5 +72,6 @@ void init_enums(py::module& m) {
   py::enum_<broker::backend>(m, "Backend")
     .value("Memory", broker::backend::memory)
     .value("SQLite", broker::backend::sqlite)
+    .value("WAL", broker::backend::wal)
     .export_values();
 }
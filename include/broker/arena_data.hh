@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "broker/data.hh"
+#include "broker/expected.hh"
+#include "broker/message.hh"
+
+namespace broker {
+
+class arena_data;
+class data_envelope;
+
+/// A read-only sequence of elements in an arena. Elements are stored
+/// contiguously, i.e., random access runs in constant time.
+template <data::type Tag>
+class arena_list {
+public:
+  using iterator = const arena_data*;
+
+  using const_iterator = const arena_data*;
+
+  arena_list() noexcept = default;
+
+  arena_list(const arena_data* first, size_t size) noexcept
+    : first_(first), size_(size) {
+    // nop
+  }
+
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  iterator begin() const noexcept {
+    return first_;
+  }
+
+  iterator end() const noexcept;
+
+  const arena_data& operator[](size_t index) const noexcept;
+
+private:
+  const arena_data* first_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// A read-only list of elements of a set in an arena. Since the arena stores
+/// the elements in the same order as `broker::set`, the elements are sorted.
+using arena_set = arena_list<data::type::set>;
+
+/// A read-only list of elements of a vector in an arena.
+using arena_vector = arena_list<data::type::vector>;
+
+/// Iterates the key-value pairs of an @ref arena_table.
+class arena_table_iterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+
+  using difference_type = std::ptrdiff_t;
+
+  using value_type = std::pair<const arena_data&, const arena_data&>;
+
+  using pointer = void;
+
+  using reference = value_type;
+
+  arena_table_iterator() noexcept = default;
+
+  explicit arena_table_iterator(const arena_data* pos) noexcept : pos_(pos) {
+    // nop
+  }
+
+  value_type operator*() const noexcept;
+
+  arena_table_iterator& operator++() noexcept {
+    pos_ += 2;
+    return *this;
+  }
+
+  arena_table_iterator operator++(int) noexcept {
+    auto result = *this;
+    pos_ += 2;
+    return result;
+  }
+
+  friend bool operator==(arena_table_iterator x,
+                         arena_table_iterator y) noexcept {
+    return x.pos_ == y.pos_;
+  }
+
+  friend bool operator!=(arena_table_iterator x,
+                         arena_table_iterator y) noexcept {
+    return x.pos_ != y.pos_;
+  }
+
+private:
+  const arena_data* pos_ = nullptr;
+};
+
+/// A read-only table in an arena. Stores keys and values interleaved, sorted
+/// by key.
+class arena_table {
+public:
+  using iterator = arena_table_iterator;
+
+  using const_iterator = arena_table_iterator;
+
+  arena_table() noexcept = default;
+
+  arena_table(const arena_data* first, size_t size) noexcept
+    : first_(first), size_(size) {
+    // nop
+  }
+
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  iterator begin() const noexcept {
+    return iterator{first_};
+  }
+
+  iterator end() const noexcept;
+
+private:
+  const arena_data* first_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// The name of an enum value in an arena.
+struct arena_enum_value {
+  std::string_view name;
+};
+
+/// The arena counterpart of `data_variant`. Strings point into the arena and
+/// containers refer to contiguous arrays in the arena.
+using arena_data_variant =
+  std::variant<none, boolean, count, integer, real, std::string_view, address,
+               subnet, port, timestamp, timespan, arena_enum_value, arena_set,
+               arena_table, arena_vector>;
+
+/// A read-only @ref data object in an arena. Objects of this type never own
+/// memory and the arena never calls destructors, i.e., releasing the arena
+/// releases the entire tree at once.
+class arena_data {
+public:
+  arena_data() noexcept = default;
+
+  template <class T,
+            class = std::enable_if_t<
+              std::is_constructible_v<arena_data_variant, T&&>>>
+  explicit arena_data(T&& x) noexcept : data_(std::forward<T>(x)) {
+    // nop
+  }
+
+  /// Returns the type tag of the stored type. The type tags are the same as for
+  /// @ref data.
+  data::type get_type() const noexcept {
+    return static_cast<data::type>(data_.index());
+  }
+
+  const arena_data_variant& get_data() const noexcept {
+    return data_;
+  }
+
+  /// Materializes this object.
+  data to_data() const;
+
+private:
+  arena_data_variant data_;
+};
+
+static_assert(std::is_trivially_destructible_v<arena_data>,
+              "arena_data must not require destructor calls");
+
+/// @relates arena_data
+template <class T>
+bool is(const arena_data& x) noexcept {
+  return std::holds_alternative<T>(x.get_data());
+}
+
+/// @relates arena_data
+template <class T>
+const T* get_if(const arena_data& x) noexcept {
+  return std::get_if<T>(std::addressof(x.get_data()));
+}
+
+/// @relates arena_data
+template <class T>
+const T* get_if(const arena_data* x) noexcept {
+  return std::get_if<T>(std::addressof(x->get_data()));
+}
+
+/// @relates arena_data
+void convert(const arena_data& x, std::string& str);
+
+/// @relates arena_data
+std::string to_string(const arena_data& x);
+
+template <data::type Tag>
+typename arena_list<Tag>::iterator arena_list<Tag>::end() const noexcept {
+  return first_ + size_;
+}
+
+template <data::type Tag>
+const arena_data& arena_list<Tag>::operator[](size_t index) const noexcept {
+  return first_[index];
+}
+
+inline arena_table_iterator::value_type
+arena_table_iterator::operator*() const noexcept {
+  return {pos_[0], pos_[1]};
+}
+
+inline arena_table::iterator arena_table::end() const noexcept {
+  return iterator{first_ + size_ * 2};
+}
+
+/// A data message that decodes its entire content into a single arena. Copies
+/// share the arena, which goes away together with the last copy.
+class arena_message {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  arena_message() noexcept = default;
+
+  arena_message(const arena_message&) noexcept = default;
+
+  arena_message(arena_message&&) noexcept = default;
+
+  arena_message& operator=(const arena_message&) noexcept = default;
+
+  arena_message& operator=(arena_message&&) noexcept = default;
+
+  // -- factories --------------------------------------------------------------
+
+  /// Decodes the payload of a packed data message.
+  /// @returns the decoded message or `ec::invalid_data` if `msg` is not a
+  ///          data message or its payload is malformed.
+  static expected<arena_message> make(packed_message msg);
+
+  /// Decodes the content of an envelope. Never fails, because envelopes only
+  /// contain valid data.
+  static arena_message make(const data_envelope& msg);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Checks whether this object holds a decoded message.
+  explicit operator bool() const noexcept {
+    return impl_ != nullptr;
+  }
+
+  /// Returns the topic of the message.
+  /// @pre `static_cast<bool>(*this)`
+  const topic& get_topic() const noexcept;
+
+  /// Returns the content of the message.
+  /// @pre `static_cast<bool>(*this)`
+  const arena_data& value() const noexcept;
+
+  /// Returns the number of bytes that the arena reserved for the content.
+  /// @pre `static_cast<bool>(*this)`
+  size_t arena_size() const noexcept;
+
+  // -- conversion -------------------------------------------------------------
+
+  /// Materializes the message.
+  /// @pre `static_cast<bool>(*this)`
+  data_message to_data_message() const;
+
+private:
+  struct impl;
+
+  explicit arena_message(std::shared_ptr<const impl> ptr) noexcept
+    : impl_(std::move(ptr)) {
+    // nop
+  }
+
+  std::shared_ptr<const impl> impl_;
+};
+
+} // namespace broker
@@ -8,6 +8,7 @@ namespace broker {
 enum class backend : uint8_t {
   memory, ///< An in-memory backend based on a simple hash table.
   sqlite, ///< A SQLite3 backend.
+  wal,    ///< An in-memory backend that persists changes to a write-ahead log.
 };
 
 /// @relates backend
@@ -15,7 +16,7 @@ template <class Inspector>
 bool inspect(Inspector& f, backend& x) {
   auto get = [&] { return static_cast<uint8_t>(x); };
   auto set = [&](uint8_t val) {
-    if (val <= static_cast<uint8_t>(backend::sqlite)) {
+    if (val <= static_cast<uint8_t>(backend::wal)) {
       x = static_cast<backend>(val);
       return true;
     } else {
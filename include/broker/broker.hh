@@ -6,6 +6,7 @@
 #include "broker/data.hh"
 #include "broker/endpoint.hh"
 #include "broker/port.hh"
+#include "broker/publish_limit.hh"
 #include "broker/publisher.hh"
 #include "broker/status.hh"
 #include "broker/status_subscriber.hh"
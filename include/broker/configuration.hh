@@ -46,6 +46,15 @@ struct broker_options {
   /// How many hops we forward at the most before dropping a message.
   uint16_t ttl = defaults::ttl;
 
+  /// Topic prefixes for collecting end-to-end latency histograms. A non-empty
+  /// list also enables origin timestamps on the wire for peers that support
+  /// them.
+  std::vector<std::string> latency_prefixes;
+
+  /// Number of threads for performing peering handshakes. Values greater than
+  /// 1 distribute incoming and outgoing connections over multiple threads.
+  size_t connector_threads = defaults::connector::threads;
+
   broker_options() = default;
 
   broker_options(const broker_options&) = default;
@@ -61,6 +70,22 @@ struct openssl_options {
   std::string capath;
   std::string cafile;
 
+  /// Maximum number of TLS sessions for resuming sessions with peers, on the
+  /// client side as well as on the server side. The value 0 disables session
+  /// resumption, including session tickets.
+  size_t session_cache_size = defaults::ssl::session_cache_size;
+
+  /// Lifetime of TLS sessions and session tickets.
+  timespan session_timeout = defaults::ssl::session_timeout;
+
+  /// Enables stateless session resumption via session tickets.
+  bool session_tickets = true;
+
+  /// Path to a file with the keys for encrypting session tickets. Peers that
+  /// share the same file accept session tickets of each other, even after
+  /// restarting. The file must contain at least 80 random bytes.
+  std::string session_ticket_key_file;
+
   bool authentication_enabled() const noexcept;
 };
 
@@ -0,0 +1,501 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "broker/data.hh"
+#include "broker/expected.hh"
+#include "broker/message.hh"
+#include "broker/span.hh"
+
+namespace broker {
+
+class data_view_list;
+class data_view_table;
+
+/// A read-only view of a @ref data object in its binary representation. A view
+/// walks the serialized bytes in place and never allocates unless converting
+/// to an owned value via `to_data`. Views do not own their bytes. Users must
+/// make sure that the underlying buffer outlives all views into it, e.g., by
+/// keeping the @ref data_envelope alive.
+/// @note Views are only valid for buffers that passed validation. Use a
+///       @ref data_envelope for obtaining views to untrusted input.
+class data_view {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// Constructs a view that represents `none`.
+  data_view() noexcept = default;
+
+  /// Constructs a view to the serialized object at `pos`.
+  /// @pre `pos` points to a valid, serialized @ref data object.
+  explicit data_view(const std::byte* pos) noexcept : pos_(pos) {
+    // nop
+  }
+
+  data_view(const data_view&) noexcept = default;
+
+  data_view& operator=(const data_view&) noexcept = default;
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the type of the viewed object.
+  data::type get_type() const noexcept {
+    if (pos_ == nullptr)
+      return data::type::none;
+    return static_cast<data::type>(*pos_);
+  }
+
+  /// Returns the serialized representation of the viewed object.
+  span<const std::byte> raw_bytes() const noexcept;
+
+  // -- type predicates --------------------------------------------------------
+
+  bool is_none() const noexcept {
+    return get_type() == data::type::none;
+  }
+
+  bool is_boolean() const noexcept {
+    return get_type() == data::type::boolean;
+  }
+
+  bool is_count() const noexcept {
+    return get_type() == data::type::count;
+  }
+
+  bool is_integer() const noexcept {
+    return get_type() == data::type::integer;
+  }
+
+  bool is_real() const noexcept {
+    return get_type() == data::type::real;
+  }
+
+  bool is_string() const noexcept {
+    return get_type() == data::type::string;
+  }
+
+  bool is_address() const noexcept {
+    return get_type() == data::type::address;
+  }
+
+  bool is_subnet() const noexcept {
+    return get_type() == data::type::subnet;
+  }
+
+  bool is_port() const noexcept {
+    return get_type() == data::type::port;
+  }
+
+  bool is_timestamp() const noexcept {
+    return get_type() == data::type::timestamp;
+  }
+
+  bool is_timespan() const noexcept {
+    return get_type() == data::type::timespan;
+  }
+
+  bool is_enum_value() const noexcept {
+    return get_type() == data::type::enum_value;
+  }
+
+  bool is_set() const noexcept {
+    return get_type() == data::type::set;
+  }
+
+  bool is_table() const noexcept {
+    return get_type() == data::type::table;
+  }
+
+  bool is_vector() const noexcept {
+    return get_type() == data::type::vector;
+  }
+
+  // -- typed accessors --------------------------------------------------------
+
+  // Note: the accessors below require that the view has the matching type.
+  //       Calling an accessor for the wrong type is undefined behavior. Use
+  //       the type predicates or the `get_if` overloads below to check first.
+
+  boolean to_boolean() const noexcept;
+
+  count to_count() const noexcept;
+
+  integer to_integer() const noexcept;
+
+  real to_real() const noexcept;
+
+  /// Returns the content of a string without copying it.
+  std::string_view to_string_view() const noexcept;
+
+  address to_address() const noexcept;
+
+  subnet to_subnet() const noexcept;
+
+  port to_port() const noexcept;
+
+  timestamp to_timestamp() const noexcept;
+
+  timespan to_timespan() const noexcept;
+
+  /// Returns the name of an enum value without copying it.
+  std::string_view to_enum_name() const noexcept;
+
+  /// Returns a view to the elements of a set.
+  data_view_list to_set() const noexcept;
+
+  /// Returns a view to the key-value pairs of a table.
+  data_view_table to_table() const noexcept;
+
+  /// Returns a view to the elements of a vector.
+  data_view_list to_vector() const noexcept;
+
+  // -- conversion -------------------------------------------------------------
+
+  /// Materializes the viewed object.
+  data to_data() const;
+
+private:
+  const std::byte* pos_ = nullptr;
+};
+
+/// Iterates the serialized elements of a vector or set.
+class data_view_iterator {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using iterator_category = std::forward_iterator_tag;
+
+  using difference_type = std::ptrdiff_t;
+
+  using value_type = data_view;
+
+  using pointer = const data_view*;
+
+  using reference = data_view;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  data_view_iterator() noexcept = default;
+
+  data_view_iterator(const std::byte* pos, size_t remaining) noexcept
+    : pos_(pos), remaining_(remaining) {
+    // nop
+  }
+
+  data_view_iterator(const data_view_iterator&) noexcept = default;
+
+  data_view_iterator& operator=(const data_view_iterator&) noexcept = default;
+
+  // -- operators --------------------------------------------------------------
+
+  data_view operator*() const noexcept {
+    return data_view{pos_};
+  }
+
+  data_view_iterator& operator++() noexcept;
+
+  data_view_iterator operator++(int) noexcept {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  /// Iterators compare equal if they have the same number of remaining
+  /// elements, i.e., the past-the-end iterator never needs to walk the bytes.
+  friend bool operator==(const data_view_iterator& x,
+                         const data_view_iterator& y) noexcept {
+    return x.remaining_ == y.remaining_;
+  }
+
+  friend bool operator!=(const data_view_iterator& x,
+                         const data_view_iterator& y) noexcept {
+    return x.remaining_ != y.remaining_;
+  }
+
+private:
+  const std::byte* pos_ = nullptr;
+  size_t remaining_ = 0;
+};
+
+/// Iterates the serialized key-value pairs of a table.
+class data_view_table_iterator {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using iterator_category = std::forward_iterator_tag;
+
+  using difference_type = std::ptrdiff_t;
+
+  using value_type = std::pair<data_view, data_view>;
+
+  using pointer = const value_type*;
+
+  using reference = value_type;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  data_view_table_iterator() noexcept = default;
+
+  data_view_table_iterator(const std::byte* pos, size_t remaining) noexcept;
+
+  data_view_table_iterator(const data_view_table_iterator&) noexcept = default;
+
+  data_view_table_iterator&
+  operator=(const data_view_table_iterator&) noexcept = default;
+
+  // -- operators --------------------------------------------------------------
+
+  value_type operator*() const noexcept {
+    return {data_view{pos_}, data_view{value_pos_}};
+  }
+
+  data_view_table_iterator& operator++() noexcept;
+
+  data_view_table_iterator operator++(int) noexcept {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const data_view_table_iterator& x,
+                         const data_view_table_iterator& y) noexcept {
+    return x.remaining_ == y.remaining_;
+  }
+
+  friend bool operator!=(const data_view_table_iterator& x,
+                         const data_view_table_iterator& y) noexcept {
+    return x.remaining_ != y.remaining_;
+  }
+
+private:
+  const std::byte* pos_ = nullptr;
+  const std::byte* value_pos_ = nullptr;
+  size_t remaining_ = 0;
+};
+
+/// A view to the elements of a serialized vector or set.
+class data_view_list {
+public:
+  using iterator = data_view_iterator;
+
+  using const_iterator = data_view_iterator;
+
+  data_view_list() noexcept = default;
+
+  data_view_list(const std::byte* first, size_t size) noexcept
+    : first_(first), size_(size) {
+    // nop
+  }
+
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  iterator begin() const noexcept {
+    return {first_, size_};
+  }
+
+  iterator end() const noexcept {
+    return {nullptr, 0};
+  }
+
+  /// Returns the element at position `index`.
+  /// @pre `index < size()`
+  /// @note Runs in linear time, because elements have variable size.
+  data_view operator[](size_t index) const noexcept;
+
+private:
+  const std::byte* first_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// A view to the key-value pairs of a serialized table.
+class data_view_table {
+public:
+  using iterator = data_view_table_iterator;
+
+  using const_iterator = data_view_table_iterator;
+
+  data_view_table() noexcept = default;
+
+  data_view_table(const std::byte* first, size_t size) noexcept
+    : first_(first), size_(size) {
+    // nop
+  }
+
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  iterator begin() const noexcept {
+    return {first_, size_};
+  }
+
+  iterator end() const noexcept {
+    return {nullptr, 0};
+  }
+
+private:
+  const std::byte* first_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// Owns the serialized representation of a data message and grants read-only
+/// access to its content via @ref data_view. Creating an envelope validates
+/// the bytes once. Afterwards, accessing the content never fails.
+/// @note Subscribers and the accessors in zeek.hh other than `EventView` still
+///       deliver owned values. Envelopes serve code that already holds a
+///       @ref packed_message.
+class data_envelope {
+public:
+  // -- constructors, destructors, and assignment operators --------------------
+
+  data_envelope() = default;
+
+  data_envelope(const data_envelope&) = default;
+
+  data_envelope(data_envelope&&) = default;
+
+  data_envelope& operator=(const data_envelope&) = default;
+
+  data_envelope& operator=(data_envelope&&) = default;
+
+  // -- factories --------------------------------------------------------------
+
+  /// Wraps the payload of a packed data message without copying it.
+  /// @returns an envelope for `msg` or `ec::invalid_data` if `msg` is not a
+  ///          data message or its payload is malformed.
+  static expected<data_envelope> make(packed_message msg);
+
+  /// Wraps a serialized @ref data object.
+  /// @returns an envelope for `bytes` or `ec::invalid_data` if `bytes` does
+  ///          not contain exactly one serialized @ref data object.
+  static expected<data_envelope> make(topic t, std::vector<std::byte> bytes);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the topic of the message.
+  const topic& get_topic() const noexcept {
+    return broker::get_topic(msg_);
+  }
+
+  /// Returns a view to the content of the message.
+  data_view value() const noexcept {
+    auto& bytes = get_payload(msg_);
+    return bytes.empty() ? data_view{} : data_view{bytes.data()};
+  }
+
+  /// Returns the serialized content of the message.
+  span<const std::byte> raw_bytes() const noexcept {
+    return get_payload(msg_);
+  }
+
+  /// Returns the wrapped message.
+  const packed_message& get_packed_message() const noexcept {
+    return msg_;
+  }
+
+  // -- conversion -------------------------------------------------------------
+
+  /// Materializes the content of the message.
+  data to_data() const {
+    return value().to_data();
+  }
+
+  /// Materializes the message.
+  data_message to_data_message() const {
+    return make_data_message(get_topic(), to_data());
+  }
+
+private:
+  explicit data_envelope(packed_message msg) : msg_(std::move(msg)) {
+    // nop
+  }
+
+  packed_message msg_;
+};
+
+/// Limits how deeply containers may nest in a serialized @ref data object that
+/// passes validation. Walking deeper structures from untrusted input could
+/// otherwise exhaust the stack.
+/// @relates data_view
+constexpr size_t max_data_view_depth = 128;
+
+/// Checks whether `bytes` contains exactly one valid, serialized @ref data
+/// object with at most `max_data_view_depth` levels of nested containers.
+/// @relates data_view
+bool is_valid_data_encoding(span<const std::byte> bytes) noexcept;
+
+/// @relates data_view
+void convert(const data_view& x, std::string& str);
+
+/// @relates data_view
+std::string to_string(const data_view& x);
+
+/// @relates data_view
+template <class T>
+struct data_view_access;
+
+#define BROKER_DATA_VIEW_ACCESS(type_name, tag, fn)                            \
+  template <>                                                                  \
+  struct data_view_access<type_name> {                                         \
+    static bool is(const data_view& x) noexcept {                              \
+      return x.get_type() == data::type::tag;                                  \
+    }                                                                          \
+    static auto get(const data_view& x) noexcept {                             \
+      return x.fn();                                                           \
+    }                                                                          \
+  };
+
+BROKER_DATA_VIEW_ACCESS(boolean, boolean, to_boolean)
+BROKER_DATA_VIEW_ACCESS(count, count, to_count)
+BROKER_DATA_VIEW_ACCESS(integer, integer, to_integer)
+BROKER_DATA_VIEW_ACCESS(real, real, to_real)
+BROKER_DATA_VIEW_ACCESS(std::string, string, to_string_view)
+BROKER_DATA_VIEW_ACCESS(address, address, to_address)
+BROKER_DATA_VIEW_ACCESS(subnet, subnet, to_subnet)
+BROKER_DATA_VIEW_ACCESS(port, port, to_port)
+BROKER_DATA_VIEW_ACCESS(timestamp, timestamp, to_timestamp)
+BROKER_DATA_VIEW_ACCESS(timespan, timespan, to_timespan)
+BROKER_DATA_VIEW_ACCESS(enum_value, enum_value, to_enum_name)
+BROKER_DATA_VIEW_ACCESS(set, set, to_set)
+BROKER_DATA_VIEW_ACCESS(table, table, to_table)
+BROKER_DATA_VIEW_ACCESS(vector, vector, to_vector)
+
+#undef BROKER_DATA_VIEW_ACCESS
+
+/// Checks whether `x` views an object of type `T`.
+/// @relates data_view
+template <class T>
+bool is(const data_view& x) noexcept {
+  return data_view_access<T>::is(x);
+}
+
+/// Returns the viewed value if `x` views an object of type `T`. Selecting
+/// `std::string` or `enum_value` returns a `std::string_view` and selecting a
+/// container type returns a @ref data_view_list or @ref data_view_table.
+/// @relates data_view
+template <class T>
+auto get_if(const data_view& x) noexcept
+  -> std::optional<decltype(data_view_access<T>::get(x))> {
+  if (data_view_access<T>::is(x))
+    return data_view_access<T>::get(x);
+  return std::nullopt;
+}
+
+} // namespace broker
@@ -3,6 +3,7 @@
 #include "broker/time.hh"
 
 #include <chrono>
+#include <cstddef>
 #include <limits>
 #include <string_view>
 
@@ -24,6 +25,77 @@ constexpr timespan unpeer_timeout = std::chrono::seconds{3};
 
 } // namespace broker::defaults
 
+namespace broker::defaults::core {
+
+/// Configures how many dispatch shards the core uses for writing to peers. The
+/// default value of 0 disables sharding, i.e., the core dispatches all
+/// messages to its peers directly.
+constexpr size_t dispatch_shards = 0;
+
+} // namespace broker::defaults::core
+
+namespace broker::defaults::capture {
+
+/// Configures the size of a single segment file when capturing messages.
+constexpr size_t segment_size = 64 * 1024 * 1024;
+
+/// Configures how often the capture actor flushes its segment to disk.
+constexpr timespan flush_interval = std::chrono::seconds{1};
+
+/// Configures how many messages may wait for the capture actor. The core drops
+/// messages for the capture while the buffer is full.
+constexpr size_t buffer_size = 8192;
+
+} // namespace broker::defaults::capture
+
+namespace broker::defaults::trace {
+
+/// Configures how many records each thread keeps in its trace ring buffer.
+constexpr size_t buffer_size = 4096;
+
+} // namespace broker::defaults::trace
+
+namespace broker::defaults::peering {
+
+/// Configures how many messages the core may group into a single batch when
+/// writing to a peer. The default value of 1 disables batching.
+constexpr size_t write_batch_size = 1;
+
+/// Configures how long the core may delay a message for filling up a batch.
+constexpr timespan write_batch_delay = std::chrono::milliseconds{1};
+
+/// Configures how many bytes the transport of a peer connection may read from
+/// the socket at once. The value 0 disables reading ahead.
+constexpr size_t read_ahead = 65536;
+
+} // namespace broker::defaults::peering
+
+namespace broker::defaults::priority {
+
+/// Configures how many messages a priority stage may buffer per input.
+constexpr size_t buffer_size = 32;
+
+} // namespace broker::defaults::priority
+
+namespace broker::defaults::connector {
+
+/// Configures how many threads perform peering handshakes. The default value
+/// of 1 runs all handshakes on a single thread.
+constexpr size_t threads = 1;
+
+} // namespace broker::defaults::connector
+
+namespace broker::defaults::ssl {
+
+/// Configures how many TLS sessions Broker keeps for resuming sessions when
+/// reconnecting to peers. The value 0 disables session resumption.
+constexpr size_t session_cache_size = 1024;
+
+/// Configures how long peers may resume a TLS session.
+constexpr timespan session_timeout = std::chrono::hours{2};
+
+} // namespace broker::defaults::ssl
+
 namespace broker::defaults::subscriber {
 
 static constexpr size_t queue_size = 64;
@@ -51,6 +123,22 @@ constexpr uint16_t connection_timeout = 100; // 10s
 /// Configures the default timeout of @ref peer::await_idle.
 constexpr timespan await_idle_timeout = std::chrono::seconds{15};
 
+/// Configures the default number of entries per page for range and prefix
+/// queries.
+constexpr uint64_t scan_page_size = 1'000;
+
+/// Configures how many entries a master removes per tick at most when its
+/// backend selects expired entries on its own.
+constexpr size_t max_expirations_per_tick = 10'000;
+
+/// Configures how long a clone may hold back writes for combining successive
+/// writes to the same key. The default value of 0 disables combining.
+constexpr timespan combine_interval = timespan{0};
+
+/// Configures how many commands a clone may hold back at most before
+/// forwarding them to the master.
+constexpr size_t combine_max_size = 1'000;
+
 } // namespace broker::defaults::store
 
 namespace broker::defaults::path_revocations {
@@ -65,4 +153,6 @@ namespace broker::defaults::metrics {
 
 constexpr timespan export_interval = std::chrono::seconds{1};
 
+constexpr timespan max_staleness = timespan{0};
+
 } // namespace broker::defaults::metrics
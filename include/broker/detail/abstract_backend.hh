@@ -6,6 +6,7 @@
 
 #include <deque>
 #include <optional>
+#include <vector>
 
 namespace broker::detail {
 
@@ -68,6 +69,20 @@ public:
   /// time lies in the future.
   virtual expected<bool> expire(const data& key, timestamp current_time) = 0;
 
+  /// Removes up to *limit* entries with an expiration time before or equal to
+  /// *current_time*, starting with the entries that expired first. The default
+  /// implementation calls `expiries` and `expire`.
+  /// @param current_time The time used to select the entries to expire.
+  /// @param limit The maximum number of entries to expire.
+  /// @returns the keys of all expired entries.
+  virtual expected<std::vector<data>> expire_due(timestamp current_time,
+                                                 size_t limit);
+
+  /// Writes buffered changes to persistent storage. The master calls this
+  /// function periodically. The default implementation does nothing.
+  /// @returns `nil` on success.
+  virtual expected<void> flush();
+
   // --- inspectors -----------------------------------------------------------
 
   /// Retrieves the value associated with a given key.
@@ -95,12 +110,41 @@ public:
   /// @returns The set of current keys.
   virtual expected<data> keys() const = 0;
 
+  /// Retrieves up to *limit* key-value pairs with keys in the range
+  /// `[first, last)` in ascending order. A `nil` value for *last* selects all
+  /// keys with the same type as *first*.
+  /// @param first The smallest key to include.
+  /// @param last The first key to exclude or `nil`.
+  /// @param limit The maximum number of entries in the result. A limit of 0
+  ///              returns no entries and no cursor.
+  /// @returns A vector with a table of the selected entries plus the key for
+  ///          resuming the scan (or `nil` if no more entries exist).
+  virtual expected<data> scan(const data& first, const data& last,
+                              count limit) const;
+
+  /// Retrieves the entry with the most specific subnet key that contains
+  /// *addr*.
+  /// @param addr The address to look up.
+  /// @returns A vector with the subnet key and its value or `no_such_key` if
+  ///          no subnet key contains *addr*.
+  virtual expected<data> lookup_containing(const address& addr) const;
+
+  /// Retrieves all entries with a subnet key that is a subset of *net*.
+  /// @param net The subnet that covers the selected keys.
+  /// @returns A table of the selected entries.
+  virtual expected<data> covered_by(const subnet& net) const;
+
   /// Retrieves all key-value pairs.
   /// @returns A snapshot of the store that includes its content.
   virtual expected<broker::snapshot> snapshot() const = 0;
 
   /// @returns the set of all keys that have expiry times.
   virtual expected<expirables> expiries() const = 0;
+
+  /// Returns whether the backend can efficiently select entries by their
+  /// expiration time. If `true`, masters rely on `expire_due` instead of
+  /// keeping track of all expiration times in memory.
+  virtual bool has_expiry_index() const noexcept;
 };
 
 } // namespace broker::detail
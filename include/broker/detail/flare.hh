@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 
 #include "broker/config.hh"
 #include "broker/detail/native_socket.hh"
@@ -14,14 +16,20 @@ namespace broker::detail {
 /// signal availability of a resource across threads, both access to that
 /// resource and the use of the fire/extinguish functions must be performed in
 /// a thread-safe manner in order for that to work correctly.
+///
+/// The flare keeps track of how many times it has been fired in an atomic
+/// counter and only touches the file descriptor when the counter switches
+/// between zero and non-zero. Hence, firing an already "ready" flare or only
+/// partially extinguishing it never results in a system call. On Linux, the
+/// flare uses an `eventfd` instead of a UNIX pipe.
 class flare {
 public:
   using timeout_type = clock::time_point;
 
-  /// Constructs a flare by opening a UNIX pipe.
+  /// Constructs a flare by opening an eventfd (Linux) or a UNIX pipe.
   flare();
 
-  /// Destructs the flare, closing the UNIX pipe's file descriptors.
+  /// Destructs the flare, closing the file descriptors.
   ~flare();
 
   flare(const flare&) = delete;
@@ -31,34 +39,41 @@ public:
   /// "fired" and not yet "extinguished."
   native_socket fd() const;
 
-  /// Puts the object in the "ready" state by writing `n` bytes into the
-  /// underlying pipe.
+  /// Puts the object in the "ready" state by incrementing the counter by
+  /// `num`. Signals the file descriptor only if the flare was not ready yet.
   void fire(size_t num = 1);
 
-  /// Takes the object out of the "ready" state by consuming all bytes from the
-  /// underlying pipe.
-  /// @returns the number of consumed bytes
+  /// Takes the object out of the "ready" state by resetting the counter.
+  /// @returns the value of the counter prior to extinguishing the flare.
   size_t extinguish();
 
-  /// Attempts to consume only one byte from the pipe, potentially leaving the
-  /// flare in "ready" state.
-  /// @returns `true` if one byte was read successfully from the pipe and
-  ///          `false` if the pipe had no data to be read.
+  /// Attempts to decrement the counter by one, potentially leaving the flare
+  /// in "ready" state.
+  /// @returns `true` if the counter was decremented and `false` if the flare
+  ///          was not ready.
   bool extinguish_one();
 
-  /// Attempts to consume only one byte from the pipe, potentially leaving the
+  /// Attempts to decrement the counter by up to `num`, potentially leaving the
   /// flare in "ready" state.
-  /// @returns `true` if one byte was read successfully from the pipe and
-  ///          `false` if the pipe had no data to be read.
+  /// @returns the number by which the counter was decremented.
   size_t extinguish_some(size_t num);
 
-  /// Blocks the caller until the object could consume one byte from the pipe.
+  /// Checks whether the flare is currently in "ready" state without a system
+  /// call.
+  bool ready() const noexcept {
+    return count_.load(std::memory_order_acquire) > 0;
+  }
+
+  /// Blocks the caller until the flare becomes ready. Spins for a short time
+  /// before blocking on the file descriptor.
   void await_one();
 
-  /// Blocks the caller until the object could consume one byte from the pipe
-  /// or or a timeout occurs.
+  /// Blocks the caller until the flare becomes ready or a timeout occurs.
+  /// Spins for a short time before blocking on the file descriptor.
   template <class Timeout>
   bool await_one(Timeout timeout) {
+    if (ready() || spin())
+      return true;
     using clk = typename Timeout::clock;
     auto delta = timeout - clk::now();
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(delta);
@@ -68,9 +83,29 @@ public:
   }
 
 private:
+  /// Spins for a while, waiting for the flare to become ready. Adapts the
+  /// number of iterations to whether spinning paid off the last time.
+  bool spin() noexcept;
+
   bool await_one_impl(int ms_timeout);
 
+  /// Makes the file descriptor readable.
+  void signal();
+
+  /// Makes the file descriptor unreadable again.
+  void drain();
+
+  /// Counts how many times the flare has been fired but not extinguished.
+  std::atomic<size_t> count_{0};
+
+  /// Stores how many iterations `spin` may use.
+  std::atomic<uint32_t> spin_limit_;
+
+#ifdef BROKER_LINUX
+  native_socket fd_;
+#else
   native_socket fds_[2];
+#endif
 };
 
 } // namespace broker::detail
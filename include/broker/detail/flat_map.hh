@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "broker/detail/flat_set.hh"
+
+namespace broker::detail {
+
+/// A map that stores its key-value pairs in a vector, sorted by key. Offers
+/// the same API as `std::map` for lookup, iteration and insertion. See
+/// @ref flat_set for the trade-offs compared to the node-based containers.
+/// @note Unlike `std::map`, the key of the `value_type` is not `const`. Users
+///       must not modify the key through an iterator.
+template <class Key, class T, class Compare = std::less<Key>>
+class flat_map {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using key_type = Key;
+
+  using mapped_type = T;
+
+  using value_type = std::pair<Key, T>;
+
+  using container_type = std::vector<value_type>;
+
+  using key_compare = Compare;
+
+  using size_type = size_t;
+
+  using difference_type = ptrdiff_t;
+
+  using reference = value_type&;
+
+  using const_reference = const value_type&;
+
+  using pointer = value_type*;
+
+  using const_pointer = const value_type*;
+
+  using iterator = typename container_type::iterator;
+
+  using const_iterator = typename container_type::const_iterator;
+
+  using reverse_iterator = typename container_type::reverse_iterator;
+
+  using const_reverse_iterator =
+    typename container_type::const_reverse_iterator;
+
+  /// Compares two key-value pairs by their key.
+  struct value_compare {
+    bool operator()(const value_type& x, const value_type& y) const {
+      return Compare{}(x.first, y.first);
+    }
+
+    bool operator()(const value_type& x, const key_type& y) const {
+      return Compare{}(x.first, y);
+    }
+
+    bool operator()(const key_type& x, const value_type& y) const {
+      return Compare{}(x, y.first);
+    }
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  flat_map() = default;
+
+  flat_map(const flat_map&) = default;
+
+  flat_map(flat_map&&) noexcept = default;
+
+  template <class InputIterator>
+  flat_map(InputIterator first, InputIterator last) {
+    insert(first, last);
+  }
+
+  flat_map(std::initializer_list<value_type> xs) {
+    insert(xs.begin(), xs.end());
+  }
+
+  /// Takes ownership of `xs` without sorting it.
+  /// @pre `xs` is sorted by key and contains no duplicate keys.
+  flat_map(sorted_unique_t, container_type xs) : xs_(std::move(xs)) {
+    // nop
+  }
+
+  flat_map& operator=(const flat_map&) = default;
+
+  flat_map& operator=(flat_map&&) noexcept = default;
+
+  flat_map& operator=(std::initializer_list<value_type> xs) {
+    clear();
+    insert(xs.begin(), xs.end());
+    return *this;
+  }
+
+  // -- iterator access --------------------------------------------------------
+
+  iterator begin() noexcept {
+    return xs_.begin();
+  }
+
+  const_iterator begin() const noexcept {
+    return xs_.begin();
+  }
+
+  const_iterator cbegin() const noexcept {
+    return xs_.cbegin();
+  }
+
+  iterator end() noexcept {
+    return xs_.end();
+  }
+
+  const_iterator end() const noexcept {
+    return xs_.end();
+  }
+
+  const_iterator cend() const noexcept {
+    return xs_.cend();
+  }
+
+  reverse_iterator rbegin() noexcept {
+    return xs_.rbegin();
+  }
+
+  const_reverse_iterator rbegin() const noexcept {
+    return xs_.rbegin();
+  }
+
+  reverse_iterator rend() noexcept {
+    return xs_.rend();
+  }
+
+  const_reverse_iterator rend() const noexcept {
+    return xs_.rend();
+  }
+
+  // -- size and capacity ------------------------------------------------------
+
+  bool empty() const noexcept {
+    return xs_.empty();
+  }
+
+  size_type size() const noexcept {
+    return xs_.size();
+  }
+
+  size_type max_size() const noexcept {
+    return xs_.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return xs_.capacity();
+  }
+
+  void reserve(size_type n) {
+    xs_.reserve(n);
+  }
+
+  void shrink_to_fit() {
+    xs_.shrink_to_fit();
+  }
+
+  // -- element access ---------------------------------------------------------
+
+  mapped_type& at(const key_type& key) {
+    if (auto i = find(key); i != end())
+      return i->second;
+    throw std::out_of_range{"broker::detail::flat_map::at"};
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    if (auto i = find(key); i != end())
+      return i->second;
+    throw std::out_of_range{"broker::detail::flat_map::at"};
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  void clear() noexcept {
+    xs_.clear();
+  }
+
+  void swap(flat_map& other) noexcept {
+    xs_.swap(other.xs_);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& x) {
+    return insert_impl(x);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& x) {
+    return insert_impl(std::move(x));
+  }
+
+  iterator insert(const_iterator hint, const value_type& x) {
+    return insert_hint_impl(hint, x);
+  }
+
+  iterator insert(const_iterator hint, value_type&& x) {
+    return insert_hint_impl(hint, std::move(x));
+  }
+
+  /// Inserts all elements in the range. Appends all elements first and then
+  /// restores the order in a single pass.
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    auto old_size = xs_.size();
+    xs_.insert(xs_.end(), first, last);
+    auto mid = xs_.begin() + static_cast<difference_type>(old_size);
+    // Note: stable_sort makes sure that we keep the first occurrence of
+    //       equivalent keys, just like std::map does.
+    std::stable_sort(mid, xs_.end(), value_compare{});
+    std::inplace_merge(xs_.begin(), mid, xs_.end(), value_compare{});
+    auto eq = [](const value_type& x, const value_type& y) {
+      return !Compare{}(x.first, y.first) && !Compare{}(y.first, x.first);
+    };
+    xs_.erase(std::unique(xs_.begin(), xs_.end(), eq), xs_.end());
+  }
+
+  void insert(std::initializer_list<value_type> xs) {
+    insert(xs.begin(), xs.end());
+  }
+
+  template <class... Ts>
+  std::pair<iterator, bool> emplace(Ts&&... xs) {
+    return insert_impl(value_type(std::forward<Ts>(xs)...));
+  }
+
+  template <class... Ts>
+  iterator emplace_hint(const_iterator hint, Ts&&... xs) {
+    return insert_hint_impl(hint, value_type(std::forward<Ts>(xs)...));
+  }
+
+  template <class K, class... Ts>
+  std::pair<iterator, bool> try_emplace(K&& key, Ts&&... xs) {
+    auto i = lower_bound(key);
+    if (i != end() && !Compare{}(key, i->first))
+      return {i, false};
+    i = xs_.emplace(i, std::piecewise_construct,
+                    std::forward_as_tuple(std::forward<K>(key)),
+                    std::forward_as_tuple(std::forward<Ts>(xs)...));
+    return {i, true};
+  }
+
+  template <class K, class V>
+  std::pair<iterator, bool> insert_or_assign(K&& key, V&& val) {
+    auto res = try_emplace(std::forward<K>(key), std::forward<V>(val));
+    if (!res.second)
+      res.first->second = std::forward<V>(val);
+    return res;
+  }
+
+  iterator erase(const_iterator pos) {
+    return xs_.erase(pos);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    return xs_.erase(first, last);
+  }
+
+  size_type erase(const key_type& key) {
+    if (auto i = find(key); i != end()) {
+      xs_.erase(i);
+      return 1;
+    }
+    return 0;
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  iterator lower_bound(const key_type& key) {
+    return std::lower_bound(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  const_iterator lower_bound(const key_type& key) const {
+    return std::lower_bound(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  iterator upper_bound(const key_type& key) {
+    return std::upper_bound(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  const_iterator upper_bound(const key_type& key) const {
+    return std::upper_bound(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    return std::equal_range(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type& key) const {
+    return std::equal_range(xs_.begin(), xs_.end(), key, value_compare{});
+  }
+
+  iterator find(const key_type& key) {
+    auto i = lower_bound(key);
+    if (i != end() && !Compare{}(key, i->first))
+      return i;
+    return end();
+  }
+
+  const_iterator find(const key_type& key) const {
+    auto i = lower_bound(key);
+    if (i != end() && !Compare{}(key, i->first))
+      return i;
+    return end();
+  }
+
+  size_type count(const key_type& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  bool contains(const key_type& key) const {
+    return find(key) != end();
+  }
+
+  // -- observers --------------------------------------------------------------
+
+  key_compare key_comp() const {
+    return Compare{};
+  }
+
+  value_compare value_comp() const {
+    return value_compare{};
+  }
+
+  /// Grants access to the underlying, sorted vector.
+  const container_type& container() const noexcept {
+    return xs_;
+  }
+
+  // -- comparison operators ---------------------------------------------------
+
+  friend bool operator==(const flat_map& x, const flat_map& y) {
+    return x.xs_ == y.xs_;
+  }
+
+  friend bool operator!=(const flat_map& x, const flat_map& y) {
+    return x.xs_ != y.xs_;
+  }
+
+  friend bool operator<(const flat_map& x, const flat_map& y) {
+    return x.xs_ < y.xs_;
+  }
+
+  friend bool operator<=(const flat_map& x, const flat_map& y) {
+    return x.xs_ <= y.xs_;
+  }
+
+  friend bool operator>(const flat_map& x, const flat_map& y) {
+    return x.xs_ > y.xs_;
+  }
+
+  friend bool operator>=(const flat_map& x, const flat_map& y) {
+    return x.xs_ >= y.xs_;
+  }
+
+private:
+  template <class U>
+  std::pair<iterator, bool> insert_impl(U&& x) {
+    auto i = lower_bound(x.first);
+    if (i != end() && !Compare{}(x.first, i->first))
+      return {i, false};
+    return {xs_.insert(i, std::forward<U>(x)), true};
+  }
+
+  template <class U>
+  iterator insert_hint_impl(const_iterator hint, U&& x) {
+    // Use the hint if `x` belongs right before it.
+    if ((hint == cend() || Compare{}(x.first, hint->first))
+        && (hint == cbegin() || Compare{}(std::prev(hint)->first, x.first)))
+      return xs_.insert(hint, std::forward<U>(x));
+    return insert_impl(std::forward<U>(x)).first;
+  }
+
+  container_type xs_;
+};
+
+} // namespace broker::detail
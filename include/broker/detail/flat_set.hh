@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace broker::detail {
+
+/// Tag type for passing an already sorted range without duplicates.
+struct sorted_unique_t {};
+
+/// Tag value for passing an already sorted range without duplicates.
+constexpr sorted_unique_t sorted_unique = sorted_unique_t{};
+
+/// A set that stores its elements in a sorted vector. Offers the same API as
+/// `std::set` for lookup, iteration and insertion. Compared to `std::set`,
+/// this container needs one allocation for all elements and iterates without
+/// pointer chasing. In turn, inserting and erasing elements runs in linear
+/// time and invalidates iterators.
+template <class T, class Compare = std::less<T>>
+class flat_set {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using container_type = std::vector<T>;
+
+  using key_type = T;
+
+  using value_type = T;
+
+  using key_compare = Compare;
+
+  using value_compare = Compare;
+
+  using size_type = size_t;
+
+  using difference_type = ptrdiff_t;
+
+  using reference = value_type&;
+
+  using const_reference = const value_type&;
+
+  using pointer = value_type*;
+
+  using const_pointer = const value_type*;
+
+  // Just like std::set, we never allow mutable access to the elements.
+  using iterator = typename container_type::const_iterator;
+
+  using const_iterator = iterator;
+
+  using reverse_iterator = typename container_type::const_reverse_iterator;
+
+  using const_reverse_iterator = reverse_iterator;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  flat_set() = default;
+
+  flat_set(const flat_set&) = default;
+
+  flat_set(flat_set&&) noexcept = default;
+
+  template <class InputIterator>
+  flat_set(InputIterator first, InputIterator last) {
+    insert(first, last);
+  }
+
+  flat_set(std::initializer_list<value_type> xs) {
+    insert(xs.begin(), xs.end());
+  }
+
+  /// Takes ownership of `xs` without sorting it.
+  /// @pre `xs` is sorted and contains no duplicates.
+  flat_set(sorted_unique_t, container_type xs) : xs_(std::move(xs)) {
+    // nop
+  }
+
+  flat_set& operator=(const flat_set&) = default;
+
+  flat_set& operator=(flat_set&&) noexcept = default;
+
+  flat_set& operator=(std::initializer_list<value_type> xs) {
+    clear();
+    insert(xs.begin(), xs.end());
+    return *this;
+  }
+
+  // -- iterator access --------------------------------------------------------
+
+  iterator begin() const noexcept {
+    return xs_.begin();
+  }
+
+  iterator cbegin() const noexcept {
+    return xs_.cbegin();
+  }
+
+  iterator end() const noexcept {
+    return xs_.end();
+  }
+
+  iterator cend() const noexcept {
+    return xs_.cend();
+  }
+
+  reverse_iterator rbegin() const noexcept {
+    return xs_.rbegin();
+  }
+
+  reverse_iterator rend() const noexcept {
+    return xs_.rend();
+  }
+
+  // -- size and capacity ------------------------------------------------------
+
+  bool empty() const noexcept {
+    return xs_.empty();
+  }
+
+  size_type size() const noexcept {
+    return xs_.size();
+  }
+
+  size_type max_size() const noexcept {
+    return xs_.max_size();
+  }
+
+  size_type capacity() const noexcept {
+    return xs_.capacity();
+  }
+
+  void reserve(size_type n) {
+    xs_.reserve(n);
+  }
+
+  void shrink_to_fit() {
+    xs_.shrink_to_fit();
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  void clear() noexcept {
+    xs_.clear();
+  }
+
+  void swap(flat_set& other) noexcept {
+    xs_.swap(other.xs_);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& x) {
+    return insert_impl(x);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& x) {
+    return insert_impl(std::move(x));
+  }
+
+  iterator insert(const_iterator hint, const value_type& x) {
+    return insert_hint_impl(hint, x);
+  }
+
+  iterator insert(const_iterator hint, value_type&& x) {
+    return insert_hint_impl(hint, std::move(x));
+  }
+
+  /// Inserts all elements in the range. Appends all elements first and then
+  /// restores the order in a single pass, which is much faster than inserting
+  /// the elements one by one.
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    auto old_size = xs_.size();
+    xs_.insert(xs_.end(), first, last);
+    auto mid = xs_.begin() + static_cast<difference_type>(old_size);
+    // Note: stable_sort makes sure that we keep the first occurrence of
+    //       equivalent elements, just like std::set does.
+    std::stable_sort(mid, xs_.end(), Compare{});
+    std::inplace_merge(xs_.begin(), mid, xs_.end(), Compare{});
+    auto eq = [](const value_type& x, const value_type& y) {
+      return !Compare{}(x, y) && !Compare{}(y, x);
+    };
+    xs_.erase(std::unique(xs_.begin(), xs_.end(), eq), xs_.end());
+  }
+
+  void insert(std::initializer_list<value_type> xs) {
+    insert(xs.begin(), xs.end());
+  }
+
+  template <class... Ts>
+  std::pair<iterator, bool> emplace(Ts&&... xs) {
+    return insert_impl(value_type(std::forward<Ts>(xs)...));
+  }
+
+  template <class... Ts>
+  iterator emplace_hint(const_iterator hint, Ts&&... xs) {
+    return insert_hint_impl(hint, value_type(std::forward<Ts>(xs)...));
+  }
+
+  iterator erase(const_iterator pos) {
+    return xs_.erase(pos);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    return xs_.erase(first, last);
+  }
+
+  size_type erase(const key_type& key) {
+    if (auto i = find(key); i != end()) {
+      xs_.erase(i);
+      return 1;
+    }
+    return 0;
+  }
+
+  // -- lookup -----------------------------------------------------------------
+
+  iterator lower_bound(const key_type& key) const {
+    return std::lower_bound(xs_.begin(), xs_.end(), key, Compare{});
+  }
+
+  iterator upper_bound(const key_type& key) const {
+    return std::upper_bound(xs_.begin(), xs_.end(), key, Compare{});
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type& key) const {
+    return std::equal_range(xs_.begin(), xs_.end(), key, Compare{});
+  }
+
+  iterator find(const key_type& key) const {
+    auto i = lower_bound(key);
+    if (i != end() && !Compare{}(key, *i))
+      return i;
+    return end();
+  }
+
+  size_type count(const key_type& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  bool contains(const key_type& key) const {
+    return find(key) != end();
+  }
+
+  // -- observers --------------------------------------------------------------
+
+  key_compare key_comp() const {
+    return Compare{};
+  }
+
+  value_compare value_comp() const {
+    return Compare{};
+  }
+
+  /// Grants access to the underlying, sorted vector.
+  const container_type& container() const noexcept {
+    return xs_;
+  }
+
+  // -- comparison operators ---------------------------------------------------
+
+  friend bool operator==(const flat_set& x, const flat_set& y) {
+    return x.xs_ == y.xs_;
+  }
+
+  friend bool operator!=(const flat_set& x, const flat_set& y) {
+    return x.xs_ != y.xs_;
+  }
+
+  friend bool operator<(const flat_set& x, const flat_set& y) {
+    return x.xs_ < y.xs_;
+  }
+
+  friend bool operator<=(const flat_set& x, const flat_set& y) {
+    return x.xs_ <= y.xs_;
+  }
+
+  friend bool operator>(const flat_set& x, const flat_set& y) {
+    return x.xs_ > y.xs_;
+  }
+
+  friend bool operator>=(const flat_set& x, const flat_set& y) {
+    return x.xs_ >= y.xs_;
+  }
+
+private:
+  template <class U>
+  std::pair<iterator, bool> insert_impl(U&& x) {
+    auto i = std::lower_bound(xs_.begin(), xs_.end(), x, Compare{});
+    if (i != xs_.end() && !Compare{}(x, *i))
+      return {i, false};
+    return {xs_.insert(i, std::forward<U>(x)), true};
+  }
+
+  template <class U>
+  iterator insert_hint_impl(const_iterator hint, U&& x) {
+    // Use the hint if `x` belongs right before it. This makes appending sorted
+    // input (e.g., when deserializing) run in constant time.
+    if ((hint == end() || Compare{}(x, *hint))
+        && (hint == begin() || Compare{}(*std::prev(hint), x)))
+      return xs_.insert(hint, std::forward<U>(x));
+    return insert_impl(std::forward<U>(x)).first;
+  }
+
+  container_type xs_;
+};
+
+} // namespace broker::detail
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "broker/data.hh"
+#include "broker/expected.hh"
+
+#include <set>
+#include <type_traits>
+#include <utility>
+
+namespace broker::detail {
+
+/// Checks whether `key` falls into the scan range `[first, last)`. A `nil`
+/// value for `last` selects all keys that have the same type as `first`.
+/// Scans never cross type boundaries.
+bool in_scan_range(const data& key, const data& first, const data& last);
+
+/// Computes the scan range `[first, last)` that selects all keys with given
+/// prefix. Supports strings (all strings that start with `prefix`) and subnets
+/// (all addresses in the subnet).
+expected<std::pair<data, data>> prefix_range(const data& prefix);
+
+/// Packs the result of a scan into a vector with two elements: a table with the
+/// selected entries plus the key for resuming the scan (`nil` if the scan
+/// returned all remaining entries).
+data make_scan_result(table entries, data cursor);
+
+/// An ordered index over the keys of a node-based map. The index only stores
+/// pointers to the keys and thus requires that keys never change their address
+/// while in the map. Owners build the index lazily on the first scan and keep
+/// it up to date afterwards.
+class key_index {
+public:
+  struct less {
+    using is_transparent = std::true_type;
+
+    bool operator()(const data* x, const data* y) const noexcept {
+      return *x < *y;
+    }
+
+    bool operator()(const data* x, const data& y) const noexcept {
+      return *x < y;
+    }
+
+    bool operator()(const data& x, const data* y) const noexcept {
+      return x < *y;
+    }
+  };
+
+  [[nodiscard]] bool enabled() const noexcept {
+    return enabled_;
+  }
+
+  /// Builds the index from all keys in `xs`.
+  template <class Map>
+  void enable(const Map& xs) {
+    keys_.clear();
+    for (const auto& kvp : xs)
+      keys_.emplace_hint(keys_.end(), &kvp.first);
+    enabled_ = true;
+  }
+
+  /// Drops the index, e.g., after replacing the content of the indexed map.
+  void disable() {
+    keys_.clear();
+    enabled_ = false;
+  }
+
+  /// Adds a new key to the index.
+  /// @pre `key` points into the indexed map
+  void insert(const data& key) {
+    if (enabled_)
+      keys_.emplace(&key);
+  }
+
+  /// Removes a key from the index.
+  /// @pre the indexed map still contains `key`
+  void erase(const data& key) {
+    if (enabled_)
+      if (auto i = keys_.find(key); i != keys_.end())
+        keys_.erase(i);
+  }
+
+  void clear() {
+    keys_.clear();
+  }
+
+  /// Calls `f` for up to `limit` keys in the range `[first, last)` in
+  /// ascending order. A `limit` of 0 selects no keys and ends the scan.
+  /// @returns the key for resuming the scan or `nil`.
+  template <class F>
+  data scan(const data& first, const data& last, count limit, F f) const {
+    if (limit == 0)
+      return data{};
+    for (auto i = keys_.lower_bound(first); i != keys_.end(); ++i) {
+      if (!in_scan_range(**i, first, last))
+        break;
+      if (limit-- == 0)
+        return **i;
+      f(**i);
+    }
+    return data{};
+  }
+
+private:
+  std::set<const data*, less> keys_;
+  bool enabled_ = false;
+};
+
+} // namespace broker::detail
@@ -6,12 +6,18 @@
 #include "broker/backend_options.hh"
 
 #include "broker/detail/abstract_backend.hh"
+#include "broker/detail/key_index.hh"
+#include "broker/detail/subnet_index.hh"
 
 namespace broker::detail {
 
 /// An in-memory key-value storage backend.
 class memory_backend : public abstract_backend {
 public:
+  /// Maps keys to their value and optional expiry.
+  using entry_map
+    = std::unordered_map<data, std::pair<data, std::optional<timestamp>>>;
+
   /// Constructs a memory backend.
   /// @param opts The options controlling the backend behavior.
   memory_backend(backend_options opts = backend_options{});
@@ -41,14 +47,28 @@ public:
 
   expected<data> keys() const override;
 
+  expected<data> scan(const data& first, const data& last,
+                      count limit) const override;
+
+  expected<data> lookup_containing(const address& addr) const override;
+
+  expected<data> covered_by(const subnet& net) const override;
+
   expected<broker::snapshot> snapshot() const override;
 
   expected<expirables> expiries() const override;
 
+  /// Grants read access to all entries without copying them.
+  const entry_map& entries() const noexcept {
+    return store_;
+  }
+
 private:
   backend_options options_;
-  std::unordered_map<data, std::pair<data, std::optional<timestamp>>> store_;
+  entry_map store_;
   std::unordered_map<data, timestamp> expirations_;
+  mutable key_index index_;
+  mutable subnet_index subnets_;
 };
 
 } // namespace broker::detail
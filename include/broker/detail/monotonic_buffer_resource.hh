@@ -11,7 +11,14 @@ namespace broker::detail {
 class monotonic_buffer_resource {
 public:
   monotonic_buffer_resource() {
-    allocate_block(nullptr);
+    allocate_block(nullptr, 0);
+  }
+
+  /// Constructs the resource with a first block that holds at least
+  /// `initial_size` bytes. Allows users that know the total size in advance to
+  /// serve all allocations from a single block.
+  explicit monotonic_buffer_resource(size_t initial_size) {
+    allocate_block(nullptr, initial_size);
   }
 
   monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
@@ -38,7 +45,7 @@ private:
     void* bytes;
   };
 
-  void allocate_block(block* prev_block);
+  void allocate_block(block* prev_block, size_t min_bytes);
 
   void destroy() noexcept;
 
@@ -48,6 +48,9 @@ public:
 
   expected<bool> expire(const data& key, timestamp current_time) override;
 
+  expected<std::vector<data>> expire_due(timestamp current_time,
+                                         size_t limit) override;
+
   expected<data> get(const data& key) const override;
 
   expected<bool> exists(const data& key) const override;
@@ -56,10 +59,15 @@ public:
 
   expected<data> keys() const override;
 
+  expected<data> scan(const data& first, const data& last,
+                      count limit) const override;
+
   expected<broker::snapshot> snapshot() const override;
 
   expected<expirables> expiries() const override;
 
+  bool has_expiry_index() const noexcept override;
+
   /// Run PRAGAMA command with an optional value.
   /// @param name The name of the PRAGMA to run.
   /// @param value An optional value for the PRAGMA.
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "broker/address.hh"
+#include "broker/data.hh"
+#include "broker/subnet.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace broker::detail {
+
+/// Returns the prefix length of `net` in the 128-bit address space, i.e.,
+/// including the offset of 96 bits for IPv4 subnets.
+uint8_t full_length(const subnet& net);
+
+/// Checks whether `x` is a subset of `y`.
+bool is_covered_by(const subnet& x, const subnet& y);
+
+/// A longest-prefix-match index over the subnet keys of a node-based map,
+/// implemented as a path-compressed binary trie (Patricia trie) over the 128
+/// bits of the network address. Like the @ref key_index, the index only stores
+/// pointers to the keys and thus requires that keys never change their address
+/// while in the map. Keys that are not subnets are ignored. Owners build the
+/// index lazily on the first lookup and keep it up to date afterwards.
+class subnet_index {
+public:
+  subnet_index();
+
+  subnet_index(subnet_index&&) noexcept;
+
+  subnet_index& operator=(subnet_index&&) noexcept;
+
+  ~subnet_index();
+
+  [[nodiscard]] bool enabled() const noexcept {
+    return enabled_;
+  }
+
+  /// Returns the number of subnets in the index.
+  [[nodiscard]] size_t size() const noexcept {
+    return size_;
+  }
+
+  /// Builds the index from all keys in `xs`.
+  template <class Map>
+  void enable(const Map& xs) {
+    clear();
+    enabled_ = true;
+    for (const auto& kvp : xs)
+      insert(kvp.first);
+  }
+
+  /// Drops the index, e.g., after replacing the content of the indexed map.
+  void disable() {
+    clear();
+    enabled_ = false;
+  }
+
+  /// Adds a new key to the index.
+  /// @pre `key` points into the indexed map
+  void insert(const data& key);
+
+  /// Removes a key from the index.
+  void erase(const data& key);
+
+  void clear();
+
+  /// Returns the most specific subnet that contains `addr` or `nullptr`.
+  [[nodiscard]] const data* longest_match(const address& addr) const;
+
+  /// Calls `f` for each subnet in the index that is a subset of `net`.
+  template <class F>
+  void covered_by(const subnet& net, F f) const {
+    auto [bits, len] = unpack(net);
+    if (auto* root = find_cover(bits, len))
+      visit(root, f);
+  }
+
+private:
+  using bits_type = std::array<uint8_t, 16>;
+
+  struct node {
+    bits_type bits;
+    uint8_t len;
+    const data* key;
+    std::unique_ptr<node> children[2];
+  };
+
+  /// Returns the 128-bit representation of a subnet, i.e., the bytes of the
+  /// network address plus the prefix length including the IPv4 offset.
+  static std::pair<bits_type, uint8_t> unpack(const subnet& net);
+
+  /// Returns the first node in the trie whose prefix has at least `len` bits
+  /// and starts with the first `len` bits in `bits`.
+  const node* find_cover(const bits_type& bits, uint8_t len) const;
+
+  template <class F>
+  static void visit(const node* ptr, F& f) {
+    if (ptr->key)
+      f(*ptr->key);
+    for (auto& child : ptr->children)
+      if (child)
+        visit(child.get(), f);
+  }
+
+  std::unique_ptr<node> root_;
+  size_t size_ = 0;
+  bool enabled_ = false;
+};
+
+} // namespace broker::detail
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "broker/backend_options.hh"
+#include "broker/detail/abstract_backend.hh"
+#include "broker/detail/memory_backend.hh"
+#include "broker/expected.hh"
+
+namespace broker::detail {
+
+/// An in-memory storage backend that persists all changes to a write-ahead log
+/// (WAL). The backend buffers log records and writes them to disk in groups,
+/// i.e., one write and sync per commit instead of one per operation. Once the
+/// log grows large enough, the backend writes a compacted snapshot of its
+/// state and starts a new log.
+///
+/// Writing a snapshot takes time proportional to the size of the state and
+/// blocks the caller, i.e., the master actor, for that time. Hence, the
+/// backend never compacts in its modifiers but only in `flush`, which the
+/// master calls once per tick. Since the log must grow at least as large as
+/// the previous snapshot, the backend writes at most one byte of snapshot per
+/// byte of log on average.
+///
+/// On startup, the backend maps the latest snapshot into memory and replays
+/// all logs that were written after the snapshot. A truncated or corrupted
+/// record, e.g., after a crash in the middle of a write, ends the replay of its
+/// log. The backend starts a new log on each startup and thus never appends to
+/// a log with a damaged record.
+class wal_backend : public abstract_backend {
+public:
+  /// Describes the layout of snapshot and log files. Both start with a header
+  /// (magic number, version and generation), followed by a sequence of
+  /// records. A record consists of a 32-bit size, a 32-bit checksum (FNV-1a)
+  /// and the serialized operation. All integers use the byte order of the
+  /// host. A snapshot with generation N contains all changes from logs with a
+  /// generation less than N.
+  struct format {
+    static constexpr uint32_t magic = 0x3AB1E70C;
+
+    static constexpr uint8_t version = 1;
+
+    static constexpr size_t header_size = sizeof(magic) + sizeof(version)
+                                          + sizeof(uint64_t);
+
+    static constexpr size_t record_header_size = 2 * sizeof(uint32_t);
+
+    /// Returns the file name of the snapshot.
+    static std::string snapshot_file_name(const std::string& directory);
+
+    /// Returns the file name of the log with given generation.
+    static std::string log_file_name(const std::string& directory,
+                                     uint64_t generation);
+  };
+
+  /// Constructs a WAL backend.
+  /// @param opts The options to create/open the backend.
+  /// Required parameters:
+  ///   - `path`: a `std::string` with the directory for the snapshot and log
+  ///             files.
+  /// Optional parameters:
+  ///   - `commit_interval`: a `broker::timespan` that limits how long the
+  ///                        backend may buffer changes before writing them
+  ///                        (default: 10ms).
+  ///   - `commit_bytes`: a `broker::count` that limits how many bytes the
+  ///                     backend may buffer before writing them (default:
+  ///                     1 MiB).
+  ///   - `compact_bytes`: a `broker::count` with the minimum log size before
+  ///                      the backend writes a new snapshot (default: 64 MiB).
+  ///                      The backend waits for the log to become at least as
+  ///                      large as the previous snapshot in any case.
+  ///   - `synchronous`: a `broker::boolean` that toggles whether each commit
+  ///                    waits for the OS to write the log to disk (default:
+  ///                    true).
+  wal_backend(backend_options opts = backend_options{});
+
+  ~wal_backend() override;
+
+  bool init_failed() const;
+
+  expected<void> put(const data& key, data value,
+                     std::optional<timestamp> expiry) override;
+
+  expected<void> add(const data& key, const data& value, data::type init_type,
+                     std::optional<timestamp> expiry) override;
+
+  expected<void> subtract(const data& key, const data& value,
+                          std::optional<timestamp> expiry) override;
+
+  expected<void> erase(const data& key) override;
+
+  expected<void> clear() override;
+
+  expected<bool> expire(const data& key, timestamp current_time) override;
+
+  expected<void> flush() override;
+
+  expected<data> get(const data& key) const override;
+
+  expected<data> get(const data& key, const data& value) const override;
+
+  expected<bool> exists(const data& key) const override;
+
+  expected<uint64_t> size() const override;
+
+  expected<data> keys() const override;
+
+  expected<data> scan(const data& first, const data& last,
+                      count limit) const override;
+
+  expected<data> lookup_containing(const address& addr) const override;
+
+  expected<data> covered_by(const subnet& net) const override;
+
+  expected<broker::snapshot> snapshot() const override;
+
+  expected<expirables> expiries() const override;
+
+  /// Writes a snapshot of the current state and starts a new log.
+  expected<void> compact();
+
+  /// Returns the generation of the current log.
+  uint64_t generation() const noexcept {
+    return generation_;
+  }
+
+private:
+  using clock_type = std::chrono::steady_clock;
+
+  /// Loads the snapshot and replays all logs.
+  bool load();
+
+  /// Applies all records in `fname` to the in-memory state and stores the
+  /// generation from the file header in `generation`. In strict mode, any
+  /// invalid record causes the replay to fail. Otherwise, the first invalid
+  /// record ends the replay.
+  bool replay(const std::string& fname, bool strict, uint64_t& generation,
+              size_t& file_size);
+
+  /// Creates the log for the current generation.
+  bool open_log();
+
+  /// Adds an operation to the buffer, applies it to the state by calling
+  /// `fn` and commits the buffer if necessary. Removes the operation from the
+  /// buffer again if `fn` fails.
+  template <class F, class... Ts>
+  expected<void> apply(F fn, uint8_t op, const Ts&... xs);
+
+  /// Adds an operation to the buffer without committing it.
+  template <class... Ts>
+  expected<void> stage(uint8_t op, const Ts&... xs);
+
+  /// Commits the buffer if it exceeds `commit_bytes_` or if its oldest
+  /// operation exceeds `commit_interval_`.
+  expected<void> commit_if_due();
+
+  /// Writes the buffer to the log.
+  expected<void> write_buffer();
+
+  backend_options options_;
+  std::string directory_;
+  memory_backend state_;
+  std::FILE* log_ = nullptr;
+  uint64_t first_generation_ = 0;
+  uint64_t generation_ = 0;
+  std::vector<std::byte> buf_;
+  std::optional<clock_type::time_point> first_pending_;
+  clock_type::duration commit_interval_ = clock_type::duration{0};
+  size_t commit_bytes_ = 0;
+  size_t compact_bytes_ = 0;
+  size_t log_size_ = 0;
+  size_t snapshot_size_ = 0;
+  bool synchronous_ = true;
+  bool failed_ = true;
+};
+
+} // namespace broker::detail
@@ -24,6 +24,7 @@
 #include "broker/message.hh"
 #include "broker/network_info.hh"
 #include "broker/peer_info.hh"
+#include "broker/publish_limit.hh"
 #include "broker/shutdown_options.hh"
 #include "broker/status.hh"
 #include "broker/status_subscriber.hh"
@@ -271,6 +272,16 @@ public:
 
   publisher make_publisher(topic ts);
 
+  /// Limits how many messages local publishers and clients may publish on
+  /// topics that start with `prefix`. The core drops messages that exceed the
+  /// limit and counts them in the metric
+  /// `broker-publish-limit-dropped-messages`. Replaces any previous limit for
+  /// `prefix`.
+  void set_publish_limit(topic prefix, publish_limit limit);
+
+  /// Removes the limit for `prefix`.
+  void clear_publish_limit(topic prefix);
+
   /// Starts a background worker from the given set of functions that publishes
   /// a series of messages. The worker will run in the background, but `init`
   /// is guaranteed to be called before the function returns.
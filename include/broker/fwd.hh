@@ -48,8 +48,12 @@ using publisher_id [[deprecated("use entity_id instead")]] = entity_id;
 // -- classes ------------------------------------------------------------------
 
 class address;
+class arena_data;
+class arena_message;
 class configuration;
 class data;
+class data_envelope;
+class data_view;
 class endpoint;
 class endpoint_id;
 class internal_command;
@@ -136,8 +140,8 @@ using routing_table = std::unordered_map<endpoint_id, routing_table_row>;
 
 namespace broker {
 
-using packed_message =
-  cow_tuple<packed_message_type, uint16_t, topic, std::vector<std::byte>>;
+using packed_message = cow_tuple<packed_message_type, uint16_t, topic,
+                                 std::vector<std::byte>, timestamp>;
 using command_message = cow_tuple<topic, internal_command>;
 using data_message = cow_tuple<topic, data>;
 using node_message = cow_tuple<endpoint_id, endpoint_id, packed_message>;
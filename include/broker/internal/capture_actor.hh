@@ -0,0 +1,65 @@
+#pragma once
+
+#include "broker/internal/capture_writer.hh"
+#include "broker/internal/fwd.hh"
+
+#include <caf/behavior.hpp>
+#include <caf/disposable.hpp>
+#include <caf/event_based_actor.hpp>
+#include <caf/stateful_actor.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace broker::internal {
+
+/// Counts the records that wait in the buffer between the core and the capture
+/// actor. The core drops records while the buffer is full instead of waiting
+/// for the capture actor, i.e., slow disk I/O never slows down the core.
+using capture_backlog_ptr = std::shared_ptr<std::atomic<size_t>>;
+
+/// Writes the node messages that the core selected for capturing to disk. The
+/// core spawns this actor as a detached actor, i.e., with its own thread, and
+/// connects it to the central merge point via a single-producer,
+/// single-consumer buffer. Hence, file I/O never blocks the core. The buffer
+/// is bounded by a @ref capture_backlog_ptr.
+class capture_state {
+public:
+  // -- constants --------------------------------------------------------------
+
+  static inline const char* name = "broker.capture";
+
+  // -- constructors and destructors -------------------------------------------
+
+  capture_state(caf::event_based_actor* self, capture_writer_ptr writer,
+                capture_consumer_res input, capture_backlog_ptr backlog);
+
+  ~capture_state();
+
+  // -- initialization ---------------------------------------------------------
+
+  /// Creates the initial set of message handlers for `self`.
+  caf::behavior make_behavior();
+
+  // -- properties -------------------------------------------------------------
+
+  /// Points to the actor itself.
+  caf::event_based_actor* self;
+
+  /// Writes the records to the segment files.
+  capture_writer_ptr writer;
+
+  /// Consumer end of the buffer that connects the core to this actor. Only
+  /// valid until calling `make_behavior`.
+  capture_consumer_res input_res;
+
+  /// Counts the records that the core has sent but we did not process yet.
+  capture_backlog_ptr backlog;
+
+  /// Allows the actor to stop reading from the core after an I/O error.
+  caf::disposable sub;
+};
+
+using capture_actor = caf::stateful_actor<capture_state>;
+
+} // namespace broker::internal
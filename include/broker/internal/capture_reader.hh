@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <caf/error.hpp>
+
+#include "broker/internal/capture_writer.hh"
+#include "broker/internal/mapped_file.hh"
+#include "broker/internal/wire_format.hh"
+
+namespace broker::internal {
+
+/// Reads the records of a capture in the order of the writer. The reader maps
+/// one segment at a time into memory.
+class capture_reader {
+public:
+  explicit capture_reader(std::string directory);
+
+  capture_reader(capture_reader&&) = delete;
+
+  capture_reader(const capture_reader&) = delete;
+
+  capture_reader& operator=(capture_reader&&) = delete;
+
+  capture_reader& operator=(const capture_reader&) = delete;
+
+  ~capture_reader();
+
+  /// Reads the next record from the capture.
+  /// @returns `ec::end_of_file` after reaching the end of the last segment.
+  caf::error read(capture_record& x);
+
+  /// Starts reading from the first segment again.
+  void rewind();
+
+  /// Returns the number of records read so far.
+  size_t records() const noexcept {
+    return records_;
+  }
+
+  const std::string& directory() const noexcept {
+    return directory_;
+  }
+
+private:
+  /// Maps the next segment into memory.
+  caf::error open_next_segment();
+
+  std::string directory_;
+  size_t next_segment_ = 0;
+  size_t records_ = 0;
+  mapped_file segment_;
+  size_t pos_ = 0;
+  wire_format::v1::trait trait_{true, nullptr};
+};
+
+using capture_reader_ptr = std::unique_ptr<capture_reader>;
+
+/// Creates a reader for the capture in `directory`.
+/// @returns a reader or `nullptr` if `directory` contains no valid capture.
+capture_reader_ptr make_capture_reader(const std::string& directory);
+
+} // namespace broker::internal
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <caf/byte_buffer.hpp>
+#include <caf/error.hpp>
+
+#include "broker/config.hh"
+#include "broker/internal/wire_format.hh"
+#include "broker/message.hh"
+#include "broker/time.hh"
+
+namespace broker::internal {
+
+/// A single node message in a capture together with the time when the core
+/// received it.
+struct capture_record {
+  timestamp captured;
+  node_message msg;
+};
+
+/// Writes node messages into a capture, i.e., a directory of fixed-size,
+/// memory-mapped segment files. Once a record no longer fits into the current
+/// segment, the writer truncates the segment to its actual size and continues
+/// with the next one.
+class capture_writer {
+public:
+  /// Describes the layout of a capture. Each segment starts with a header
+  /// (magic number + version), followed by a sequence of records. A record
+  /// consists of a 32-bit size, the capture time in nanoseconds since the
+  /// epoch and the node message in the wire format (including the origin
+  /// timestamp). All integers use the byte order of the host. A size of 0
+  /// marks the end of a segment that the writer did not close properly, e.g.,
+  /// after a crash.
+  struct format {
+    static constexpr uint32_t magic = 0x2EECCA97;
+
+    static constexpr uint8_t version = 1;
+
+    static constexpr size_t header_size = sizeof(magic) + sizeof(version);
+
+    static constexpr size_t record_header_size = sizeof(uint32_t)
+                                                 + sizeof(int64_t);
+
+    /// Returns the file name of the segment at position `index`.
+    static std::string segment_file_name(const std::string& directory,
+                                         size_t index);
+  };
+
+  capture_writer(std::string directory, size_t segment_size);
+
+  capture_writer(capture_writer&&) = delete;
+
+  capture_writer(const capture_writer&) = delete;
+
+  capture_writer& operator=(capture_writer&&) = delete;
+
+  capture_writer& operator=(const capture_writer&) = delete;
+
+  ~capture_writer();
+
+  /// Appends `msg` to the capture.
+  caf::error write(timestamp captured, const node_message& msg);
+
+  /// Asks the OS to write dirty pages of the current segment back to disk
+  /// without waiting for the I/O to complete.
+  caf::error flush();
+
+  /// Returns the number of records written so far.
+  size_t records() const noexcept {
+    return records_;
+  }
+
+  /// Returns the number of segments created so far.
+  size_t segments() const noexcept {
+    return next_segment_;
+  }
+
+  const std::string& directory() const noexcept {
+    return directory_;
+  }
+
+private:
+  /// Opens the next segment with room for at least `min_size` bytes of
+  /// records.
+  caf::error open_segment(size_t min_size);
+
+  /// Truncates the current segment to its actual size and closes it.
+  void close_segment();
+
+  std::string directory_;
+  size_t segment_size_;
+  size_t next_segment_ = 0;
+  size_t records_ = 0;
+  std::string file_name_;
+  std::byte* addr_ = nullptr;
+  size_t capacity_ = 0;
+  size_t pos_ = 0;
+#ifdef BROKER_WINDOWS
+  // On Windows, we fill the segment in memory and write it when closing it.
+  std::vector<std::byte> segment_buf_;
+#else
+  int fd_ = -1;
+#endif
+  caf::byte_buffer buf_;
+  wire_format::v1::trait trait_{true, nullptr};
+};
+
+using capture_writer_ptr = std::unique_ptr<capture_writer>;
+
+/// Creates a writer for a new capture in `directory`, creating the directory
+/// if necessary.
+/// @returns a writer or `nullptr` if `directory` is not accessible or already
+///          contains a capture.
+capture_writer_ptr make_capture_writer(const std::string& directory,
+                                       size_t segment_size);
+
+} // namespace broker::internal
@@ -13,6 +13,7 @@
 #include "broker/error.hh"
 #include "broker/internal/logger.hh"
 #include "broker/internal/metric_factory.hh"
+#include "broker/internal/trace.hh"
 #include "broker/lamport_timestamp.hh"
 #include "broker/none.hh"
 
@@ -243,6 +244,7 @@ public:
     }
 
     void handle_ack(const Handle& hdl, sequence_number_type seq) {
+      trace(trace_event::channel_ack, hdl, seq);
       sequence_number_type acked = seq;
       // Iterate all paths once, fetching minimum acknowledged sequence number
       // and updating the path belonging to `hdl` in one go.
@@ -279,6 +281,7 @@ public:
       // Sanity checks.
       if (seqs.empty())
         return;
+      trace(trace_event::channel_nack, hdl, seqs.size());
       // Nack 0 implicitly acts as a handshake.
       auto p = find_path(hdl);
       if (p == paths_.end()) {
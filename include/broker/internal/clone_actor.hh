@@ -8,11 +8,15 @@
 #include <caf/behavior.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/stateful_actor.hpp>
+#include <caf/telemetry/counter.hpp>
 
 #include "broker/data.hh"
+#include "broker/detail/key_index.hh"
+#include "broker/detail/subnet_index.hh"
 #include "broker/endpoint.hh"
 #include "broker/entity_id.hh"
 #include "broker/internal/store_actor.hh"
+#include "broker/internal/write_combiner.hh"
 #include "broker/internal_command.hh"
 #include "broker/topic.hh"
 
@@ -31,6 +35,17 @@ public:
   /// Callback for set_store;
   using on_set_store = std::function<void()>;
 
+  /// Bundles metrics for the clone.
+  struct metrics_t {
+    metrics_t(caf::actor_system& sys, const std::string& name) noexcept;
+
+    /// Counts the writes that entered the combining window.
+    caf::telemetry::int_counter* combiner_inputs = nullptr;
+
+    /// Counts the commands that left the combining window.
+    caf::telemetry::int_counter* combiner_outputs = nullptr;
+  };
+
   // -- initialization ---------------------------------------------------------
 
   clone_state(caf::event_based_actor* ptr, endpoint_id this_endpoint,
@@ -100,6 +115,19 @@ public:
   /// Returns all keys of the store.
   data keys() const;
 
+  /// Returns up to `limit` entries with keys in the range `[first, last)`.
+  /// @sa abstract_backend::scan
+  data scan(const data& first, const data& last, count limit);
+
+  /// Returns the entry with the most specific subnet key that contains `addr`
+  /// as a vector with key and value or `nil`.
+  /// @sa abstract_backend::lookup_containing
+  data lookup_containing(const address& addr);
+
+  /// Returns all entries with a subnet key that is a subset of `net`.
+  /// @sa abstract_backend::covered_by
+  data covered_by(const subnet& net);
+
   /// Sets the store content of the clone.
   void set_store(std::unordered_map<data, data> x);
 
@@ -143,12 +171,25 @@ public:
   /// `start_output` gets called.
   void send_to_master(internal_command_variant&& content);
 
+  /// Sends a write command to the master, either immediately or after
+  /// combining it with subsequent writes if `combine_interval` is positive.
+  void write(internal_command_variant&& content);
+
+  /// Forwards all writes in the combining window to the master.
+  void flush_writes();
+
   // -- member variables -------------------------------------------------------
 
   topic master_topic;
 
   std::unordered_map<data, data> store;
 
+  /// Orders the keys in `store` for range queries. Built on the first scan.
+  detail::key_index index;
+
+  /// Finds subnet keys in `store` by address. Built on the first lookup.
+  detail::subnet_index subnets;
+
   consumer_type input;
 
   std::optional<producer_type> output_opt;
@@ -177,6 +218,22 @@ public:
   /// operations before attaching the clone as a consumer.
   std::vector<internal_command_variant> stalled;
 
+  /// Merges successive writes to the same key before sending them to the
+  /// master.
+  write_combiner combiner;
+
+  /// Stores the maximum amount of time that a write may remain in `combiner`.
+  /// A value of 0 disables combining.
+  caf::timespan combine_interval;
+
+  /// Stores the maximum number of commands in `combiner`.
+  size_t combine_max_size;
+
+  /// Stores whether a flush of `combiner` is already scheduled.
+  bool combine_flush_scheduled = false;
+
+  metrics_t metrics;
+
   static inline constexpr const char* name = "broker.clone";
 };
 
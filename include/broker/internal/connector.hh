@@ -82,6 +82,13 @@ public:
 
   void run();
 
+  /// Sets the actor system for logging in additional connector threads (see
+  /// `broker_options::connector_threads`) and for exporting metrics. Must be
+  /// called before `run`.
+  void sys(caf::actor_system* ptr) noexcept {
+    sys_ = ptr;
+  }
+
 private:
   void run_impl(listener* sub, shared_filter_type* filter);
 
@@ -100,6 +107,7 @@ private:
   detail::shared_peer_status_map_ptr peer_statuses_;
   broker_options broker_cfg_;
   openssl_options_ptr ssl_cfg_;
+  caf::actor_system* sys_ = nullptr;
 };
 
 using connector_ptr = std::shared_ptr<connector>;
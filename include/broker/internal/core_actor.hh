@@ -5,12 +5,19 @@
 #include "broker/internal/connector_adapter.hh"
 #include "broker/internal/fwd.hh"
 #include "broker/internal/peering.hh"
+#include "broker/internal/priority_lanes.hh"
+#include "broker/internal/publish_limiter.hh"
+#include "broker/internal/type_id.hh"
 #include "broker/lamport_timestamp.hh"
 
+#include <caf/actor.hpp>
+#include <caf/actor_addr.hpp>
+#include <caf/actor_cast.hpp>
 #include <caf/disposable.hpp>
 #include <caf/flow/item_publisher.hpp>
 #include <caf/flow/observable.hpp>
 #include <caf/make_counted.hpp>
+#include <caf/send.hpp>
 #include <caf/telemetry/counter.hpp>
 #include <caf/telemetry/gauge.hpp>
 
@@ -98,6 +105,12 @@ public:
   template <class T>
   packed_message pack(const T& msg);
 
+  /// Returns the origin timestamp for a data message that enters the network
+  /// at this core: the current time if we collect latencies for its topic and
+  /// a default-constructed timestamp otherwise.
+  /// @private
+  timestamp origin_of(const data_message& msg);
+
   /// Deserializes a data or command message from the payload of `msg`.
   /// @private
   template <class T>
@@ -171,6 +184,17 @@ public:
                            const filter_type& filter,
                            const pending_connection_ptr& conn);
 
+  /// Spins up the dispatch shards and connects them to our central merge
+  /// point.
+  void init_dispatch_shards(size_t num_shards);
+
+  /// Returns the index of the dispatch shard with the least peers.
+  size_t next_dispatch_shard() const noexcept;
+
+  /// Spins up a capture actor that writes data and command messages to the
+  /// segment files in `directory`.
+  void init_capture(const std::string& directory);
+
   /// Connects the input and output buffers for a new client to our central
   /// merge point.
   caf::error init_new_client(const network_info& addr, const std::string& type,
@@ -180,9 +204,16 @@ public:
   // -- topic management -------------------------------------------------------
 
   /// Adds `what` to the local filter and also forwards the subscription to
-  /// connected peers.
+  /// connected peers. Each call increments the reference count of all topics in
+  /// `what` and must be matched by a call to `unsubscribe` once the subscriber
+  /// goes away.
   void subscribe(const filter_type& what);
 
+  /// Decrements the reference count of all topics in `what`. Removes topics
+  /// without remaining subscribers from the local filter and also retracts
+  /// them from connected peers.
+  void unsubscribe(const filter_type& what);
+
   // -- data store management --------------------------------------------------
 
   /// Returns whether a master for `name` probably exists already on one of our
@@ -206,12 +237,41 @@ public:
 
   // -- dispatching of messages ------------------------------------------------
 
+  /// Checks whether `msg` from a local publisher or client passes the publish
+  /// limits.
+  bool admit_publish(const data_message& msg);
+
+  /// Returns the publisher for messages that the core generates itself, i.e.,
+  /// `priority_inputs` for messages on the high lane if priority lanes are
+  /// enabled and `unsafe_inputs` otherwise.
+  caf::flow::item_publisher<node_message>& inputs_for(const node_message& msg);
+
+  /// Returns the publisher for input flows on given lane, i.e.,
+  /// `priority_flow_inputs` for the high lane if priority lanes are enabled
+  /// and `flow_inputs` otherwise.
+  caf::flow::item_publisher<caf::flow::observable<node_message>>&
+  flow_inputs_for(priority_lane lane);
+
   /// Dispatches `msg` to `receiver` regardless of its subscriptions.
-  /// @returns `true` on success, `false` if no peering to `receiver` exists.
-  void dispatch(endpoint_id receiver, const packed_message& msg);
+  /// @param origin The origin timestamp for the node message.
+  void dispatch(endpoint_id receiver, const packed_message& msg,
+                timestamp origin = timestamp{});
+
+  /// Broadcasts a change to the local subscriptions to all peers. Sends a
+  /// delta update to peers that accept them and a full update otherwise.
+  void broadcast_subscriptions(lamport_timestamp version,
+                               const filter_type& added,
+                               const filter_type& removed);
+
+  /// Sends the local subscriptions to `peer_id` as a full routing update.
+  void send_subscriptions(endpoint_id peer_id);
 
-  /// Broadcasts the local subscriptions to all peers.
-  void broadcast_subscriptions();
+  /// Asks `peer_id` for a full routing update after detecting a gap in the
+  /// versions of its routing updates. Does nothing while a request is pending.
+  void request_filter_resync(endpoint_id peer_id);
+
+  /// Returns a routing update with the local subscriptions.
+  packed_message make_full_routing_update();
 
   // -- unpeering --------------------------------------------------------------
 
@@ -233,6 +293,11 @@ public:
   /// with the connector, which needs access to the filter during handshake.
   shared_filter_ptr filter;
 
+  /// Counts how many local subscribers, stores and clients currently subscribe
+  /// to a topic. The local filter contains exactly the (non-internal) topics in
+  /// this map, reduced to a minimal set of prefixes.
+  std::unordered_map<topic, size_t> subscription_counts;
+
   /// Stores whether this peer disabled forwarding, i.e., only appears as leaf
   /// node to other peers.
   bool disable_forwarding = false;
@@ -250,6 +315,13 @@ public:
   /// Caches pointers to the Broker metrics.
   metrics_t metrics;
 
+  /// Observes end-to-end latencies if configured, `nullptr` otherwise.
+  latency_tracker_ptr latency;
+
+  /// Drops messages from local publishers and clients that exceed a publish
+  /// limit.
+  publish_limiter publish_limits;
+
   /// Stores all master actors created by this endpoint.
   std::unordered_map<std::string, caf::actor> masters;
 
@@ -264,7 +336,19 @@ public:
   /// Pushes flows into the central merge point.
   caf::flow::item_publisher<caf::flow::observable<node_message>> flow_inputs;
 
-  /// The output of `flow_inputs`.
+  /// Configures scheduling of control traffic ahead of bulk data.
+  priority_lanes lanes;
+
+  /// Like `unsafe_inputs`, but for messages on the high lane. Only connected
+  /// to the central merge point if priority lanes are enabled.
+  caf::flow::item_publisher<node_message> priority_inputs;
+
+  /// Like `flow_inputs`, but for flows on the high lane. Only connected to the
+  /// central merge point if priority lanes are enabled.
+  caf::flow::item_publisher<caf::flow::observable<node_message>>
+    priority_flow_inputs;
+
+  /// The output of `flow_inputs` and `priority_flow_inputs`.
   caf::flow::observable<node_message> central_merge;
 
   /// Pushes data messages into the flow.
@@ -279,6 +363,16 @@ public:
   /// Handles for aborting flows on unpeering.
   peer_state_map peers;
 
+  /// Background workers that select and forward messages to peers. Empty if
+  /// sharding is disabled, i.e., if the core dispatches to peers directly.
+  std::vector<caf::actor> dispatch_shards;
+
+  /// Stores how many peers each dispatch shard currently serves.
+  std::vector<size_t> dispatch_shard_loads;
+
+  /// Maps peers to the index of their dispatch shard.
+  std::unordered_map<endpoint_id, size_t> peer_shards;
+
   /// Synchronizes information about the current status of a peering with the
   /// connector.
   detail::shared_peer_status_map_ptr peer_statuses =
@@ -328,6 +422,35 @@ public:
                             }};
   }
 
+  /// Stores the filters of local subscribers with an active flow. This is a
+  /// pointer for the same reason as `local_subscriber_stats`.
+  std::shared_ptr<std::set<const filter_type*>> local_subscriber_filters =
+    std::make_shared<std::set<const filter_type*>>();
+
+  /// Returns a function object for adding instrumentation to flow that belongs
+  /// to a local subscriber with the filter `fptr`. Once the flow terminates,
+  /// the scope asks the core to unsubscribe from all topics in the filter.
+  /// Since scopes may get destroyed after the state object, the scope only
+  /// sends an asynchronous message to the actor.
+  auto local_subscriber_scope_adder(std::shared_ptr<filter_type> fptr) {
+    auto stats_ptr = std::make_shared<flow_scope_stats>();
+    auto stats_set = local_subscriber_stats;
+    stats_set->emplace(stats_ptr);
+    auto filters = local_subscriber_filters;
+    filters->emplace(fptr.get());
+    auto addr = self->address();
+    return add_flow_scope_t{stats_ptr, [stats_set, filters, addr, fptr](
+                                         const flow_scope_stats_ptr& ptr) {
+      stats_set->erase(ptr);
+      // Closing the scope turns late updates to the filter into no-ops.
+      filters->erase(fptr.get());
+      auto what = std::move(*fptr);
+      fptr->clear();
+      if (auto hdl = caf::actor_cast<caf::actor>(addr); hdl && !what.empty())
+        caf::anon_send(hdl, atom::unsubscribe_v, std::move(what));
+    }};
+  }
+
   /// Keeps track of statistics for local publishers. This is a pointer, because
   /// some scopes may get destroyed after the state object or while destroying
   /// the state.
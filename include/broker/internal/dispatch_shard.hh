@@ -0,0 +1,153 @@
+#pragma once
+
+#include "broker/endpoint_id.hh"
+#include "broker/filter_type.hh"
+#include "broker/internal/flow_scope.hh"
+#include "broker/internal/fwd.hh"
+#include "broker/internal/priority_lanes.hh"
+#include "broker/internal/routing_update.hh"
+#include "broker/message.hh"
+
+#include <caf/actor.hpp>
+#include <caf/actor_cast.hpp>
+#include <caf/behavior.hpp>
+#include <caf/disposable.hpp>
+#include <caf/event_based_actor.hpp>
+#include <caf/flow/observable.hpp>
+#include <caf/ref_counted.hpp>
+#include <caf/stateful_actor.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace broker::internal {
+
+/// Takes the per-peer output stage off the core actor. Each shard receives all
+/// messages from the central merge point of the core via a single-producer,
+/// single-consumer buffer and then selects and forwards messages for the
+/// subset of peers that the core assigned to it. Because every shard observes
+/// the central merge point in the same order, the order of messages per
+/// (sender, topic) remains the same as when dispatching in the core directly.
+class dispatch_shard_state {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Bundles the state for a single peer.
+  struct output_state {
+    /// Stores the subscriptions of the remote peer. The shard keeps its own
+    /// copy of the filter and updates it from the routing updates in the
+    /// input stream, i.e., the core never writes to this filter.
+    std::shared_ptr<filter_type> filter;
+
+    /// Keeps track of the version of `filter`. When the peer skips a version,
+    /// the shard asks the core to request a full update from the peer and
+    /// drops deltas until the full update arrives.
+    routing_update_state filter_state;
+
+    /// Allows the shard to cancel the output flow when unpeering.
+    caf::disposable sub;
+  };
+
+  // -- constants --------------------------------------------------------------
+
+  static inline const char* name = "broker.dispatch-shard";
+
+  // -- constructors and destructors -------------------------------------------
+
+  dispatch_shard_state(caf::event_based_actor* self, endpoint_id this_peer,
+                       bool disable_forwarding, node_consumer_res input,
+                       caf::actor core);
+
+  ~dispatch_shard_state();
+
+  // -- initialization ---------------------------------------------------------
+
+  /// Creates the initial set of message handlers for `self`.
+  caf::behavior make_behavior();
+
+  // -- peer management --------------------------------------------------------
+
+  /// Connects the output buffer for a new peer to the input of this shard.
+  void add_peer(endpoint_id peer_id, const filter_type& filter,
+                node_producer_res out_res, flow_scope_stats_ptr stats);
+
+  /// Cancels the output flow for the peer and drops its state.
+  void remove_peer(endpoint_id peer_id);
+
+  // -- routing ----------------------------------------------------------------
+
+  /// Applies a routing update from the input to the filter of its sender.
+  /// Ignores updates from peers of other shards.
+  void handle_routing_update(const node_message& msg);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Points to the actor itself.
+  caf::event_based_actor* self;
+
+  /// Identifies this endpoint in the network.
+  endpoint_id id;
+
+  /// Stores whether this endpoint disabled forwarding.
+  bool disable_forwarding;
+
+  /// Points to the core actor for reporting gaps in routing updates. Holds a
+  /// weak reference, because the core keeps strong references to its shards.
+  caf::weak_actor_ptr core;
+
+  /// Consumer end of the buffer that connects the core to this shard. Only
+  /// valid until calling `make_behavior`.
+  node_consumer_res input_res;
+
+  /// Multicasts the messages from the core to all peer outputs.
+  caf::flow::observable<node_message> input;
+
+  /// Configures scheduling of control traffic ahead of bulk data.
+  priority_lanes lanes;
+
+  /// Stores the output state for all peers that this shard is responsible for.
+  std::unordered_map<endpoint_id, output_state> outputs;
+};
+
+using dispatch_shard_actor = caf::stateful_actor<dispatch_shard_state>;
+
+/// Enables the @ref peering to cancel its output on a shard by sending an
+/// `unpeer` message to the shard.
+class dispatch_shard_disposer : public caf::ref_counted,
+                                public caf::disposable_impl {
+public:
+  dispatch_shard_disposer(caf::actor shard, endpoint_id peer_id)
+    : shard_(std::move(shard)), peer_id_(peer_id) {
+    // nop
+  }
+
+  void dispose() override;
+
+  bool disposed() const noexcept override {
+    return disposed_;
+  }
+
+  void ref_disposable() const noexcept override {
+    this->ref();
+  }
+
+  void deref_disposable() const noexcept override {
+    this->deref();
+  }
+
+  friend void intrusive_ptr_add_ref(const dispatch_shard_disposer* ptr) {
+    ptr->ref();
+  }
+
+  friend void intrusive_ptr_release(const dispatch_shard_disposer* ptr) {
+    ptr->deref();
+  }
+
+private:
+  bool disposed_ = false;
+  caf::actor shard_;
+  endpoint_id peer_id_;
+};
+
+} // namespace broker::internal
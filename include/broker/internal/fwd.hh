@@ -8,17 +8,25 @@ namespace broker::internal {
 
 enum class connector_event_id : uint64_t;
 
+struct capture_record;
+struct flow_scope_stats;
+struct peer_io_metrics;
 struct retry_state;
 
 class central_dispatcher;
 class flare_actor;
+class latency_tracker;
 class pending_connection;
 class unipath_manager;
 
+using capture_consumer_res = caf::async::consumer_resource<capture_record>;
+using capture_producer_res = caf::async::producer_resource<capture_record>;
 using command_consumer_res = caf::async::consumer_resource<command_message>;
 using command_producer_res = caf::async::producer_resource<command_message>;
 using data_consumer_res = caf::async::consumer_resource<data_message>;
 using data_producer_res = caf::async::producer_resource<data_message>;
+using flow_scope_stats_ptr = std::shared_ptr<flow_scope_stats>;
+using latency_tracker_ptr = std::shared_ptr<latency_tracker>;
 using node_consumer_res = caf::async::consumer_resource<node_message>;
 using node_producer_res = caf::async::producer_resource<node_message>;
 using pending_connection_ptr = std::shared_ptr<pending_connection>;
@@ -8,10 +8,9 @@
 
 #include <caf/binary_deserializer.hpp>
 
-#include "broker/config.hh"
-#include "broker/detail/native_socket.hh"
 #include "broker/fwd.hh"
 #include "broker/internal/data_generator.hh"
+#include "broker/internal/mapped_file.hh"
 #include "broker/topic.hh"
 
 namespace broker::internal {
@@ -20,21 +19,10 @@ class generator_file_reader {
 public:
   using value_type = std::variant<data_message, command_message>;
 
-  using mapper_handle = void*;
-
-  using mapped_pointer = void*;
-
-#ifdef BROKER_WINDOWS
-  using file_handle_type = void*;
-#else
-  using file_handle_type = detail::native_socket;
-#endif
-
   using read_raw_callback =
     std::function<bool(value_type*, caf::span<const caf::byte>)>;
 
-  generator_file_reader(file_handle_type fd, mapper_handle mapper,
-                        mapped_pointer addr, size_t file_size);
+  explicit generator_file_reader(mapped_file file);
 
   generator_file_reader(generator_file_reader&&) = delete;
 
@@ -78,10 +66,7 @@ public:
   }
 
 private:
-  file_handle_type fd_;
-  mapper_handle mapper_;
-  mapped_pointer addr_;
-  size_t file_size_;
+  mapped_file file_;
   caf::binary_deserializer source_;
   data_generator generator_;
   std::vector<topic> topic_table_;
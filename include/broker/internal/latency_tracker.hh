@@ -0,0 +1,93 @@
+#pragma once
+
+#include "broker/data.hh"
+#include "broker/internal/fwd.hh"
+#include "broker/message.hh"
+#include "broker/time.hh"
+#include "broker/topic.hh"
+
+#include <caf/fwd.hpp>
+#include <caf/telemetry/histogram.hpp>
+
+#include <string>
+#include <vector>
+
+namespace broker::internal {
+
+/// Observes end-to-end latencies of data messages for a configured set of
+/// topic prefixes. All latencies are relative to the origin timestamp of a
+/// message, i.e., the time when the message first entered a Broker core. For
+/// messages from remote peers, the latencies are only as accurate as the clock
+/// synchronization between the hosts. The histograms are thread-safe, which
+/// allows connections to observe latencies from their own thread.
+class latency_tracker {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using histogram_type = caf::telemetry::dbl_histogram;
+
+  /// Bundles the histograms for a single topic prefix.
+  struct histograms {
+    /// The topic prefix as configured by the user.
+    std::string prefix;
+
+    /// Time until a core receives the message from a peer.
+    histogram_type* publish_to_core = nullptr;
+
+    /// Time until a transport writes the message to a peer.
+    histogram_type* core_to_peer_write = nullptr;
+
+    /// Time until a core delivers the message to local subscribers.
+    histogram_type* publish_to_delivery = nullptr;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  latency_tracker(caf::telemetry::metric_registry& reg,
+                  const std::vector<std::string>& prefixes);
+
+  /// Creates a tracker for the topic prefixes in the configuration option
+  /// `broker.metrics.latency-prefixes`.
+  /// @returns a new tracker or `nullptr` if no prefix is configured.
+  static latency_tracker_ptr make(caf::actor_system& sys);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the histograms for the longest configured prefix of `t` or
+  /// `nullptr` if no prefix matches. Prefixes match topics like subscription
+  /// filters do, i.e., as in `topic::prefix_of`.
+  const histograms* find(const topic& t) const noexcept;
+
+  /// Checks whether the tracker observes messages for topic `t`.
+  bool tracks(const topic& t) const noexcept {
+    return find(t) != nullptr;
+  }
+
+  // -- observers --------------------------------------------------------------
+
+  void observe_publish_to_core(const node_message& msg) const {
+    observe(msg, &histograms::publish_to_core);
+  }
+
+  void observe_core_to_peer_write(const node_message& msg) const {
+    observe(msg, &histograms::core_to_peer_write);
+  }
+
+  void observe_publish_to_delivery(const node_message& msg) const {
+    observe(msg, &histograms::publish_to_delivery);
+  }
+
+  // -- introspection ----------------------------------------------------------
+
+  /// Renders the current state of all histograms for the status snapshot of
+  /// the core.
+  table snapshot() const;
+
+private:
+  void observe(const node_message& msg,
+               histogram_type* histograms::*member) const;
+
+  std::vector<histograms> entries_;
+};
+
+} // namespace broker::internal
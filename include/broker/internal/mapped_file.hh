@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <caf/error.hpp>
+#include <caf/span.hpp>
+
+#include "broker/config.hh"
+
+namespace broker::internal {
+
+/// Maps the content of a file into memory for read-only access.
+class mapped_file {
+public:
+  // -- member types -----------------------------------------------------------
+
+#ifdef BROKER_WINDOWS
+  using file_handle_type = void*;
+#else
+  using file_handle_type = int;
+#endif
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  mapped_file() noexcept = default;
+
+  mapped_file(mapped_file&& other) noexcept;
+
+  mapped_file(const mapped_file&) = delete;
+
+  mapped_file& operator=(mapped_file&& other) noexcept;
+
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file();
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns whether this object currently maps a file.
+  bool valid() const noexcept {
+    return addr_ != nullptr;
+  }
+
+  /// Returns the content of the mapped file.
+  caf::span<const caf::byte> bytes() const noexcept {
+    return {reinterpret_cast<const caf::byte*>(addr_), size_};
+  }
+
+  /// Returns the size of the mapped file in bytes.
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Maps the file `fname` into memory, closing any previously mapped file.
+  caf::error open(const std::string& fname);
+
+  /// Unmaps the file and closes the file handle.
+  void close() noexcept;
+
+private:
+  file_handle_type fd_ = file_handle_type{};
+  void* mapper_ = nullptr;
+  void* addr_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace broker::internal
@@ -74,6 +74,9 @@ public:
 
   void tick();
 
+  /// Removes due entries from backends with an expiry index.
+  void expire_due(timestamp t);
+
   void set_expire_time(const data& key, const std::optional<timespan>& expiry);
 
   // -- callbacks for the consumer ---------------------------------------------
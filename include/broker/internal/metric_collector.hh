@@ -1,6 +1,7 @@
 #pragma once
 
 #include <set>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -44,7 +45,8 @@ public:
 
     ~remote_metric() override;
 
-    virtual void update(metric_view mv) = 0;
+    /// Updates the value of this metric and returns whether it changed.
+    virtual bool update(metric_view mv) = 0;
 
     virtual void append_to(caf::telemetry::collector::prometheus&) = 0;
 
@@ -141,7 +143,14 @@ public:
   size_t insert_or_update(const std::string& endpoint_name, timestamp ts,
                           caf::span<const data> rows);
 
-  /// Returns the recorded metrics in the Prometheus text format.
+  /// Returns how many times the collector dropped delta-encoded metrics from
+  /// an endpoint because of a gap in the sequence numbers.
+  [[nodiscard]] size_t gaps() const noexcept {
+    return gaps_;
+  }
+
+  /// Returns the recorded metrics in the Prometheus text format. Only
+  /// re-renders metric families that changed since the last call.
   [[nodiscard]] std::string_view prometheus_text();
 
   void clear();
@@ -154,6 +163,10 @@ private:
     family_ptr family;
     /// The instances of the metric family, sorted by label values.
     std::set<instance_ptr, labels_less> instances;
+    /// Generates the Prometheus-formatted text for this family.
+    caf::telemetry::collector::prometheus generator;
+    /// Signals whether `generator` needs to render this family again.
+    bool dirty = true;
   };
 
   using name_map = std::unordered_map<std::string, metric_scope>;
@@ -165,6 +178,16 @@ private:
   /// Tries to advance the last-seen-time for given endpoint.
   bool advance_time(const std::string& endpoint_name, timestamp current_time);
 
+  /// Checks whether `ts` is not newer than the last-seen-time for given
+  /// endpoint.
+  bool is_stale(const std::string& endpoint_name, timestamp ts) const;
+
+  /// Checks whether the collector may apply delta-encoded metrics with given
+  /// sequence number. After detecting a gap, the collector drops all deltas
+  /// from the endpoint until receiving the next full state.
+  bool advance_sequence(const std::string& endpoint_name, uint64_t seq,
+                        bool full);
+
   // -- lookups ----------------------------------------------------------------
 
   /// Extracts the names for all label dimensions from `mv`.
@@ -174,8 +197,12 @@ private:
   void labels_for(const std::string& endpoint_name, metric_view mv,
                   label_view_list& result);
 
+  /// Retrieves or lazily creates the metric family for `mv`.
+  metric_scope& scope_for(metric_view mv);
+
   /// Retrieves or lazily creates a metric object for `mv`.
-  remote_metric* instance(const std::string& endpoint_name, metric_view mv);
+  remote_metric* instance(metric_scope& scope,
+                          const std::string& endpoint_name, metric_view mv);
 
   /// Caches labels (key/value pairs) for instance lookups.
   std::vector<caf::telemetry::label_view> labels_;
@@ -189,8 +216,15 @@ private:
   /// Stores last-seen-times by endpoints.
   std::unordered_map<std::string, timestamp> last_seen_;
 
-  /// Generates Prometheus-formatted text.
-  caf::telemetry::collector::prometheus generator_;
+  /// Stores the next expected sequence number by endpoints that use delta
+  /// encoding. Endpoints without an entry need to send their full state next.
+  std::unordered_map<std::string, uint64_t> next_seq_;
+
+  /// Counts how many times we have detected a gap in the sequence numbers.
+  size_t gaps_ = 0;
+
+  /// Stores the Prometheus-formatted text for all metric families.
+  std::string text_;
 
   /// Caches the string "endpoint" as a broker::data instance. Having this as a
   /// member avoids constructing this object each time in `labels_for`.
@@ -26,6 +26,7 @@ namespace broker::internal {
 struct metric_exporter_params {
   std::vector<std::string> selected_prefixes;
   caf::timespan interval = caf::timespan{0};
+  caf::timespan full_interval = caf::timespan{0};
   topic target;
   std::string id;
   static metric_exporter_params from(const caf::actor_system_config& cfg);
@@ -41,14 +42,16 @@ public:
 
   metric_exporter_state(Self* self, caf::actor core,
                         std::vector<std::string> selected_prefixes,
-                        caf::timespan interval, topic target, std::string id)
+                        caf::timespan interval, topic target, std::string id,
+                        caf::timespan full_interval = caf::timespan{0})
     : self(self),
       core(std::move(core)),
       interval(interval),
+      full_interval(full_interval),
       target(std::move(target)),
       proc_importer(self->system().metrics()),
       impl(std::move(selected_prefixes), std::move(id)) {
-    // nop
+    impl.delta_encoding(full_interval.count() > 0);
   }
 
   metric_exporter_state(Self* self, caf::actor core,
@@ -56,7 +59,7 @@ public:
     : metric_exporter_state(self, std::move(core),
                             std::move(params.selected_prefixes),
                             params.interval, std::move(params.target),
-                            std::move(params.id)) {
+                            std::move(params.id), params.full_interval) {
     // nop
   }
 
@@ -75,7 +78,14 @@ public:
       [this](caf::tick_atom) {
         if (running_) {
           proc_importer.update();
-          impl.scrape(self->system().metrics());
+          // With delta encoding, we only publish the full state once per
+          // `full_interval` and otherwise only the metrics that changed.
+          if (auto now = self->clock().now(); now < next_full) {
+            impl.scrape_changes(self->system().metrics());
+          } else {
+            impl.scrape(self->system().metrics());
+            next_full = now + full_interval;
+          }
           // Send nothing if we only have meta data (or nothing) to send.
           if (const auto& rows = impl.rows(); rows.size() > 1)
             self->send(core, atom::publish_v, make_data_message(target, rows));
@@ -171,9 +181,16 @@ public:
   /// Configures how frequent the exporter collects metrics from the system.
   caf::timespan interval;
 
+  /// Configures how frequent the exporter publishes all metrics when using
+  /// delta encoding. A value of zero disables delta encoding.
+  caf::timespan full_interval;
+
   /// Caches the time point of our initialization for scheduling ticks.
   caf::actor_clock::time_point tick_init;
 
+  /// Stores when the exporter needs to publish all metrics again.
+  caf::actor_clock::time_point next_full;
+
   /// Configures the topic for periodically publishing scrape results to.
   topic target;
 
@@ -96,6 +96,171 @@ public:
     /// Returns all instances of `broker.buffered-messages`.
     buffered_messages_t buffered_messages_instances();
 
+    /// Counts the write operations on the socket of a peer. The transport
+    /// writes all pending messages with a single operation, so the ratio to
+    /// `broker.peer-written-messages` shows the effect of write batching.
+    ///
+    /// Label dimensions: `endpoint` (ID of the peer).
+    int_counter_family* peer_writes_family();
+
+    /// Returns an instance of `broker.peer-writes` for the given peer.
+    int_counter* peer_writes_instance(std::string_view peer);
+
+    /// Counts how many messages Broker has handed to the transport of a peer.
+    ///
+    /// Label dimensions: `endpoint` (ID of the peer).
+    int_counter_family* peer_written_messages_family();
+
+    /// Returns an instance of `broker.peer-written-messages` for the given
+    /// peer.
+    int_counter* peer_written_messages_instance(std::string_view peer);
+
+    /// Counts the read operations on the socket of a peer.
+    ///
+    /// Label dimensions: `endpoint` (ID of the peer).
+    int_counter_family* peer_reads_family();
+
+    /// Returns an instance of `broker.peer-reads` for the given peer.
+    int_counter* peer_reads_instance(std::string_view peer);
+
+    /// Counts how many messages Broker has received from a peer.
+    ///
+    /// Label dimensions: `endpoint` (ID of the peer).
+    int_counter_family* peer_read_messages_family();
+
+    /// Returns an instance of `broker.peer-read-messages` for the given peer.
+    int_counter* peer_read_messages_instance(std::string_view peer);
+
+    /// Counts how many messages currently wait in priority stages, i.e., at
+    /// the merge point of the core and at peer writers.
+    ///
+    /// Label dimensions: `lane` ('high' or 'bulk').
+    int_gauge_family* priority_lane_queued_messages_family();
+
+    struct priority_lane_queued_messages_t {
+      int_gauge* high;
+      int_gauge* bulk;
+    };
+
+    /// Returns all instances of `broker.priority-lane-queued-messages`.
+    priority_lane_queued_messages_t priority_lane_queued_messages_instances();
+
+    /// Counts how many messages have passed through priority stages.
+    ///
+    /// Label dimensions: `lane` ('high' or 'bulk').
+    int_counter_family* priority_lane_processed_messages_family();
+
+    struct priority_lane_processed_messages_t {
+      int_counter* high;
+      int_counter* bulk;
+    };
+
+    /// Returns all instances of `broker.priority-lane-processed-messages`.
+    priority_lane_processed_messages_t
+    priority_lane_processed_messages_instances();
+
+    /// Counts how many messages from local publishers and clients passed a
+    /// publish limit.
+    ///
+    /// Label dimensions: `prefix` (topic prefix of the policy).
+    int_counter_family* publish_limit_accepted_messages_family();
+
+    /// Returns an instance of `broker.publish-limit-accepted-messages` for the
+    /// given topic prefix.
+    int_counter*
+    publish_limit_accepted_messages_instance(std::string_view prefix);
+
+    /// Counts how many messages from local publishers and clients Broker has
+    /// dropped for exceeding a publish limit.
+    ///
+    /// Label dimensions: `prefix` (topic prefix of the policy), `reason`
+    /// ('rate', 'sample' or 'drop').
+    int_counter_family* publish_limit_dropped_messages_family();
+
+    struct publish_limit_dropped_messages_t {
+      int_counter* rate;
+      int_counter* sample;
+      int_counter* drop;
+    };
+
+    /// Returns all instances of `broker.publish-limit-dropped-messages` for
+    /// the given topic prefix.
+    publish_limit_dropped_messages_t
+    publish_limit_dropped_messages_instances(std::string_view prefix);
+
+    /// Reports the configured rate limit in messages per second.
+    ///
+    /// Label dimensions: `prefix` (topic prefix of the policy).
+    dbl_gauge_family* publish_limit_rate_family();
+
+    /// Returns an instance of `broker.publish-limit-rate` for the given topic
+    /// prefix.
+    dbl_gauge* publish_limit_rate_instance(std::string_view prefix);
+
+    /// Measures the time between the origin of a data message and its arrival
+    /// at the core of a receiving peer.
+    ///
+    /// Label dimensions: `prefix` (configured topic prefix).
+    dbl_histogram_family* publish_to_core_latency_family();
+
+    /// Returns an instance of `broker.publish-to-core-latency` for the given
+    /// topic prefix.
+    dbl_histogram* publish_to_core_latency_instance(std::string_view prefix);
+
+    /// Measures the time between the origin of a data message and writing it
+    /// to the transport of a peer.
+    ///
+    /// Label dimensions: `prefix` (configured topic prefix).
+    dbl_histogram_family* core_to_peer_write_latency_family();
+
+    /// Returns an instance of `broker.core-to-peer-write-latency` for the
+    /// given topic prefix.
+    dbl_histogram* core_to_peer_write_latency_instance(std::string_view prefix);
+
+    /// Measures the time between the origin of a data message and delivering
+    /// it to local subscribers.
+    ///
+    /// Label dimensions: `prefix` (configured topic prefix).
+    dbl_histogram_family* publish_to_delivery_latency_family();
+
+    /// Returns an instance of `broker.publish-to-delivery-latency` for the
+    /// given topic prefix.
+    dbl_histogram*
+    publish_to_delivery_latency_instance(std::string_view prefix);
+
+    /// Counts how many TLS handshakes the connector has completed for
+    /// peerings.
+    ///
+    /// Label dimensions: `type` ('full' or 'resumed').
+    int_counter_family* tls_handshakes_family();
+
+    struct tls_handshakes_t {
+      int_counter* full;
+      int_counter* resumed;
+    };
+
+    /// Returns all instances of `broker.tls-handshakes`.
+    tls_handshakes_t tls_handshakes_instances();
+
+    /// Measures how long TLS handshakes for peerings take, i.e., the time
+    /// between sending or receiving the first and the last TLS handshake
+    /// message.
+    ///
+    /// Label dimensions: `type` ('full' or 'resumed').
+    dbl_histogram_family* tls_handshake_duration_family();
+
+    struct tls_handshake_duration_t {
+      dbl_histogram* full;
+      dbl_histogram* resumed;
+    };
+
+    /// Returns all instances of `broker.tls-handshake-duration`.
+    tls_handshake_duration_t tls_handshake_duration_instances();
+
+    /// Counts how many messages the core dropped instead of capturing them,
+    /// because the buffer to the capture actor was full.
+    int_counter* capture_dropped_messages_instance();
+
   private:
     caf::telemetry::metric_registry* reg_;
   };
@@ -151,6 +316,21 @@ public:
     /// given data store.
     int_gauge* unacknowledged_updates_instance(std::string_view name);
 
+    /// Counts how many writes entered the combining window of a clone.
+    int_counter_family* combiner_inputs_family();
+
+    /// Returns an instance of `broker.store-combiner-inputs` for the given
+    /// data store.
+    int_counter* combiner_inputs_instance(std::string_view name);
+
+    /// Counts how many commands a clone forwarded to its master after
+    /// combining writes.
+    int_counter_family* combiner_outputs_family();
+
+    /// Returns an instance of `broker.store-combiner-outputs` for the given
+    /// data store.
+    int_counter* combiner_outputs_instance(std::string_view name);
+
   private:
     caf::telemetry::metric_registry* reg_;
   };
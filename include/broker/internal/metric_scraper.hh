@@ -5,6 +5,9 @@
 
 #include <caf/telemetry/metric_registry.hpp>
 
+#include <cstdint>
+#include <unordered_map>
+
 namespace broker::internal {
 
 /// Scrapes local CAF metrics and encodes them into `data` objects (for
@@ -43,6 +46,16 @@ public:
     return rows_;
   }
 
+  [[nodiscard]] bool delta_encoding() const noexcept {
+    return delta_encoding_;
+  }
+
+  /// Enables or disables delta encoding. With delta encoding, the meta data
+  /// row carries two additional fields: a sequence number and a flag that
+  /// signals whether the rows contain all metrics or only the metrics that
+  /// changed since the previous scrape.
+  void delta_encoding(bool value);
+
   /// Checks whether `selected_prefixes` is empty (an empty filter means *select
   /// all*) or `family->prefix()` is in `selected_prefixes`.
   bool selected(const caf::telemetry::metric_family* family);
@@ -53,6 +66,10 @@ public:
   /// data structure and stores the result in `rows`.
   void scrape(caf::telemetry::metric_registry& registry);
 
+  /// Like `scrape`, but only encodes metrics that changed since the last
+  /// scrape. Falls back to `scrape` if delta encoding is disabled.
+  void scrape_changes(caf::telemetry::metric_registry& registry);
+
   void operator()(const caf::telemetry::metric_family* family,
                   const caf::telemetry::metric* instance,
                   const caf::telemetry::dbl_counter* counter);
@@ -86,6 +103,12 @@ public:
 private:
   // -- private utility --------------------------------------------------------
 
+  void scrape(caf::telemetry::metric_registry& registry, bool full);
+
+  /// Checks whether `value` differs from the last value of `instance` and
+  /// stores the new value. Always returns `true` for full scrapes.
+  bool changed(const caf::telemetry::metric* instance, const data& value);
+
   /// Encodes a single metric as a row in our output vector.
   template <class T>
   void add_row(const caf::telemetry::metric_family* family, std::string type,
@@ -106,8 +129,21 @@ private:
   std::string id_;
 
   /// Contains the result for the last scraping run as data rows. The first row
-  /// is reserved for meta data (scraper ID plus timestamp).
+  /// is reserved for meta data (scraper ID plus timestamp and, with delta
+  /// encoding, a sequence number plus a flag for full scrapes).
   vector rows_;
+
+  /// Configures whether `scrape_changes` skips unchanged metrics.
+  bool delta_encoding_ = false;
+
+  /// Stores whether the current scrape includes all metrics.
+  bool full_ = true;
+
+  /// Sequence number for the next non-empty scrape with delta encoding.
+  uint64_t seq_ = 0;
+
+  /// Stores the last encoded value per metric instance for delta encoding.
+  std::unordered_map<const caf::telemetry::metric*, data> last_values_;
 };
 
 } // namespace broker::internal
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "broker/defaults.hh"
+#include "broker/endpoint_id.hh"
+
+#include <caf/byte.hpp>
+#include <caf/byte_buffer.hpp>
+#include <caf/fwd.hpp>
+#include <caf/net/stream_socket.hpp>
+#include <caf/span.hpp>
+#include <caf/telemetry/counter.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace broker::internal {
+
+/// Bundles the configuration and the instrumentation for the socket I/O of a
+/// connection to a peer.
+struct peer_io_metrics {
+  /// Maximum number of bytes per read from the socket. Reading ahead allows the
+  /// transport to parse all frames that arrived in the meantime with a single
+  /// read instead of reading each header and payload separately.
+  size_t read_ahead = defaults::peering::read_ahead;
+
+  /// Counts the write operations on the socket.
+  caf::telemetry::int_counter* writes = nullptr;
+
+  /// Counts the read operations on the socket.
+  caf::telemetry::int_counter* reads = nullptr;
+
+  /// Counts the messages received from the peer.
+  caf::telemetry::int_counter* read_messages = nullptr;
+
+  /// Reads the configuration from `sys` and fetches the metric instances for
+  /// `peer_id`.
+  static peer_io_metrics make(caf::actor_system& sys, endpoint_id peer_id);
+};
+
+/// Wraps a transport policy for counting the read and write operations on the
+/// socket. Also reads ahead into an internal buffer. The transport calls
+/// `buffered()` after each read and then picks up all pending bytes, i.e., it
+/// processes all frames in the buffer before returning to the multiplexer.
+template <class Policy>
+class peer_io_policy : public Policy {
+public:
+  peer_io_policy(Policy base, peer_io_metrics metrics)
+    : Policy(std::move(base)), metrics_(metrics) {
+    // nop
+  }
+
+  ptrdiff_t write(caf::net::stream_socket x, caf::span<const caf::byte> buf) {
+    if (metrics_.writes)
+      metrics_.writes->inc();
+    return Policy::write(x, buf);
+  }
+
+  ptrdiff_t read(caf::net::stream_socket x, caf::span<caf::byte> buf) {
+    if (buf.empty())
+      return 0;
+    if (rd_pos_ == rd_buf_.size() && buf.size() < metrics_.read_ahead) {
+      // Fill our buffer with a single read and serve from it afterwards.
+      rd_buf_.resize(metrics_.read_ahead);
+      auto res = do_read(x, caf::make_span(rd_buf_));
+      rd_buf_.resize(res > 0 ? static_cast<size_t>(res) : 0u);
+      rd_pos_ = 0;
+      if (res <= 0)
+        return res;
+    }
+    if (rd_pos_ < rd_buf_.size()) {
+      auto n = std::min(buf.size(), rd_buf_.size() - rd_pos_);
+      memcpy(buf.data(), rd_buf_.data() + rd_pos_, n);
+      rd_pos_ += n;
+      return static_cast<ptrdiff_t>(n);
+    }
+    return do_read(x, buf);
+  }
+
+  size_t buffered() const noexcept {
+    return (rd_buf_.size() - rd_pos_) + Policy::buffered();
+  }
+
+private:
+  ptrdiff_t do_read(caf::net::stream_socket x, caf::span<caf::byte> buf) {
+    if (metrics_.reads)
+      metrics_.reads->inc();
+    return Policy::read(x, buf);
+  }
+
+  peer_io_metrics metrics_;
+  caf::byte_buffer rd_buf_;
+  size_t rd_pos_ = 0;
+};
+
+} // namespace broker::internal
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "broker/endpoint_id.hh"
+#include "broker/filter_type.hh"
+#include "broker/message.hh"
+
+#include <caf/flow/observable.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace broker::internal {
+
+/// Selects the messages that an endpoint forwards to one of its peers and
+/// rewrites their sender field. The core and the dispatch shards both use this
+/// stage for their per-peer outputs.
+struct peer_selection {
+  /// Identifies this endpoint in the network.
+  endpoint_id this_peer;
+
+  /// Identifies the receiving peer.
+  endpoint_id peer;
+
+  /// Stores whether this endpoint disabled forwarding.
+  bool disable_forwarding = false;
+
+  /// Stores the subscriptions of the receiving peer.
+  std::shared_ptr<filter_type> filter;
+
+  /// Returns whether the peer receives `msg` based on the sender and receiver
+  /// fields and on the subscriptions of the peer.
+  bool selects(const node_message& msg) const;
+
+  /// Overrides the sender field of `msg`. This makes sure the sender field
+  /// always reflects the last hop. Since we only need this information to
+  /// avoid forwarding loops, "sender" really just means "last hop" right now.
+  node_message rewrite(const node_message& msg) const;
+};
+
+/// Utility class for applying a @ref peer_selection to an `observable`.
+struct add_peer_selection_t {
+  peer_selection sel;
+
+  explicit add_peer_selection_t(peer_selection sel) : sel(std::move(sel)) {
+    // nop
+  }
+
+  template <class Observable>
+  caf::flow::observable<node_message> operator()(Observable&& input) const {
+    return std::forward<Observable>(input)
+      .filter([sel = sel](const node_message& msg) { return sel.selects(msg); })
+      .map([sel = sel](const node_message& msg) { return sel.rewrite(msg); })
+      .as_observable();
+  }
+};
+
+} // namespace broker::internal
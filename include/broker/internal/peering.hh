@@ -6,6 +6,7 @@
 #include "broker/internal/connector_adapter.hh"
 #include "broker/internal/flow_scope.hh"
 #include "broker/internal/fwd.hh"
+#include "broker/internal/routing_update.hh"
 
 #include <caf/disposable.hpp>
 #include <caf/flow/item_publisher.hpp>
@@ -54,6 +55,12 @@ public:
   setup(caf::scheduled_actor* self, node_consumer_res in_res,
         node_producer_res out_res, caf::flow::observable<node_message> src);
 
+  /// Sets up the input pipeline for this peer when a dispatch shard manages
+  /// the output to the peer. The peering cancels the output via `out`.
+  caf::flow::observable<node_message>
+  setup(caf::scheduled_actor* self, node_consumer_res in_res,
+        caf::disposable out);
+
   /// Queries whether `remove` was called.
   bool removed() const noexcept {
     return removed_;
@@ -98,6 +105,14 @@ public:
     *filter_ = std::move(new_filter);
   }
 
+  /// Applies a routing update from the peer to its filter.
+  routing_update_result handle_routing_update(const node_message& msg);
+
+  /// Returns what we know about the filter version of the peer.
+  routing_update_state& filter_state() noexcept {
+    return filter_state_;
+  }
+
   /// Returns a status object that keeps track of input messages from the peer.
   flow_scope_stats_ptr input_stats() const {
     return input_stats_;
@@ -109,6 +124,11 @@ public:
   }
 
 private:
+  /// Creates the input pipeline that surrounds the messages from the peer with
+  /// connect/disconnect status messages.
+  caf::flow::observable<node_message> setup_input(caf::scheduled_actor* self,
+                                                  node_consumer_res in_res);
+
   /// Indicates whether we have explicitly removed this connection by sending a
   /// BYE message to the peer.
   bool removed_ = false;
@@ -119,6 +139,9 @@ private:
   /// Stores the subscriptions of the remote peer.
   std::shared_ptr<filter_type> filter_;
 
+  /// Keeps track of the version of `filter_`.
+  routing_update_state filter_state_;
+
   /// Handle for aborting inputs.
   caf::disposable in_;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "broker/fwd.hh"
+#include "broker/internal/fwd.hh"
 
 #include <caf/async/fwd.hpp>
 #include <caf/fwd.hpp>
@@ -19,9 +20,12 @@ public:
   /// @param sys the actor system with the network manager.
   /// @param pull The resource where the connection pulls data from.
   /// @param push The resource where the connection pushes data to.
+  /// @param latency Observes the latency of outgoing messages (optional).
+  /// @param io Configures and counts the socket I/O.
   virtual caf::error run(caf::actor_system& sys,
                          caf::async::consumer_resource<node_message> pull,
-                         caf::async::producer_resource<node_message> push) = 0;
+                         caf::async::producer_resource<node_message> push,
+                         latency_tracker_ptr latency, peer_io_metrics io) = 0;
 };
 
 /// @relates pending_connection
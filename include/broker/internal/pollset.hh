@@ -0,0 +1,202 @@
+#pragma once
+
+#include "broker/detail/native_socket.hh"
+#include "broker/internal/logger.hh"
+
+#include <caf/config.hpp>
+#include <caf/net/socket.hpp>
+#include <caf/net/socket_id.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// clang-format off
+#ifdef CAF_WINDOWS
+#  include <winsock2.h>
+#else
+#  include <poll.h>
+#endif // CAF_WINDOWS
+#ifdef CAF_LINUX
+#  include <cerrno>
+#  include <sys/epoll.h>
+#endif // CAF_LINUX
+// clang-format on
+
+namespace broker::internal {
+
+/// Multiplexes sockets with `poll()`. Handlers modify the event mask of an
+/// entry directly. Clearing the mask removes the entry in the next cycle.
+class poll_backend {
+public:
+  /// Returns the entry for `fd` or `nullptr`.
+  pollfd* find(caf::net::socket_id fd) {
+    if (auto i = index_.find(fd); i != index_.end()) {
+      if (i->second < fdset_.size())
+        return std::addressof(fdset_[i->second]);
+      return std::addressof(pending_[i->second - fdset_.size()]);
+    }
+    return nullptr;
+  }
+
+  /// Adds an entry for `fd`. We cannot add elements to the pollset while
+  /// iterating it, so the entry becomes active in the next cycle.
+  void add(caf::net::socket_id fd, short events) {
+    index_[fd] = fdset_.size() + pending_.size();
+    pending_.push_back(pollfd{fd, events, 0});
+  }
+
+  /// Returns the number of active entries.
+  size_t size() const noexcept {
+    return fdset_.size();
+  }
+
+  /// Waits until at least one socket becomes ready or until `timeout`
+  /// milliseconds have passed and calls `f` for each entry with activity.
+  template <class F>
+  void wait(int timeout, F&& f) {
+    int presult =
+#ifdef CAF_WINDOWS
+      ::WSAPoll(fdset_.data(), static_cast<ULONG>(fdset_.size()), timeout);
+#else
+      ::poll(fdset_.data(), static_cast<nfds_t>(fdset_.size()), timeout);
+#endif
+    BROKER_DEBUG("poll on" << fdset_.size() << "sockets returned" << presult);
+    if (presult < 0) {
+      if (caf::net::last_socket_error() != std::errc::interrupted) {
+        BROKER_ERROR("poll() failed");
+        throw std::runtime_error("poll() failed");
+      }
+      return;
+    }
+    for (size_t i = 0; presult > 0 && i < fdset_.size(); ++i) {
+      if (fdset_[i].revents != 0) {
+        --presult;
+        f(fdset_[i]);
+      }
+    }
+  }
+
+  /// Drops entries without events and activates entries added via `add`.
+  void prepare_next_cycle();
+
+private:
+  /// Our pollset.
+  std::vector<pollfd> fdset_;
+
+  /// Stores new entries until the next cycle.
+  std::vector<pollfd> pending_;
+
+  /// Maps socket IDs to their position in `fdset_`, followed by `pending_`.
+  std::unordered_map<caf::net::socket_id, size_t> index_;
+};
+
+#ifdef CAF_LINUX
+
+/// Multiplexes sockets with `epoll`. Offers the same interface as
+/// `poll_backend`, but the cost of each cycle only depends on the number of
+/// ready sockets rather than on the number of pending handshakes.
+class epoll_backend {
+public:
+  epoll_backend();
+
+  epoll_backend(const epoll_backend&) = delete;
+
+  epoll_backend& operator=(const epoll_backend&) = delete;
+
+  ~epoll_backend();
+
+  /// Returns the entry for `fd` or `nullptr`.
+  pollfd* find(caf::net::socket_id fd) {
+    if (auto i = entries_.find(fd); i != entries_.end()) {
+      changed_.push_back(fd);
+      return std::addressof(i->second.pfd);
+    }
+    return nullptr;
+  }
+
+  /// Adds an entry for `fd`. The entry becomes active in the next cycle.
+  /// Replaces the entire entry if `fd` is still known from a previous socket,
+  /// because the OS may re-use the ID of a closed socket.
+  void add(caf::net::socket_id fd, short events) {
+    entries_[fd] = entry{pollfd{fd, events, 0}, 0};
+    changed_.push_back(fd);
+  }
+
+  /// Returns the number of entries.
+  size_t size() const noexcept {
+    return entries_.size();
+  }
+
+  /// Waits until at least one socket becomes ready or until `timeout`
+  /// milliseconds have passed and calls `f` for each entry with activity.
+  template <class F>
+  void wait(int timeout, F&& f) {
+    auto presult = ::epoll_wait(epfd_, events_.data(),
+                                static_cast<int>(events_.size()), timeout);
+    BROKER_DEBUG("epoll_wait on" << entries_.size() << "sockets returned"
+                                 << presult);
+    if (presult < 0) {
+      if (errno != EINTR) {
+        BROKER_ERROR("epoll_wait() failed");
+        throw std::runtime_error("epoll_wait() failed");
+      }
+      return;
+    }
+    for (int i = 0; i < presult; ++i) {
+      auto fd = events_[i].data.fd;
+      auto j = entries_.find(fd);
+      if (j == entries_.end() || j->second.pfd.events == 0)
+        continue;
+      auto& pfd = j->second.pfd;
+      pfd.revents = from_epoll_mask(events_[i].events);
+      changed_.push_back(fd);
+      f(pfd);
+      pfd.revents = 0;
+    }
+    if (static_cast<size_t>(presult) == events_.size())
+      events_.resize(events_.size() * 2);
+  }
+
+  /// Synchronizes the event masks of all entries that handlers had access to
+  /// with the kernel and drops entries without events.
+  void prepare_next_cycle();
+
+  /// Converts a `poll` event mask to an `epoll` event mask.
+  static uint32_t to_epoll_mask(short mask) noexcept;
+
+  /// Converts an `epoll` event mask to a `poll` event mask.
+  static short from_epoll_mask(uint32_t mask) noexcept;
+
+private:
+  struct entry {
+    /// The event mask as seen by the handlers.
+    pollfd pfd;
+
+    /// The event mask as seen by the kernel.
+    uint32_t registered = 0;
+  };
+
+  bool update(caf::net::socket_id fd, uint32_t mask, bool registered);
+
+  int epfd_;
+
+  std::vector<epoll_event> events_;
+
+  std::unordered_map<caf::net::socket_id, entry> entries_;
+
+  /// Stores all IDs of sockets that handlers had access to in this cycle.
+  std::vector<caf::net::socket_id> changed_;
+};
+
+using pollset = epoll_backend;
+
+#else // CAF_LINUX
+
+using pollset = poll_backend;
+
+#endif // CAF_LINUX
+
+} // namespace broker::internal
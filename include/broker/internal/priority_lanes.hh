@@ -0,0 +1,422 @@
+#pragma once
+
+#include "broker/defaults.hh"
+#include "broker/filter_type.hh"
+#include "broker/message.hh"
+
+#include <caf/disposable.hpp>
+#include <caf/flow/observable.hpp>
+#include <caf/flow/op/cold.hpp>
+#include <caf/fwd.hpp>
+#include <caf/scheduled_actor.hpp>
+#include <caf/telemetry/counter.hpp>
+#include <caf/telemetry/gauge.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace broker::internal {
+
+/// Classifies messages for scheduling. Messages on the high lane always go
+/// ahead of messages on the bulk lane.
+enum class priority_lane : uint8_t {
+  /// Control traffic, i.e., routing updates, pings and pongs, store channels
+  /// and data on topics with a configured prefix.
+  high,
+  /// Everything else.
+  bulk,
+};
+
+/// @relates priority_lane
+std::string to_string(priority_lane x);
+
+/// Bundles the instrumentation for a single @ref priority_lane.
+struct priority_lane_metrics {
+  /// Keeps track of how many messages currently wait in priority stages.
+  caf::telemetry::int_gauge* queued = nullptr;
+
+  /// Counts how many messages have passed through priority stages.
+  caf::telemetry::int_counter* processed = nullptr;
+};
+
+/// Bundles the configuration and the instrumentation for scheduling control
+/// traffic ahead of bulk data. Without priority lanes, all messages share the
+/// same merge point and per-peer output buffers, i.e., a routing update or a
+/// store heartbeat queues behind all data that some publisher produced before.
+struct priority_lanes {
+  /// Enables the priority stages in the core and at each peer writer.
+  bool enabled = false;
+
+  /// Selects data messages for the high lane.
+  filter_type high_prefixes;
+
+  /// Configures how many messages a priority stage may buffer per input. Also
+  /// limits the FIFO buffer between each peer writer and its transport (see
+  /// `for_peer_writer`).
+  size_t buffer_size = defaults::priority::buffer_size;
+
+  /// Metrics for each lane, indexed by @ref priority_lane.
+  std::array<priority_lane_metrics, 2> metrics;
+
+  /// Returns the lane for `msg`.
+  priority_lane classify(const node_message& msg) const;
+
+  /// Returns the configuration for the priority stage at a peer writer. The
+  /// stage and the buffer to the transport hold at least one full batch of
+  /// `write_batch_size` messages. Otherwise, the buffer would split each batch
+  /// into multiple writes.
+  priority_lanes for_peer_writer(size_t write_batch_size) const {
+    auto result = *this;
+    result.buffer_size = std::max({buffer_size, write_batch_size, size_t{1}});
+    return result;
+  }
+
+  /// Reads the configuration from `sys` and fetches the metric instances.
+  static priority_lanes make(caf::actor_system& sys);
+};
+
+/// Merges any number of inputs into one output and always serves pending items
+/// of the high lane first. An input either puts all of its items on a fixed
+/// lane or classifies each item. Each input may have up to `buffer_size` items
+/// in flight, but bulk items only move forward while the output has demand left
+/// after draining the high lane.
+template <class T>
+class priority_merge_sub : public caf::ref_counted,
+                           public caf::flow::subscription_impl {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using output_type = T;
+
+  /// Receives the items from one of the inputs.
+  class input : public caf::ref_counted, public caf::flow::observer_impl<T> {
+  public:
+    input(caf::intrusive_ptr<priority_merge_sub> parent, size_t index)
+      : parent_(std::move(parent)), index_(index) {
+      // nop
+    }
+
+    void ref_coordinated() const noexcept final {
+      this->ref();
+    }
+
+    void deref_coordinated() const noexcept final {
+      this->deref();
+    }
+
+    friend void intrusive_ptr_add_ref(const input* ptr) noexcept {
+      ptr->ref();
+    }
+
+    friend void intrusive_ptr_release(const input* ptr) noexcept {
+      ptr->deref();
+    }
+
+    void on_next(const T& item) override {
+      parent_->fwd_on_next(index_, item);
+    }
+
+    void on_complete() override {
+      parent_->fwd_on_complete(index_);
+    }
+
+    void on_error(const caf::error& what) override {
+      parent_->fwd_on_error(index_, what);
+    }
+
+    void on_subscribe(caf::flow::subscription in) override {
+      parent_->fwd_on_subscribe(index_, std::move(in));
+    }
+
+  private:
+    caf::intrusive_ptr<priority_merge_sub> parent_;
+    size_t index_;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param lanes The fixed lane for each input or `std::nullopt` for inputs
+  ///              that need to classify each item.
+  priority_merge_sub(caf::flow::coordinator* ctx,
+                     caf::flow::observer<output_type> out,
+                     const priority_lanes& cfg,
+                     const std::vector<std::optional<priority_lane>>& lanes)
+    : ctx_(ctx),
+      out_(std::move(out)),
+      cfg_(cfg),
+      buffer_size_(std::max(cfg.buffer_size, size_t{1})),
+      inputs_(lanes.size()) {
+    for (size_t i = 0; i < lanes.size(); ++i)
+      inputs_[i].lane = lanes[i];
+    for (size_t i = 0; i < lanes_.size(); ++i)
+      lanes_[i].metrics = cfg.metrics[i];
+  }
+
+  ~priority_merge_sub() override {
+    drop_buffers();
+  }
+
+  // -- ref counting -----------------------------------------------------------
+
+  void ref_disposable() const noexcept final {
+    this->ref();
+  }
+
+  void deref_disposable() const noexcept final {
+    this->deref();
+  }
+
+  friend void intrusive_ptr_add_ref(const priority_merge_sub* ptr) noexcept {
+    ptr->ref();
+  }
+
+  friend void intrusive_ptr_release(const priority_merge_sub* ptr) noexcept {
+    ptr->deref();
+  }
+
+  // -- callbacks for the inputs -----------------------------------------------
+
+  void fwd_on_subscribe(size_t index, caf::flow::subscription in) {
+    auto& st = inputs_[index];
+    if (!out_ || st.in || st.done) {
+      in.dispose();
+      return;
+    }
+    st.in = std::move(in);
+    st.in.request(buffer_size_);
+  }
+
+  void fwd_on_next(size_t index, const T& item) {
+    if (!out_)
+      return;
+    auto lane = inputs_[index].lane ? *inputs_[index].lane
+                                    : cfg_.classify(item);
+    auto& st = get(lane);
+    st.buf.emplace_back(index, item);
+    if (st.metrics.queued)
+      st.metrics.queued->inc();
+    drain();
+  }
+
+  void fwd_on_complete(size_t index) {
+    auto& st = inputs_[index];
+    st.in = nullptr;
+    st.done = true;
+    drain();
+  }
+
+  void fwd_on_error(size_t index, const caf::error& what) {
+    auto& st = inputs_[index];
+    st.in = nullptr;
+    st.done = true;
+    if (out_) {
+      dispose_inputs();
+      drop_buffers();
+      auto tmp = std::move(out_);
+      tmp.on_error(what);
+    }
+  }
+
+  // -- implementation of subscription_impl ------------------------------------
+
+  bool disposed() const noexcept override {
+    return !out_;
+  }
+
+  void dispose() override {
+    if (out_) {
+      ctx_->delay_fn([out = std::move(out_)]() mutable { out.on_complete(); });
+    }
+    dispose_inputs();
+    drop_buffers();
+  }
+
+  void request(size_t n) override {
+    demand_ += n;
+    drain();
+  }
+
+private:
+  struct input_state {
+    caf::flow::subscription in;
+    std::optional<priority_lane> lane;
+    bool done = false;
+    size_t consumed = 0;
+  };
+
+  struct lane_state {
+    /// Stores pending items along with the index of their input.
+    std::deque<std::pair<size_t, T>> buf;
+    priority_lane_metrics metrics;
+  };
+
+  lane_state& get(priority_lane lane) {
+    return lanes_[static_cast<size_t>(lane)];
+  }
+
+  /// Emits buffered items while the output has demand, high lane first.
+  void drain() {
+    // Guard against re-entrant calls, e.g., when the observer calls `request`
+    // from `on_next` or an input emits items right away when we request more.
+    if (running_) {
+      rerun_ = true;
+      return;
+    }
+    running_ = true;
+    auto has_items = [](const lane_state& st) { return !st.buf.empty(); };
+    do {
+      rerun_ = false;
+      while (out_ && demand_ > 0) {
+        auto i = std::find_if(lanes_.begin(), lanes_.end(), has_items);
+        if (i == lanes_.end())
+          break;
+        auto [index, item] = std::move(i->buf.front());
+        i->buf.pop_front();
+        --demand_;
+        ++inputs_[index].consumed;
+        if (i->metrics.queued)
+          i->metrics.queued->dec();
+        if (i->metrics.processed)
+          i->metrics.processed->inc();
+        out_.on_next(item);
+      }
+      // Hand out new credit for all items we have passed on.
+      for (auto& st : inputs_) {
+        if (auto n = std::exchange(st.consumed, 0); n > 0 && st.in)
+          st.in.request(n);
+      }
+    } while (rerun_ && out_);
+    auto done = [](const input_state& st) { return st.done; };
+    if (out_ && std::none_of(lanes_.begin(), lanes_.end(), has_items)
+        && std::all_of(inputs_.begin(), inputs_.end(), done)) {
+      auto tmp = std::move(out_);
+      tmp.on_complete();
+    }
+    running_ = false;
+  }
+
+  void dispose_inputs() {
+    for (auto& st : inputs_) {
+      if (st.in) {
+        st.in.dispose();
+        st.in = nullptr;
+      }
+    }
+  }
+
+  void drop_buffers() {
+    for (auto& st : lanes_) {
+      if (st.metrics.queued && !st.buf.empty())
+        st.metrics.queued->dec(static_cast<int64_t>(st.buf.size()));
+      st.buf.clear();
+    }
+  }
+
+  caf::flow::coordinator* ctx_;
+  caf::flow::observer<output_type> out_;
+  priority_lanes cfg_;
+  size_t buffer_size_;
+  size_t demand_ = 0;
+  bool running_ = false;
+  bool rerun_ = false;
+  std::vector<input_state> inputs_;
+  std::array<lane_state, 2> lanes_;
+};
+
+/// Merges inputs with strict priority for the high lane. See
+/// @ref priority_merge_sub.
+template <class T>
+class priority_merge : public caf::flow::op::cold<T> {
+public:
+  using super = caf::flow::op::cold<T>;
+
+  using input_type = caf::flow::observable<T>;
+
+  /// Pairs an input with its fixed lane or `std::nullopt` if the merge needs
+  /// to classify each item.
+  using lane_input = std::pair<input_type, std::optional<priority_lane>>;
+
+  priority_merge(caf::flow::coordinator* ctx, std::vector<lane_input> inputs,
+                 priority_lanes cfg)
+    : super(ctx), inputs_(std::move(inputs)), cfg_(std::move(cfg)) {
+    // nop
+  }
+
+  caf::disposable subscribe(caf::flow::observer<T> out) override {
+    if (inputs_.empty()) {
+      out.on_error(make_error(caf::sec::too_many_observers,
+                              "priority_merge may only be subscribed to once"));
+      return {};
+    }
+    using sub_t = priority_merge_sub<T>;
+    using input_t = typename sub_t::input;
+    auto inputs = std::move(inputs_);
+    inputs_.clear();
+    std::vector<std::optional<priority_lane>> lanes;
+    for (auto& in : inputs)
+      lanes.emplace_back(in.second);
+    auto sub = caf::make_counted<sub_t>(this->ctx(), out, cfg_, lanes);
+    out.on_subscribe(caf::flow::subscription{sub});
+    for (size_t index = 0; index < inputs.size(); ++index)
+      inputs[index].first.subscribe(
+        caf::flow::observer<T>{caf::make_counted<input_t>(sub, index)});
+    return sub->as_disposable();
+  }
+
+private:
+  std::vector<lane_input> inputs_;
+  priority_lanes cfg_;
+};
+
+/// Merges `high` and `bulk` into a single observable that always serves
+/// pending items of `high` first. Items of `bulk` that belong to the high lane
+/// also go ahead of pending bulk items.
+template <class T>
+caf::flow::observable<T> make_priority_merge(caf::flow::observable<T> high,
+                                             caf::flow::observable<T> bulk,
+                                             priority_lanes cfg) {
+  using impl_t = priority_merge<T>;
+  auto ctx = high.ctx();
+  std::vector<typename impl_t::lane_input> inputs;
+  inputs.emplace_back(std::move(high), priority_lane::high);
+  inputs.emplace_back(std::move(bulk), std::nullopt);
+  auto ptr = caf::make_counted<impl_t>(ctx, std::move(inputs), std::move(cfg));
+  return caf::flow::observable<T>{ptr};
+}
+
+/// Utility class for adding a priority stage to an `observable`. The stage
+/// buffers up to `buffer_size` items and always emits pending items of the
+/// high lane first. Passes the input through unchanged if priority lanes are
+/// disabled.
+///
+/// The stage subscribes only once to its input. Hence, a full bulk lane never
+/// holds back high items that already arrived at the stage. Since the output
+/// buffer to a peer is a FIFO, the stage should come last before the buffer.
+struct add_priority_lanes_t {
+  priority_lanes cfg;
+
+  explicit add_priority_lanes_t(priority_lanes cfg) : cfg(std::move(cfg)) {
+    // nop
+  }
+
+  template <class Observable>
+  caf::flow::observable<node_message> operator()(Observable&& input) const {
+    auto obs = std::forward<Observable>(input).as_observable();
+    if (!cfg.enabled)
+      return obs;
+    using impl_t = priority_merge<node_message>;
+    auto ctx = obs.ctx();
+    std::vector<impl_t::lane_input> inputs;
+    inputs.emplace_back(std::move(obs), std::nullopt);
+    auto ptr = caf::make_counted<impl_t>(ctx, std::move(inputs), cfg);
+    return caf::flow::observable<node_message>{ptr};
+  }
+};
+
+} // namespace broker::internal
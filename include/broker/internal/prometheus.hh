@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include <caf/actor.hpp>
+#include <caf/actor_clock.hpp>
 #include <caf/byte_buffer.hpp>
 #include <caf/io/broker.hpp>
 #include <caf/io/connection_handle.hpp>
+#include <caf/span.hpp>
 
 #include "broker/filter_type.hh"
 #include "broker/internal/metric_collector.hh"
@@ -56,6 +60,13 @@ private:
   void on_status_request_cb(caf::io::connection_handle hdl, uint64_t async_id,
                             const table& res);
 
+  /// Writes `payload` with HTTP header `hdr` and closes the connection.
+  void respond(caf::io::connection_handle hdl, caf::span<const std::byte> hdr,
+               caf::span<const std::byte> payload);
+
+  /// Checks whether a response rendered at `rendered` is still usable.
+  bool fresh(caf::actor_clock::time_point rendered);
+
   /// Caches input per open connection for parsing the HTTP header.
   std::unordered_map<caf::io::connection_handle, request_state> requests_;
 
@@ -74,6 +85,25 @@ private:
 
   /// Buffer for writing JSON output.
   std::vector<char> json_buf_;
+
+  /// Configures how long we may serve cached responses before rendering them
+  /// again.
+  caf::timespan max_staleness_;
+
+  /// Stores when we have rendered `/metrics` for the last time.
+  caf::actor_clock::time_point metrics_rendered_;
+
+  /// Stores when we have rendered `/v1/status/json` for the last time.
+  caf::actor_clock::time_point status_rendered_;
+
+  /// Points to the last `/metrics` output of `collector_`.
+  std::string_view metrics_text_;
+
+  /// Signals whether `metrics_text_` contains a response.
+  bool has_metrics_text_ = false;
+
+  /// Signals whether `json_buf_` contains a status response.
+  bool has_status_json_ = false;
 };
 
 } // namespace broker::internal
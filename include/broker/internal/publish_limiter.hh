@@ -0,0 +1,114 @@
+#pragma once
+
+#include "broker/data.hh"
+#include "broker/publish_limit.hh"
+#include "broker/time.hh"
+#include "broker/topic.hh"
+
+#include <caf/fwd.hpp>
+#include <caf/telemetry/counter.hpp>
+#include <caf/telemetry/gauge.hpp>
+
+#include <string>
+#include <vector>
+
+namespace broker::internal {
+
+/// Applies @ref publish_limit policies to messages from local publishers and
+/// clients. Each policy applies to all topics that start with its prefix. For
+/// topics that match several prefixes, the longest prefix wins. Messages that
+/// exceed a limit are dropped and only show up in the metrics.
+class publish_limiter {
+public:
+  // -- member types -----------------------------------------------------------
+
+  /// Bundles the state and the metrics for a single topic prefix.
+  struct entry {
+    /// The topic prefix as configured by the user.
+    std::string prefix;
+
+    /// The policy for this prefix.
+    publish_limit limit;
+
+    /// Number of available tokens for the rate limit.
+    double tokens = 0;
+
+    /// Time of the last refill of the token bucket.
+    timestamp last_refill;
+
+    /// Counts messages for 1-in-N sampling.
+    uint64_t seen = 0;
+
+    /// Counts messages that passed the policy.
+    caf::telemetry::int_counter* accepted = nullptr;
+
+    /// Counts messages that exceeded the rate limit.
+    caf::telemetry::int_counter* dropped_by_rate = nullptr;
+
+    /// Counts messages that sampling skipped.
+    caf::telemetry::int_counter* dropped_by_sample = nullptr;
+
+    /// Counts messages that the policy dropped unconditionally.
+    caf::telemetry::int_counter* dropped_by_policy = nullptr;
+
+    /// Reports the configured rate.
+    caf::telemetry::dbl_gauge* rate = nullptr;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  explicit publish_limiter(caf::telemetry::metric_registry& reg);
+
+  /// Creates a limiter with the policies in the configuration option
+  /// `broker.publish-limits`. Each entry in this list consists of a topic
+  /// prefix, followed by the policy, e.g., `zeek/logs/ rate=1000 sample=10`.
+  /// The configuration rejects malformed entries (see `parse_policy`).
+  static publish_limiter make(caf::actor_system& sys);
+
+  /// Parses an entry of `broker.publish-limits`.
+  /// @returns `true` on success, `false` if `str` is malformed.
+  static bool parse_policy(const std::string& str, topic& prefix,
+                           publish_limit& limit);
+
+  // -- properties -------------------------------------------------------------
+
+  /// Checks whether the limiter has no policies.
+  bool empty() const noexcept {
+    return entries_.empty();
+  }
+
+  // -- policy management ------------------------------------------------------
+
+  /// Adds or replaces the policy for `prefix`. Replacing a policy resets the
+  /// token bucket and the sampling counter.
+  void set(const topic& prefix, const publish_limit& limit, timestamp now);
+
+  /// Removes the policy for `prefix`.
+  void clear(const topic& prefix);
+
+  // -- filtering --------------------------------------------------------------
+
+  /// Checks whether a message on topic `t` passes the policy for the longest
+  /// matching prefix and updates the state of that policy.
+  bool admit(const topic& t, timestamp now) {
+    return entries_.empty() || admit_impl(t, now);
+  }
+
+  // -- introspection ----------------------------------------------------------
+
+  /// Renders all policies for the status snapshot of the core.
+  table snapshot() const;
+
+private:
+  bool admit_impl(const topic& t, timestamp now);
+
+  entry* find(const topic& t) noexcept;
+
+  entry* find_exact(const topic& prefix) noexcept;
+
+  caf::telemetry::metric_registry* reg_;
+
+  std::vector<entry> entries_;
+};
+
+} // namespace broker::internal
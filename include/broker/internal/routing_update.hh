@@ -0,0 +1,83 @@
+#pragma once
+
+#include "broker/filter_type.hh"
+#include "broker/lamport_timestamp.hh"
+#include "broker/topic.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace broker::internal {
+
+/// Selects the payload format of a routing update. The topic of a routing
+/// update encodes its kind:
+/// - Full updates (`<$>`) carry the complete filter of the sender, followed by
+///   the version of the filter. Older peers only read the filter and ignore the
+///   version.
+/// - Delta updates (`<$>/delta`) carry a version plus the topics that the
+///   sender added to and removed from its filter since the previous version.
+///   Endpoints only send delta updates to peers that announced support for
+///   them by sending a full update with a version.
+/// - Resync requests (`<$>/resync`) ask the receiver to send a full update,
+///   e.g., after detecting a gap in the version numbers.
+enum class routing_update_kind : uint8_t {
+  full,
+  delta,
+  resync,
+};
+
+/// Returns the topic for routing updates of given kind.
+topic routing_update_topic(routing_update_kind kind);
+
+/// Returns the kind of a routing update by looking at its topic.
+routing_update_kind get_routing_update_kind(const topic& x);
+
+/// Returns the serialized payload for a full routing update.
+std::vector<std::byte> make_full_routing_update(const filter_type& filter,
+                                                lamport_timestamp version);
+
+/// Returns the serialized payload for a delta routing update.
+std::vector<std::byte> make_delta_routing_update(lamport_timestamp version,
+                                                 const filter_type& added,
+                                                 const filter_type& removed);
+
+/// Stores what we know about the filter version of a peer.
+struct routing_update_state {
+  /// The version of the filter or 0 if unknown.
+  lamport_timestamp version{0};
+
+  /// Stores whether the peer sends versioned updates. Only these peers accept
+  /// delta updates.
+  bool versioned = false;
+
+  /// Stores whether we have requested a full update from the peer.
+  bool resync_pending = false;
+};
+
+/// Outcome of applying a routing update to a peer filter.
+enum class routing_update_result {
+  /// The update changed the filter.
+  applied,
+  /// The update was outdated or carries no filter.
+  ignored,
+  /// One or more delta updates are missing. Only a full update can restore the
+  /// filter.
+  gap,
+  /// The payload was not a valid routing update.
+  malformed,
+};
+
+/// Applies a routing update to the filter of a peer.
+routing_update_result apply_routing_update(const topic& x,
+                                           const std::vector<std::byte>& bytes,
+                                           filter_type& filter,
+                                           routing_update_state& state);
+
+/// Computes the topics that are in `new_filter` but not in `old_filter`
+/// (`added`) and the topics that are in `old_filter` but not in `new_filter`
+/// (`removed`).
+void filter_diff(const filter_type& old_filter, const filter_type& new_filter,
+                 filter_type& added, filter_type& removed);
+
+} // namespace broker::internal
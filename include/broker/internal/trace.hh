@@ -0,0 +1,154 @@
+#pragma once
+
+#include "broker/endpoint_id.hh"
+#include "broker/expected.hh"
+#include "broker/message.hh"
+#include "broker/topic.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace broker::internal {
+
+/// Identifies a point in the message pipeline that emits trace records.
+enum class trace_event : uint16_t {
+  /// A local publisher handed a message to the core.
+  publish = 1,
+  /// The central merge point of the core processed a message.
+  merge,
+  /// The filter of a peer selected a message for forwarding.
+  filter_pass,
+  /// The filter of a peer rejected a message.
+  filter_drop,
+  /// The core handed a message to the transport of a peer.
+  peer_write,
+  /// A data store master applied a command. The size field holds the index of
+  /// the command type in `internal_command_variant`.
+  store_apply,
+  /// A channel producer received an acknowledgement. The size field holds the
+  /// acknowledged sequence number and the peer field holds the `std::hash` of
+  /// the channel handle.
+  channel_ack,
+  /// A channel producer received a retransmit request. The size field holds
+  /// the number of requested events and the peer field holds the `std::hash`
+  /// of the channel handle.
+  channel_nack,
+  /// The core generated a control message for its peers, e.g., a routing
+  /// update, a resync request or a pong.
+  control,
+};
+
+/// @relates trace_event
+std::string_view to_string(trace_event x) noexcept;
+
+/// A fixed-size record in a trace ring buffer.
+struct trace_record {
+  /// Nanoseconds since the UNIX epoch.
+  uint64_t timestamp = 0;
+
+  /// Identifies the trace point.
+  trace_event event = trace_event::publish;
+
+  /// Identifies the ring buffer (i.e., the thread) that recorded the event.
+  uint16_t thread = 0;
+
+  /// Size of the payload in bytes or an event-specific value.
+  uint32_t size = 0;
+
+  /// Hash of the peer ID (see @ref trace_hash) or 0.
+  uint64_t peer = 0;
+
+  /// Hash of the topic (see @ref trace_hash) or 0.
+  uint64_t topic = 0;
+};
+
+/// @relates trace_record
+inline bool operator==(const trace_record& x, const trace_record& y) noexcept {
+  return x.timestamp == y.timestamp && x.event == y.event
+         && x.thread == y.thread && x.size == y.size && x.peer == y.peer
+         && x.topic == y.topic;
+}
+
+/// Returns a stable 64-bit hash (FNV-1a) of `str`. Unlike `std::hash`, the
+/// hash does not depend on the platform. Hence, the decoder can resolve hashes
+/// in a trace dump by hashing topics given by the user.
+uint64_t trace_hash(std::string_view str) noexcept;
+
+/// Returns the hash of a topic for trace records.
+inline uint64_t trace_hash(const topic& x) noexcept {
+  return trace_hash(std::string_view{x.string()});
+}
+
+/// Returns the hash of the bytes of `x` for trace records or 0 if `x` is nil.
+uint64_t trace_hash(const endpoint_id& x) noexcept;
+
+/// Stores whether tracing is enabled. Use @ref enable_tracing for changing
+/// the value.
+extern std::atomic<bool> tracing_flag;
+
+/// Checks whether tracing is currently enabled.
+inline bool tracing_enabled() noexcept {
+  return tracing_flag.load(std::memory_order_relaxed);
+}
+
+/// Turns tracing on or off for all threads.
+void enable_tracing(bool value) noexcept;
+
+/// Sets the number of records per ring buffer, rounded up to the next power
+/// of two. Only affects buffers that the tracing facility allocates afterwards.
+/// All endpoints in the process share the ring buffers. Hence, only the first
+/// call has an effect and later calls keep the size.
+/// @returns the number of records per ring buffer.
+size_t set_trace_buffer_size(size_t capacity) noexcept;
+
+/// Adds a record to the ring buffer of the calling thread.
+void trace_impl(trace_event event, uint64_t peer, uint64_t topic,
+                uint64_t size);
+
+/// Adds a record for `msg` to the ring buffer of the calling thread.
+void trace_impl(trace_event event, const endpoint_id& peer,
+                const packed_message& msg);
+
+/// Adds a record to the ring buffer of the calling thread if tracing is
+/// enabled. Computes the hashes only if tracing is enabled.
+inline void trace(trace_event event, const endpoint_id& peer,
+                  const packed_message& msg) {
+  if (tracing_enabled())
+    trace_impl(event, peer, msg);
+}
+
+/// @copydoc trace
+inline void trace(trace_event event, const endpoint_id& peer,
+                  const topic& what, size_t size) {
+  if (tracing_enabled())
+    trace_impl(event, trace_hash(peer), trace_hash(what), size);
+}
+
+/// @copydoc trace
+template <class Handle>
+void trace(trace_event event, const Handle& peer, size_t size) {
+  if (tracing_enabled())
+    trace_impl(event, std::hash<Handle>{}(peer), 0, size);
+}
+
+/// Returns all records from all ring buffers, ordered by their timestamp.
+std::vector<trace_record> trace_snapshot();
+
+/// Serializes `xs` into the binary dump format:
+/// - 8 bytes magic number (`BRKTRACE`)
+/// - 4 bytes format version
+/// - 4 bytes number of records
+/// - 32 bytes per record: timestamp (8), event (2), thread (2), size (4),
+///   peer (8), topic (8)
+/// All integers use little-endian byte order.
+std::vector<std::byte> trace_dump(const std::vector<trace_record>& xs);
+
+/// Deserializes a binary dump.
+/// @sa trace_dump
+expected<std::vector<trace_record>>
+parse_trace_dump(const std::byte* first, size_t size);
+
+} // namespace broker::internal
@@ -89,6 +89,8 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker_internal, caf::first_custom_type_id)
   BROKER_ADD_ATOM(await)
   BROKER_ADD_ATOM(clear)
   BROKER_ADD_ATOM(clone)
+  BROKER_ADD_ATOM(containing)
+  BROKER_ADD_ATOM(covered_by)
   BROKER_ADD_ATOM(data_store)
   BROKER_ADD_ATOM(decrement)
   BROKER_ADD_ATOM(erase)
@@ -102,6 +104,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker_internal, caf::first_custom_type_id)
   BROKER_ADD_ATOM(mutable_check)
   BROKER_ADD_ATOM(resolve)
   BROKER_ADD_ATOM(restart)
+  BROKER_ADD_ATOM(scan)
   BROKER_ADD_ATOM(stale_check)
   BROKER_ADD_ATOM(subtract)
   BROKER_ADD_ATOM(sync_point)
@@ -109,8 +112,10 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker_internal, caf::first_custom_type_id)
   // -- atoms for communciation with the core actor ----------------------------
 
   BROKER_ADD_ATOM(no_events)
+  BROKER_ADD_ATOM(resync)
   BROKER_ADD_ATOM(snapshot)
   BROKER_ADD_ATOM(subscriptions)
+  BROKER_ADD_ATOM(unsubscribe)
 
   // -- Broker type announcements ----------------------------------------------
 
@@ -139,6 +144,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker_internal, caf::first_custom_type_id)
   BROKER_ADD_TYPE_ID((broker::internal::connector_event_id))
   BROKER_ADD_TYPE_ID((broker::internal::data_consumer_res))
   BROKER_ADD_TYPE_ID((broker::internal::data_producer_res))
+  BROKER_ADD_TYPE_ID((broker::internal::flow_scope_stats_ptr))
   BROKER_ADD_TYPE_ID((broker::internal::node_consumer_res))
   BROKER_ADD_TYPE_ID((broker::internal::node_producer_res))
   BROKER_ADD_TYPE_ID((broker::internal::pending_connection_ptr))
@@ -246,6 +252,7 @@ CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::command_consumer_res)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::command_producer_res)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::data_consumer_res)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::data_producer_res)
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::flow_scope_stats_ptr)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::node_consumer_res)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::node_producer_res)
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::internal::pending_connection_ptr)
@@ -3,12 +3,14 @@
 #include "broker/endpoint_id.hh"
 #include "broker/error.hh"
 #include "broker/fwd.hh"
+#include "broker/internal/fwd.hh"
 #include "broker/message.hh"
 
 #include <caf/byte_buffer.hpp>
 #include <caf/byte_span.hpp>
 #include <caf/error.hpp>
 #include <caf/fwd.hpp>
+#include <caf/telemetry/counter.hpp>
 
 // After establishing a transport channel (usually TCP/TLS), the Broker protocol
 // traverses three phases:
@@ -28,6 +30,12 @@ constexpr uint32_t magic_number = 0x5A45454B;
 /// The current version of the protocol.
 constexpr uint8_t protocol_version = 1;
 
+/// Extends version 1 of the protocol with an origin timestamp for each data
+/// message. Broker only offers this version when collecting latency metrics,
+/// i.e., peers negotiate this wire feature during the handshake and fall back
+/// to @ref protocol_version unless both sides enable it.
+constexpr uint8_t timestamped_protocol_version = 2;
+
 // -- version-agnostic Broker messages -----------------------------------------
 
 /// Starts the handshake process. Sent by the Broker node that establishes the
@@ -65,8 +73,9 @@ bool inspect(Inspector& f, hello_msg& x) {
 }
 
 /// @relates hello_msg
-inline hello_msg make_hello_msg(endpoint_id id) {
-  return {magic_number, id, protocol_version, protocol_version};
+inline hello_msg make_hello_msg(endpoint_id id,
+                                uint8_t max_version = protocol_version) {
+  return {magic_number, id, protocol_version, max_version};
 }
 
 /// Only probes connectivity without any other effect. Sent as first message by
@@ -119,9 +128,10 @@ bool inspect(Inspector& f, version_select_msg& x) {
                             f.field("selected-version", x.selected_version));
 }
 
-/// @relates probe_msg
-inline version_select_msg make_version_select_msg(endpoint_id id) {
-  return {magic_number, id, protocol_version};
+/// @relates version_select_msg
+inline version_select_msg
+make_version_select_msg(endpoint_id id, uint8_t version = protocol_version) {
+  return {magic_number, id, version};
 }
 
 /// Aborts the handshake.
@@ -238,6 +248,20 @@ inline originator_ack_msg make_originator_ack_msg() {
 /// representation.
 class trait {
 public:
+  trait() = default;
+
+  /// @param with_origin Adds origin timestamps to data messages. Requires that
+  ///                    both peers agreed on @ref timestamped_protocol_version.
+  /// @param latency Observes the latency of outgoing data messages (optional).
+  /// @param read_messages Counts incoming messages (optional).
+  trait(bool with_origin, latency_tracker_ptr latency,
+        caf::telemetry::int_counter* read_messages = nullptr)
+    : with_origin_(with_origin),
+      latency_(std::move(latency)),
+      read_messages_(read_messages) {
+    // nop
+  }
+
   /// Serializes a @ref node_message to a sequence of bytes.
   bool convert(const node_message& msg, caf::byte_buffer& buf);
 
@@ -251,6 +275,9 @@ public:
 
 private:
   caf::error last_error_;
+  bool with_origin_ = false;
+  latency_tracker_ptr latency_;
+  caf::telemetry::int_counter* read_messages_ = nullptr;
 };
 
 } // namespace v1
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "broker/defaults.hh"
+#include "broker/endpoint_id.hh"
+#include "broker/internal/trace.hh"
+#include "broker/message.hh"
+#include "broker/time.hh"
+
+#include <caf/cow_vector.hpp>
+#include <caf/flow/observable.hpp>
+#include <caf/fwd.hpp>
+#include <caf/scheduled_actor.hpp>
+#include <caf/telemetry/counter.hpp>
+
+namespace broker::internal {
+
+/// Bundles the configuration and the instrumentation for coalescing outgoing
+/// messages to a peer. The batching stage holds back messages until it has a
+/// full batch or the delay expires and then hands the entire batch to the
+/// buffer of the peer connection. The transport of the connection serializes
+/// all frames in its buffer into its write buffer before writing to the socket,
+/// i.e., it issues a single `write` (or `SSL_write`) per batch. The metric
+/// `broker.peer-writes` counts the actual write operations (see peer_io.hh).
+/// Batching is off by default, since the default batch size is 1.
+struct write_batching {
+  /// Maximum number of messages per batch.
+  size_t max_size = defaults::peering::write_batch_size;
+
+  /// Maximum delay for filling up a batch.
+  timespan max_delay = defaults::peering::write_batch_delay;
+
+  /// Identifies the receiving peer in trace records.
+  endpoint_id peer;
+
+  /// Counts the messages written to the peer.
+  caf::telemetry::int_counter* messages = nullptr;
+
+  /// Returns whether batching is enabled.
+  bool enabled() const noexcept {
+    return max_size > 1;
+  }
+
+  /// Reads the configuration from `sys` and fetches the metric instances for
+  /// `peer_id`.
+  static write_batching make(caf::actor_system& sys, endpoint_id peer_id);
+};
+
+/// Utility class for coalescing the messages of an `observable` according to
+/// a @ref write_batching configuration.
+struct add_write_batching_t {
+  caf::scheduled_actor* self;
+  write_batching cfg;
+
+  add_write_batching_t(caf::scheduled_actor* self, write_batching cfg)
+    : self(self), cfg(cfg) {
+    // nop
+  }
+
+  template <class Observable>
+  caf::flow::observable<node_message> operator()(Observable&& input) const {
+    auto obs = std::forward<Observable>(input).as_observable();
+    if (!cfg.enabled()) {
+      return obs
+        .do_on_next([messages = cfg.messages,
+                     peer = cfg.peer](const node_message& msg) {
+          trace(trace_event::peer_write, peer, get_packed_message(msg));
+          messages->inc();
+        })
+        .as_observable();
+    }
+    return obs //
+      .buffer(cfg.max_size, cfg.max_delay)
+      .concat_map([self = self, messages = cfg.messages,
+                   peer = cfg.peer](const caf::cow_vector<node_message>& xs) {
+        if (tracing_enabled())
+          for (const auto& msg : xs.std_vector())
+            trace(trace_event::peer_write, peer, get_packed_message(msg));
+        messages->inc(static_cast<int64_t>(xs.size()));
+        // Release the entire batch at once. The transport picks up all
+        // messages that are available when the socket becomes writable.
+        return self->make_observable()
+          .from_container(xs.std_vector())
+          .as_observable();
+      })
+      .as_observable();
+  }
+};
+
+} // namespace broker::internal
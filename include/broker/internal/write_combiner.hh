@@ -0,0 +1,72 @@
+#pragma once
+
+#include "broker/data.hh"
+#include "broker/internal_command.hh"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace broker::internal {
+
+/// Merges successive writes of a clone to the same key before the clone
+/// forwards them to its master:
+/// - A `put` replaces all buffered commands for its key.
+/// - An `add` following a `put` modifies the value of the `put`, e.g., adds the
+///   amount of an increment or inserts into a set.
+/// - An increment following another increment adds up the two amounts.
+/// - A set insertion of a value that is already buffered has no effect.
+/// Except for a `put` replacing previous commands, the combiner only merges
+/// commands of the same publisher.
+/// The merged commands carry the expiry of the last command for a key, i.e.,
+/// applying the merged commands results in the same store content as applying
+/// the original commands in order. Commands for different keys are independent
+/// of each other, but the combiner preserves the order of commands for the
+/// same key.
+class write_combiner {
+public:
+  /// Adds `cmd` to the buffer. Leaves `cmd` untouched and returns `false` if
+  /// `cmd` is not a `put` or an `add` command. In this case, the caller must
+  /// flush the buffer before sending `cmd` to preserve ordering.
+  bool add(internal_command_variant& cmd);
+
+  /// Calls `f` for each buffered command and clears the buffer afterwards.
+  template <class F>
+  void flush(F f) {
+    for (auto& key : keys_) {
+      if (auto i = buf_.find(key); i != buf_.end())
+        for (auto& cmd : i->second)
+          f(std::move(cmd));
+    }
+    clear();
+  }
+
+  /// Returns the number of buffered commands.
+  [[nodiscard]] size_t size() const noexcept {
+    return size_;
+  }
+
+  [[nodiscard]] bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  void clear();
+
+private:
+  using command_list = std::vector<internal_command_variant>;
+
+  void add(put_command& cmd);
+
+  void add(add_command& cmd);
+
+  /// Stores the keys in the order of their first write.
+  std::vector<data> keys_;
+
+  /// Stores the buffered commands per key.
+  std::unordered_map<data, command_list> buf_;
+
+  /// Stores the total number of commands in `buf_`.
+  size_t size_ = 0;
+};
+
+} // namespace broker::internal
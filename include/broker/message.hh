@@ -9,6 +9,7 @@
 #include "broker/data.hh"
 #include "broker/detail/inspect_enum.hh"
 #include "broker/internal_command.hh"
+#include "broker/time.hh"
 #include "broker/topic.hh"
 
 namespace broker {
@@ -112,10 +113,14 @@ inline const std::vector<std::byte>& get_payload(const packed_message& msg) {
   return get<3>(msg);
 }
 
-/// A Broker-internal message with path and content (packed message).
-using node_message = cow_tuple<endpoint_id,     // Sender.
-                               endpoint_id,     // Receiver or NIL.
-                               packed_message>; // Content.
+/// A Broker-internal message with path and content (packed message). The
+/// last field stores the origin timestamp of the message, i.e., the time when
+/// the message first entered a Broker core. A default-constructed timestamp
+/// means that the message carries no origin timestamp.
+using node_message = cow_tuple<endpoint_id,    // Sender.
+                               endpoint_id,    // Receiver or NIL.
+                               packed_message, // Content.
+                               timestamp>;     // Origin.
 
 /// @relates node_message
 inline auto get_sender(const node_message& msg) {
@@ -152,6 +157,16 @@ inline const std::vector<std::byte>& get_payload(const node_message& msg) {
   return get_payload(get_packed_message(msg));
 }
 
+/// @relates node_message
+inline timestamp get_origin(const node_message& msg) {
+  return get<3>(msg);
+}
+
+/// @relates node_message
+inline bool has_origin(const node_message& msg) {
+  return get_origin(msg) != timestamp{};
+}
+
 /// A user-defined message with topic and data.
 using data_message = cow_tuple<topic, data>;
 
@@ -197,13 +212,14 @@ command_message make_command_message(Topic&& t, Command&& d) {
 /// Generates a @ref node_message with NIL receiver, causing all receivers to
 /// dispatch on topic only.
 inline node_message make_node_message(endpoint_id sender, packed_message pm) {
-  return node_message{sender, endpoint_id::nil(), std::move(pm)};
+  return node_message{sender, endpoint_id::nil(), std::move(pm), timestamp{}};
 }
 
 /// Generates a @ref node_message.
 inline node_message make_node_message(endpoint_id sender, endpoint_id receiver,
-                                      packed_message pm) {
-  return node_message{sender, receiver, std::move(pm)};
+                                      packed_message pm,
+                                      timestamp origin = timestamp{}) {
+  return node_message{sender, receiver, std::move(pm), origin};
 }
 
 /// Retrieves the topic from a @ref data_message.
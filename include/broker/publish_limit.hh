@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace broker {
+
+/// Limits how many messages local publishers and clients may publish on topics
+/// with a given prefix. The core drops messages that exceed the limit at the
+/// source, i.e., before they reach any peer.
+struct publish_limit {
+  /// Maximum number of messages per second. The value 0 disables the rate
+  /// limit.
+  double rate = 0;
+
+  /// Maximum number of messages in a burst, i.e., the capacity of the token
+  /// bucket. The value 0 selects a capacity of one second worth of messages.
+  uint64_t burst = 0;
+
+  /// Forwards only one in `sample` messages. The values 0 and 1 disable
+  /// sampling.
+  uint64_t sample = 1;
+
+  /// Drops all messages, e.g., for silencing a runaway publisher. Note that a
+  /// `rate` of 0 disables the rate limit instead.
+  bool drop = false;
+};
+
+/// @relates publish_limit
+bool operator==(const publish_limit& x, const publish_limit& y) noexcept;
+
+/// @relates publish_limit
+inline bool operator!=(const publish_limit& x,
+                       const publish_limit& y) noexcept {
+  return !(x == y);
+}
+
+/// Renders `x` in the format that `convert` accepts, e.g.,
+/// `rate=100 burst=200 sample=10`. Adds `drop=true` if `x.drop` is set.
+/// @relates publish_limit
+std::string to_string(const publish_limit& x);
+
+/// Parses a publish limit from a list of key-value pairs, e.g.,
+/// `rate=100 burst=200 sample=10` or `drop=true`. Omitted keys keep their
+/// default value.
+/// @relates publish_limit
+bool convert(const std::string& str, publish_limit& x);
+
+} // namespace broker
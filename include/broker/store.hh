@@ -73,6 +73,37 @@ public:
     /// response.
     request_id keys();
 
+    /// Performs a request to retrieve up to *limit* entries with keys in the
+    /// range `[first, last)`.
+    /// @returns A unique identifier for this request to correlate it with a
+    /// response.
+    /// @sa store::scan
+    request_id scan(data first, data last,
+                    count limit = defaults::store::scan_page_size);
+
+    /// Performs a request to retrieve up to *limit* entries with keys that
+    /// start with *prefix*.
+    /// @returns A unique identifier for this request to correlate it with a
+    /// response or 0 if *prefix* is neither a string nor a subnet.
+    /// @sa store::prefix
+    request_id prefix(data prefix,
+                      count limit = defaults::store::scan_page_size,
+                      data cursor = {});
+
+    /// Performs a request to retrieve the entry with the most specific subnet
+    /// key that contains *addr*.
+    /// @returns A unique identifier for this request to correlate it with a
+    /// response.
+    /// @sa store::lookup_containing
+    request_id lookup_containing(address addr);
+
+    /// Performs a request to retrieve all entries with a subnet key that is a
+    /// subset of *net*.
+    /// @returns A unique identifier for this request to correlate it with a
+    /// response.
+    /// @sa store::covered_by
+    request_id covered_by(subnet net);
+
     /// Retrieves the proxy's mailbox that reflects query responses.
     broker::mailbox mailbox();
 
@@ -149,6 +180,45 @@ public:
   /// Retrieves a copy of the store's current keys, returned as a set.
   expected<data> keys() const;
 
+  /// Retrieves up to *limit* entries with keys in the range `[first, last)` in
+  /// ascending order. The range only includes keys with the same type as
+  /// *first*. Passing `nil` for *last* selects all keys of that type.
+  /// @param first The smallest key to include.
+  /// @param last The first key to exclude or `nil`.
+  /// @param limit The maximum number of entries per page. A limit of 0
+  ///              returns no entries and a `nil` cursor.
+  /// @returns A vector with two elements: a table with the selected entries
+  ///          and a cursor. The cursor is `nil` when reaching the end of the
+  ///          range. Otherwise, passing the cursor as *first* retrieves the
+  ///          next page.
+  expected<data> scan(data first, data last,
+                      count limit = defaults::store::scan_page_size) const;
+
+  /// Retrieves up to *limit* entries with keys that start with *prefix*. For
+  /// strings, this selects all string keys that start with *prefix*. For
+  /// subnets, this selects all address keys in the subnet.
+  /// @param prefix A string or subnet.
+  /// @param limit The maximum number of entries per page.
+  /// @param cursor The cursor from a previous result or `nil` for retrieving
+  ///               the first page.
+  /// @returns The same result as @ref scan.
+  expected<data> prefix(data prefix,
+                        count limit = defaults::store::scan_page_size,
+                        data cursor = {}) const;
+
+  /// Retrieves the entry with the most specific subnet key that contains
+  /// *addr*, i.e., performs a longest-prefix match. Masters and clones answer
+  /// this query from an index over all subnet keys.
+  /// @param addr The address to look up.
+  /// @returns A vector with two elements: the subnet key and its value. Fails
+  ///          with `no_such_key` if no subnet key contains *addr*.
+  expected<data> lookup_containing(address addr) const;
+
+  /// Retrieves all entries with a subnet key that is a subset of *net*.
+  /// @param net The subnet that covers the selected keys.
+  /// @returns A table with the selected entries.
+  expected<data> covered_by(subnet net) const;
+
   /// Returns whether the store was fully initialized
   bool initialized() const noexcept;
 
@@ -5,6 +5,7 @@
 #include <optional>
 
 #include "broker/data.hh"
+#include "broker/data_view.hh"
 #include "broker/detail/assert.hh"
 
 namespace broker::zeek {
@@ -94,6 +95,26 @@ public:
     return Type(*cp);
   }
 
+  static Type type(const data_view& msg) {
+    if (!msg.is_vector())
+      return Type::Invalid;
+
+    auto v = msg.to_vector();
+
+    if (v.size() < 2)
+      return Type::Invalid;
+
+    auto cp = get_if<count>(v[1]);
+
+    if (!cp)
+      return Type::Invalid;
+
+    if (*cp > Type::MAX)
+      return Type::Invalid;
+
+    return Type(*cp);
+  }
+
 protected:
   Message(Type type, vector content)
     : data_(vector{ProtocolVersion, count(type), std::move(content)}) {}
@@ -291,6 +312,85 @@ public:
   }
 };
 
+/// A read-only view of a serialized Zeek event. Unlike @ref Event, this class
+/// accesses the fields in place without materializing the event first.
+class EventView {
+public:
+  explicit EventView(data_view msg) noexcept : msg_(msg) {}
+
+  std::string_view name() const {
+    return content()[0].to_string_view();
+  }
+
+  data_view_list args() const {
+    return content()[1].to_vector();
+  }
+
+  const std::optional<timestamp> ts() const {
+    auto xs = content();
+    if (xs.size() < 3)
+      return std::nullopt;
+    constexpr auto net_ts_key =
+      static_cast<count>(MetadataType::NetworkTimestamp);
+    for (auto entry : xs[2].to_vector()) {
+      auto kvp = entry.to_vector();
+      if (kvp[0].to_count() == net_ts_key)
+        return kvp[1].to_timestamp();
+    }
+    return std::nullopt;
+  }
+
+  /// Materializes the event.
+  Event to_event() const {
+    return Event{msg_.to_data()};
+  }
+
+  bool valid() const {
+    if (Message::type(msg_) != Message::Type::Event)
+      return false;
+
+    auto outer = msg_.to_vector();
+
+    if (outer.size() < 3 || !outer[2].is_vector())
+      return false;
+
+    auto v = outer[2].to_vector();
+
+    if (v.size() < 2 || !v[0].is_string() || !v[1].is_vector())
+      return false;
+
+    // Same checks for the optional event metadata as in Event::valid().
+    if (v.size() > 2) {
+      if (!v[2].is_vector())
+        return false;
+
+      for (auto mde : v[2].to_vector()) {
+        if (!mde.is_vector())
+          return false;
+
+        auto mdev = mde.to_vector();
+
+        if (mdev.size() != 2 || !mdev[0].is_count())
+          return false;
+
+        constexpr auto net_ts_key =
+          static_cast<count>(MetadataType::NetworkTimestamp);
+        if (mdev[0].to_count() == net_ts_key && !mdev[1].is_timestamp())
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  data_view_list content() const {
+    return msg_.to_vector()[2].to_vector();
+  }
+
+  data_view msg_;
+};
+
 /// A batch of other messages.
 class Batch : public Message {
 public:
@@ -0,0 +1,236 @@
+#include "broker/arena_data.hh"
+
+#include <cstring>
+#include <new>
+
+#include "broker/convert.hh"
+#include "broker/data_view.hh"
+#include "broker/detail/monotonic_buffer_resource.hh"
+
+namespace broker {
+
+namespace {
+
+// Computes how much memory we need for the arena: the number of nodes for all
+// container elements plus the number of characters for all strings.
+void measure(const data_view& x, size_t& nodes, size_t& chars) {
+  switch (x.get_type()) {
+    default:
+      break;
+    case data::type::string:
+      chars += x.to_string_view().size();
+      break;
+    case data::type::enum_value:
+      chars += x.to_enum_name().size();
+      break;
+    case data::type::set:
+    case data::type::vector: {
+      auto xs = x.is_set() ? x.to_set() : x.to_vector();
+      nodes += xs.size();
+      for (auto y : xs)
+        measure(y, nodes, chars);
+      break;
+    }
+    case data::type::table: {
+      auto xs = x.to_table();
+      nodes += xs.size() * 2;
+      for (auto [key, val] : xs) {
+        measure(key, nodes, chars);
+        measure(val, nodes, chars);
+      }
+      break;
+    }
+  }
+}
+
+// Fills a pre-allocated arena. Both regions must have the size computed by
+// `measure`.
+struct arena_builder {
+  arena_data* nodes;
+  char* chars;
+
+  arena_data* next_nodes(size_t n) {
+    auto result = nodes;
+    nodes += n;
+    return result;
+  }
+
+  std::string_view copy(std::string_view str) {
+    if (str.empty())
+      return {};
+    auto result = chars;
+    memcpy(result, str.data(), str.size());
+    chars += str.size();
+    return {result, str.size()};
+  }
+
+  template <class T>
+  void build_list(const data_view_list& xs, arena_data* dst) {
+    auto first = next_nodes(xs.size());
+    auto pos = first;
+    for (auto x : xs)
+      build(x, pos++);
+    new (dst) arena_data(T{first, xs.size()});
+  }
+
+  void build(const data_view& x, arena_data* dst) {
+    switch (x.get_type()) {
+      default:
+        new (dst) arena_data();
+        break;
+      case data::type::boolean:
+        new (dst) arena_data(x.to_boolean());
+        break;
+      case data::type::count:
+        new (dst) arena_data(x.to_count());
+        break;
+      case data::type::integer:
+        new (dst) arena_data(x.to_integer());
+        break;
+      case data::type::real:
+        new (dst) arena_data(x.to_real());
+        break;
+      case data::type::string:
+        new (dst) arena_data(copy(x.to_string_view()));
+        break;
+      case data::type::address:
+        new (dst) arena_data(x.to_address());
+        break;
+      case data::type::subnet:
+        new (dst) arena_data(x.to_subnet());
+        break;
+      case data::type::port:
+        new (dst) arena_data(x.to_port());
+        break;
+      case data::type::timestamp:
+        new (dst) arena_data(x.to_timestamp());
+        break;
+      case data::type::timespan:
+        new (dst) arena_data(x.to_timespan());
+        break;
+      case data::type::enum_value:
+        new (dst) arena_data(arena_enum_value{copy(x.to_enum_name())});
+        break;
+      case data::type::set:
+        build_list<arena_set>(x.to_set(), dst);
+        break;
+      case data::type::vector:
+        build_list<arena_vector>(x.to_vector(), dst);
+        break;
+      case data::type::table: {
+        auto xs = x.to_table();
+        auto first = next_nodes(xs.size() * 2);
+        auto pos = first;
+        for (auto [key, val] : xs) {
+          build(key, pos++);
+          build(val, pos++);
+        }
+        new (dst) arena_data(arena_table{first, xs.size()});
+        break;
+      }
+    }
+  }
+};
+
+} // namespace
+
+// -- arena_data ---------------------------------------------------------------
+
+data arena_data::to_data() const {
+  auto f = [](const auto& x) -> data {
+    using type = std::decay_t<decltype(x)>;
+    if constexpr (std::is_same_v<type, std::string_view>) {
+      return data{std::string{x}};
+    } else if constexpr (std::is_same_v<type, arena_enum_value>) {
+      return data{enum_value{std::string{x.name}}};
+    } else if constexpr (std::is_same_v<type, arena_set>) {
+      broker::set result;
+      for (auto& y : x)
+        result.emplace(y.to_data());
+      return data{std::move(result)};
+    } else if constexpr (std::is_same_v<type, arena_vector>) {
+      broker::vector result;
+      result.reserve(x.size());
+      for (auto& y : x)
+        result.emplace_back(y.to_data());
+      return data{std::move(result)};
+    } else if constexpr (std::is_same_v<type, arena_table>) {
+      broker::table result;
+      for (auto [key, val] : x)
+        result.emplace(key.to_data(), val.to_data());
+      return data{std::move(result)};
+    } else if constexpr (std::is_same_v<type, none>) {
+      return data{};
+    } else {
+      return data{x};
+    }
+  };
+  return std::visit(f, data_);
+}
+
+void convert(const arena_data& x, std::string& str) {
+  convert(x.to_data(), str);
+}
+
+std::string to_string(const arena_data& x) {
+  std::string result;
+  convert(x, result);
+  return result;
+}
+
+// -- arena_message ------------------------------------------------------------
+
+struct arena_message::impl {
+  impl(topic t, size_t arena_size)
+    : t(std::move(t)), mem(arena_size), size(arena_size) {
+    // nop
+  }
+
+  topic t;
+  detail::monotonic_buffer_resource mem;
+  size_t size;
+  arena_data* root = nullptr;
+};
+
+expected<arena_message> arena_message::make(packed_message msg) {
+  auto env = data_envelope::make(std::move(msg));
+  if (!env)
+    return std::move(env.error());
+  return make(*env);
+}
+
+arena_message arena_message::make(const data_envelope& msg) {
+  auto root = msg.value();
+  size_t num_nodes = 1; // The root node.
+  size_t num_chars = 0;
+  measure(root, num_nodes, num_chars);
+  auto node_bytes = num_nodes * sizeof(arena_data);
+  // Reserve some extra space for aligning the nodes.
+  auto arena_size = node_bytes + num_chars + alignof(arena_data);
+  auto ptr = std::make_shared<impl>(msg.get_topic(), arena_size);
+  auto nodes = ptr->mem.allocate(node_bytes, alignof(arena_data));
+  auto chars = num_chars > 0 ? ptr->mem.allocate(num_chars, 1) : nullptr;
+  arena_builder builder{static_cast<arena_data*>(nodes),
+                        static_cast<char*>(chars)};
+  ptr->root = builder.next_nodes(1);
+  builder.build(root, ptr->root);
+  return arena_message{std::move(ptr)};
+}
+
+const topic& arena_message::get_topic() const noexcept {
+  return impl_->t;
+}
+
+const arena_data& arena_message::value() const noexcept {
+  return *impl_->root;
+}
+
+size_t arena_message::arena_size() const noexcept {
+  return impl_->size;
+}
+
+data_message arena_message::to_data_message() const {
+  return make_data_message(get_topic(), value().to_data());
+}
+
+} // namespace broker
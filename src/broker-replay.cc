@@ -0,0 +1,206 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/endpoint.hh"
+#include "broker/error.hh"
+#include "broker/internal/capture_reader.hh"
+#include "broker/internal/type_id.hh"
+#include "broker/message.hh"
+#include "broker/time.hh"
+#include "broker/topic.hh"
+
+// Re-publishes the data messages of a capture, i.e., the segment files that a
+// Broker endpoint writes when setting `broker.capture.directory`. Each
+// publisher thread maps the capture into memory on its own and publishes the
+// subset of topics that hash to its index. Hence, the order of messages per
+// topic remains the same as in the capture.
+
+using broker::data;
+using broker::topic;
+using broker::internal::capture_record;
+
+namespace {
+
+std::mutex cout_mtx;
+
+using guard_type = std::unique_lock<std::mutex>;
+
+std::atomic<size_t> msg_count{0};
+
+std::atomic<size_t> skip_count{0};
+
+void print_line(std::ostream& out, const std::string& line) {
+  guard_type guard{cout_mtx};
+  out << line << std::endl;
+}
+
+struct parameters {
+  std::string capture;
+  std::vector<std::string> peers;
+  uint64_t local_port = 0;
+  double speed = 1.0;
+  uint64_t threads = 1;
+};
+
+// Adds custom configuration options to the config object.
+void extend_config(parameters& param, broker::configuration& cfg) {
+  cfg.add_option(&param.capture, "capture,c",
+                 "directory with the segment files of the capture");
+  cfg.add_option(&param.peers, "peers,p",
+                 "list of peers we connect to on startup (host:port notation)");
+  cfg.add_option(&param.local_port, "local-port,l",
+                 "local port for publishing this endpoint at (ignored if 0)");
+  cfg.add_option(&param.speed, "speed,s",
+                 "scales the original timing, e.g., 2 replays twice as fast "
+                 "(0 = as fast as possible)");
+  cfg.add_option(&param.threads, "threads,t", "number of publisher threads");
+}
+
+using clock_type = std::chrono::steady_clock;
+
+// Publishes all data messages in the capture that belong to this thread.
+void replay(broker::endpoint& ep, const parameters& params, size_t index,
+            broker::timestamp first, clock_type::time_point start) {
+  auto reader = broker::internal::make_capture_reader(params.capture);
+  if (!reader) {
+    print_line(std::cerr, "*** unable to open capture: " + params.capture);
+    return;
+  }
+  std::hash<std::string> hasher;
+  capture_record rec;
+  for (;;) {
+    if (auto err = reader->read(rec)) {
+      if (err != broker::ec::end_of_file)
+        print_line(std::cerr, "*** failed to read capture: " + to_string(err));
+      return;
+    }
+    // Store commands only make sense in the context of the original masters
+    // and clones.
+    if (get_type(rec.msg) != broker::packed_message_type::data) {
+      if (index == 0)
+        ++skip_count;
+      continue;
+    }
+    const auto& str = get_topic(rec.msg).string();
+    if (hasher(str) % params.threads != index)
+      continue;
+    if (params.speed > 0) {
+      auto offset = std::chrono::duration_cast<clock_type::duration>(
+        (rec.captured - first) / params.speed);
+      std::this_thread::sleep_until(start + offset);
+    }
+    caf::binary_deserializer src{nullptr, get_payload(rec.msg)};
+    data content;
+    if (!src.apply(content)) {
+      ++skip_count;
+      continue;
+    }
+    ep.publish(get_topic(rec.msg), std::move(content));
+    ++msg_count;
+  }
+}
+
+void split(std::vector<std::string>& result, std::string_view str,
+           std::string_view delims, bool keep_all = true) {
+  size_t pos = 0;
+  size_t prev = 0;
+  while ((pos = str.find_first_of(delims, prev)) != std::string::npos) {
+    auto substr = str.substr(prev, pos - prev);
+    if (keep_all || !substr.empty())
+      result.emplace_back(substr);
+    prev = pos + 1;
+  }
+  if (prev < str.size())
+    result.emplace_back(str.substr(prev));
+  else if (keep_all)
+    result.emplace_back();
+}
+
+} // namespace
+
+int main(int argc, char** argv) try {
+  broker::endpoint::system_guard sys_guard;
+  // Parse CLI parameters using our config.
+  parameters params;
+  broker::configuration cfg{broker::skip_init};
+  extend_config(params, cfg);
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << "*** error while reading config: " << ex.what() << '\n';
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed()) {
+    return EXIT_SUCCESS;
+  } else if (!cfg.remainder().empty()) {
+    std::cerr << "*** too many arguments\n\n";
+    return EXIT_FAILURE;
+  } else if (params.capture.empty()) {
+    std::cerr << "*** missing capture directory (--capture)\n";
+    return EXIT_FAILURE;
+  } else if (params.threads == 0 || params.speed < 0) {
+    std::cerr << "*** invalid number of threads or speed\n";
+    return EXIT_FAILURE;
+  }
+  // Read the first record for computing the offsets of all other records.
+  auto reader = broker::internal::make_capture_reader(params.capture);
+  capture_record first;
+  if (!reader || reader->read(first)) {
+    std::cerr << "*** unable to read capture: " << params.capture << '\n';
+    return EXIT_FAILURE;
+  }
+  reader.reset();
+  broker::endpoint ep{std::move(cfg)};
+  // Publish endpoint at demanded port.
+  if (params.local_port != 0)
+    ep.listen({}, params.local_port);
+  // Connect to the requested peers.
+  for (auto& p : params.peers) {
+    std::vector<std::string> fields;
+    split(fields, p, ":");
+    if (fields.size() != 2) {
+      std::cerr << "*** invalid peer: " << p << std::endl;
+      continue;
+    }
+    uint16_t port;
+    try {
+      port = static_cast<uint16_t>(std::stoi(fields.back()));
+    } catch (std::exception&) {
+      std::cerr << "*** invalid port: " << fields.back() << std::endl;
+      continue;
+    }
+    if (!ep.peer(fields.front(), port))
+      std::cerr << "*** unable to peer with: " << p << std::endl;
+  }
+  // Replay the capture.
+  auto start = clock_type::now();
+  std::vector<std::thread> publishers;
+  publishers.reserve(params.threads);
+  for (size_t index = 0; index < params.threads; ++index)
+    publishers.emplace_back(replay, std::ref(ep), std::cref(params), index,
+                            first.captured, start);
+  for (auto& publisher : publishers)
+    publisher.join();
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+    clock_type::now() - start);
+  std::cout << "*** published " << msg_count << " messages in "
+            << elapsed.count() << "ms, skipped " << skip_count
+            << " messages\n";
+} catch (std::exception& ex) {
+  std::cerr << "*** exception: " << ex.what() << "\n";
+  return EXIT_FAILURE;
+}
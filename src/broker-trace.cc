@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "broker/endpoint_id.hh"
+#include "broker/error.hh"
+#include "broker/internal/trace.hh"
+#include "broker/time.hh"
+
+// Decodes a binary trace dump, i.e., the response of an endpoint for
+// `GET /v1/trace/dump` on its metrics port, and prints one line per record.
+// Trace records only store hashes of topics and peer IDs. Users may pass the
+// topics and peer IDs they are interested in to resolve these hashes.
+
+using broker::internal::trace_hash;
+using broker::internal::trace_record;
+
+namespace {
+
+constexpr std::string_view usage =
+  "usage: broker-trace [-t TOPIC]... [-p ENDPOINT-ID]... FILE\n"
+  "\n"
+  "  -t TOPIC        print TOPIC instead of its hash\n"
+  "  -p ENDPOINT-ID  print ENDPOINT-ID instead of its hash\n"
+  "  FILE            binary trace dump ('-' for STDIN)\n";
+
+using name_map = std::unordered_map<uint64_t, std::string>;
+
+std::string to_hex(uint64_t x) {
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << x;
+  return out.str();
+}
+
+std::string lookup(const name_map& names, uint64_t hash) {
+  if (hash == 0)
+    return "-";
+  if (auto i = names.find(hash); i != names.end())
+    return i->second;
+  return to_hex(hash);
+}
+
+bool read_all(std::istream& in, std::vector<std::byte>& buf) {
+  std::vector<char> chars{std::istreambuf_iterator<char>{in},
+                          std::istreambuf_iterator<char>{}};
+  if (in.bad())
+    return false;
+  auto first = reinterpret_cast<const std::byte*>(chars.data());
+  buf.assign(first, first + chars.size());
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  name_map topics;
+  name_map peers;
+  std::string path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if ((arg == "-t" || arg == "-p") && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (arg == "-t") {
+        topics.emplace(trace_hash(std::string_view{name}), name);
+      } else {
+        broker::endpoint_id id;
+        if (!convert(name, id)) {
+          std::cerr << "*** invalid endpoint ID: " << name << '\n';
+          return EXIT_FAILURE;
+        }
+        peers.emplace(trace_hash(id), name);
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      std::cout << usage;
+      return EXIT_SUCCESS;
+    } else if (path.empty() && (arg == "-" || arg.front() != '-')) {
+      path = arg;
+    } else {
+      std::cerr << "*** invalid argument: " << arg << "\n\n" << usage;
+      return EXIT_FAILURE;
+    }
+  }
+  if (path.empty()) {
+    std::cerr << "*** missing input file\n\n" << usage;
+    return EXIT_FAILURE;
+  }
+  std::vector<std::byte> buf;
+  if (path == "-") {
+    if (!read_all(std::cin, buf)) {
+      std::cerr << "*** unable to read from STDIN\n";
+      return EXIT_FAILURE;
+    }
+  } else {
+    std::ifstream in{path, std::ios::binary};
+    if (!in || !read_all(in, buf)) {
+      std::cerr << "*** unable to read file: " << path << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+  auto records = broker::internal::parse_trace_dump(buf.data(), buf.size());
+  if (!records) {
+    std::cerr << "*** " << to_string(records.error()) << '\n';
+    return EXIT_FAILURE;
+  }
+  for (const auto& rec : *records) {
+    auto ts = broker::timestamp{broker::timespan{rec.timestamp}};
+    std::cout << broker::to_string(ts) << ' ' << rec.thread << ' '
+              << to_string(rec.event) << " peer=" << lookup(peers, rec.peer)
+              << " topic=" << lookup(topics, rec.topic)
+              << " size=" << rec.size << '\n';
+  }
+  return EXIT_SUCCESS;
+}
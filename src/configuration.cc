@@ -25,11 +25,13 @@
 #include "broker/internal/configuration_access.hh"
 #include "broker/internal/core_actor.hh"
 #include "broker/internal/native.hh"
+#include "broker/internal/publish_limiter.hh"
 #include "broker/internal/retry_state.hh"
 #include "broker/internal/type_id.hh"
 #include "broker/internal_command.hh"
 #include "broker/lamport_timestamp.hh"
 #include "broker/port.hh"
+#include "broker/publish_limit.hh"
 #include "broker/snapshot.hh"
 #include "broker/status.hh"
 #include "broker/store.hh"
@@ -119,7 +121,49 @@ struct configuration::impl : public caf::actor_system_config {
         "output-generator-file-cap",
         "maximum number of entries when recording published messages")
       .add<size_t>("max-pending-inputs-per-source",
-                   "maximum number of items we buffer per peer or publisher");
+                   "maximum number of items we buffer per peer or publisher")
+      .add<string_list>("publish-limits",
+                        "limits for local publishers per topic prefix, e.g., "
+                        "'zeek/logs/ rate=1000 burst=2000 sample=1'");
+    opt_group{custom_options_, "broker.core"} //
+      .add<size_t>("dispatch-shards",
+                   "number of background workers for dispatching messages "
+                   "to peers (0 = dispatch in the core)");
+    opt_group{custom_options_, "broker.connector"} //
+      .add(options.connector_threads, "threads",
+           "number of threads for performing peering handshakes");
+    opt_group{custom_options_, "broker.capture"}
+      .add<string>("directory",
+                   "if set, causes Broker to write data and command messages "
+                   "to segment files in this directory")
+      .add<string_list>("topics",
+                        "selects topic prefixes for capturing (default: all)")
+      .add<size_t>("segment-size", "size of a single segment file in bytes")
+      .add<size_t>("buffer-size",
+                   "maximum number of messages waiting for the capture "
+                   "(drops messages when full)");
+    opt_group{custom_options_, "broker.trace"}
+      .add<bool>("enabled", "records hot-path events in per-thread ring "
+                            "buffers (see /v1/trace on the metrics port)")
+      .add<size_t>("buffer-size", "number of trace records per thread");
+    opt_group{custom_options_, "broker.peering"}
+      .add<size_t>("write-batch-size",
+                   "maximum number of messages per write to a peer "
+                   "(1 = no batching)")
+      .add<caf::timespan>("write-batch-delay",
+                          "maximum delay for filling up a batch of messages")
+      .add<size_t>("read-ahead", "maximum number of bytes per read from a "
+                                 "peer (0 = no read-ahead)");
+    opt_group{custom_options_, "broker.priority"}
+      .add<bool>("enabled", "schedules control traffic ahead of bulk data in "
+                            "the core and at each peer writer")
+      .add<string_list>("high-prefixes",
+                        "selects topic prefixes for the high-priority lane "
+                        "(internal topics always use the high lane)")
+      .add<size_t>("buffer-size",
+                   "maximum number of buffered messages per input of a "
+                   "priority stage and per output buffer to a peer (at "
+                   "least broker.peering.write-batch-size at peer writers)");
     opt_group{custom_options_, "broker.web-socket"} //
       .add<string>("address", "bind address for the WebSocket server socket")
       .add<port>("port", "port for incoming WebSocket connections");
@@ -129,12 +173,20 @@ struct configuration::impl : public caf::actor_system_config {
       .add<string>(
         "endpoint-name",
         "name for this endpoint in metrics (when exporting: suffix of "
-        "the topic by default)");
+        "the topic by default)")
+      .add(options.latency_prefixes, "latency-prefixes",
+           "enables end-to-end latency histograms for the topic prefixes")
+      .add<caf::timespan>("max-staleness",
+                          "maximum age of cached HTTP responses before the "
+                          "Prometheus actor renders them again");
     opt_group{custom_options_, "broker.metrics.export"}
       .add<string>("topic", "if set, causes Broker to publish its metrics "
                             "periodically on the given topic")
       .add<caf::timespan>("interval",
                           "time between publishing metrics on the topic")
+      .add<caf::timespan>("full-interval",
+                          "if set, publishes all metrics only once per "
+                          "interval and otherwise only changed metrics")
       .add<string_list>("prefixes",
                         "selects metric prefixes to publish on the topic");
     opt_group{custom_options_, "broker.metrics.import"} //
@@ -149,7 +201,17 @@ struct configuration::impl : public caf::actor_system_config {
       .add(ssl_options->capath, "capath",
            "path to an OpenSSL-style directory of trusted certificates")
       .add(ssl_options->cafile, "cafile",
-           "path to a file of concatenated PEM-formatted certificates");
+           "path to a file of concatenated PEM-formatted certificates")
+      .add(ssl_options->session_cache_size, "session-cache-size",
+           "maximum number of TLS sessions for resuming sessions with peers "
+           "(0 = always perform full handshakes)")
+      .add(ssl_options->session_timeout, "session-timeout",
+           "lifetime of TLS sessions and session tickets")
+      .add(ssl_options->session_tickets, "session-tickets",
+           "enables session resumption via TLS session tickets")
+      .add(ssl_options->session_ticket_key_file, "session-ticket-key-file",
+           "path to a file with at least 80 random bytes for encrypting "
+           "session tickets (default: random keys per process)");
     // Ensure that we're only talking to compatible Broker instances.
     string_list ids{"broker.v" + std::to_string(version::protocol)};
     // Override CAF defaults.
@@ -200,6 +262,8 @@ configuration::configuration(broker_options opts) : configuration(skip_init) {
   impl_->options = opts;
   impl_->set("broker.ttl", opts.ttl);
   caf::put(impl_->content, "disable-forwarding", opts.disable_forwarding);
+  if (!opts.latency_prefixes.empty())
+    impl_->set("broker.metrics.latency-prefixes", opts.latency_prefixes);
   init(0, nullptr);
   impl_->config_file_path = "broker.conf";
 }
@@ -324,6 +388,19 @@ void configuration::impl::init(int argc, char** argv) {
       throw std::runtime_error(what);
     }
   }
+  // Check settings that CAF cannot validate for us.
+  using string_list = std::vector<std::string>;
+  for (const auto& policy :
+       caf::get_or(content, "broker.publish-limits", string_list{})) {
+    topic prefix;
+    publish_limit limit;
+    if (!internal::publish_limiter::parse_policy(policy, prefix, limit)) {
+      auto what = concat("invalid value for broker.publish-limits: '", policy,
+                         "' (expected a topic prefix followed by a limit such "
+                         "as 'rate=1000 burst=2000 sample=1')");
+      throw std::invalid_argument(what);
+    }
+  }
 }
 
 void configuration::init(int argc, char** argv) {
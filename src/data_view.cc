@@ -0,0 +1,395 @@
+#include "broker/data_view.hh"
+
+#include <caf/detail/ieee_754.hpp>
+
+#include <cstring>
+#include <limits>
+
+#include "broker/convert.hh"
+#include "broker/defaults.hh"
+#include "broker/error.hh"
+
+namespace broker {
+
+namespace {
+
+// The functions in this namespace mirror the layout of the CAF binary format
+// for broker::data:
+// - the variant index as uint8_t, followed by the value;
+// - integers as fixed-size, big-endian values;
+// - reals as IEEE 754 encoded uint64_t;
+// - strings and sequences (set, table, vector) with a varbyte length prefix;
+// - tables as a sequence of key-value pairs;
+// - timestamps and timespans as int64_t count of nanoseconds;
+// - addresses as 16 raw bytes;
+// - subnets as address followed by an uint8_t length;
+// - ports as uint16_t number followed by an uint8_t protocol;
+// - enum values as their name (string);
+// - none as an empty object (no bytes).
+
+constexpr auto max_type_tag = static_cast<uint8_t>(data::type::vector);
+
+constexpr auto max_protocol = static_cast<uint8_t>(port::protocol::icmp);
+
+uint8_t to_u8(std::byte x) noexcept {
+  return std::to_integer<uint8_t>(x);
+}
+
+template <class T>
+T read_be(const std::byte* pos) noexcept {
+  using unsigned_type = std::make_unsigned_t<T>;
+  unsigned_type result = 0;
+  for (size_t i = 0; i < sizeof(T); ++i)
+    result = static_cast<unsigned_type>((result << 8) | to_u8(pos[i]));
+  return static_cast<T>(result);
+}
+
+/// Reads a varbyte-encoded size and advances `pos` past the encoded value.
+size_t read_varbyte(const std::byte*& pos) noexcept {
+  uint32_t result = 0;
+  int shift = 0;
+  uint8_t low7 = 0;
+  do {
+    low7 = to_u8(*pos++);
+    result |= static_cast<uint32_t>(low7 & 0x7F) << shift;
+    shift += 7;
+  } while ((low7 & 0x80) != 0);
+  return result;
+}
+
+/// Bounds-checked version of `read_varbyte`. Returns `false` on malformed
+/// input.
+bool read_varbyte(const std::byte*& pos, const std::byte* end,
+                  size_t& result) noexcept {
+  uint32_t x = 0;
+  int shift = 0;
+  uint8_t low7 = 0;
+  do {
+    // A 32-bit value needs at most 5 bytes.
+    if (pos == end || shift > 28)
+      return false;
+    low7 = to_u8(*pos++);
+    x |= static_cast<uint32_t>(low7 & 0x7F) << shift;
+    shift += 7;
+  } while ((low7 & 0x80) != 0);
+  result = x;
+  return true;
+}
+
+/// Returns the size of fixed-size types (excluding the type tag) or 0 for
+/// types with variable size.
+size_t fixed_size(data::type tag) noexcept {
+  switch (tag) {
+    default:
+      return 0;
+    case data::type::boolean:
+      return 1;
+    case data::type::count:
+    case data::type::integer:
+    case data::type::real:
+    case data::type::timestamp:
+    case data::type::timespan:
+      return 8;
+    case data::type::address:
+      return address::num_bytes;
+    case data::type::subnet:
+      return address::num_bytes + 1;
+    case data::type::port:
+      return 3;
+  }
+}
+
+/// Returns a pointer past the end of the serialized object at `pos`.
+/// @pre `pos` points to a valid, serialized object. Validation also bounds the
+///      depth of the recursion.
+const std::byte* skip(const std::byte* pos) noexcept {
+  auto tag = static_cast<data::type>(*pos++);
+  switch (tag) {
+    case data::type::none:
+      return pos;
+    case data::type::string:
+    case data::type::enum_value: {
+      auto n = read_varbyte(pos);
+      return pos + n;
+    }
+    case data::type::set:
+    case data::type::vector: {
+      auto n = read_varbyte(pos);
+      for (size_t i = 0; i < n; ++i)
+        pos = skip(pos);
+      return pos;
+    }
+    case data::type::table: {
+      auto n = read_varbyte(pos);
+      for (size_t i = 0; i < n * 2; ++i)
+        pos = skip(pos);
+      return pos;
+    }
+    default:
+      return pos + fixed_size(tag);
+  }
+}
+
+/// Returns a pointer past the end of the serialized object at `pos` or
+/// `nullptr` if the input is malformed or nests containers deeper than
+/// `max_data_view_depth`.
+const std::byte* validate(const std::byte* pos, const std::byte* end,
+                          size_t depth = 0) noexcept {
+  if (pos == end)
+    return nullptr;
+  auto raw_tag = to_u8(*pos++);
+  if (raw_tag > max_type_tag)
+    return nullptr;
+  auto tag = static_cast<data::type>(raw_tag);
+  auto remaining = [&] { return static_cast<size_t>(end - pos); };
+  switch (tag) {
+    case data::type::none:
+      return pos;
+    case data::type::string:
+    case data::type::enum_value: {
+      size_t n = 0;
+      if (!read_varbyte(pos, end, n) || remaining() < n)
+        return nullptr;
+      return pos + n;
+    }
+    case data::type::set:
+    case data::type::vector:
+    case data::type::table: {
+      size_t n = 0;
+      if (depth == max_data_view_depth || !read_varbyte(pos, end, n))
+        return nullptr;
+      if (tag == data::type::table)
+        n *= 2;
+      for (size_t i = 0; i < n; ++i)
+        if (pos = validate(pos, end, depth + 1); pos == nullptr)
+          return nullptr;
+      return pos;
+    }
+    case data::type::subnet: {
+      if (remaining() < fixed_size(tag))
+        return nullptr;
+      address net;
+      memcpy(net.bytes().data(), pos, address::num_bytes);
+      auto len = to_u8(pos[address::num_bytes]);
+      if (len > 128 || (net.is_v4() && len < 96))
+        return nullptr;
+      return pos + fixed_size(tag);
+    }
+    case data::type::port: {
+      if (remaining() < fixed_size(tag) || to_u8(pos[2]) > max_protocol)
+        return nullptr;
+      return pos + fixed_size(tag);
+    }
+    default: {
+      if (remaining() < fixed_size(tag))
+        return nullptr;
+      return pos + fixed_size(tag);
+    }
+  }
+}
+
+address read_address(const std::byte* pos) noexcept {
+  address result;
+  memcpy(result.bytes().data(), pos, address::num_bytes);
+  return result;
+}
+
+} // namespace
+
+// -- data_view ----------------------------------------------------------------
+
+span<const std::byte> data_view::raw_bytes() const noexcept {
+  if (pos_ == nullptr)
+    return {};
+  return {pos_, skip(pos_)};
+}
+
+boolean data_view::to_boolean() const noexcept {
+  return to_u8(pos_[1]) != 0;
+}
+
+count data_view::to_count() const noexcept {
+  return read_be<count>(pos_ + 1);
+}
+
+integer data_view::to_integer() const noexcept {
+  return read_be<integer>(pos_ + 1);
+}
+
+real data_view::to_real() const noexcept {
+  return caf::detail::unpack754(read_be<uint64_t>(pos_ + 1));
+}
+
+std::string_view data_view::to_string_view() const noexcept {
+  auto pos = pos_ + 1;
+  auto n = read_varbyte(pos);
+  return {reinterpret_cast<const char*>(pos), n};
+}
+
+address data_view::to_address() const noexcept {
+  return read_address(pos_ + 1);
+}
+
+subnet data_view::to_subnet() const noexcept {
+  auto net = read_address(pos_ + 1);
+  auto len = to_u8(pos_[1 + address::num_bytes]);
+  // Subnets store the length for IPv4 addresses in their IPv6 representation.
+  return subnet{net, static_cast<uint8_t>(net.is_v4() ? len - 96 : len)};
+}
+
+port data_view::to_port() const noexcept {
+  auto num = read_be<uint16_t>(pos_ + 1);
+  auto proto = static_cast<port::protocol>(to_u8(pos_[3]));
+  return port{num, proto};
+}
+
+timestamp data_view::to_timestamp() const noexcept {
+  return timestamp{timespan{read_be<int64_t>(pos_ + 1)}};
+}
+
+timespan data_view::to_timespan() const noexcept {
+  return timespan{read_be<int64_t>(pos_ + 1)};
+}
+
+std::string_view data_view::to_enum_name() const noexcept {
+  return to_string_view();
+}
+
+data_view_list data_view::to_set() const noexcept {
+  auto pos = pos_ + 1;
+  auto n = read_varbyte(pos);
+  return {pos, n};
+}
+
+data_view_table data_view::to_table() const noexcept {
+  auto pos = pos_ + 1;
+  auto n = read_varbyte(pos);
+  return {pos, n};
+}
+
+data_view_list data_view::to_vector() const noexcept {
+  return to_set();
+}
+
+data data_view::to_data() const {
+  switch (get_type()) {
+    default:
+      return data{};
+    case data::type::boolean:
+      return data{to_boolean()};
+    case data::type::count:
+      return data{to_count()};
+    case data::type::integer:
+      return data{to_integer()};
+    case data::type::real:
+      return data{to_real()};
+    case data::type::string:
+      return data{std::string{to_string_view()}};
+    case data::type::address:
+      return data{to_address()};
+    case data::type::subnet:
+      return data{to_subnet()};
+    case data::type::port:
+      return data{to_port()};
+    case data::type::timestamp:
+      return data{to_timestamp()};
+    case data::type::timespan:
+      return data{to_timespan()};
+    case data::type::enum_value:
+      return data{enum_value{std::string{to_enum_name()}}};
+    case data::type::set: {
+      broker::set result;
+      for (auto x : to_set())
+        result.emplace(x.to_data());
+      return data{std::move(result)};
+    }
+    case data::type::table: {
+      broker::table result;
+      for (auto [key, val] : to_table())
+        result.emplace(key.to_data(), val.to_data());
+      return data{std::move(result)};
+    }
+    case data::type::vector: {
+      broker::vector result;
+      auto xs = to_vector();
+      result.reserve(xs.size());
+      for (auto x : xs)
+        result.emplace_back(x.to_data());
+      return data{std::move(result)};
+    }
+  }
+}
+
+// -- data_view_iterator -------------------------------------------------------
+
+data_view_iterator& data_view_iterator::operator++() noexcept {
+  if (--remaining_ > 0)
+    pos_ = skip(pos_);
+  else
+    pos_ = nullptr;
+  return *this;
+}
+
+// -- data_view_table_iterator -------------------------------------------------
+
+data_view_table_iterator::data_view_table_iterator(const std::byte* pos,
+                                                   size_t remaining) noexcept
+  : pos_(pos), remaining_(remaining) {
+  if (remaining_ > 0)
+    value_pos_ = skip(pos_);
+}
+
+data_view_table_iterator& data_view_table_iterator::operator++() noexcept {
+  if (--remaining_ > 0) {
+    pos_ = skip(value_pos_);
+    value_pos_ = skip(pos_);
+  } else {
+    pos_ = nullptr;
+    value_pos_ = nullptr;
+  }
+  return *this;
+}
+
+// -- data_view_list -----------------------------------------------------------
+
+data_view data_view_list::operator[](size_t index) const noexcept {
+  auto pos = first_;
+  for (size_t i = 0; i < index; ++i)
+    pos = skip(pos);
+  return data_view{pos};
+}
+
+// -- data_envelope ------------------------------------------------------------
+
+expected<data_envelope> data_envelope::make(packed_message msg) {
+  if (get_type(msg) != packed_message_type::data
+      || !is_valid_data_encoding(get_payload(msg)))
+    return make_error(ec::invalid_data);
+  return data_envelope{std::move(msg)};
+}
+
+expected<data_envelope> data_envelope::make(topic t,
+                                            std::vector<std::byte> bytes) {
+  return make(make_packed_message(packed_message_type::data, defaults::ttl,
+                                  std::move(t), std::move(bytes)));
+}
+
+// -- free functions -----------------------------------------------------------
+
+bool is_valid_data_encoding(span<const std::byte> bytes) noexcept {
+  auto first = bytes.data();
+  auto last = first + bytes.size();
+  return validate(first, last) == last;
+}
+
+void convert(const data_view& x, std::string& str) {
+  convert(x.to_data(), str);
+}
+
+std::string to_string(const data_view& x) {
+  std::string result;
+  convert(x, result);
+  return result;
+}
+
+} // namespace broker
@@ -1,5 +1,11 @@
 #include "broker/detail/abstract_backend.hh"
 #include "broker/detail/appliers.hh"
+#include "broker/detail/key_index.hh"
+#include "broker/detail/subnet_index.hh"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
 
 namespace broker::detail {
 
@@ -36,4 +42,90 @@ expected<data> abstract_backend::get(const data& key, const data& value) const {
     return k;
 }
 
+expected<std::vector<data>> abstract_backend::expire_due(timestamp current_time,
+                                                       size_t limit) {
+  auto xs = expiries();
+  if (!xs)
+    return xs.error();
+  auto is_due = [current_time](const expirable& x) {
+    return x.second <= current_time;
+  };
+  auto first = xs->begin();
+  auto last = std::partition(first, xs->end(), is_due);
+  auto by_expiry = [](const expirable& x, const expirable& y) {
+    return std::tie(x.second, x.first) < std::tie(y.second, y.first);
+  };
+  std::sort(first, last, by_expiry);
+  std::vector<data> result;
+  for (; first != last && result.size() < limit; ++first) {
+    auto res = expire(first->first, current_time);
+    if (!res)
+      return res.error();
+    if (*res)
+      result.emplace_back(std::move(first->first));
+  }
+  return result;
+}
+
+expected<void> abstract_backend::flush() {
+  return {};
+}
+
+bool abstract_backend::has_expiry_index() const noexcept {
+  return false;
+}
+
+expected<data> abstract_backend::scan(const data& first, const data& last,
+                                      count limit) const {
+  if (limit == 0)
+    return make_scan_result(table{}, data{});
+  // Backends without an ordered index need to filter and sort a snapshot.
+  auto ss = snapshot();
+  if (!ss)
+    return ss.error();
+  std::vector<const data*> keys;
+  for (const auto& kvp : *ss)
+    if (in_scan_range(kvp.first, first, last) && !(kvp.first < first))
+      keys.emplace_back(&kvp.first);
+  std::sort(keys.begin(), keys.end(), key_index::less{});
+  table entries;
+  for (size_t index = 0; index < keys.size(); ++index) {
+    if (index == limit)
+      return make_scan_result(std::move(entries), *keys[index]);
+    entries.emplace_hint(entries.end(), *keys[index], ss->at(*keys[index]));
+  }
+  return make_scan_result(std::move(entries), data{});
+}
+
+expected<data> abstract_backend::lookup_containing(const address& addr) const {
+  // Backends without a subnet index need to test each key.
+  auto ss = snapshot();
+  if (!ss)
+    return ss.error();
+  const std::pair<const data, data>* best = nullptr;
+  uint8_t best_len = 0;
+  for (const auto& kvp : *ss) {
+    if (auto net = get_if<subnet>(kvp.first); net && net->contains(addr)) {
+      if (auto len = full_length(*net); !best || len > best_len) {
+        best = &kvp;
+        best_len = len;
+      }
+    }
+  }
+  if (!best)
+    return ec::no_such_key;
+  return vector{best->first, best->second};
+}
+
+expected<data> abstract_backend::covered_by(const subnet& net) const {
+  auto ss = snapshot();
+  if (!ss)
+    return ss.error();
+  table entries;
+  for (auto& kvp : *ss)
+    if (auto x = get_if<subnet>(kvp.first); x && is_covered_by(*x, net))
+      entries.emplace_hint(entries.end(), kvp.first, kvp.second);
+  return {std::move(entries)};
+}
+
 } // namespace broker::detail
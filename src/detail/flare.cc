@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <thread>
 
 #include <caf/error.hpp>
 #include <caf/expected.hpp>
@@ -14,6 +15,10 @@
 #include "broker/detail/assert.hh"
 #include "broker/internal/logger.hh"
 
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
 #ifdef BROKER_WINDOWS
 
 #  include <Winsock2.h>
@@ -39,10 +44,15 @@ bool try_again_later() {
 #else // BROKER_WINDOWS
 
 #  include <cerrno>
+#  include <cstring>
 #  include <fcntl.h>
 #  include <poll.h>
 #  include <unistd.h>
 
+#  ifdef BROKER_LINUX
+#    include <sys/eventfd.h>
+#  endif
+
 #  define PIPE_WRITE ::write
 
 #  define PIPE_READ ::read
@@ -64,6 +74,25 @@ namespace broker::detail {
 
 namespace {
 
+// Bounds for the number of iterations in flare::spin.
+constexpr uint32_t min_spin_limit = 16;
+constexpr uint32_t initial_spin_limit = 256;
+constexpr uint32_t max_spin_limit = 4096;
+
+void cpu_relax() noexcept {
+#if defined(_MSC_VER)
+  _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+#ifndef BROKER_LINUX
+
 constexpr size_t stack_buffer_size = 256;
 
 struct stack_buffer {
@@ -74,9 +103,57 @@ struct stack_buffer {
   }
 };
 
+#endif // BROKER_LINUX
+
 } // namespace
 
-flare::flare() {
+#ifdef BROKER_LINUX
+
+flare::flare() : spin_limit_(initial_spin_limit) {
+  fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (fd_ < 0) {
+    BROKER_ERROR("failed to create eventfd: " << strerror(errno));
+    abort();
+  }
+}
+
+flare::~flare() {
+  ::close(fd_);
+}
+
+native_socket flare::fd() const {
+  return fd_;
+}
+
+void flare::signal() {
+  uint64_t one = 1;
+  for (;;) {
+    auto n = ::write(fd_, &one, sizeof(one));
+    if (n == sizeof(one))
+      return;
+    if (n < 0 && errno == EINTR)
+      continue;
+    BROKER_ERROR("unable to write flare eventfd!");
+    std::terminate();
+  }
+}
+
+void flare::drain() {
+  uint64_t tmp = 0;
+  for (;;) {
+    auto n = ::read(fd_, &tmp, sizeof(tmp));
+    if (n == sizeof(tmp) || (n < 0 && try_again_later()))
+      return;
+    if (n < 0 && errno == EINTR)
+      continue;
+    BROKER_ERROR("unable to read flare eventfd!");
+    std::terminate();
+  }
+}
+
+#else // BROKER_LINUX
+
+flare::flare() : spin_limit_(initial_spin_limit) {
   auto maybe_fds = caf::net::make_pipe();
   if (!maybe_fds) {
     BROKER_ERROR("failed to create pipe: " << maybe_fds.error());
@@ -93,9 +170,6 @@ flare::flare() {
     BROKER_ERROR("failed to set flare fd 0 NONBLOCK: " << err);
     std::terminate();
   }
-  // Do not set the write handle to nonblock, because we want the producer to
-  // slow down in case the consumer cannot keep up emptying the pipe.
-  //::fcntl(fds_[1], F_SETFL, ::fcntl(fds_[1], F_GETFL) | O_NONBLOCK);
 }
 
 flare::~flare() {
@@ -107,46 +181,86 @@ native_socket flare::fd() const {
   return fds_[0];
 }
 
-void flare::fire(size_t num) {
-  stack_buffer tmp;
-  size_t remaining = num;
-  while (remaining > 0) {
-    int len = static_cast<int>(std::min(remaining, stack_buffer_size));
-    auto n = PIPE_WRITE(fds_[1], tmp.data, len);
-    if (n <= 0) {
-      BROKER_ERROR("unable to write flare pipe!");
-      std::terminate();
-    }
-    remaining -= static_cast<size_t>(n);
+void flare::signal() {
+  char tmp = 0;
+  if (PIPE_WRITE(fds_[1], &tmp, 1) <= 0) {
+    BROKER_ERROR("unable to write flare pipe!");
+    std::terminate();
   }
 }
 
-size_t flare::extinguish() {
+void flare::drain() {
   stack_buffer tmp;
-  size_t result = 0;
   for (;;) {
     auto n = PIPE_READ(fds_[0], tmp.data, stack_buffer_size);
-    if (n > 0)
-      result += static_cast<size_t>(n);
-    else if (n == -1 && try_again_later())
-      return result; // Pipe is now drained.
+    if (n == -1 && try_again_later())
+      return; // Pipe is now drained.
   }
 }
 
+#endif // BROKER_LINUX
+
+void flare::fire(size_t num) {
+  if (num == 0)
+    return;
+  // Only the transition from "not ready" to "ready" needs a system call.
+  if (count_.fetch_add(num, std::memory_order_acq_rel) == 0)
+    signal();
+}
+
+size_t flare::extinguish() {
+  auto result = count_.exchange(0, std::memory_order_acq_rel);
+  if (result > 0) {
+    drain();
+    // Restore the signal if a concurrent fire() slipped in before drain().
+    if (ready())
+      signal();
+  }
+  return result;
+}
+
 bool flare::extinguish_one() {
-  char tmp = 0;
-  for (;;) {
-    auto n = PIPE_READ(fds_[0], &tmp, 1);
-    if (n == 1)
-      return true; // Read one byte.
-    if (n < 0 && try_again_later())
-      return false; // No data available to read.
+  return extinguish_some(1) == 1;
+}
+
+size_t flare::extinguish_some(size_t num) {
+  auto cur = count_.load(std::memory_order_acquire);
+  size_t n = 0;
+  do {
+    n = std::min(cur, num);
+    if (n == 0)
+      return 0;
+  } while (!count_.compare_exchange_weak(cur, cur - n,
+                                         std::memory_order_acq_rel));
+  if (cur == n) {
+    drain();
+    if (ready())
+      signal();
+  }
+  return n;
+}
+
+bool flare::spin() noexcept {
+  auto limit = spin_limit_.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < limit; ++i) {
+    cpu_relax();
+    if (ready()) {
+      // Spinning paid off: allow more iterations next time.
+      spin_limit_.store(std::min(limit * 2, max_spin_limit),
+                        std::memory_order_relaxed);
+      return true;
+    }
   }
+  spin_limit_.store(std::max(limit / 2, min_spin_limit),
+                    std::memory_order_relaxed);
+  return false;
 }
 
 void flare::await_one() {
   BROKER_TRACE("");
-  pollfd p = {fds_[0], POLLIN, 0};
+  if (ready() || spin())
+    return;
+  pollfd p = {fd(), POLLIN, 0};
   for (;;) {
     BROKER_DEBUG("polling");
     auto n = ::poll(&p, 1, -1);
@@ -161,7 +275,7 @@ void flare::await_one() {
 
 bool flare::await_one_impl(int ms_timeout) {
   BROKER_TRACE("");
-  pollfd p = {fds_[0], POLLIN, 0};
+  pollfd p = {fd(), POLLIN, 0};
   auto n = ::poll(&p, 1, ms_timeout);
   if (n < 0 && !try_again_later())
     std::terminate();
@@ -0,0 +1,55 @@
+#include "broker/detail/key_index.hh"
+
+#include "broker/error.hh"
+
+#include <cstddef>
+#include <string>
+
+namespace broker::detail {
+
+bool in_scan_range(const data& key, const data& first, const data& last) {
+  if (key.get_type() != first.get_type())
+    return false;
+  return is<none>(last) || key < last;
+}
+
+expected<std::pair<data, data>> prefix_range(const data& prefix) {
+  if (auto str = get_if<std::string>(prefix)) {
+    // The first string that no longer starts with the prefix results from
+    // incrementing the last character that isn't 0xFF.
+    auto upper = *str;
+    while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xFF)
+      upper.pop_back();
+    if (upper.empty())
+      return std::make_pair(prefix, data{});
+    upper.back() = static_cast<char>(static_cast<unsigned char>(upper.back())
+                                     + 1);
+    return std::make_pair(prefix, data{std::move(upper)});
+  }
+  if (auto sn = get_if<subnet>(prefix)) {
+    // The first address after the subnet results from setting all host bits
+    // and then incrementing the address by one.
+    const auto& net = sn->network();
+    size_t len = net.is_v4() ? sn->length() + 96u : sn->length();
+    auto upper = net;
+    auto& bytes = upper.bytes();
+    for (auto bit = len; bit < 128; ++bit)
+      bytes[bit / 8] |= static_cast<uint8_t>(0x80 >> (bit % 8));
+    for (size_t index = bytes.size(); index-- > 0;)
+      if (++bytes[index] != 0)
+        return std::make_pair(data{net}, data{upper});
+    // Overflow: the subnet includes the last address.
+    return std::make_pair(data{net}, data{});
+  }
+  return ec::type_clash;
+}
+
+data make_scan_result(table entries, data cursor) {
+  vector result;
+  result.reserve(2);
+  result.emplace_back(std::move(entries));
+  result.emplace_back(std::move(cursor));
+  return data{std::move(result)};
+}
+
+} // namespace broker::detail
@@ -4,6 +4,7 @@
 #include "broker/detail/make_backend.hh"
 #include "broker/detail/memory_backend.hh"
 #include "broker/detail/sqlite_backend.hh"
+#include "broker/detail/wal_backend.hh"
 
 namespace broker::detail {
 
@@ -18,6 +19,12 @@ std::unique_ptr<detail::abstract_backend> make_backend(backend type,
         return nullptr;
       return rval;
     }
+    case backend::wal: {
+      auto rval = std::make_unique<wal_backend>(std::move(opts));
+      if (rval->init_failed())
+        return nullptr;
+      return rval;
+    }
   }
 
   die("invalid backend type");
@@ -14,7 +14,12 @@ memory_backend::memory_backend(backend_options opts)
 
 expected<void> memory_backend::put(const data& key, data value,
                                    std::optional<timestamp> expiry) {
-  store_[key] = {std::move(value), expiry};
+  auto [i, added] = store_.try_emplace(key);
+  i->second = {std::move(value), expiry};
+  if (added) {
+    index_.insert(i->first);
+    subnets_.insert(i->first);
+  }
   return {};
 }
 
@@ -27,6 +32,8 @@ expected<void> memory_backend::add(const data& key, const data& value,
       return ec::type_clash;
     auto new_val = std::make_pair(data::from_type(init_type), expiry);
     i = store_.emplace(key, std::move(new_val)).first;
+    index_.insert(i->first);
+    subnets_.insert(i->first);
   }
   auto result = visit(adder{value}, i->second.first);
   if (result)
@@ -46,11 +53,15 @@ expected<void> memory_backend::subtract(const data& key, const data& value,
 }
 
 expected<void> memory_backend::erase(const data& key) {
+  index_.erase(key);
+  subnets_.erase(key);
   store_.erase(key);
   return {};
 }
 
 expected<void> memory_backend::clear() {
+  index_.clear();
+  subnets_.clear();
   store_.clear();
   return {};
 }
@@ -61,6 +72,8 @@ expected<bool> memory_backend::expire(const data& key, timestamp ts) {
     return false;
   if (!i->second.second || ts < i->second.second)
     return false;
+  index_.erase(i->first);
+  subnets_.erase(i->first);
   store_.erase(i);
   return true;
 }
@@ -79,6 +92,36 @@ expected<data> memory_backend::keys() const {
   return {std::move(keys)};
 }
 
+expected<data> memory_backend::scan(const data& first, const data& last,
+                                    count limit) const {
+  if (!index_.enabled())
+    index_.enable(store_);
+  table entries;
+  auto cursor = index_.scan(first, last, limit, [&](const data& key) {
+    entries.emplace_hint(entries.end(), key, store_.find(key)->second.first);
+  });
+  return make_scan_result(std::move(entries), std::move(cursor));
+}
+
+expected<data> memory_backend::lookup_containing(const address& addr) const {
+  if (!subnets_.enabled())
+    subnets_.enable(store_);
+  auto key = subnets_.longest_match(addr);
+  if (!key)
+    return ec::no_such_key;
+  return vector{*key, store_.find(*key)->second.first};
+}
+
+expected<data> memory_backend::covered_by(const subnet& net) const {
+  if (!subnets_.enabled())
+    subnets_.enable(store_);
+  table entries;
+  subnets_.covered_by(net, [&](const data& key) {
+    entries.emplace(key, store_.find(key)->second.first);
+  });
+  return {std::move(entries)};
+}
+
 expected<data> memory_backend::get(const data& key, const data& value) const {
   auto i = store_.find(key);
   if (i == store_.end())
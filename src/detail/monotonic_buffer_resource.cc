@@ -1,7 +1,8 @@
 #include "broker/detail/monotonic_buffer_resource.hh"
 
-#include <cstdlib>
+#include <algorithm>
 #include <memory>
+#include <new>
 
 namespace broker::detail {
 
@@ -21,20 +22,20 @@ void* monotonic_buffer_resource::allocate(size_t num_bytes, size_t alignment) {
     remaining_ -= num_bytes;
     return res;
   } else {
-    allocate_block(current_);
+    // Make sure the next block has enough space for oversized requests.
+    allocate_block(current_, num_bytes + alignment);
     return allocate(num_bytes, alignment);
   }
 }
 
-void monotonic_buffer_resource::allocate_block(block* prev_block) {
-  if (auto vptr = malloc(block_size)) {
-    current_ = static_cast<block*>(vptr);
-    current_->next = prev_block;
-    current_->bytes = static_cast<std::byte*>(vptr) + sizeof(block);
-    remaining_ = block_size - sizeof(block);
-  } else {
-    throw std::bad_alloc();
-  }
+void monotonic_buffer_resource::allocate_block(block* prev_block,
+                                              size_t min_bytes) {
+  auto size = std::max(block_size, sizeof(block) + min_bytes);
+  auto vptr = ::operator new(size);
+  current_ = static_cast<block*>(vptr);
+  current_->next = prev_block;
+  current_->bytes = static_cast<std::byte*>(vptr) + sizeof(block);
+  remaining_ = size - sizeof(block);
 }
 
 void monotonic_buffer_resource::destroy() noexcept {
@@ -42,7 +43,7 @@ void monotonic_buffer_resource::destroy() noexcept {
   while (blk != nullptr) {
     auto prev = blk;
     blk = blk->next;
-    free(prev);
+    ::operator delete(prev);
   }
 }
 
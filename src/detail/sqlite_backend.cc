@@ -1,7 +1,10 @@
 #include "broker/internal/logger.hh"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio> // std::snprintf
+#include <cstring>
+#include <limits>
 #include <optional>
 #include <set>
 #include <string>
@@ -17,6 +20,7 @@
 #include "broker/detail/appliers.hh"
 #include "broker/detail/assert.hh"
 #include "broker/detail/filesystem.hh"
+#include "broker/detail/key_index.hh"
 #include "broker/detail/sqlite_backend.hh"
 #include "broker/error.hh"
 #include "broker/expected.hh"
@@ -50,6 +54,76 @@ expected<data> from_blob(const void* buf, size_t size) {
     return {ec::invalid_data};
 }
 
+// Encodes keys into blobs that SQLite compares (via memcmp) in the same order
+// as the original values. Each blob starts with the type of the key. Leaves
+// `buf` empty for containers, which have no such encoding.
+struct ordered_encoder {
+  std::vector<uint8_t>& buf;
+
+  void append(uint64_t x, size_t num_bytes) {
+    for (auto i = num_bytes; i-- > 0;)
+      buf.push_back(static_cast<uint8_t>(x >> (i * 8)));
+  }
+
+  void append_signed(int64_t x) {
+    append(static_cast<uint64_t>(x) ^ (uint64_t{1} << 63), 8);
+  }
+
+  template <class T>
+  void operator()(const T& x) {
+    if constexpr (std::is_same_v<T, none>) {
+      // nop
+    } else if constexpr (std::is_same_v<T, boolean>) {
+      buf.push_back(x ? 1 : 0);
+    } else if constexpr (std::is_same_v<T, count>) {
+      append(x, 8);
+    } else if constexpr (std::is_same_v<T, integer>) {
+      append_signed(x);
+    } else if constexpr (std::is_same_v<T, real>) {
+      uint64_t bits;
+      std::memcpy(&bits, &x, sizeof(bits));
+      if (bits >> 63)
+        bits = ~bits;
+      else
+        bits |= uint64_t{1} << 63;
+      append(bits, 8);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      buf.insert(buf.end(), x.begin(), x.end());
+    } else if constexpr (std::is_same_v<T, address>) {
+      buf.insert(buf.end(), x.bytes().begin(), x.bytes().end());
+    } else if constexpr (std::is_same_v<T, subnet>) {
+      (*this)(x.network());
+      buf.push_back(x.length());
+    } else if constexpr (std::is_same_v<T, port>) {
+      append(x.number(), 2);
+      buf.push_back(static_cast<uint8_t>(x.type()));
+    } else if constexpr (std::is_same_v<T, timestamp>) {
+      append_signed(x.time_since_epoch().count());
+    } else if constexpr (std::is_same_v<T, timespan>) {
+      append_signed(x.count());
+    } else if constexpr (std::is_same_v<T, enum_value>) {
+      buf.insert(buf.end(), x.name.begin(), x.name.end());
+    } else {
+      buf.clear();
+    }
+  }
+};
+
+std::vector<uint8_t> to_ordered_blob(const data& x) {
+  std::vector<uint8_t> buf;
+  buf.push_back(static_cast<uint8_t>(x.get_type()));
+  visit(ordered_encoder{buf}, x);
+  return buf;
+}
+
+int bind_ordered_blob(sqlite3_stmt* stmt, int pos,
+                      const std::vector<uint8_t>& blob) {
+  if (blob.empty())
+    return sqlite3_bind_null(stmt, pos);
+  return sqlite3_bind_blob64(stmt, pos, blob.data(), blob.size(),
+                             SQLITE_STATIC);
+}
+
 // Find name in options and verify it starts with the given prefix,
 // if the prefix-stripped part of the value is found in allowed,
 // set result to the value.
@@ -229,7 +303,8 @@ struct sqlite_backend::impl {
     // Create table for actual data.
     result = sqlite3_exec(db,
                           "create table if not exists store"
-                          "(key blob primary key, value blob, expiry integer);",
+                          "(key blob primary key, value blob, expiry integer,"
+                          " okey blob);",
                           nullptr, nullptr, nullptr);
     if (result != SQLITE_OK) {
       BROKER_ERROR("failed to create store table" << sqlite3_errmsg(db));
@@ -237,6 +312,42 @@ struct sqlite_backend::impl {
       db = nullptr;
       return false;
     }
+    // Databases from older versions lack the column for range queries.
+    result = sqlite3_exec(db, "select okey from store limit 0;", nullptr,
+                          nullptr, nullptr);
+    if (result != SQLITE_OK) {
+      BROKER_INFO("adding ordered keys to database " << path);
+      result = sqlite3_exec(db, "alter table store add column okey blob;",
+                            nullptr, nullptr, nullptr);
+      if (result != SQLITE_OK) {
+        BROKER_ERROR("failed to add okey column" << sqlite3_errmsg(db));
+        sqlite3_close(db);
+        db = nullptr;
+        return false;
+      }
+      populate_okeys = true;
+    }
+    result = sqlite3_exec(db,
+                          "create index if not exists store_okey "
+                          "on store(okey);",
+                          nullptr, nullptr, nullptr);
+    if (result != SQLITE_OK) {
+      BROKER_ERROR("failed to create okey index" << sqlite3_errmsg(db));
+      sqlite3_close(db);
+      db = nullptr;
+      return false;
+    }
+    // Create an index for selecting expired entries without a full scan.
+    result = sqlite3_exec(db,
+                          "create index if not exists store_expiry "
+                          "on store(expiry) where expiry is not null;",
+                          nullptr, nullptr, nullptr);
+    if (result != SQLITE_OK) {
+      BROKER_ERROR("failed to create expiry index" << sqlite3_errmsg(db));
+      sqlite3_close(db);
+      db = nullptr;
+      return false;
+    }
     // Store Broker version in meta table.
     char tmp[128];
     std::snprintf(tmp, sizeof(tmp),
@@ -301,8 +412,10 @@ struct sqlite_backend::impl {
 
     // Prepare statements.
     std::vector<std::pair<sqlite3_stmt**, const char*>> statements{
-      {&replace, "replace into store(key, value, expiry) values(?, ?, ?);"},
+      {&replace, "replace into store(key, value, expiry, okey) "
+                 "values(?, ?, ?, ?);"},
       {&update, "update store set value = ?, expiry = ? where key = ?;"},
+      {&set_okey, "update store set okey = ? where key = ?;"},
       {&erase, "delete from store where key = ?;"},
       {&expire, "delete from store where key = ? and expiry <= ?;"},
 
@@ -313,6 +426,13 @@ struct sqlite_backend::impl {
       {&expiries, "select key, expiry from store where expiry is not null;"},
       {&clear, "delete from store;"},
       {&keys, "select key from store;"},
+      {&scan, "select key, value from store where okey >= ? and okey < ? "
+              "order by okey limit ?;"},
+      {&select_due, "select key from store where expiry <= ?1 "
+                    "order by expiry, rowid limit ?2;"},
+      {&erase_due, "delete from store where rowid in "
+                   "(select rowid from store where expiry <= ?1 "
+                   "order by expiry, rowid limit ?2);"},
     };
     auto prepare = [&](sqlite3_stmt** stmt, const char* sql) {
       finalize.push_back(*stmt);
@@ -325,9 +445,51 @@ struct sqlite_backend::impl {
         db = nullptr;
         return false;
       }
+    if (populate_okeys && !fill_okeys()) {
+      BROKER_ERROR("failed to add ordered keys:" << sqlite3_errmsg(db));
+      sqlite3_close(db);
+      db = nullptr;
+      return false;
+    }
     return true;
   }
 
+  // Computes the okey column for all rows after migrating a database.
+  bool fill_okeys() {
+    std::vector<std::pair<std::vector<uint8_t>, data>> rows;
+    {
+      auto guard = make_statement_guard(keys);
+      auto result = SQLITE_DONE;
+      while ((result = sqlite3_step(keys)) == SQLITE_ROW) {
+        auto blob = static_cast<const uint8_t*>(sqlite3_column_blob(keys, 0));
+        auto size = static_cast<size_t>(sqlite3_column_bytes(keys, 0));
+        auto key = from_blob(blob, size);
+        if (!key)
+          return false;
+        rows.emplace_back(std::vector<uint8_t>(blob, blob + size),
+                          std::move(*key));
+      }
+      if (result != SQLITE_DONE)
+        return false;
+    }
+    if (sqlite3_exec(db, "begin transaction;", nullptr, nullptr, nullptr)
+        != SQLITE_OK)
+      return false;
+    for (auto& [key_blob, key] : rows) {
+      auto guard = make_statement_guard(set_okey);
+      auto okey = to_ordered_blob(key);
+      if (bind_ordered_blob(set_okey, 1, okey) != SQLITE_OK
+          || sqlite3_bind_blob64(set_okey, 2, key_blob.data(), key_blob.size(),
+                                 SQLITE_STATIC)
+               != SQLITE_OK
+          || sqlite3_step(set_okey) != SQLITE_DONE) {
+        sqlite3_exec(db, "rollback;", nullptr, nullptr, nullptr);
+        return false;
+      }
+    }
+    return sqlite3_exec(db, "commit;", nullptr, nullptr, nullptr) == SQLITE_OK;
+  }
+
   bool modify(const data& key, const data& value,
               std::optional<timestamp> expiry) {
     auto [key_ok, key_blob] = to_blob(key);
@@ -384,11 +546,16 @@ struct sqlite_backend::impl {
   sqlite3_stmt* expiries = nullptr;
   sqlite3_stmt* clear = nullptr;
   sqlite3_stmt* keys = nullptr;
+  sqlite3_stmt* set_okey = nullptr;
+  sqlite3_stmt* scan = nullptr;
+  sqlite3_stmt* select_due = nullptr;
+  sqlite3_stmt* erase_due = nullptr;
   std::vector<sqlite3_stmt*> finalize;
   std::string pragma_synchronous;
   std::string pragma_journal_mode;
   bool delete_corrupt = false;
   bool integrity_check = false;
+  bool populate_okeys = false;
 };
 
 sqlite_backend::sqlite_backend(backend_options opts)
@@ -437,6 +604,11 @@ expected<void> sqlite_backend::put(const data& key, data value,
                                 expiry->time_since_epoch().count());
   else
     result = sqlite3_bind_null(impl_->replace, 3);
+  if (result != SQLITE_OK)
+    return ec::backend_failure;
+  // Bind ordered key.
+  auto okey = to_ordered_blob(key);
+  result = bind_ordered_blob(impl_->replace, 4, okey);
   if (result != SQLITE_OK)
     return ec::backend_failure;
   // Execute statement.
@@ -532,6 +704,52 @@ expected<bool> sqlite_backend::expire(const data& key, timestamp ts) {
   return sqlite3_changes(impl_->db) == 1;
 }
 
+expected<std::vector<data>> sqlite_backend::expire_due(timestamp current_time,
+                                                     size_t limit) {
+  if (!impl_->db)
+    return ec::backend_failure;
+  auto t = current_time.time_since_epoch().count();
+  auto n = static_cast<sqlite3_int64>(
+    std::min<size_t>(limit, std::numeric_limits<sqlite3_int64>::max()));
+  auto exec = [this](const char* sql) {
+    return sqlite3_exec(impl_->db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+  };
+  // Both statements must select the same rows.
+  if (!exec("begin transaction;"))
+    return ec::backend_failure;
+  auto rollback = caf::detail::make_scope_guard([&] { exec("rollback;"); });
+  std::vector<data> result;
+  {
+    auto guard = make_statement_guard(impl_->select_due);
+    if (sqlite3_bind_int64(impl_->select_due, 1, t) != SQLITE_OK
+        || sqlite3_bind_int64(impl_->select_due, 2, n) != SQLITE_OK)
+      return ec::backend_failure;
+    auto res = SQLITE_DONE;
+    while ((res = sqlite3_step(impl_->select_due)) == SQLITE_ROW) {
+      auto key = from_blob(sqlite3_column_blob(impl_->select_due, 0),
+                           sqlite3_column_bytes(impl_->select_due, 0));
+      if (!key)
+        return {key.error()};
+      result.emplace_back(std::move(*key));
+    }
+    if (res != SQLITE_DONE)
+      return ec::backend_failure;
+  }
+  if (result.empty())
+    return result;
+  {
+    auto guard = make_statement_guard(impl_->erase_due);
+    if (sqlite3_bind_int64(impl_->erase_due, 1, t) != SQLITE_OK
+        || sqlite3_bind_int64(impl_->erase_due, 2, n) != SQLITE_OK
+        || sqlite3_step(impl_->erase_due) != SQLITE_DONE)
+      return ec::backend_failure;
+  }
+  if (!exec("commit;"))
+    return ec::backend_failure;
+  rollback.disable();
+  return result;
+}
+
 expected<data> sqlite_backend::get(const data& key) const {
   if (!impl_->db)
     return ec::backend_failure;
@@ -572,6 +790,52 @@ expected<data> sqlite_backend::keys() const {
   return ec::backend_failure;
 }
 
+expected<data> sqlite_backend::scan(const data& first, const data& last,
+                                    count limit) const {
+  if (!impl_->db)
+    return ec::backend_failure;
+  if (limit == 0)
+    return make_scan_result(table{}, data{});
+  auto lower = to_ordered_blob(first);
+  if (lower.empty()) {
+    // Rows with container keys have no ordered key.
+    return abstract_backend::scan(first, last, limit);
+  }
+  std::vector<uint8_t> upper;
+  if (is<none>(last) || last.get_type() > first.get_type())
+    upper.push_back(static_cast<uint8_t>(first.get_type()) + 1);
+  else if (last.get_type() == first.get_type())
+    upper = to_ordered_blob(last);
+  else
+    return make_scan_result(table{}, data{});
+  auto guard = make_statement_guard(impl_->scan);
+  // Fetch one more row than requested for computing the cursor.
+  constexpr auto max_limit = std::numeric_limits<int64_t>::max() - 1;
+  auto rows = static_cast<int64_t>(std::min<count>(limit, max_limit)) + 1;
+  if (bind_ordered_blob(impl_->scan, 1, lower) != SQLITE_OK
+      || bind_ordered_blob(impl_->scan, 2, upper) != SQLITE_OK
+      || sqlite3_bind_int64(impl_->scan, 3, rows) != SQLITE_OK)
+    return ec::backend_failure;
+  table entries;
+  auto result = SQLITE_DONE;
+  while ((result = sqlite3_step(impl_->scan)) == SQLITE_ROW) {
+    auto key = from_blob(sqlite3_column_blob(impl_->scan, 0),
+                         sqlite3_column_bytes(impl_->scan, 0));
+    if (!key)
+      return {key.error()};
+    if (entries.size() == limit)
+      return make_scan_result(std::move(entries), std::move(*key));
+    auto value = from_blob(sqlite3_column_blob(impl_->scan, 1),
+                           sqlite3_column_bytes(impl_->scan, 1));
+    if (!value)
+      return {value.error()};
+    entries.emplace_hint(entries.end(), std::move(*key), std::move(*value));
+  }
+  if (result == SQLITE_DONE)
+    return make_scan_result(std::move(entries), data{});
+  return ec::backend_failure;
+}
+
 expected<bool> sqlite_backend::exists(const data& key) const {
   if (!impl_->db)
     return ec::backend_failure;
@@ -627,6 +891,10 @@ expected<snapshot> sqlite_backend::snapshot() const {
   return ec::backend_failure;
 }
 
+bool sqlite_backend::has_expiry_index() const noexcept {
+  return true;
+}
+
 expected<expirables> sqlite_backend::expiries() const {
   if (!impl_->db)
     return ec::backend_failure;
@@ -0,0 +1,181 @@
+#include "broker/detail/subnet_index.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace broker::detail {
+
+namespace {
+
+using bits_type = std::array<uint8_t, 16>;
+
+/// Returns the bit at position `pos` (0 = most significant bit).
+int bit(const bits_type& xs, uint8_t pos) {
+  return (xs[pos / 8] >> (7 - pos % 8)) & 1;
+}
+
+/// Returns the number of leading bits that `xs` and `ys` have in common, but
+/// at most `max_len`.
+uint8_t common_prefix(const bits_type& xs, const bits_type& ys,
+                      uint8_t max_len) {
+  uint8_t result = 0;
+  for (size_t i = 0; i < xs.size() && result < max_len; ++i) {
+    auto diff = static_cast<uint8_t>(xs[i] ^ ys[i]);
+    if (diff == 0) {
+      result += 8;
+      continue;
+    }
+    while ((diff & 0x80) == 0) {
+      ++result;
+      diff <<= 1;
+    }
+    break;
+  }
+  return result < max_len ? result : max_len;
+}
+
+} // namespace
+
+uint8_t full_length(const subnet& net) {
+  auto len = net.length();
+  return net.network().is_v4() ? len + 96 : len;
+}
+
+bool is_covered_by(const subnet& x, const subnet& y) {
+  return full_length(x) >= full_length(y) && y.contains(x.network());
+}
+
+subnet_index::subnet_index() = default;
+
+subnet_index::subnet_index(subnet_index&&) noexcept = default;
+
+subnet_index& subnet_index::operator=(subnet_index&&) noexcept = default;
+
+subnet_index::~subnet_index() = default;
+
+std::pair<bits_type, uint8_t> subnet_index::unpack(const subnet& net) {
+  return {net.network().bytes(), full_length(net)};
+}
+
+void subnet_index::insert(const data& key) {
+  if (!enabled_)
+    return;
+  auto net = get_if<subnet>(&key);
+  if (!net)
+    return;
+  auto [bits, len] = unpack(*net);
+  auto make_leaf = [&, bits = bits, len = len] {
+    return std::unique_ptr<node>{new node{bits, len, &key, {}}};
+  };
+  auto* pos = &root_;
+  while (*pos) {
+    auto* ptr = pos->get();
+    auto common = common_prefix(ptr->bits, bits, std::min(ptr->len, len));
+    if (common < ptr->len) {
+      // The new subnet branches off in the middle of the prefix of `ptr` or is
+      // a supernet of `ptr`: insert a new node above `ptr`.
+      auto old = std::move(*pos);
+      if (common == len) {
+        *pos = make_leaf();
+        (*pos)->children[bit(old->bits, len)] = std::move(old);
+      } else {
+        *pos = std::unique_ptr<node>{new node{bits, common, nullptr, {}}};
+        (*pos)->children[bit(old->bits, common)] = std::move(old);
+        (*pos)->children[bit(bits, common)] = make_leaf();
+      }
+      ++size_;
+      return;
+    }
+    if (ptr->len == len) {
+      // Found a node for the subnet (possibly an inner node without a key).
+      if (!ptr->key)
+        ++size_;
+      ptr->key = &key;
+      return;
+    }
+    pos = &ptr->children[bit(bits, ptr->len)];
+  }
+  *pos = make_leaf();
+  ++size_;
+}
+
+void subnet_index::erase(const data& key) {
+  if (!enabled_)
+    return;
+  auto net = get_if<subnet>(&key);
+  if (!net)
+    return;
+  auto [bits, len] = unpack(*net);
+  std::unique_ptr<node>* parent = nullptr;
+  auto* pos = &root_;
+  while (*pos) {
+    auto* ptr = pos->get();
+    if (ptr->len > len || common_prefix(ptr->bits, bits, ptr->len) < ptr->len)
+      return;
+    if (ptr->len < len) {
+      parent = pos;
+      pos = &ptr->children[bit(bits, ptr->len)];
+      continue;
+    }
+    if (!ptr->key)
+      return;
+    ptr->key = nullptr;
+    --size_;
+    // Remove nodes that no longer carry information.
+    auto& [lhs, rhs] = ptr->children;
+    if (lhs && rhs)
+      return;
+    if (lhs || rhs) {
+      auto child = std::move(lhs ? lhs : rhs);
+      *pos = std::move(child);
+      return;
+    }
+    pos->reset();
+    // The parent may now be an inner node with a single child.
+    if (parent) {
+      auto* pptr = parent->get();
+      if (!pptr->key) {
+        auto& [plhs, prhs] = pptr->children;
+        auto child = std::move(plhs ? plhs : prhs);
+        *parent = std::move(child);
+      }
+    }
+    return;
+  }
+}
+
+void subnet_index::clear() {
+  root_.reset();
+  size_ = 0;
+}
+
+const data* subnet_index::longest_match(const address& addr) const {
+  const auto& bits = addr.bytes();
+  const data* result = nullptr;
+  auto* ptr = root_.get();
+  while (ptr) {
+    if (common_prefix(ptr->bits, bits, ptr->len) < ptr->len)
+      break;
+    if (ptr->key)
+      result = ptr->key;
+    if (ptr->len == 128)
+      break;
+    ptr = ptr->children[bit(bits, ptr->len)].get();
+  }
+  return result;
+}
+
+const subnet_index::node* subnet_index::find_cover(const bits_type& bits,
+                                                   uint8_t len) const {
+  auto* ptr = root_.get();
+  while (ptr && ptr->len < len) {
+    if (common_prefix(ptr->bits, bits, ptr->len) < ptr->len)
+      return nullptr;
+    ptr = ptr->children[bit(bits, ptr->len)].get();
+  }
+  if (ptr && common_prefix(ptr->bits, bits, len) == len)
+    return ptr;
+  return nullptr;
+}
+
+} // namespace broker::detail
@@ -0,0 +1,547 @@
+#include "broker/detail/wal_backend.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/config.hh"
+#include "broker/detail/filesystem.hh"
+#include "broker/error.hh"
+#include "broker/internal/logger.hh"
+#include "broker/internal/mapped_file.hh"
+
+#ifdef BROKER_WINDOWS
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace broker::detail {
+
+namespace {
+
+/// Default for the `commit_interval` option.
+constexpr auto default_commit_interval = std::chrono::milliseconds{10};
+
+/// Default for the `commit_bytes` option.
+constexpr size_t default_commit_bytes = 1024 * 1024;
+
+/// Default for the `compact_bytes` option.
+constexpr size_t default_compact_bytes = 64 * 1024 * 1024;
+
+/// Tags the operations in the log.
+enum class wal_op : uint8_t {
+  put,
+  add,
+  subtract,
+  erase,
+  clear,
+  expire,
+};
+
+uint32_t fnv1a(const std::byte* first, size_t size) {
+  uint32_t result = 0x811C9DC5;
+  for (size_t index = 0; index < size; ++index) {
+    result ^= static_cast<uint32_t>(first[index]);
+    result *= 0x01000193;
+  }
+  return result;
+}
+
+/// Serializes an operation and appends it as a record to `buf`.
+template <class... Ts>
+bool encode_record(std::vector<std::byte>& buf, wal_op op, const Ts&... xs) {
+  using format = wal_backend::format;
+  auto offset = buf.size();
+  buf.resize(offset + format::record_header_size);
+  caf::binary_serializer sink{nullptr, buf};
+  if (!sink.apply(static_cast<uint8_t>(op)) || !(sink.apply(xs) && ...)) {
+    buf.resize(offset);
+    return false;
+  }
+  auto payload = buf.data() + offset + format::record_header_size;
+  auto size = buf.size() - offset - format::record_header_size;
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    buf.resize(offset);
+    return false;
+  }
+  auto size32 = static_cast<uint32_t>(size);
+  auto checksum = fnv1a(payload, size);
+  memcpy(buf.data() + offset, &size32, sizeof(size32));
+  memcpy(buf.data() + offset + sizeof(size32), &checksum, sizeof(checksum));
+  return true;
+}
+
+bool write_header(std::FILE* out, uint64_t generation) {
+  using format = wal_backend::format;
+  std::byte header[format::header_size];
+  auto magic = format::magic;
+  auto version = format::version;
+  memcpy(header, &magic, sizeof(magic));
+  memcpy(header + sizeof(magic), &version, sizeof(version));
+  memcpy(header + sizeof(magic) + sizeof(version), &generation,
+         sizeof(generation));
+  return std::fwrite(header, 1, sizeof(header), out) == sizeof(header);
+}
+
+bool write_bytes(std::FILE* out, const std::vector<std::byte>& buf) {
+  return std::fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+}
+
+/// Blocks until the OS wrote all buffered data of `out` to disk.
+bool sync_file(std::FILE* out) {
+  if (std::fflush(out) != 0)
+    return false;
+#ifdef BROKER_WINDOWS
+  return _commit(_fileno(out)) == 0;
+#else
+  return fsync(fileno(out)) == 0;
+#endif
+}
+
+/// Returns the size of the file `fname` or 0 if the file is not readable.
+size_t file_size(const std::string& fname) {
+  auto in = std::fopen(fname.c_str(), "rb");
+  if (in == nullptr)
+    return 0;
+  long result = 0;
+  if (std::fseek(in, 0, SEEK_END) == 0)
+    result = std::ftell(in);
+  std::fclose(in);
+  return result > 0 ? static_cast<size_t>(result) : 0;
+}
+
+template <class T>
+T get_option(const backend_options& opts, const std::string& key,
+             T fallback) {
+  if (auto i = opts.find(key); i != opts.end()) {
+    if (auto val = get_if<T>(&i->second))
+      return *val;
+    BROKER_ERROR("WAL backend option" << key << "has the wrong type");
+  }
+  return fallback;
+}
+
+} // namespace
+
+std::string
+wal_backend::format::snapshot_file_name(const std::string& directory) {
+  return directory + "/snapshot.bin";
+}
+
+std::string wal_backend::format::log_file_name(const std::string& directory,
+                                               uint64_t generation) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "wal-%012llu.log",
+                static_cast<unsigned long long>(generation));
+  auto result = directory;
+  result += '/';
+  result += buf;
+  return result;
+}
+
+wal_backend::wal_backend(backend_options opts) : options_(std::move(opts)) {
+  auto path = options_.find("path");
+  if (path == options_.end() || !is<std::string>(path->second)) {
+    BROKER_ERROR("WAL backend options are missing required 'path' string");
+    return;
+  }
+  directory_ = get<std::string>(path->second);
+  auto interval = get_option<timespan>(options_, "commit_interval",
+                                       default_commit_interval);
+  commit_interval_ = std::chrono::duration_cast<clock_type::duration>(interval);
+  commit_bytes_ = get_option<count>(options_, "commit_bytes",
+                                    default_commit_bytes);
+  compact_bytes_ = get_option<count>(options_, "compact_bytes",
+                                     default_compact_bytes);
+  synchronous_ = get_option<boolean>(options_, "synchronous", true);
+  if (!is_directory(directory_) && !mkdirs(directory_)) {
+    BROKER_ERROR("unable to create WAL directory:" << directory_);
+    return;
+  }
+  if (!load() || !open_log())
+    return;
+  failed_ = false;
+}
+
+wal_backend::~wal_backend() {
+  if (log_ != nullptr) {
+    if (!write_buffer())
+      BROKER_ERROR("unable to write pending changes to the WAL");
+    std::fclose(log_);
+  }
+}
+
+bool wal_backend::init_failed() const {
+  return failed_;
+}
+
+// -- persistence --------------------------------------------------------------
+
+bool wal_backend::load() {
+  auto start = clock_type::now();
+  uint64_t next = 0;
+  if (auto fname = format::snapshot_file_name(directory_); is_file(fname)) {
+    if (!replay(fname, true, next, snapshot_size_)) {
+      BROKER_ERROR("unable to load WAL snapshot:" << fname);
+      return false;
+    }
+    if (auto size = state_.size())
+      BROKER_DEBUG("loaded WAL snapshot with" << *size << "entries");
+  }
+  first_generation_ = next;
+  // Logs before the snapshot may remain after a crash during compaction.
+  for (auto gen = next; gen-- > 0;) {
+    auto fname = format::log_file_name(directory_, gen);
+    if (!is_file(fname) || !detail::remove(fname))
+      break;
+  }
+  for (;; ++next) {
+    auto fname = format::log_file_name(directory_, next);
+    if (!is_file(fname))
+      break;
+    // A crash right after creating a log may leave a file without header.
+    if (file_size(fname) < format::header_size) {
+      BROKER_WARNING("skip WAL log without header:" << fname);
+      continue;
+    }
+    uint64_t gen = 0;
+    size_t size = 0;
+    if (!replay(fname, false, gen, size) || gen != next) {
+      BROKER_ERROR("unable to replay WAL log:" << fname);
+      return false;
+    }
+  }
+  generation_ = next;
+  BROKER_INFO("loaded WAL backend from"
+              << directory_ << "in"
+              << std::chrono::duration_cast<timespan>(clock_type::now()
+                                                      - start));
+  return true;
+}
+
+bool wal_backend::replay(const std::string& fname, bool strict,
+                         uint64_t& generation, size_t& file_size) {
+  internal::mapped_file file;
+  if (auto err = file.open(fname))
+    return false;
+  auto bytes = file.bytes();
+  file_size = bytes.size();
+  if (bytes.size() < format::header_size)
+    return false;
+  uint32_t magic = 0;
+  uint8_t version = 0;
+  memcpy(&magic, bytes.data(), sizeof(magic));
+  memcpy(&version, bytes.data() + sizeof(magic), sizeof(version));
+  memcpy(&generation, bytes.data() + sizeof(magic) + sizeof(version),
+         sizeof(generation));
+  if (magic != format::magic || version != format::version)
+    return false;
+  auto invalid = [&](const char* what, size_t pos) {
+    if (strict)
+      return false;
+    BROKER_WARNING("stop replaying" << fname << "at offset" << pos << ":"
+                                    << what);
+    return true;
+  };
+  size_t pos = format::header_size;
+  while (pos < bytes.size()) {
+    if (bytes.size() - pos < format::record_header_size)
+      return invalid("truncated record header", pos);
+    uint32_t size = 0;
+    uint32_t checksum = 0;
+    memcpy(&size, bytes.data() + pos, sizeof(size));
+    memcpy(&checksum, bytes.data() + pos + sizeof(size), sizeof(checksum));
+    auto payload = bytes.data() + pos + format::record_header_size;
+    if (bytes.size() - pos - format::record_header_size < size)
+      return invalid("truncated record", pos);
+    if (fnv1a(payload, size) != checksum)
+      return invalid("checksum mismatch", pos);
+    caf::binary_deserializer src{nullptr, payload, size};
+    uint8_t op = 0;
+    data key;
+    data value;
+    std::optional<timestamp> expiry;
+    if (!src.apply(op))
+      return invalid("malformed record", pos);
+    auto ok = true;
+    switch (static_cast<wal_op>(op)) {
+      case wal_op::put:
+        ok = src.apply(key) && src.apply(value) && src.apply(expiry);
+        if (ok)
+          std::ignore = state_.put(key, std::move(value), expiry);
+        break;
+      case wal_op::add: {
+        uint8_t init_type = 0;
+        ok = src.apply(key) && src.apply(value) && src.apply(init_type)
+             && src.apply(expiry);
+        if (ok)
+          std::ignore = state_.add(key, value,
+                                   static_cast<data::type>(init_type), expiry);
+        break;
+      }
+      case wal_op::subtract:
+        ok = src.apply(key) && src.apply(value) && src.apply(expiry);
+        if (ok)
+          std::ignore = state_.subtract(key, value, expiry);
+        break;
+      case wal_op::erase:
+        ok = src.apply(key);
+        if (ok)
+          std::ignore = state_.erase(key);
+        break;
+      case wal_op::clear:
+        std::ignore = state_.clear();
+        break;
+      case wal_op::expire: {
+        timestamp ts;
+        ok = src.apply(key) && src.apply(ts);
+        if (ok)
+          std::ignore = state_.expire(key, ts);
+        break;
+      }
+      default:
+        ok = false;
+    }
+    if (!ok)
+      return invalid("malformed record", pos);
+    pos += format::record_header_size + size;
+  }
+  return true;
+}
+
+bool wal_backend::open_log() {
+  auto fname = format::log_file_name(directory_, generation_);
+  log_ = std::fopen(fname.c_str(), "wb");
+  if (log_ == nullptr) {
+    BROKER_ERROR("unable to open WAL log:" << fname);
+    return false;
+  }
+  if (!write_header(log_, generation_) || !sync_file(log_)) {
+    BROKER_ERROR("unable to write WAL log header:" << fname);
+    std::fclose(log_);
+    log_ = nullptr;
+    return false;
+  }
+  log_size_ = 0;
+  return true;
+}
+
+template <class F, class... Ts>
+expected<void> wal_backend::apply(F fn, uint8_t op, const Ts&... xs) {
+  // Stage the record first to make sure that we never change the state
+  // without logging the change.
+  auto offset = buf_.size();
+  if (auto res = stage(op, xs...); !res)
+    return res;
+  if (auto res = fn(); !res) {
+    buf_.resize(offset);
+    return res;
+  }
+  return commit_if_due();
+}
+
+template <class... Ts>
+expected<void> wal_backend::stage(uint8_t op, const Ts&... xs) {
+  if (log_ == nullptr)
+    return ec::backend_failure;
+  if (!encode_record(buf_, static_cast<wal_op>(op), xs...))
+    return ec::invalid_data;
+  return {};
+}
+
+expected<void> wal_backend::commit_if_due() {
+  auto now = clock_type::now();
+  if (!first_pending_)
+    first_pending_ = now;
+  if (buf_.size() >= commit_bytes_ || now - *first_pending_ >= commit_interval_)
+    return write_buffer();
+  return {};
+}
+
+expected<void> wal_backend::write_buffer() {
+  if (buf_.empty())
+    return {};
+  if (!write_bytes(log_, buf_)
+      || (synchronous_ ? !sync_file(log_) : std::fflush(log_) != 0)) {
+    BROKER_ERROR("unable to write to the WAL log");
+    return ec::backend_failure;
+  }
+  log_size_ += buf_.size();
+  buf_.clear();
+  first_pending_.reset();
+  return {};
+}
+
+expected<void> wal_backend::compact() {
+  if (log_ == nullptr)
+    return ec::backend_failure;
+  if (auto res = write_buffer(); !res)
+    return res;
+  auto start = clock_type::now();
+  auto next = generation_ + 1;
+  auto fname = format::snapshot_file_name(directory_);
+  auto tmp_fname = fname + ".tmp";
+  auto out = std::fopen(tmp_fname.c_str(), "wb");
+  if (out == nullptr) {
+    BROKER_ERROR("unable to open WAL snapshot:" << tmp_fname);
+    return ec::backend_failure;
+  }
+  auto ok = write_header(out, next);
+  auto snapshot_size = format::header_size;
+  for (auto& [key, entry] : state_.entries()) {
+    if (!ok)
+      break;
+    ok = encode_record(buf_, wal_op::put, key, entry.first, entry.second);
+    if (ok && buf_.size() >= commit_bytes_) {
+      ok = write_bytes(out, buf_);
+      snapshot_size += buf_.size();
+      buf_.clear();
+    }
+  }
+  if (ok) {
+    ok = write_bytes(out, buf_) && sync_file(out);
+    snapshot_size += buf_.size();
+  }
+  buf_.clear();
+  std::fclose(out);
+#ifdef BROKER_WINDOWS
+  if (ok && is_file(fname))
+    detail::remove(fname);
+#endif
+  if (!ok || std::rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+    BROKER_ERROR("unable to write WAL snapshot:" << fname);
+    detail::remove(tmp_fname);
+    return ec::backend_failure;
+  }
+  // The snapshot now contains all changes from the current log and its
+  // predecessors.
+  std::fclose(log_);
+  log_ = nullptr;
+  for (auto gen = first_generation_; gen <= generation_; ++gen)
+    detail::remove(format::log_file_name(directory_, gen));
+  snapshot_size_ = snapshot_size;
+  first_generation_ = next;
+  generation_ = next;
+  if (!open_log())
+    return ec::backend_failure;
+  BROKER_DEBUG("compacted WAL in"
+               << std::chrono::duration_cast<timespan>(clock_type::now()
+                                                       - start));
+  return {};
+}
+
+// -- modifiers ----------------------------------------------------------------
+
+expected<void> wal_backend::put(const data& key, data value,
+                                std::optional<timestamp> expiry) {
+  // We must encode the record before moving the value into the state.
+  auto offset = buf_.size();
+  if (auto res = stage(static_cast<uint8_t>(wal_op::put), key, value, expiry);
+      !res)
+    return res;
+  if (auto res = state_.put(key, std::move(value), expiry); !res) {
+    buf_.resize(offset);
+    return res;
+  }
+  return commit_if_due();
+}
+
+expected<void> wal_backend::add(const data& key, const data& value,
+                                data::type init_type,
+                                std::optional<timestamp> expiry) {
+  return apply([&] { return state_.add(key, value, init_type, expiry); },
+               static_cast<uint8_t>(wal_op::add), key, value,
+               static_cast<uint8_t>(init_type), expiry);
+}
+
+expected<void> wal_backend::subtract(const data& key, const data& value,
+                                     std::optional<timestamp> expiry) {
+  return apply([&] { return state_.subtract(key, value, expiry); },
+               static_cast<uint8_t>(wal_op::subtract), key, value, expiry);
+}
+
+expected<void> wal_backend::erase(const data& key) {
+  return apply([&] { return state_.erase(key); },
+               static_cast<uint8_t>(wal_op::erase), key);
+}
+
+expected<void> wal_backend::clear() {
+  return apply([&] { return state_.clear(); },
+               static_cast<uint8_t>(wal_op::clear));
+}
+
+expected<bool> wal_backend::expire(const data& key, timestamp current_time) {
+  auto offset = buf_.size();
+  if (auto res = stage(static_cast<uint8_t>(wal_op::expire), key,
+                       current_time);
+      !res)
+    return res.error();
+  auto res = state_.expire(key, current_time);
+  if (!res || !*res) {
+    buf_.resize(offset);
+    return res;
+  }
+  if (auto committed = commit_if_due(); !committed)
+    return committed.error();
+  return true;
+}
+
+expected<void> wal_backend::flush() {
+  if (auto res = write_buffer(); !res)
+    return res;
+  if (log_size_ > 0 && log_size_ >= std::max(compact_bytes_, snapshot_size_))
+    return compact();
+  return {};
+}
+
+// -- inspectors ---------------------------------------------------------------
+
+expected<data> wal_backend::get(const data& key) const {
+  return state_.get(key);
+}
+
+expected<data> wal_backend::get(const data& key, const data& value) const {
+  return state_.get(key, value);
+}
+
+expected<bool> wal_backend::exists(const data& key) const {
+  return state_.exists(key);
+}
+
+expected<uint64_t> wal_backend::size() const {
+  return state_.size();
+}
+
+expected<data> wal_backend::keys() const {
+  return state_.keys();
+}
+
+expected<data> wal_backend::scan(const data& first, const data& last,
+                                 count limit) const {
+  return state_.scan(first, last, limit);
+}
+
+expected<data> wal_backend::lookup_containing(const address& addr) const {
+  return state_.lookup_containing(addr);
+}
+
+expected<data> wal_backend::covered_by(const subnet& net) const {
+  return state_.covered_by(net);
+}
+
+expected<snapshot> wal_backend::snapshot() const {
+  return state_.snapshot();
+}
+
+expected<expirables> wal_backend::expiries() const {
+  return state_.expiries();
+}
+
+} // namespace broker::detail
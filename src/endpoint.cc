@@ -418,6 +418,7 @@ public:
                                 openssl_options_ptr ssl_cfg) {
     connector_ = std::make_shared<internal::connector>(this_peer, broker_cfg,
                                                        std::move(ssl_cfg));
+    connector_->sys(&sys);
     thread_ = std::thread{[ptr{connector_}, sys_ptr{&sys}] {
       CAF_SET_LOGGER_SYS(sys_ptr);
       ptr->run();
@@ -836,6 +837,19 @@ publisher endpoint::make_publisher(topic ts) {
   return publisher::make(*this, std::move(ts));
 }
 
+void endpoint::set_publish_limit(topic prefix, publish_limit limit) {
+  BROKER_INFO("set publish limit for" << prefix << "to" << to_string(limit));
+  caf::anon_send(native(core_), atom::publish_v, atom::put_v,
+                 std::move(prefix), limit.rate, limit.burst, limit.sample,
+                 limit.drop);
+}
+
+void endpoint::clear_publish_limit(topic prefix) {
+  BROKER_INFO("clear publish limit for" << prefix);
+  caf::anon_send(native(core_), atom::publish_v, atom::clear_v,
+                 std::move(prefix));
+}
+
 status_subscriber endpoint::make_status_subscriber(bool receive_statuses,
                                                    size_t queue_size) {
   return status_subscriber::make(*this, receive_statuses, queue_size);
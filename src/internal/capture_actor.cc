@@ -0,0 +1,67 @@
+#include "broker/internal/capture_actor.hh"
+
+#include "broker/defaults.hh"
+#include "broker/internal/logger.hh"
+#include "broker/internal/type_id.hh"
+
+#include <caf/scheduled_actor/flow.hpp>
+
+namespace broker::internal {
+
+// -- constructors and destructors ---------------------------------------------
+
+capture_state::capture_state(caf::event_based_actor* self,
+                             capture_writer_ptr writer,
+                             capture_consumer_res input,
+                             capture_backlog_ptr backlog)
+  : self(self),
+    writer(std::move(writer)),
+    input_res(std::move(input)),
+    backlog(std::move(backlog)) {
+  // nop
+}
+
+capture_state::~capture_state() {
+  BROKER_DEBUG("capture_state destroyed");
+}
+
+// -- initialization -----------------------------------------------------------
+
+caf::behavior capture_state::make_behavior() {
+  sub = self->make_observable()
+          .from_resource(std::move(input_res))
+          // The core closes the buffer after shutting down. Closing the writer
+          // truncates the last segment to its actual size.
+          .do_finally([this] {
+            BROKER_DEBUG("input from the core closed, stop capturing");
+            if (writer) {
+              BROKER_INFO("captured" << writer->records() << "messages in"
+                                     << writer->segments() << "segments");
+              writer.reset();
+            }
+            self->quit();
+          })
+          .for_each([this](const capture_record& x) {
+            backlog->fetch_sub(1, std::memory_order_relaxed);
+            if (!writer)
+              return;
+            if (auto err = writer->write(x.captured, x.msg)) {
+              BROKER_ERROR("stop capturing after a write error:" << err);
+              writer.reset();
+              sub.dispose();
+            }
+          });
+  self->delayed_send(self, defaults::capture::flush_interval, atom::tick_v);
+  return {
+    [this](atom::tick) {
+      if (!writer)
+        return;
+      if (auto err = writer->flush())
+        BROKER_WARNING("failed to flush capture segment:" << err);
+      self->delayed_send(self, defaults::capture::flush_interval,
+                         atom::tick_v);
+    },
+  };
+}
+
+} // namespace broker::internal
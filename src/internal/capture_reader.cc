@@ -0,0 +1,105 @@
+#include "broker/internal/capture_reader.hh"
+
+#include <cstring>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/error.hh"
+#include "broker/internal/logger.hh"
+
+namespace broker::internal {
+
+capture_reader::capture_reader(std::string directory)
+  : directory_(std::move(directory)) {
+  // nop
+}
+
+capture_reader::~capture_reader() {
+  // nop
+}
+
+caf::error capture_reader::read(capture_record& x) {
+  using format = capture_writer::format;
+  for (;;) {
+    if (!segment_.valid())
+      if (auto err = open_next_segment())
+        return err;
+    auto bytes = segment_.bytes();
+    auto remaining = bytes.size() - pos_;
+    if (remaining < format::record_header_size) {
+      segment_.close();
+      continue;
+    }
+    auto pos = bytes.data() + pos_;
+    uint32_t size = 0;
+    int64_t ns = 0;
+    memcpy(&size, pos, sizeof(size));
+    memcpy(&ns, pos + sizeof(size), sizeof(ns));
+    // A size of 0 marks the end of a segment that wasn't closed properly and
+    // a truncated record means the writer died while writing to the segment.
+    if (size == 0 || remaining - format::record_header_size < size) {
+      if (size != 0)
+        BROKER_WARNING("skip truncated record in capture segment"
+                       << (next_segment_ - 1));
+      segment_.close();
+      continue;
+    }
+    auto content = bytes.subspan(pos_ + format::record_header_size, size);
+    if (!trait_.convert(content, x.msg))
+      return trait_.last_error();
+    x.captured = timestamp{timespan{ns}};
+    pos_ += format::record_header_size + size;
+    ++records_;
+    return caf::none;
+  }
+}
+
+void capture_reader::rewind() {
+  segment_.close();
+  next_segment_ = 0;
+  records_ = 0;
+  pos_ = 0;
+}
+
+caf::error capture_reader::open_next_segment() {
+  using format = capture_writer::format;
+  auto fname = format::segment_file_name(directory_, next_segment_);
+  if (!detail::is_file(fname))
+    return ec::end_of_file;
+  if (auto err = segment_.open(fname))
+    return err;
+  ++next_segment_;
+  // Verify segment header (magic number + version).
+  auto bytes = segment_.bytes();
+  if (bytes.size() < format::header_size) {
+    BROKER_ERROR("cannot read segment header (file too small):" << fname);
+    segment_.close();
+    return caf::make_error(ec::invalid_data, fname);
+  }
+  uint32_t magic = 0;
+  uint8_t version = 0;
+  memcpy(&magic, bytes.data(), sizeof(magic));
+  memcpy(&version, bytes.data() + sizeof(magic), sizeof(version));
+  if (magic != format::magic) {
+    BROKER_ERROR("unexpected segment header (magic mismatch):" << fname);
+    segment_.close();
+    return caf::make_error(ec::wrong_magic_number, fname);
+  }
+  if (version != format::version) {
+    BROKER_ERROR("unexpected segment header (version mismatch):" << fname);
+    segment_.close();
+    return caf::make_error(ec::invalid_data, fname);
+  }
+  pos_ = format::header_size;
+  return caf::none;
+}
+
+capture_reader_ptr make_capture_reader(const std::string& directory) {
+  auto fname = capture_writer::format::segment_file_name(directory, 0);
+  if (!detail::is_file(fname)) {
+    BROKER_ERROR("no capture found in directory:" << directory);
+    return nullptr;
+  }
+  return std::make_unique<capture_reader>(directory);
+}
+
+} // namespace broker::internal
@@ -0,0 +1,155 @@
+#include "broker/internal/capture_writer.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/error.hh"
+#include "broker/internal/logger.hh"
+
+#ifdef BROKER_WINDOWS
+#  include <fstream>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace broker::internal {
+
+std::string
+capture_writer::format::segment_file_name(const std::string& directory,
+                                          size_t index) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "capture-%06zu.bin", index);
+  auto result = directory;
+  result += '/';
+  result += buf;
+  return result;
+}
+
+capture_writer::capture_writer(std::string directory, size_t segment_size)
+  : directory_(std::move(directory)),
+    segment_size_(std::max(segment_size, size_t{4096})) {
+  buf_.reserve(1024);
+}
+
+capture_writer::~capture_writer() {
+  close_segment();
+}
+
+caf::error capture_writer::write(timestamp captured, const node_message& msg) {
+  buf_.clear();
+  if (!trait_.convert(msg, buf_))
+    return trait_.last_error();
+  if (buf_.size() > std::numeric_limits<uint32_t>::max())
+    return caf::make_error(ec::serialization_failed,
+                           "node message exceeds the maximum record size");
+  auto record_size = format::record_header_size + buf_.size();
+  if (addr_ == nullptr || capacity_ - pos_ < record_size) {
+    close_segment();
+    if (auto err = open_segment(record_size))
+      return err;
+  }
+  auto size = static_cast<uint32_t>(buf_.size());
+  int64_t ns = captured.time_since_epoch().count();
+  auto pos = addr_ + pos_;
+  memcpy(pos, &size, sizeof(size));
+  pos += sizeof(size);
+  memcpy(pos, &ns, sizeof(ns));
+  pos += sizeof(ns);
+  memcpy(pos, buf_.data(), buf_.size());
+  pos_ += record_size;
+  ++records_;
+  return caf::none;
+}
+
+caf::error capture_writer::flush() {
+#ifndef BROKER_WINDOWS
+  if (addr_ != nullptr && msync(addr_, pos_, MS_ASYNC) != 0)
+    return caf::make_error(ec::cannot_write_file, file_name_);
+#endif
+  return caf::none;
+}
+
+caf::error capture_writer::open_segment(size_t min_size) {
+  auto size = std::max(segment_size_, format::header_size + min_size);
+  file_name_ = format::segment_file_name(directory_, next_segment_++);
+#ifdef BROKER_WINDOWS
+  segment_buf_.resize(size);
+  addr_ = segment_buf_.data();
+#else
+  fd_ = ::open(file_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ == -1) {
+    BROKER_ERROR("unable to open capture segment:" << file_name_);
+    return caf::make_error(ec::cannot_open_file, file_name_);
+  }
+  // Reserve space for the entire segment up front. The pages only consume
+  // disk space once we write to them.
+  if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    BROKER_ERROR("unable to resize capture segment:" << file_name_);
+    ::close(fd_);
+    fd_ = -1;
+    return caf::make_error(ec::cannot_write_file, file_name_);
+  }
+  auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    BROKER_ERROR("unable to map capture segment:" << file_name_);
+    ::close(fd_);
+    fd_ = -1;
+    return caf::make_error(ec::cannot_write_file, file_name_);
+  }
+  addr_ = reinterpret_cast<std::byte*>(addr);
+#endif
+  capacity_ = size;
+  auto magic = format::magic;
+  auto version = format::version;
+  memcpy(addr_, &magic, sizeof(magic));
+  memcpy(addr_ + sizeof(magic), &version, sizeof(version));
+  pos_ = format::header_size;
+  BROKER_DEBUG("opened capture segment" << file_name_);
+  return caf::none;
+}
+
+void capture_writer::close_segment() {
+  if (addr_ == nullptr)
+    return;
+#ifdef BROKER_WINDOWS
+  std::ofstream out{file_name_, std::ofstream::binary};
+  if (!out.write(reinterpret_cast<const char*>(addr_),
+                 static_cast<std::streamsize>(pos_)))
+    BROKER_ERROR("unable to write capture segment:" << file_name_);
+  segment_buf_.clear();
+#else
+  munmap(addr_, capacity_);
+  if (ftruncate(fd_, static_cast<off_t>(pos_)) != 0)
+    BROKER_ERROR("unable to truncate capture segment:" << file_name_);
+  ::close(fd_);
+  fd_ = -1;
+#endif
+  addr_ = nullptr;
+  capacity_ = 0;
+  pos_ = 0;
+}
+
+capture_writer_ptr make_capture_writer(const std::string& directory,
+                                       size_t segment_size) {
+  if (!detail::is_directory(directory) && !detail::mkdirs(directory)) {
+    BROKER_ERROR("unable to create capture directory:" << directory);
+    return nullptr;
+  }
+  // Readers consume segments until hitting the first missing index. Hence, we
+  // cannot mix a new capture with the segments of a previous capture and we
+  // never delete previous captures.
+  if (auto fname = capture_writer::format::segment_file_name(directory, 0);
+      detail::is_file(fname)) {
+    BROKER_ERROR("capture directory already contains a capture:" << directory);
+    return nullptr;
+  }
+  return std::make_unique<capture_writer>(directory, segment_size);
+}
+
+} // namespace broker::internal
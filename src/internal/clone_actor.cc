@@ -7,6 +7,7 @@
 #include "broker/detail/assert.hh"
 #include "broker/error.hh"
 #include "broker/internal/logger.hh"
+#include "broker/internal/metric_factory.hh"
 #include "broker/internal/type_id.hh"
 #include "broker/store.hh"
 #include "broker/topic.hh"
@@ -38,6 +39,15 @@ double now(endpoint::clock* clock) {
 
 } // namespace
 
+// -- metrics ------------------------------------------------------------------
+
+clone_state::metrics_t::metrics_t(caf::actor_system& sys,
+                                  const std::string& name) noexcept {
+  metric_factory factory{sys};
+  combiner_inputs = factory.store.combiner_inputs_instance(name);
+  combiner_outputs = factory.store.combiner_outputs_instance(name);
+}
+
 // -- initialization -----------------------------------------------------------
 
 clone_state::clone_state(caf::event_based_actor* ptr, endpoint_id this_endpoint,
@@ -45,13 +55,20 @@ clone_state::clone_state(caf::event_based_actor* ptr, endpoint_id this_endpoint,
                          caf::actor parent, endpoint::clock* ep_clock,
                          caf::async::consumer_resource<command_message> in_res,
                          caf::async::producer_resource<command_message> out_res)
-  : super(ptr), input(this), max_sync_interval(master_timeout) {
+  : super(ptr),
+    input(this),
+    max_sync_interval(master_timeout),
+    metrics(ptr->system(), nm) {
   super::init(this_endpoint, ep_clock, std::move(nm), std::move(parent),
               std::move(in_res), std::move(out_res));
   master_topic = store_name / topic::master_suffix();
   super::init(input);
   max_get_delay = caf::get_or(ptr->config(), "broker.store.max-get-delay",
                               defaults::store::max_get_delay);
+  combine_interval = caf::get_or(ptr->config(), "broker.store.combine-interval",
+                                 defaults::store::combine_interval);
+  combine_max_size = caf::get_or(ptr->config(), "broker.store.combine-max-size",
+                                 defaults::store::combine_max_size);
   BROKER_INFO("attached clone" << id << "to" << store_name);
 }
 
@@ -207,6 +224,7 @@ table clone_state::status_snapshot() const {
     result.emplace("output"s, get_stats(*output_opt));
   else
     result.emplace("output"s, nil);
+  result.emplace("combined-writes"s, count{combiner.size()});
   return result;
 }
 
@@ -233,7 +251,9 @@ void clone_state::consume(put_command& x) {
     value = std::move(x.value);
   } else {
     emit_insert_event(x);
-    store.emplace(std::move(x.key), std::move(x.value));
+    auto i = store.emplace(std::move(x.key), std::move(x.value)).first;
+    index.insert(i->first);
+    subnets.insert(i->first);
   }
 }
 
@@ -248,12 +268,16 @@ void clone_state::consume(put_unique_result_command& cmd) {
 
 void clone_state::consume(erase_command& x) {
   BROKER_INFO("ERASE" << x.key);
+  index.erase(x.key);
+  subnets.erase(x.key);
   if (store.erase(x.key) != 0)
     emit_erase_event(x.key, x.publisher);
 }
 
 void clone_state::consume(expire_command& x) {
   BROKER_INFO("EXPIRE" << x.key);
+  index.erase(x.key);
+  subnets.erase(x.key);
   if (store.erase(x.key) != 0)
     emit_expire_event(x.key, x.publisher);
 }
@@ -262,6 +286,8 @@ void clone_state::consume(clear_command& x) {
   BROKER_INFO("CLEAR");
   for (auto& kvp : store)
     emit_erase_event(kvp.first, x.publisher);
+  index.clear();
+  subnets.clear();
   store.clear();
 }
 
@@ -386,6 +412,34 @@ data clone_state::keys() const {
   return result;
 }
 
+data clone_state::scan(const data& first, const data& last, count limit) {
+  if (!index.enabled())
+    index.enable(store);
+  table entries;
+  auto cursor = index.scan(first, last, limit, [&](const data& key) {
+    entries.emplace_hint(entries.end(), key, store.find(key)->second);
+  });
+  return detail::make_scan_result(std::move(entries), std::move(cursor));
+}
+
+data clone_state::lookup_containing(const address& addr) {
+  if (!subnets.enabled())
+    subnets.enable(store);
+  if (auto key = subnets.longest_match(addr))
+    return vector{*key, store.find(*key)->second};
+  return data{};
+}
+
+data clone_state::covered_by(const subnet& net) {
+  if (!subnets.enabled())
+    subnets.enable(store);
+  table entries;
+  subnets.covered_by(net, [&](const data& key) {
+    entries.emplace(key, store.find(key)->second);
+  });
+  return entries;
+}
+
 void clone_state::set_store(std::unordered_map<data, data> x) {
   BROKER_TRACE("");
   BROKER_INFO("SET" << x);
@@ -427,6 +481,8 @@ void clone_state::set_store(std::unordered_map<data, data> x) {
         emit_insert_event(key, value, std::nullopt, publisher);
   }
   // Override local state.
+  index.disable();
+  subnets.disable();
   store = std::move(x);
   // Trigger any GET messages waiting for a reply.
   for (auto& callback : on_set_store_callbacks)
@@ -439,7 +495,8 @@ bool clone_state::has_master() const noexcept {
 }
 
 bool clone_state::idle() const noexcept {
-  return input.idle() && (!output_opt || output_opt->idle());
+  return combiner.empty() && input.idle()
+         && (!output_opt || output_opt->idle());
 }
 
 // -- helper functions ---------------------------------------------------------
@@ -478,6 +535,37 @@ void clone_state::send_to_master(internal_command_variant&& content) {
   }
 }
 
+void clone_state::write(internal_command_variant&& content) {
+  if (combine_interval.count() > 0 && combiner.add(content)) {
+    metrics.combiner_inputs->inc();
+    if (combiner.size() >= combine_max_size) {
+      flush_writes();
+    } else if (!combine_flush_scheduled) {
+      // Flushing early leaves this timeout in place. Hence, no write remains in
+      // the combiner for longer than `combine_interval`.
+      combine_flush_scheduled = true;
+      self->run_delayed(combine_interval, [this] {
+        combine_flush_scheduled = false;
+        flush_writes();
+      });
+    }
+    return;
+  }
+  // Commands that we cannot combine must not overtake buffered writes.
+  flush_writes();
+  send_to_master(std::move(content));
+}
+
+void clone_state::flush_writes() {
+  if (combiner.empty())
+    return;
+  BROKER_DEBUG("flush" << combiner.size() << "combined writes");
+  combiner.flush([this](internal_command_variant&& content) {
+    metrics.combiner_outputs->inc();
+    send_to_master(std::move(content));
+  });
+}
+
 // -- clone actor --------------------------------------------------------------
 
 caf::behavior clone_state::make_behavior() {
@@ -510,9 +598,10 @@ caf::behavior clone_state::make_behavior() {
           return;
         }
       }
-      send_to_master(std::move(content));
+      write(std::move(content));
     },
     [=](atom::sync_point, caf::actor& who) {
+      flush_writes();
       self->send(who, atom::sync_point_v);
     },
     [=](atom::tick) {
@@ -560,6 +649,82 @@ caf::behavior clone_state::make_behavior() {
         id);
       return rp;
     },
+    [=](atom::get, atom::scan, data& first, data& last,
+        count limit) -> caf::result<data> {
+      auto rp = self->make_response_promise();
+      get_impl(rp, [this, rp, first{std::move(first)}, last{std::move(last)},
+                    limit]() mutable {
+        auto x = scan(first, last, limit);
+        BROKER_INFO("SCAN" << first << last << limit << "->" << x);
+        rp.deliver(std::move(x));
+      });
+      return rp;
+    },
+    [=](atom::get, atom::scan, data& first, data& last, count limit,
+        request_id id) {
+      auto rp = self->make_response_promise();
+      get_impl(
+        rp,
+        [this, rp, first{std::move(first)}, last{std::move(last)}, limit,
+         id]() mutable {
+          auto x = scan(first, last, limit);
+          BROKER_INFO("SCAN" << first << last << limit << "with id" << id
+                             << "->" << x);
+          rp.deliver(std::move(x), id);
+        },
+        id);
+      return rp;
+    },
+    [=](atom::get, atom::containing,
+        const address& addr) -> caf::result<data> {
+      auto rp = self->make_response_promise();
+      get_impl(rp, [this, rp, addr]() mutable {
+        auto x = lookup_containing(addr);
+        BROKER_INFO("LOOKUP_CONTAINING" << addr << "->" << x);
+        if (is<none>(x))
+          rp.deliver(caf::make_error(ec::no_such_key));
+        else
+          rp.deliver(std::move(x));
+      });
+      return rp;
+    },
+    [=](atom::get, atom::containing, const address& addr, request_id id) {
+      auto rp = self->make_response_promise();
+      get_impl(
+        rp,
+        [this, rp, addr, id]() mutable {
+          auto x = lookup_containing(addr);
+          BROKER_INFO("LOOKUP_CONTAINING" << addr << "with id" << id << "->"
+                                          << x);
+          if (is<none>(x))
+            rp.deliver(caf::make_error(ec::no_such_key), id);
+          else
+            rp.deliver(std::move(x), id);
+        },
+        id);
+      return rp;
+    },
+    [=](atom::get, atom::covered_by, const subnet& net) -> caf::result<data> {
+      auto rp = self->make_response_promise();
+      get_impl(rp, [this, rp, net]() mutable {
+        auto x = covered_by(net);
+        BROKER_INFO("COVERED_BY" << net << "->" << x);
+        rp.deliver(std::move(x));
+      });
+      return rp;
+    },
+    [=](atom::get, atom::covered_by, const subnet& net, request_id id) {
+      auto rp = self->make_response_promise();
+      get_impl(
+        rp,
+        [this, rp, net, id]() mutable {
+          auto x = covered_by(net);
+          BROKER_INFO("COVERED_BY" << net << "with id" << id << "->" << x);
+          rp.deliver(std::move(x), id);
+        },
+        id);
+      return rp;
+    },
     [=](atom::exists, data& key) -> caf::result<data> {
       auto rp = self->make_response_promise();
       get_impl(rp, [this, rp, key{std::move(key)}]() mutable {
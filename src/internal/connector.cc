@@ -6,6 +6,9 @@
 #include "broker/error.hh"
 #include "broker/filter_type.hh"
 #include "broker/internal/logger.hh"
+#include "broker/internal/metric_factory.hh"
+#include "broker/internal/peer_io.hh"
+#include "broker/internal/pollset.hh"
 #include "broker/internal/type_id.hh"
 #include "broker/internal/wire_format.hh"
 #include "broker/lamport_timestamp.hh"
@@ -21,13 +24,22 @@
 #include <caf/net/middleman.hpp>
 #include <caf/net/openssl_transport.hpp>
 #include <caf/net/pipe_socket.hpp>
+#include <caf/net/stream_transport.hpp>
 #include <caf/net/tcp_accept_socket.hpp>
 #include <caf/net/tcp_stream_socket.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 // -- platform setup -----------------------------------------------------------
 
@@ -264,11 +276,255 @@ ssl_context_from_cfg(const openssl_options_ptr& cfg) {
 
 namespace {
 
+// -- TLS session resumption ---------------------------------------------------
+
+/// Bundles the metric instances for TLS handshakes.
+struct ssl_handshake_metrics {
+  metric_factory::core_t::tls_handshakes_t count{nullptr, nullptr};
+  metric_factory::core_t::tls_handshake_duration_t duration{nullptr, nullptr};
+};
+
+/// Stores TLS sessions of outgoing connections for resuming them when
+/// reconnecting to the same peer. The SSL context of the connector owns the
+/// cache. Note that OpenSSL may add sessions from any thread that reads from
+/// a TLS connection, because TLS 1.3 servers send session tickets only after
+/// completing the handshake.
+///
+/// The cache stores serialized sessions rather than `SSL_SESSION` objects.
+/// OpenSSL marks the session of a connection as not resumable when closing the
+/// connection without a TLS shutdown, which is the usual case when a peer
+/// restarts.
+class ssl_session_cache {
+public:
+  using bytes = std::vector<unsigned char>;
+
+  ssl_session_cache(size_t capacity, ssl_handshake_metrics metrics)
+    : capacity_(capacity), metrics_(metrics) {
+    // nop
+  }
+
+  ssl_session_cache(const ssl_session_cache&) = delete;
+
+  ssl_session_cache& operator=(const ssl_session_cache&) = delete;
+
+  /// Stores `sess` as most recent session for `key`.
+  void put(const std::string& key, SSL_SESSION* sess) {
+    auto size = i2d_SSL_SESSION(sess, nullptr);
+    if (size <= 0)
+      return;
+    bytes buf(static_cast<size_t>(size));
+    auto pos = buf.data();
+    i2d_SSL_SESSION(sess, &pos);
+    std::unique_lock guard{mtx_};
+    if (auto i = index_.find(key); i != index_.end()) {
+      i->second->second = std::move(buf);
+      sessions_.splice(sessions_.begin(), sessions_, i->second);
+      return;
+    }
+    sessions_.emplace_front(key, std::move(buf));
+    index_.emplace(key, sessions_.begin());
+    if (sessions_.size() > capacity_) {
+      index_.erase(sessions_.back().first);
+      sessions_.pop_back();
+    }
+  }
+
+  /// Configures `ssl` to resume the most recent session for `key` if present.
+  void resume(const std::string& key, SSL* ssl) {
+    SSL_SESSION* sess = nullptr;
+    {
+      std::unique_lock guard{mtx_};
+      if (auto i = index_.find(key); i != index_.end()) {
+        const unsigned char* pos = i->second->second.data();
+        auto size = static_cast<long>(i->second->second.size());
+        sess = d2i_SSL_SESSION(nullptr, &pos, size);
+        sessions_.splice(sessions_.begin(), sessions_, i->second);
+      }
+    }
+    if (sess != nullptr) {
+      BROKER_DEBUG("try resuming TLS session with" << key);
+      SSL_set_session(ssl, sess);
+      SSL_SESSION_free(sess);
+    }
+  }
+
+  /// Updates the metrics after completing a TLS handshake.
+  void observe(bool resumed, timespan duration) {
+    auto& [count, hist] = metrics_;
+    if (auto ptr = resumed ? count.resumed : count.full)
+      ptr->inc();
+    if (auto ptr = resumed ? hist.resumed : hist.full)
+      ptr->observe(std::chrono::duration<double>{duration}.count());
+  }
+
+private:
+  using session_list = std::list<std::pair<std::string, bytes>>;
+
+  std::mutex mtx_;
+
+  size_t capacity_;
+
+  /// Stores the most recently used sessions first.
+  session_list sessions_;
+
+  std::unordered_map<std::string, session_list::iterator> index_;
+
+  ssl_handshake_metrics metrics_;
+};
+
+/// State for each TLS connection of the connector.
+struct ssl_conn_state {
+  /// Identifies the remote peer for outgoing connections. Empty for incoming
+  /// connections.
+  std::string key;
+
+  /// Marks the start of the current handshake.
+  std::chrono::steady_clock::time_point start;
+
+  /// Stores whether we have observed the start of a handshake.
+  bool in_handshake = false;
+};
+
+/// Returns the index for storing the session cache in an SSL context.
+int ssl_session_cache_index() {
+  static int result = SSL_CTX_get_ex_new_index(
+    0, nullptr, nullptr, nullptr,
+    [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+      delete static_cast<ssl_session_cache*>(ptr);
+    });
+  return result;
+}
+
+/// Returns the index for storing an `ssl_conn_state` in an SSL connection.
+int ssl_conn_state_index() {
+  static int result = SSL_get_ex_new_index(
+    0, nullptr, nullptr, nullptr,
+    [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+      delete static_cast<ssl_conn_state*>(ptr);
+    });
+  return result;
+}
+
+ssl_session_cache* get_ssl_session_cache(const SSL* ssl) {
+  auto ptr = SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl),
+                                 ssl_session_cache_index());
+  return static_cast<ssl_session_cache*>(ptr);
+}
+
+ssl_conn_state* get_ssl_conn_state(const SSL* ssl) {
+  return static_cast<ssl_conn_state*>(
+    SSL_get_ex_data(ssl, ssl_conn_state_index()));
+}
+
+/// Receives new sessions from OpenSSL on the client side.
+int ssl_new_session_cb(SSL* ssl, SSL_SESSION* sess) {
+  auto cache = get_ssl_session_cache(ssl);
+  auto st = get_ssl_conn_state(ssl);
+  if (cache == nullptr || st == nullptr || st->key.empty())
+    return 0;
+  cache->put(st->key, sess);
+  return 0; // The cache stores a copy.
+}
+
+/// Measures the duration of TLS handshakes.
+void ssl_info_cb(const SSL* ssl, int where, int) {
+  auto st = get_ssl_conn_state(ssl);
+  if (st == nullptr)
+    return;
+  if (where & SSL_CB_HANDSHAKE_START) {
+    st->start = std::chrono::steady_clock::now();
+    st->in_handshake = true;
+  } else if ((where & SSL_CB_HANDSHAKE_DONE) && st->in_handshake) {
+    st->in_handshake = false;
+    if (auto cache = get_ssl_session_cache(ssl)) {
+      auto resumed = SSL_session_reused(const_cast<SSL*>(ssl)) == 1;
+      BROKER_DEBUG("completed TLS handshake" << BROKER_ARG(resumed));
+      cache->observe(resumed, std::chrono::steady_clock::now() - st->start);
+    }
+  }
+}
+
+/// Configures session caching and session tickets for the SSL context of the
+/// connector. Also installs the callbacks for handshake metrics.
+void init_ssl_sessions(SSL_CTX* ctx, const openssl_options& cfg,
+                       ssl_handshake_metrics metrics) {
+  auto cache = new ssl_session_cache(cfg.session_cache_size, metrics);
+  SSL_CTX_set_ex_data(ctx, ssl_session_cache_index(), cache);
+  SSL_CTX_set_info_callback(ctx, ssl_info_cb);
+  if (cfg.session_cache_size == 0) {
+    BROKER_DEBUG("TLS session resumption disabled");
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    return;
+  }
+  // Servers only resume sessions of authenticated clients with a session ID
+  // context.
+  static constexpr unsigned char sid_ctx[] = "broker";
+  SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+  SSL_CTX_sess_set_cache_size(ctx, static_cast<long>(cfg.session_cache_size));
+  SSL_CTX_sess_set_new_cb(ctx, ssl_new_session_cb);
+  auto timeout = std::chrono::duration_cast<std::chrono::seconds>(
+    cfg.session_timeout);
+  SSL_CTX_set_timeout(ctx, static_cast<long>(timeout.count()));
+  if (!cfg.session_tickets) {
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+  } else if (!cfg.session_ticket_key_file.empty()) {
+    // Without this, OpenSSL generates a random key and servers can no longer
+    // decrypt tickets of their clients after restarting.
+    auto key_len = SSL_CTX_get_tlsext_ticket_keys(ctx, nullptr, 0);
+    std::ifstream in{cfg.session_ticket_key_file, std::ios::binary};
+    std::vector<char> keys(static_cast<size_t>(key_len));
+    if (!in.read(keys.data(), key_len))
+      throw ssl_error("failed to read session ticket keys");
+    if (SSL_CTX_set_tlsext_ticket_keys(ctx, keys.data(), key_len) != 1)
+      throw ssl_error("failed to set session ticket keys");
+  }
+}
+
+/// Creates an OpenSSL policy for `fd`. For outgoing connections, `key`
+/// identifies the remote peer for resuming a previous session.
+caf::net::openssl::policy make_ssl_policy(const caf::net::openssl::ctx_ptr& ctx,
+                                          caf::net::stream_socket fd,
+                                          std::string key = {}) {
+  auto conn = caf::net::openssl::make_conn(ctx);
+  if (SSL_set_fd(conn.get(), fd.id) != 1)
+    throw ssl_error("failed to assign socket to TLS connection");
+  if (auto cache = get_ssl_session_cache(conn.get())) {
+    if (!key.empty())
+      cache->resume(key, conn.get());
+    auto st = new ssl_conn_state;
+    st->key = std::move(key);
+    SSL_set_ex_data(conn.get(), ssl_conn_state_index(), st);
+  }
+  return caf::net::openssl::policy{std::move(conn)};
+}
+
 // -- implementations for pending connections ----------------------------------
 
+// Note: the transport serializes all messages that are available in the
+//       buffer of a connection into its write buffer before writing to the
+//       socket. Hence, a single write covers an entire batch of messages (see
+//       write_batching.hh). The policies below count the actual read and write
+//       operations and read ahead for parsing many frames per read.
+
+using plain_peer_policy =
+  peer_io_policy<caf::net::default_stream_transport_policy>;
+
+template <class UpperLayer>
+using plain_peer_transport =
+  caf::net::stream_transport_base<plain_peer_policy, UpperLayer>;
+
+using ssl_peer_policy = peer_io_policy<caf::net::openssl::policy>;
+
+template <class UpperLayer>
+using ssl_peer_transport =
+  caf::net::stream_transport_base<ssl_peer_policy, UpperLayer>;
+
 class plain_pending_connection : public pending_connection {
 public:
-  explicit plain_pending_connection(caf::net::stream_socket fd) : fd_(fd) {
+  plain_pending_connection(caf::net::stream_socket fd, bool with_origin)
+    : fd_(fd), with_origin_(with_origin) {
     // nop
   }
 
@@ -278,16 +534,20 @@ public:
 
   caf::error run(caf::actor_system& sys,
                  caf::async::consumer_resource<node_message> pull,
-                 caf::async::producer_resource<node_message> push) override {
+                 caf::async::producer_resource<node_message> push,
+                 latency_tracker_ptr latency, peer_io_metrics io) override {
     BROKER_DEBUG("run pending connection" << BROKER_ARG2("fd", fd_.id)
                                           << "(no SSL)");
     using trait_t = wire_format::v1::trait;
     if (fd_ != caf::net::invalid_socket) {
       using caf::net::run_with_length_prefix_framing;
       auto& mpx = sys.network_manager().mpx();
-      auto res = run_with_length_prefix_framing(mpx, fd_, caf::settings{},
-                                                std::move(pull),
-                                                std::move(push), trait_t{});
+      using base_policy = caf::net::default_stream_transport_policy;
+      auto policy = plain_peer_policy{base_policy{}, io};
+      auto res = run_with_length_prefix_framing<plain_peer_transport>(
+        mpx, fd_, caf::settings{}, std::move(pull), std::move(push),
+        trait_t{with_origin_, std::move(latency), io.read_messages},
+        std::move(policy));
       fd_.id = caf::net::invalid_socket_id;
       return res;
     } else {
@@ -297,13 +557,15 @@ public:
 
 private:
   caf::net::stream_socket fd_;
+  bool with_origin_;
 };
 
 class encrypted_pending_connection : public pending_connection {
 public:
   encrypted_pending_connection(caf::net::stream_socket fd,
-                               caf::net::openssl::policy policy)
-    : fd_(fd), policy_(std::move(policy)) {
+                               caf::net::openssl::policy policy,
+                               bool with_origin)
+    : fd_(fd), policy_(std::move(policy)), with_origin_(with_origin) {
     // nop
   }
 
@@ -313,16 +575,19 @@ public:
 
   caf::error run(caf::actor_system& sys,
                  caf::async::consumer_resource<node_message> pull,
-                 caf::async::producer_resource<node_message> push) override {
+                 caf::async::producer_resource<node_message> push,
+                 latency_tracker_ptr latency, peer_io_metrics io) override {
     BROKER_DEBUG("run pending connection" << BROKER_ARG2("fd", fd_.id)
                                           << "(SSL)");
     using trait_t = wire_format::v1::trait;
     if (fd_ != caf::net::invalid_socket) {
       using caf::net::run_with_length_prefix_framing;
       auto& mpx = sys.network_manager().mpx();
-      auto res = run_with_length_prefix_framing<caf::net::openssl_transport>(
-        mpx, fd_, caf::settings{}, std::move(pull), std::move(push), trait_t{},
-        std::move(policy_));
+      auto policy = ssl_peer_policy{std::move(policy_), io};
+      auto res = run_with_length_prefix_framing<ssl_peer_transport>(
+        mpx, fd_, caf::settings{}, std::move(pull), std::move(push),
+        trait_t{with_origin_, std::move(latency), io.read_messages},
+        std::move(policy));
       fd_.id = caf::net::invalid_socket_id;
       return res;
     } else {
@@ -333,6 +598,7 @@ public:
 private:
   caf::net::stream_socket fd_;
   caf::net::openssl::policy policy_;
+  bool with_origin_;
 };
 
 // -- networking and connector setup -------------------------------------------
@@ -551,9 +817,12 @@ public:
 
   // -- member variables -------------------------------------------------------
 
-  /// Points to the single manager instance owning all state objects.
+  /// Points to the manager instance owning this state object.
   connect_manager* mgr;
 
+  /// The socket for the current connection attempt.
+  caf::net::socket_id sock = caf::net::invalid_socket_id;
+
   /// Keeps track of the state of our socket to allow us to call connect() or
   /// accept() until the socket becomes ready for read and write operations.
   socket_state sck_state = socket_state::running;
@@ -580,6 +849,10 @@ public:
   /// The filter announced by the remote node.
   filter_type remote_filter;
 
+  /// The protocol version for this connection. Known after 'hello' or
+  /// 'version_select'.
+  uint8_t selected_version = wire_format::protocol_version;
+
   /// The IP network address to the remote node.
   network_info addr;
 
@@ -598,6 +871,10 @@ public:
   /// erase that state again when aborting.
   bool added_peer_status = false;
 
+  /// Stores whether we announced the handshake with `remote_id` to the other
+  /// connector threads.
+  bool announced_handshake = false;
+
   /// Stores pointers to connect states that tried to start a handshake process
   /// while this state had already started it. We store these pointers to delay
   /// the drop_conn message. Otherwise, the drop_conn message might arrive
@@ -618,6 +895,9 @@ public:
   /// Returns the ID of this peer.
   endpoint_id this_peer();
 
+  /// Returns the maximum protocol version we offer to peers.
+  uint8_t max_version();
+
   /// Checks whether the state reached the terminal success state.
   bool reached_fin_state() const noexcept {
     return fn == &connect_state::fin;
@@ -655,6 +935,7 @@ public:
     BROKER_DEBUG("resetting connect_state object"
                  << BROKER_ARG(event_id) << BROKER_ARG(addr) << BROKER_ARG(st));
     redundant = false;
+    withdraw_handshake();
     if (added_peer_status) {
       auto& psm = peer_statuses();
       BROKER_DEBUG(remote_id << "::" << psm.get(remote_id) << "-> ()");
@@ -669,6 +950,7 @@ public:
     sck_state = st;
     sck_policy = std::move(new_policy);
     remote_id = endpoint_id::nil();
+    selected_version = wire_format::protocol_version;
   }
 
   // -- socket operations ------------------------------------------------------
@@ -677,13 +959,16 @@ public:
   /// this state.
   pending_connection_ptr make_pending_connection(stream_socket fd) {
     using namespace caf::net;
+    auto with_origin =
+      selected_version == wire_format::timestamped_protocol_version;
     auto f = detail::make_overload(
-      [fd](default_stream_transport_policy&) -> pending_connection_ptr {
-        return std::make_shared<plain_pending_connection>(fd);
+      [fd, with_origin](default_stream_transport_policy&)
+        -> pending_connection_ptr {
+        return std::make_shared<plain_pending_connection>(fd, with_origin);
       },
-      [fd](openssl::policy& ssl_policy) -> pending_connection_ptr {
+      [fd, with_origin](openssl::policy& ssl_policy) -> pending_connection_ptr {
         return std::make_shared<encrypted_pending_connection>(
-          fd, std::move(ssl_policy));
+          fd, std::move(ssl_policy), with_origin);
       });
     return std::visit(f, sck_policy);
   }
@@ -860,28 +1145,13 @@ public:
   // -- FSM --------------------------------------------------------------------
 
   /// Transitions to a new state handler.
-  void transition(fn_t f) {
-    fn = f;
-    if (f == &connect_state::fin) {
-      if (!redundant_connections.empty()) {
-        auto msg = wire_format::make_drop_conn_msg(this_peer(),
-                                                   ec::redundant_connection,
-                                                   "redundant connection");
-        for (auto& conn : redundant_connections) {
-          conn->send(msg);
-          conn->transition(&connect_state::fin);
-        }
-        redundant_connections.clear();
-      }
-    } else if (f == &connect_state::err) {
-      if (added_peer_status) {
-        auto& psm = peer_statuses();
-        BROKER_DEBUG(remote_id << "::" << psm.get(remote_id) << "-> ()");
-        psm.remove(remote_id);
-        added_peer_status = false;
-      }
-    }
-  }
+  void transition(fn_t f);
+
+  /// Sends `drop_conn` to all connections in `redundant_connections`.
+  void drop_redundant_connections();
+
+  /// Removes the announcement for the handshake with `remote_id` if present.
+  void withdraw_handshake();
 
   /// Tries to update the status for a peer to connecting.
   /// @returns `true` if the state has been updated and the caller may proceed
@@ -933,9 +1203,102 @@ connect_state_ptr make_connect_state(Ts&&... xs) {
   return std::make_shared<connect_state>(std::forward<Ts>(xs)...);
 }
 
+/// Allows connect managers to schedule work on each other when running
+/// multiple connector threads.
+class connect_inbox {
+public:
+  using job = std::function<void(connect_manager&)>;
+
+  connect_inbox() {
+    auto fds = caf::net::make_pipe();
+    if (!fds) {
+      auto err_str = to_string(fds.error());
+      fprintf(stderr, "failed to create pipe: %s\n", err_str.c_str());
+      abort();
+    }
+    auto [rd, wr] = *fds;
+    if (auto err = caf::net::nonblocking(rd, true)) {
+      auto err_str = to_string(err);
+      fprintf(stderr,
+              "failed to set pipe handle %d to nonblocking (line %d): %s\n",
+              (int) rd.id, __LINE__, err_str.c_str());
+      ::abort();
+    }
+    rd_ = rd;
+    wr_ = wr;
+  }
+
+  connect_inbox(const connect_inbox&) = delete;
+
+  connect_inbox& operator=(const connect_inbox&) = delete;
+
+  ~connect_inbox() {
+    caf::net::close(rd_);
+    caf::net::close(wr_);
+  }
+
+  /// Returns the handle that becomes readable when jobs are pending.
+  caf::net::socket_id fd() const noexcept {
+    return rd_.id;
+  }
+
+  /// Enqueues a new job.
+  /// @thread-safe
+  void post(job f) {
+    std::unique_lock guard{mtx_};
+    jobs_.emplace_back(std::move(f));
+    // Wake up the owner only when the queue becomes non-empty. The owner
+    // empties the pipe before taking the jobs, so no wakeup gets lost.
+    if (jobs_.size() == 1) {
+      caf::byte token{0};
+      if (caf::net::write(wr_, caf::span<const caf::byte>{&token, 1}) != 1) {
+        const char* errmsg = "failed to write to the pipe";
+        BROKER_ERROR(errmsg);
+        throw std::runtime_error(errmsg);
+      }
+    }
+  }
+
+  /// Removes all pending jobs.
+  std::vector<job> take() {
+    caf::byte buf[64];
+    while (caf::net::read(rd_, caf::make_span(buf)) > 0)
+      ; // nop
+    std::vector<job> result;
+    std::unique_lock guard{mtx_};
+    result.swap(jobs_);
+    return result;
+  }
+
+private:
+  std::mutex mtx_;
+  std::vector<job> jobs_;
+  caf::net::pipe_socket rd_;
+  caf::net::pipe_socket wr_;
+};
+
+/// Bundles the connect managers of all connector threads.
+struct connect_shard_group {
+  /// Lists all managers. The first manager owns the acceptors and the pipe to
+  /// the connector and assigns new connections to the managers in
+  /// round-robin order.
+  std::vector<connect_manager*> members;
+
+  /// Selects the manager for the next connection.
+  size_t next = 0;
+
+  /// Guards `handshakes`.
+  std::mutex mtx;
+
+  /// Maps peer IDs to the manager that currently performs the handshake for
+  /// that peer. Allows managers to detect redundant connections across
+  /// threads.
+  std::unordered_map<endpoint_id, connect_manager*> handshakes;
+};
+
 struct connect_manager {
   /// Our pollset.
-  std::vector<pollfd> fdset;
+  pollset fds;
 
   /// Stores state objects that wait for their next retry.
   std::multimap<caf::timestamp, connect_state_ptr> retry_schedule;
@@ -946,9 +1309,15 @@ struct connect_manager {
   /// Tags socket IDs that belong to an acceptor.
   std::unordered_set<caf::net::socket_id> acceptors;
 
-  /// We cannot add elements from the pollset while iterating it, so we push new
-  /// entries to this container instead and insert after each loop iteration.
-  std::vector<pollfd> pending_fdset;
+  /// Points to the group of all managers when running multiple connector
+  /// threads, `nullptr` otherwise.
+  connect_shard_group* group = nullptr;
+
+  /// Receives jobs from other managers in the group.
+  std::unique_ptr<connect_inbox> inbox;
+
+  /// Stops the event loop when set to `true`.
+  bool done = false;
 
   /// Wraps the callbacks for handshake completion.
   connector::listener* listener;
@@ -965,15 +1334,19 @@ struct connect_manager {
   /// Stores a pointer to the OpenSSL context when running with SSL enabled.
   caf::net::openssl::ctx_ptr ssl_ctx;
 
+  /// Stores the maximum protocol version we offer to peers.
+  uint8_t max_version;
+
   connect_manager(endpoint_id this_peer, connector::listener* ls,
                   shared_filter_type* filter,
                   detail::peer_status_map* peer_statuses,
-                  caf::net::openssl::ctx_ptr ctx)
+                  caf::net::openssl::ctx_ptr ctx, uint8_t max_version)
     : listener(ls),
       filter(filter),
       peer_statuses_(peer_statuses),
       this_peer(this_peer),
-      ssl_ctx(std::move(ctx)) {
+      ssl_ctx(std::move(ctx)),
+      max_version(max_version) {
     BROKER_TRACE(BROKER_ARG(this_peer));
   }
 
@@ -981,41 +1354,101 @@ struct connect_manager {
 
   connect_manager& operator=(const connect_manager&) = delete;
 
-  /// Returns the relative timeout for the next retry in milliseconds or -1.
-  int next_timeout_ms() {
-    if (retry_schedule.empty())
-      return -1;
-    auto now = caf::make_timestamp();
-    auto timeout = retry_schedule.begin()->first;
-    if (timeout > now) {
-      namespace sc = std::chrono;
-      auto count = sc::duration_cast<sc::milliseconds>(timeout - now).count();
-      return static_cast<int>(count);
+  // -- multiple connector threads ---------------------------------------------
+
+  /// Adds this manager to `grp`.
+  void join(connect_shard_group& grp) {
+    group = &grp;
+    grp.members.push_back(this);
+    inbox = std::make_unique<connect_inbox>();
+  }
+
+  /// Selects the manager for the next connection.
+  connect_manager* next_shard() {
+    if (group == nullptr)
+      return this;
+    auto& xs = group->members;
+    return xs[group->next++ % xs.size()];
+  }
+
+  /// Runs `f` on the thread of this manager.
+  /// @thread-safe
+  void post(connect_inbox::job f) {
+    BROKER_ASSERT(inbox != nullptr);
+    inbox->post(std::move(f));
+  }
+
+  /// Announces to the other managers that this manager performs the handshake
+  /// with `peer`.
+  void announce_handshake(endpoint_id peer) {
+    if (group != nullptr) {
+      std::unique_lock guard{group->mtx};
+      group->handshakes[peer] = this;
+    }
+  }
+
+  /// Removes the announcement for the handshake with `peer`.
+  void withdraw_handshake(endpoint_id peer) {
+    if (group != nullptr) {
+      std::unique_lock guard{group->mtx};
+      if (auto i = group->handshakes.find(peer);
+          i != group->handshakes.end() && i->second == this)
+        group->handshakes.erase(i);
     }
-    return 0;
   }
 
-  pollfd* find_pollfd(caf::net::socket_id fd) {
-    for (auto& ref : fdset)
-      if (ref.fd == fd)
-        return std::addressof(ref);
-    for (auto& ref : pending_fdset)
-      if (ref.fd == fd)
-        return std::addressof(ref);
+  /// Returns the manager that currently performs the handshake with `peer` or
+  /// `nullptr`.
+  connect_manager* handshake_owner(endpoint_id peer) {
+    if (group != nullptr) {
+      std::unique_lock guard{group->mtx};
+      if (auto i = group->handshakes.find(peer); i != group->handshakes.end())
+        return i->second;
+    }
     return nullptr;
   }
 
+  /// Delays the `drop_conn` message for `conn` until the handshake with `peer`
+  /// completes. Other managers call this function via `post` after detecting
+  /// a redundant connection.
+  void add_redundant_connection(endpoint_id peer, connect_state_ptr conn) {
+    if (auto other = find_pending_handshake(peer)) {
+      other->redundant_connections.emplace_back(std::move(conn));
+    } else {
+      // The handshake completed in the meantime.
+      drop_redundant(std::move(conn),
+                     wire_format::make_drop_conn_msg(this_peer,
+                                                     ec::redundant_connection,
+                                                     "redundant connection"));
+    }
+  }
+
+  /// Sends `msg` to the paused connection `conn`, which may belong to another
+  /// manager.
+  void drop_redundant(connect_state_ptr conn,
+                      const wire_format::drop_conn_msg& msg) {
+    if (conn->mgr == this) {
+      conn->send(msg);
+      conn->transition(&connect_state::fin);
+    } else {
+      conn->mgr->post([conn, msg](connect_manager& owner) {
+        owner.drop_redundant(conn, msg);
+      });
+    }
+  }
+
+  // -- socket management ------------------------------------------------------
+
   void register_fd(connect_state* ptr, short event) {
-    auto pred = [ptr](const auto& kvp) { return kvp.second.get() == ptr; };
-    auto e = pending.end();
-    if (auto i = std::find_if(pending.begin(), e, pred); i != e) {
+    auto i = pending.find(ptr->sock);
+    if (i != pending.end() && i->second.get() == ptr) {
       BROKER_DEBUG("register for"
                    << (event == read_mask ? "reading" : "writing")
                    << BROKER_ARG2("fd", i->first));
-      if (auto fds_ptr = find_pollfd(i->first)) {
-        fds_ptr->events = static_cast<short>(fds_ptr->events | event);
+      if (auto entry = fds.find(i->first)) {
+        entry->events = static_cast<short>(entry->events | event);
       } else {
-        pending_fdset.emplace_back(pollfd{i->first, event, 0});
+        fds.add(i->first, event);
       }
     } else {
       BROKER_ERROR("called register_writing for an unknown connect state");
@@ -1075,17 +1508,19 @@ struct connect_manager {
       short mask = 0;
       if (ssl_ctx) {
         mask = write_mask; // SSL wants to write first.
+        auto key = state->addr.address + ':' + std::to_string(state->addr.port);
         state->reset(connect_state::socket_state::connecting,
-                     caf::net::openssl::policy::make(ssl_ctx, *sock));
+                     make_ssl_policy(ssl_ctx, *sock, std::move(key)));
       } else {
         mask = read_mask;
         state->reset(connect_state::socket_state::running,
                      caf::net::default_stream_transport_policy{});
       }
+      state->sock = sock->id;
       pending.emplace(sock->id, state);
-      pending_fdset.push_back({sock->id, mask, 0});
+      fds.add(sock->id, mask);
       state->transition(&connect_state::await_hello_or_version_select);
-      state->send(wire_format::make_hello_msg(this_peer));
+      state->send(wire_format::make_hello_msg(this_peer, max_version));
     } else {
       auto retry_interval = state->addr.retry;
       if (retry_interval.count() != 0) {
@@ -1107,7 +1542,23 @@ struct connect_manager {
   /// Registers a new state object for connecting to given address.
   void connect(connector_event_id event_id, const network_info& addr) {
     BROKER_TRACE(BROKER_ARG(event_id) << BROKER_ARG(addr));
-    connect(make_connect_state(this, event_id, addr));
+    auto target = next_shard();
+    auto state = make_connect_state(target, event_id, addr);
+    if (target == this)
+      connect(std::move(state));
+    else
+      target->post([state](connect_manager& mgr) { mgr.connect(state); });
+  }
+
+  /// Starts the handshake on an accepted connection.
+  void adopt(caf::net::socket_id fd, short mask, connect_state_ptr state) {
+    BROKER_TRACE(BROKER_ARG(fd));
+    BROKER_ASSERT(pending.count(fd) == 0);
+    state->sock = fd;
+    fds.add(fd, mask);
+    pending.emplace(fd, state);
+    state->transition(&connect_state::await_hello);
+    state->send(wire_format::make_probe_msg());
   }
 
   void listen(connector_event_id event_id, std::string& addr, uint16_t port,
@@ -1128,7 +1579,7 @@ struct connect_manager {
         BROKER_DEBUG("started listening on port" << *actual_port << "socket"
                                                  << sock->id);
         acceptors.emplace(sock->id);
-        pending_fdset.push_back({sock->id, read_mask, 0});
+        fds.add(sock->id, read_mask);
         listener->on_listen(event_id, *actual_port);
       } else {
         BROKER_ERROR("local_port failed:" << actual_port.error());
@@ -1217,7 +1668,8 @@ struct connect_manager {
                   (int) sock->id, __LINE__, err_str.c_str());
           ::abort();
         }
-        auto st = make_connect_state(this);
+        auto target = next_shard();
+        auto st = make_connect_state(target);
         st->addr.retry = 0s;
         if (auto addr = caf::net::remote_addr(*sock))
           st->addr.address = std::move(*addr);
@@ -1230,16 +1682,19 @@ struct connect_manager {
         if (ssl_ctx) {
           mask = write_mask; // SSL wants to write first.
           st->sck_state = connect_state::socket_state::accepting;
-          st->sck_policy = caf::net::openssl::policy::make(ssl_ctx, *sock);
+          st->sck_policy = make_ssl_policy(ssl_ctx, *sock);
         } else {
           mask = read_mask;
           st->sck_state = connect_state::socket_state::running;
           st->sck_policy = caf::net::default_stream_transport_policy{};
         }
-        pending_fdset.push_back({sock->id, mask, 0});
-        pending.emplace(sock->id, st);
-        st->transition(&connect_state::await_hello);
-        st->send(wire_format::make_probe_msg());
+        if (target == this) {
+          adopt(sock->id, mask, std::move(st));
+        } else {
+          target->post([fd{sock->id}, mask, st](connect_manager& mgr) {
+            mgr.adopt(fd, mask, st);
+          });
+        }
       }
     } else {
       entry.events &= ~read_mask;
@@ -1344,23 +1799,45 @@ struct connect_manager {
     }
   }
 
-  void prepare_next_cycle() {
-    BROKER_TRACE("pending handles:" << pending_fdset.size());
-    auto is_done = [](auto& x) { return x.events == 0; };
-    auto new_end = std::remove_if(fdset.begin(), fdset.end(), is_done);
-    if (new_end != fdset.end()) {
-#if CAF_LOG_LEVEL >= CAF_LOG_LEVEL_DEBUG
-      std::for_each(new_end, fdset.end(), [](auto& x) {
-        if (x.fd != detail::invalid_native_socket)
-          BROKER_DEBUG("drop completed socket from pollset"
-                       << BROKER_ARG2("fd", x.fd));
-      });
-#endif
-      fdset.erase(new_end, fdset.end());
+  /// Handles activity on a socket of a pending handshake or an acceptor.
+  void handle(pollfd& entry) {
+    BROKER_DEBUG(BROKER_ARG2("fd", entry.fd)
+                 << BROKER_ARG2("event-mask", entry.revents));
+    if (entry.revents & read_mask) {
+      continue_reading(entry);
+    } else if (entry.revents & write_mask) {
+      continue_writing(entry);
+    } else {
+      abort(entry);
     }
-    if (!pending_fdset.empty()) {
-      fdset.insert(fdset.end(), pending_fdset.begin(), pending_fdset.end());
-      pending_fdset.clear();
+    while ((entry.revents & read_mask) && must_read_more(entry))
+      continue_reading(entry);
+  }
+
+  /// Runs the event loop until `done` becomes `true`. Calls `on_command` for
+  /// activity on `cmd_fd`.
+  template <class OnCommand>
+  void run(caf::net::socket_id cmd_fd, OnCommand on_command) {
+    if (inbox)
+      fds.add(inbox->fd(), read_mask);
+    fds.prepare_next_cycle();
+    while (!done) {
+      fds.wait(next_timeout(), [&](pollfd& entry) {
+        if (entry.fd == cmd_fd) {
+          on_command(entry);
+        } else if (inbox && entry.fd == inbox->fd()) {
+          if (entry.revents & read_mask) {
+            for (auto& f : inbox->take())
+              f(*this);
+          } else if (entry.revents & error_mask) {
+            throw broken_pipe{entry.revents};
+          }
+        } else {
+          handle(entry);
+        }
+      });
+      handle_timeouts();
+      fds.prepare_next_cycle();
     }
   }
 };
@@ -1369,6 +1846,39 @@ detail::peer_status_map& connect_state::peer_statuses() {
   return *mgr->peer_statuses_;
 }
 
+void connect_state::transition(fn_t f) {
+  fn = f;
+  if (!performing_handshake())
+    withdraw_handshake();
+  if (f == &connect_state::fin) {
+    if (!redundant_connections.empty())
+      drop_redundant_connections();
+  } else if (f == &connect_state::err) {
+    if (added_peer_status) {
+      auto& psm = peer_statuses();
+      BROKER_DEBUG(remote_id << "::" << psm.get(remote_id) << "-> ()");
+      psm.remove(remote_id);
+      added_peer_status = false;
+    }
+  }
+}
+
+void connect_state::drop_redundant_connections() {
+  auto msg = wire_format::make_drop_conn_msg(this_peer(),
+                                             ec::redundant_connection,
+                                             "redundant connection");
+  for (auto& conn : redundant_connections)
+    mgr->drop_redundant(std::move(conn), msg);
+  redundant_connections.clear();
+}
+
+void connect_state::withdraw_handshake() {
+  if (announced_handshake) {
+    mgr->withdraw_handshake(remote_id);
+    announced_handshake = false;
+  }
+}
+
 bool connect_state::must_read_more() {
   if (auto pol = std::get_if<caf::net::openssl::policy>(&sck_policy))
     return pol->buffered() > 0;
@@ -1495,6 +2005,8 @@ bool connect_state::proceed_with_handshake(endpoint_id id, bool is_originator) {
   auto proceed = [this, id] {
     added_peer_status = true;
     remote_id = id;
+    mgr->announce_handshake(id);
+    announced_handshake = true;
     return true;
   };
   auto& psm = peer_statuses();
@@ -1523,6 +2035,17 @@ bool connect_state::proceed_with_handshake(endpoint_id id, bool is_originator) {
               other->redundant_connections.emplace_back(shared_from_this());
               transition(&connect_state::paused);
               return false;
+            } else if (auto owner = mgr->handshake_owner(id);
+                       owner != nullptr && owner != mgr) {
+              BROKER_DEBUG("detected redundant connection on another "
+                           "connector thread, enter paused state");
+              redundant = true;
+              remote_id = id;
+              owner->post([id, self{shared_from_this()}](connect_manager& m) {
+                m.add_redundant_connection(id, self);
+              });
+              transition(&connect_state::paused);
+              return false;
             } else {
               BROKER_DEBUG("detected redundant connection but "
                            "find_pending_handshake failed");
@@ -1600,7 +2123,7 @@ bool connect_state::await_hello(wire_format::var_msg& msg) {
       break;
   }
   auto& hello = std::get<wire_format::hello_msg>(msg);
-  if (hello.min_version > wire_format::protocol_version) {
+  if (hello.min_version > max_version()) {
     BROKER_DEBUG("reject peering: version range not supported");
     send(wire_format::make_drop_conn_msg(this_peer(), ec::peer_incompatible,
                                          "version range not supported"));
@@ -1608,7 +2131,8 @@ bool connect_state::await_hello(wire_format::var_msg& msg) {
     return false;
   } else if (mgr->this_peer < hello.sender_id) {
     if (proceed_with_handshake(hello.sender_id, true)) {
-      send(wire_format::make_version_select_msg(this_peer()));
+      selected_version = std::min(hello.max_version, max_version());
+      send(wire_format::make_version_select_msg(this_peer(), selected_version));
       send(wire_format::v1::make_originator_syn_msg(local_filter()));
       transition(&connect_state::await_resp_syn_ack);
       return true;
@@ -1616,7 +2140,7 @@ bool connect_state::await_hello(wire_format::var_msg& msg) {
       return fn != &connect_state::err;
     }
   } else {
-    send(wire_format::make_hello_msg(this_peer()));
+    send(wire_format::make_hello_msg(this_peer(), max_version()));
     transition(&connect_state::await_version_select);
     return true;
   }
@@ -1637,12 +2161,14 @@ bool connect_state::await_version_select(wire_format::var_msg& msg) {
       break;
   }
   auto& vselect = std::get<wire_format::version_select_msg>(msg);
-  if (vselect.selected_version != wire_format::protocol_version) {
+  if (vselect.selected_version < wire_format::protocol_version
+      || vselect.selected_version > max_version()) {
     send(wire_format::make_drop_conn_msg(this_peer(), ec::peer_incompatible,
                                          "selected version not supported"));
     transition(&connect_state::err);
     return false;
   } else if (proceed_with_handshake(vselect.sender_id, false)) {
+    selected_version = vselect.selected_version;
     transition(&connect_state::await_orig_syn);
     return true;
   } else {
@@ -1716,6 +2242,10 @@ endpoint_id connect_state::this_peer() {
   return mgr->this_peer;
 }
 
+uint8_t connect_state::max_version() {
+  return mgr->max_version;
+}
+
 } // namespace
 
 connector::listener::~listener() {
@@ -1883,73 +2413,70 @@ ssl_lib_guard global_ssl_guard;
 void connector::run_impl(listener* sub, shared_filter_type* filter) {
   // Block SIGPIPE entirely on this thread.
   caf::net::multiplexer::block_sigpipe();
-  using std::find_if;
   // When running with OpenSSL enabled, initialize the library.
   if (ssl_cfg_ != nullptr && !broker_cfg_.skip_ssl_init)
     global_ssl_guard.init();
-  // Poll isn't terribly efficient nor fast, but the connector is not a
-  // performance-critical system component. It only establishes connections and
-  // reads handshake messages, so poll() is 'good enough' and we use it since
+  // The connector only establishes connections and reads handshake messages.
+  // On Linux, we use epoll to keep the cost per cycle independent of the
+  // number of pending handshakes. Elsewhere, we fall back to poll() since
   // it's portable.
-  connect_manager mgr{this_peer_, sub, filter, peer_statuses_.get(),
-                      ssl_context_from_cfg(ssl_cfg_)};
-  auto& fdset = mgr.fdset;
-  fdset.push_back({pipe_rd_, read_mask, 0});
-  bool done = false;
-  pipe_reader prd{caf::net::pipe_socket{pipe_rd_}, &done};
-  // Loop until we receive a shutdown via the pipe.
-  while (!done) {
-    int presult =
-#ifdef CAF_WINDOWS
-      ::WSAPoll(fdset.data(), static_cast<ULONG>(fdset.size()),
-                mgr.next_timeout());
-#else
-      ::poll(fdset.data(), static_cast<nfds_t>(fdset.size()),
-             mgr.next_timeout());
-#endif
-    BROKER_DEBUG("poll on" << fdset.size() << "sockets returned" << presult);
-    if (presult < 0) {
-      switch (caf::net::last_socket_error()) {
-        case std::errc::interrupted:
-          // nop
-          break;
-        default:
-          BROKER_ERROR("poll() failed");
-          throw std::runtime_error("poll() failed");
-      }
-    } else if (presult > 0) {
-      auto has_activity = [](auto& entry) { return entry.revents != 0; };
-      auto i = std::find_if(fdset.begin(), fdset.end(), has_activity);
-      BROKER_ASSERT(i != fdset.end());
-      auto advance = [&i, &fdset, has_activity] {
-        i = std::find_if(i + 1, fdset.end(), has_activity);
-        return i != fdset.end();
-      };
-      do {
-        BROKER_DEBUG(BROKER_ARG2("fd", i->fd)
-                     << BROKER_ARG2("event-mask", i->revents));
-        if (i->fd == pipe_rd_) {
-          if (i->revents & read_mask) {
-            prd.read(mgr);
-          } else if (i->revents & error_mask) {
-            throw broken_pipe{i->revents};
-          }
-        } else {
-          if (i->revents & read_mask) {
-            mgr.continue_reading(*i);
-          } else if (i->revents & write_mask) {
-            mgr.continue_writing(*i);
-          } else {
-            mgr.abort(*i);
-          }
-          while ((i->revents & read_mask) && mgr.must_read_more(*i))
-            mgr.continue_reading(*i);
+  // Only offer origin timestamps on the wire when collecting latencies.
+  auto max_version = broker_cfg_.latency_prefixes.empty()
+                       ? wire_format::protocol_version
+                       : wire_format::timestamped_protocol_version;
+  auto ssl_ctx = ssl_context_from_cfg(ssl_cfg_);
+  if (ssl_ctx) {
+    ssl_handshake_metrics metrics;
+    if (sys_ != nullptr) {
+      metric_factory factory{*sys_};
+      metrics.count = factory.core.tls_handshakes_instances();
+      metrics.duration = factory.core.tls_handshake_duration_instances();
+    }
+    init_ssl_sessions(ssl_ctx.get(), *ssl_cfg_, metrics);
+  }
+  auto make_manager = [&] {
+    return std::make_unique<connect_manager>(this_peer_, sub, filter,
+                                             peer_statuses_.get(), ssl_ctx,
+                                             max_version);
+  };
+  auto mgr = make_manager();
+  // Optionally distribute the handshakes to additional threads. This manager
+  // owns the acceptors and assigns new connections in round-robin order.
+  connect_shard_group group;
+  std::vector<std::unique_ptr<connect_manager>> workers;
+  std::vector<std::thread> threads;
+  if (auto num_threads = broker_cfg_.connector_threads; num_threads > 1) {
+    mgr->join(group);
+    for (size_t i = 1; i < num_threads; ++i)
+      workers.emplace_back(make_manager())->join(group);
+    for (auto& worker : workers) {
+      threads.emplace_back([ptr{worker.get()}, sys{sys_}] {
+        CAF_SET_LOGGER_SYS(sys);
+        caf::net::multiplexer::block_sigpipe();
+        try {
+          ptr->run(caf::net::invalid_socket_id, [](pollfd&) {});
+        } catch ([[maybe_unused]] std::exception& ex) {
+          BROKER_ERROR("exception:" << ex.what());
         }
-      } while (--presult > 0 && advance());
+      });
     }
-    mgr.handle_timeouts();
-    mgr.prepare_next_cycle();
   }
+  auto stop_workers = caf::detail::make_scope_guard([&workers, &threads] {
+    for (auto& worker : workers)
+      worker->post([](connect_manager& m) { m.done = true; });
+    for (auto& thread : threads)
+      thread.join();
+  });
+  pipe_reader prd{caf::net::pipe_socket{pipe_rd_}, &mgr->done};
+  mgr->fds.add(pipe_rd_, read_mask);
+  // Loop until we receive a shutdown via the pipe.
+  mgr->run(pipe_rd_, [&prd, &mgr](pollfd& entry) {
+    if (entry.revents & read_mask) {
+      prd.read(*mgr);
+    } else if (entry.revents & error_mask) {
+      throw broken_pipe{entry.revents};
+    }
+  });
   BROKER_DEBUG("connector done");
 }
 
@@ -26,9 +26,21 @@
 #include "broker/detail/prefix_matcher.hh"
 #include "broker/domain_options.hh"
 #include "broker/filter_type.hh"
+#include "broker/internal/capture_actor.hh"
 #include "broker/internal/clone_actor.hh"
+#include "broker/internal/dispatch_shard.hh"
 #include "broker/internal/killswitch.hh"
+#include "broker/internal/latency_tracker.hh"
 #include "broker/internal/master_actor.hh"
+#include "broker/internal/peer_io.hh"
+#include "broker/internal/peer_selection.hh"
+#include "broker/internal/priority_lanes.hh"
+#include "broker/internal/routing_update.hh"
+#include "broker/internal/trace.hh"
+#include "broker/internal/write_batching.hh"
+
+#include <algorithm>
+#include <atomic>
 
 using namespace std::literals;
 
@@ -143,8 +155,13 @@ core_actor_state::core_actor_state(caf::event_based_actor* self,
     filter(std::make_shared<shared_filter_type>(std::move(initial_filter))),
     clock(clock),
     metrics(self->system()),
+    latency(latency_tracker::make(self->system())),
+    publish_limits(publish_limiter::make(self->system())),
     unsafe_inputs(self),
-    flow_inputs(self) {
+    flow_inputs(self),
+    lanes(priority_lanes::make(self->system())),
+    priority_inputs(self),
+    priority_flow_inputs(self) {
   // Read config and check for extra configuration parameters.
   ttl = caf::get_or(self->config(), "broker.ttl", defaults::ttl);
   if (adaptation && adaptation->disable_forwarding) {
@@ -153,6 +170,20 @@ core_actor_state::core_actor_state(caf::event_based_actor* self,
   } else {
     BROKER_INFO("enable forwarding on this peer (default)");
   }
+  // Tracing is process-wide. Hence, we only ever turn it on here and only the
+  // first endpoint that configures a buffer size gets to pick it.
+  if (auto size = caf::get_or(self->config(), "broker.trace.buffer-size",
+                              size_t{0});
+      size > 0) {
+    if (auto actual = set_trace_buffer_size(size); actual < size)
+      BROKER_WARNING("another endpoint already set the trace buffer size to"
+                     << actual);
+  }
+  if (caf::get_or(self->config(), "broker.trace.enabled", false))
+    enable_tracing(true);
+  // The initial filter stays active for the lifetime of the endpoint.
+  for (auto& x : filter->read())
+    ++subscription_counts[x];
   // Callback setup when running with a connector attached.
   if (conn) {
     auto on_peering = [this](endpoint_id remote_id, const network_info& addr,
@@ -177,12 +208,22 @@ core_actor_state::~core_actor_state() {
 // -- initialization and tear down ---------------------------------------------
 
 caf::behavior core_actor_state::make_behavior() {
-  // Create the central "bus" where everything flows through.
-  central_merge = flow_inputs.as_observable().merge().share();
+  // Create the central "bus" where everything flows through. With priority
+  // lanes, control traffic of the core and the stores bypasses all other
+  // inputs, and high items from publishers and peers bypass pending bulk items.
+  if (lanes.enabled) {
+    central_merge = make_priority_merge(
+                      priority_flow_inputs.as_observable().merge(),
+                      flow_inputs.as_observable().merge(), lanes)
+                      .share();
+  } else {
+    central_merge = flow_inputs.as_observable().merge().share();
+  }
   // Process control messages and add instrumentation for metrics.
   central_merge //
     .for_each([this](const node_message& msg) {
       auto sender = get_sender(msg);
+      trace(trace_event::merge, sender, get_packed_message(msg));
       // Update metrics.
       auto& metrics = metrics_for(get_type(msg));
       metrics.processed->inc();
@@ -194,18 +235,31 @@ caf::behavior core_actor_state::make_behavior() {
       switch (get_type(msg)) {
         default:
           break;
+        case packed_message_type::data:
+          if (latency)
+            latency->observe_publish_to_core(msg);
+          break;
         case packed_message_type::routing_update: {
+          auto i = peers.find(sender);
+          if (i == peers.end()) {
+            // Ignore. Probably a stale message after unpeering.
+            break;
+          }
+          if (get_routing_update_kind(get_topic(msg))
+              == routing_update_kind::resync) {
+            send_subscriptions(sender);
+            break;
+          }
           // Deserialize payload and update peer filter.
-          if (auto i = peers.find(sender); i != peers.end()) {
-            filter_type new_filter;
-            caf::binary_deserializer src{nullptr, get_payload(msg)};
-            if (src.apply(new_filter)) {
-              i->second->filter(std::move(new_filter));
-            } else {
+          switch (i->second->handle_routing_update(msg)) {
+            default:
+              break;
+            case routing_update_result::gap:
+              request_filter_resync(sender);
+              break;
+            case routing_update_result::malformed:
               BROKER_ERROR("received malformed routing update from" << sender);
-            }
-          } else {
-            // Ignore. Probably a stale message after unpeering.
+              break;
           }
           break;
         }
@@ -220,6 +274,16 @@ caf::behavior core_actor_state::make_behavior() {
         }
       }
     });
+  // Move the per-peer output stage to background workers if configured.
+  if (auto n = caf::get_or(self->config(), "broker.core.dispatch-shards",
+                           defaults::core::dispatch_shards);
+      n > 0)
+    init_dispatch_shards(n);
+  // Write messages to disk if configured.
+  if (auto dir = caf::get_or(self->config(), "broker.capture.directory",
+                             std::string{});
+      !dir.empty())
+    init_capture(dir);
   // Initialize data_outputs and command_outputs.
   data_outputs =
     central_merge
@@ -237,7 +301,10 @@ caf::behavior core_actor_state::make_behavior() {
       })
       // Deserialize payload and wrap it into an actual data message.
       .flat_map([this](const node_message& msg) {
-        return unpack<data_message>(get_packed_message(msg));
+        auto result = unpack<data_message>(get_packed_message(msg));
+        if (result && latency)
+          latency->observe_publish_to_delivery(msg);
+        return result;
       })
       // Convert this blueprint to a *hot* observable.
       .share();
@@ -258,9 +325,17 @@ caf::behavior core_actor_state::make_behavior() {
       .share();
   // Connect the unsafe inputs to the central merge point.
   flow_inputs.push(unsafe_inputs.as_observable());
+  if (lanes.enabled)
+    priority_flow_inputs.push(priority_inputs.as_observable());
   // Override the default exit handler to add logging.
   self->set_exit_handler([this](caf::exit_msg& msg) {
     if (msg.reason) {
+      auto is_source = [&msg](const caf::actor& hdl) {
+        return hdl.address() == msg.source;
+      };
+      if (std::any_of(dispatch_shards.begin(), dispatch_shards.end(),
+                      is_source))
+        BROKER_ERROR("a dispatch shard terminated unexpectedly:" << msg.reason);
       BROKER_DEBUG("shutting down after receiving an exit message with reason:"
                    << msg.reason);
       shutdown(shutdown_options{});
@@ -269,6 +344,7 @@ caf::behavior core_actor_state::make_behavior() {
   // Override the down handler to drop legacy subscribers.
   self->set_down_handler([this](caf::down_msg& msg) {
     if (auto i = legacy_subs.find(msg.source); i != legacy_subs.end()) {
+      // Note: disposing the flow also unsubscribes its topics.
       i->second.sub.dispose();
       legacy_subs.erase(i);
     }
@@ -311,6 +387,10 @@ caf::behavior core_actor_state::make_behavior() {
     [this](atom::unpeer, endpoint_id peer_id) { //
       unpeer(peer_id);
     },
+    // -- routing --------------------------------------------------------------
+    [this](atom::resync, endpoint_id peer_id) { //
+      request_filter_resync(peer_id);
+    },
     // -- non-native clients, e.g., via WebSocket API --------------------------
     [this](atom::attach_client, const network_info& addr,
            const std::string& type, filter_type& filter,
@@ -338,20 +418,28 @@ caf::behavior core_actor_state::make_behavior() {
     [this](atom::get_filter) { return filter->read(); },
     // -- publishing of messages without going through a publisher -------------
     [this](atom::publish, const data_message& msg) {
+      if (!admit_publish(msg))
+        return;
       ++published_via_async_msg;
-      dispatch(endpoint_id::nil(), pack(msg));
+      dispatch(endpoint_id::nil(), pack(msg), origin_of(msg));
     },
     [this](atom::publish, const data_message& msg, const endpoint_info& dst) {
+      if (!admit_publish(msg))
+        return;
       ++published_via_async_msg;
-      dispatch(dst.node, pack(msg));
+      dispatch(dst.node, pack(msg), origin_of(msg));
     },
     [this](atom::publish, const data_message& msg, endpoint_id dst) {
+      if (!admit_publish(msg))
+        return;
       ++published_via_async_msg;
-      dispatch(dst, pack(msg));
+      dispatch(dst, pack(msg), origin_of(msg));
     },
     [this](atom::publish, atom::local, const data_message& msg) {
+      if (!admit_publish(msg))
+        return;
       ++published_via_async_msg;
-      dispatch(id, pack(msg));
+      dispatch(id, pack(msg), origin_of(msg));
     },
     [this](atom::publish, const command_message& msg) {
       dispatch(endpoint_id::nil(), pack(msg));
@@ -363,6 +451,19 @@ caf::behavior core_actor_state::make_behavior() {
     [this](atom::publish, const command_message& msg, endpoint_id dst) {
       dispatch(dst, pack(msg));
     },
+    // -- publish limits -------------------------------------------------------
+    [this](atom::publish, atom::put, const topic& prefix, double rate,
+           uint64_t burst, uint64_t sample, bool drop) {
+      publish_limit limit{rate, burst, sample, drop};
+      BROKER_INFO("set publish limit for" << prefix << "to"
+                                          << to_string(limit));
+      publish_limits.set(prefix, limit,
+                         clock != nullptr ? clock->now() : now());
+    },
+    [this](atom::publish, atom::clear, const topic& prefix) {
+      BROKER_INFO("clear publish limit for" << prefix);
+      publish_limits.clear(prefix);
+    },
     // -- interface for subscribers --------------------------------------------
     [this](atom::subscribe, const filter_type& filter) {
       // Subscribe to topics without actually caring about the events. This
@@ -370,14 +471,19 @@ caf::behavior core_actor_state::make_behavior() {
       // we can forward them.
       subscribe(filter);
     },
+    [this](atom::unsubscribe, const filter_type& filter) {
+      // Drops subscriptions from `atom::subscribe` or from terminated flows.
+      unsubscribe(filter);
+    },
     [this](filter_type& filter, data_producer_res snk) {
       subscribe(filter);
+      auto fptr = std::make_shared<filter_type>(filter);
       data_outputs
         .filter([xs = std::move(filter)](const data_message& msg) {
           detail::prefix_matcher f;
           return f(xs, msg);
         })
-        .compose(local_subscriber_scope_adder())
+        .compose(local_subscriber_scope_adder(std::move(fptr)))
         .subscribe(std::move(snk));
     },
     [this](std::shared_ptr<filter_type> fptr, data_producer_res snk) {
@@ -387,26 +493,35 @@ caf::behavior core_actor_state::make_behavior() {
       // publishers should never write to it directly.
       subscribe(*fptr);
       data_outputs
-        .filter([fptr = std::move(fptr)](const data_message& msg) {
+        .filter([fptr](const data_message& msg) {
           detail::prefix_matcher f;
           return f(*fptr, msg);
         })
-        .compose(local_subscriber_scope_adder())
+        .compose(local_subscriber_scope_adder(fptr))
         .subscribe(std::move(snk));
     },
     [this](std::shared_ptr<filter_type>& fptr, topic& x, bool add,
            std::shared_ptr<std::promise<void>>& sync) {
-      // We assume that fptr belongs to a previously constructed flow.
+      // We assume that fptr belongs to a previously constructed flow. Ignore
+      // updates after the flow terminated, since nothing would ever retract
+      // the subscriptions for added topics.
+      if (local_subscriber_filters->count(fptr.get()) == 0) {
+        if (sync)
+          sync->set_value();
+        return;
+      }
       auto e = fptr->end();
       auto i = std::find(fptr->begin(), e, x);
       if (add) {
         if (i == e) {
-          fptr->emplace_back(std::move(x));
-          subscribe(*fptr);
+          fptr->emplace_back(x);
+          subscribe(filter_type{std::move(x)});
         }
       } else {
-        if (i != e)
+        if (i != e) {
           fptr->erase(i);
+          unsubscribe(filter_type{std::move(x)});
+        }
       }
       if (sync)
         sync->set_value();
@@ -417,11 +532,18 @@ caf::behavior core_actor_state::make_behavior() {
         self
           ->make_observable() //
           .from_resource(std::move(src))
+          // Drop messages that exceed a publish limit.
+          .filter([this](const data_message& msg) {
+            return admit_publish(msg);
+          })
           .do_on_next([this](const data_message&) {
             metrics_for(packed_message_type::data).buffered->inc();
           })
           .map([this](const data_message& msg) {
-            return make_node_message(id, endpoint_id::nil(), pack(msg));
+            auto packed = pack(msg);
+            trace(trace_event::publish, endpoint_id::nil(), packed);
+            return make_node_message(id, endpoint_id::nil(), std::move(packed),
+                                     origin_of(msg));
           })
           .compose(local_publisher_scope_adder())
           .compose(add_killswitch_t{});
@@ -463,16 +585,19 @@ caf::behavior core_actor_state::make_behavior() {
       auto addr = caf::actor_cast<caf::actor_addr>(sender_ptr);
       if (auto i = legacy_subs.find(addr); i != legacy_subs.end()) {
         if (filter.empty()) {
+          // Note: disposing the flow also unsubscribes its topics.
           i->second.sub.dispose();
           legacy_subs.erase(i);
         } else {
           subscribe(filter);
+          unsubscribe(*i->second.filter);
           *i->second.filter = filter;
         }
         return;
       }
       // Take selected messages out of the flow and send them via asynchronous
       // messages to the client.
+      subscribe(filter);
       auto fptr = std::make_shared<filter_type>(filter);
       auto hdl = caf::actor_cast<caf::actor>(sender_ptr);
       auto sub = data_outputs
@@ -480,7 +605,7 @@ caf::behavior core_actor_state::make_behavior() {
                      detail::prefix_matcher f;
                      return f(*fptr, item);
                    })
-                   .compose(local_subscriber_scope_adder())
+                   .compose(local_subscriber_scope_adder(fptr))
                    .for_each([this, hdl](const data_message& msg) {
                      self->send(hdl, msg);
                    });
@@ -531,6 +656,7 @@ void core_actor_state::shutdown(shutdown_options options) {
   shutdown_stores();
   // We no longer add new input flows.
   flow_inputs.close();
+  priority_flow_inputs.close();
   // Cancel all subscriptions to local publishers.
   for (auto& sub : subscriptions)
     sub.dispose();
@@ -579,6 +705,7 @@ void core_actor_state::finalize_shutdown() {
   peer_statuses->close();
   // Close all inputs.
   unsafe_inputs.close();
+  priority_inputs.close();
   // After this point, any remaining flow should stop and the actor terminate.
 }
 
@@ -603,7 +730,8 @@ void core_actor_state::emit(Info&& ep, EnumConstant code, const char* msg) {
   auto val = factory::make(code, std::forward<Info>(ep), msg);
   try {
     auto content = get_as<data>(val);
-    dispatch(id, pack(make_data_message(std::move(str), std::move(content))));
+    auto msg = make_data_message(std::move(str), std::move(content));
+    dispatch(id, pack(msg), origin_of(msg));
   } catch (std::exception&) {
     std::cerr << "*** failed to convert " << caf::deep_to_string(val)
               << " to data\n";
@@ -624,6 +752,13 @@ packed_message core_actor_state::pack(const T& msg) {
                              buf);
 }
 
+timestamp core_actor_state::origin_of(const data_message& msg) {
+  // Only take a timestamp if we collect latencies for the topic.
+  if (latency && latency->tracks(get_topic(msg)))
+    return broker::now();
+  return timestamp{};
+}
+
 template <class T>
 std::optional<T> core_actor_state::unpack(const packed_message& msg) {
   caf::binary_deserializer src{nullptr, get_payload(msg)};
@@ -734,6 +869,10 @@ table core_actor_state::status_snapshot() const {
   add("local-subscribers", local_subscriber_stats_snapshot());
   add("local-publishers", local_publisher_stats_snapshot());
   add("published-via-async-msg", published_via_async_msg);
+  if (latency)
+    add("latencies", latency->snapshot());
+  if (!publish_limits.empty())
+    add("publish-limits", publish_limits.snapshot());
   return result;
 }
 
@@ -871,36 +1010,36 @@ caf::error core_actor_state::init_new_peer(endpoint_id peer_id,
   // Hook into the central merge point for forwarding the data to the peer.
   auto filter_ptr = std::make_shared<filter_type>(filter);
   auto ptr = std::make_shared<peering>(addr, filter_ptr, id, peer_id);
-  auto in = ptr->setup(
-    self, std::move(in_res), std::move(out_res),
-    central_merge
-      // Select by subscription and sender/receiver fields.
-      .filter([this, pid = peer_id, filter_ptr](const node_message& msg) {
-        if (get_sender(msg) == pid)
-          return false;
-        if (disable_forwarding && get_sender(msg) != id)
-          return false;
-        auto f = detail::prefix_matcher{};
-        auto receiver = get_receiver(msg);
-        return receiver == pid || (!receiver && f(*filter_ptr, get_topic(msg)));
-      })
-      // Override the sender field. This makes sure the sender field
-      // always reflects the last hop. Since we only need this
-      // information to avoid forwarding loops, "sender" really just
-      // means "last hop" right now.
-      .map([this](const node_message& msg) {
-        if (get_sender(msg) == id) {
-          return msg;
-        } else {
-          using std::get;
-          auto cpy = msg;
-          get<0>(cpy.unshared()) = id;
-          return cpy;
-        }
-      })
-      .as_observable());
-  // Push messages received from the peer into the central merge point.
-  flow_inputs.push( //
+  caf::flow::observable<node_message> in;
+  caf::actor shard;
+  if (!dispatch_shards.empty()) {
+    // Let a dispatch shard select and forward the messages to the peer. The
+    // shard keeps its own copy of the peer filter.
+    auto index = next_dispatch_shard();
+    shard = dispatch_shards[index];
+    ++dispatch_shard_loads[index];
+    peer_shards.emplace(peer_id, index);
+    auto disposer = caf::make_counted<dispatch_shard_disposer>(shard, peer_id);
+    in = ptr->setup(self, std::move(in_res), disposer->as_disposable());
+  } else {
+    auto batching = write_batching::make(self->system(), peer_id);
+    auto peer_lanes = lanes.for_peer_writer(batching.max_size);
+    in = ptr->setup(
+      self, std::move(in_res), std::move(out_res),
+      central_merge
+        // Select by subscription and sender/receiver fields and override the
+        // sender field.
+        .compose(add_peer_selection_t{
+          peer_selection{id, peer_id, disable_forwarding, filter_ptr}})
+        // Group messages to reduce the number of writes to the socket.
+        .compose(add_write_batching_t{self, batching})
+        // Schedule control traffic ahead of bulk data if configured. This
+        // stage must come last, because the buffer to the transport is FIFO.
+        .compose(add_priority_lanes_t{peer_lanes})
+        .as_observable());
+  }
+  // Prepare the messages received from the peer for the central merge point.
+  auto input =
     in
       // Add instrumentation for metrics.
       .do_on_next([this](const node_message& msg) {
@@ -921,6 +1060,11 @@ caf::error core_actor_state::init_new_peer(endpoint_id peer_id,
         }
         // Clean up state our local state.
         peers.erase(peer_id);
+        if (auto i = peer_shards.find(peer_id); i != peer_shards.end()) {
+          --dispatch_shard_loads[i->second];
+          self->send(dispatch_shards[i->second], atom::unpeer_v, peer_id);
+          peer_shards.erase(i);
+        }
         // Trigger a reconnect if we have initiated the peering and did not
         // disconnect this peer as a result of unpeering from it.
         if (!ptr->removed() && !ptr->addr().address.empty()
@@ -933,14 +1077,36 @@ caf::error core_actor_state::init_new_peer(endpoint_id peer_id,
         }
         ptr = nullptr;
       })
-      .as_observable());
+      .as_observable();
   peers.emplace(peer_id, ptr);
-  // Notify clients that wait for this peering.
-  if (auto [first, last] = awaited_peers.equal_range(peer_id); first != last) {
-    for (auto i = first; i != last; ++i)
-      i->second.deliver(peer_id);
-    awaited_peers.erase(first, last);
+  auto start = [this, peer_id, input]() mutable {
+    // Push messages received from the peer into the central merge point.
+    flow_inputs.push(input);
+    // Announce the version of our filter. This also tells the peer that we
+    // accept delta updates.
+    send_subscriptions(peer_id);
+    // Notify clients that wait for this peering.
+    if (auto [first, last] = awaited_peers.equal_range(peer_id);
+        first != last) {
+      for (auto i = first; i != last; ++i)
+        i->second.deliver(peer_id);
+      awaited_peers.erase(first, last);
+    }
+  };
+  if (!shard) {
+    start();
+    return caf::none;
   }
+  // The shard only forwards messages to the peer that arrive at its input
+  // after registering the output. Hence, we connect the input of the peer and
+  // announce the peering only after the shard has processed our request. On
+  // error, the shard is gone and takes the core down with it, but we still
+  // connect the input to allow the peering to shut down properly.
+  self
+    ->request(shard, caf::infinite, atom::peer_v, peer_id, filter,
+              std::move(out_res), ptr->output_stats())
+    .then([start]() mutable { start(); },
+          [start](const caf::error&) mutable { start(); });
   return caf::none;
 }
 
@@ -957,11 +1123,23 @@ caf::error core_actor_state::init_new_peer(endpoint_id peer,
   // prefixed with 32 bit with the size.
   namespace cn = caf::net;
   // Note: structured bindings with values confuses clang-tidy's leak checker.
-  auto resources1 = caf::async::make_spsc_buffer_resource<node_message>();
+  // With priority lanes, we keep the buffer to the transport short. Otherwise,
+  // high items would wait behind all bulk items in this FIFO buffer. However,
+  // the buffer must hold a full write batch to avoid splitting batches.
+  auto write_batch_size = caf::get_or(self->config(),
+                                      "broker.peering.write-batch-size",
+                                      defaults::peering::write_batch_size);
+  auto resources1 =
+    lanes.enabled
+      ? caf::async::make_spsc_buffer_resource<node_message>(
+        lanes.for_peer_writer(write_batch_size).buffer_size, 1)
+      : caf::async::make_spsc_buffer_resource<node_message>();
   auto& [rd_1, wr_1] = resources1;
   auto resources2 = caf::async::make_spsc_buffer_resource<node_message>();
   auto& [rd_2, wr_2] = resources2;
-  if (auto err = ptr->run(self->system(), std::move(rd_1), std::move(wr_2))) {
+  auto io = peer_io_metrics::make(self->system(), peer);
+  if (auto err = ptr->run(self->system(), std::move(rd_1), std::move(wr_2),
+                          latency, io)) {
     BROKER_DEBUG("failed to run pending connection:" << err);
     return err;
   } else {
@@ -970,6 +1148,84 @@ caf::error core_actor_state::init_new_peer(endpoint_id peer,
   }
 }
 
+void core_actor_state::init_dispatch_shards(size_t num_shards) {
+  BROKER_TRACE(BROKER_ARG(num_shards));
+  BROKER_INFO("dispatch messages to peers via" << num_shards << "shards");
+  dispatch_shards.reserve(num_shards);
+  dispatch_shard_loads.resize(num_shards);
+  for (size_t index = 0; index < num_shards; ++index) {
+    // Note: structured bindings with values confuses clang-tidy's leak checker.
+    auto resources = caf::async::make_spsc_buffer_resource<node_message>();
+    auto& [con, prod] = resources;
+    central_merge.subscribe(prod);
+    auto hdl = self->system().spawn<dispatch_shard_actor>(
+      id, disable_forwarding, con, caf::actor_cast<caf::actor>(self));
+    // Shards only terminate on their own after we close their input. Hence,
+    // any error in a shard means that its peers no longer receive messages.
+    self->link_to(hdl);
+    dispatch_shards.emplace_back(std::move(hdl));
+  }
+}
+
+void core_actor_state::init_capture(const std::string& directory) {
+  BROKER_TRACE(BROKER_ARG(directory));
+  using string_list = std::vector<std::string>;
+  auto segment_size = caf::get_or(self->config(), "broker.capture.segment-size",
+                                  defaults::capture::segment_size);
+  auto writer = make_capture_writer(directory, segment_size);
+  if (!writer) {
+    BROKER_ERROR("unable to capture messages to" << directory);
+    return;
+  }
+  filter_type topics;
+  for (auto& str : caf::get_or(self->config(), "broker.capture.topics",
+                               string_list{}))
+    topics.emplace_back(str);
+  BROKER_INFO("capture messages to" << directory << "for topics" << topics);
+  auto buffer_size = caf::get_or(self->config(), "broker.capture.buffer-size",
+                                 defaults::capture::buffer_size);
+  auto dropped = metric_factory{self->system()}
+                   .core.capture_dropped_messages_instance();
+  auto backlog = std::make_shared<std::atomic<size_t>>(0);
+  // Note: structured bindings with values confuses clang-tidy's leak checker.
+  auto resources = caf::async::make_spsc_buffer_resource<capture_record>();
+  auto& [con, prod] = resources;
+  // The capture must not slow down the central merge point. Hence, we consume
+  // all messages right away and push them to a publisher that buffers them for
+  // the capture actor. Once `buffer_size` records are waiting, we drop
+  // messages instead of waiting for the disk.
+  using publisher_t = caf::flow::item_publisher<capture_record>;
+  auto out = std::make_shared<publisher_t>(self);
+  out->as_observable().subscribe(prod);
+  central_merge
+    .filter([topics = std::move(topics)](const node_message& msg) {
+      auto msg_type = get_type(msg);
+      if (msg_type != packed_message_type::data
+          && msg_type != packed_message_type::command)
+        return false;
+      detail::prefix_matcher f;
+      return topics.empty() || f(topics, get_topic(msg));
+    })
+    .do_finally([out] { out->close(); })
+    .for_each([out, backlog, buffer_size, dropped](const node_message& msg) {
+      if (backlog->load(std::memory_order_relaxed) >= buffer_size) {
+        dropped->inc();
+        return;
+      }
+      backlog->fetch_add(1, std::memory_order_relaxed);
+      // Take the timestamp here to make it independent of buffering delays.
+      out->push(capture_record{broker::now(), msg});
+    });
+  self->system().spawn<capture_actor, caf::detached>(std::move(writer), con,
+                                                     std::move(backlog));
+}
+
+size_t core_actor_state::next_dispatch_shard() const noexcept {
+  auto first = dispatch_shard_loads.begin();
+  auto i = std::min_element(first, dispatch_shard_loads.end());
+  return static_cast<size_t>(std::distance(first, i));
+}
+
 caf::error core_actor_state::init_new_client(const network_info& addr,
                                              const std::string& type,
                                              filter_type filter,
@@ -994,11 +1250,15 @@ caf::error core_actor_state::init_new_client(const network_info& addr,
   auto client_id = endpoint_id::random();
   // Emit status updates.
   client_added(client_id, addr, type);
+  // Only clients that receive data contribute to our subscriptions.
+  if (!out_res)
+    filter.clear();
+  subscribe(filter);
   // Hook into the central merge point for forwarding the data to the client.
   if (out_res) {
     auto sub = central_merge
                  // Select by subscription.
-                 .filter([this, filt = std::move(filter),
+                 .filter([this, filt = filter,
                           client_id](const node_message& msg) {
                    if (get_sender(msg) == client_id)
                      return false;
@@ -1019,15 +1279,24 @@ caf::error core_actor_state::init_new_client(const network_info& addr,
   auto [in, ks] = self->make_observable()
                     .from_resource(std::move(in_res))
                     // If the client closes this buffer, we assume a disconnect.
-                    .do_finally([this, client_id, addr, type] {
+                    .do_finally([this, client_id, addr, type,
+                                 filt = std::move(filter)] {
                       BROKER_DEBUG("client" << addr << "disconnected");
+                      unsubscribe(filt);
                       client_removed(client_id, addr, type);
                       metrics.web_socket_connections->dec();
                     })
+                    // Drop messages that exceed a publish limit.
+                    .filter([this](const data_message& msg) {
+                      return admit_publish(msg);
+                    })
                     .map([this, client_id](const data_message& msg) {
                       metrics_for(packed_message_type::data).buffered->inc();
+                      auto packed = pack(msg);
+                      trace(trace_event::publish, endpoint_id::nil(), packed);
                       return make_node_message(client_id, endpoint_id::nil(),
-                                               pack(msg));
+                                               std::move(packed),
+                                               origin_of(msg));
                     })
                     // Ignore any errors from the client.
                     .on_error_complete()
@@ -1041,23 +1310,71 @@ caf::error core_actor_state::init_new_client(const network_info& addr,
 
 void core_actor_state::subscribe(const filter_type& what) {
   BROKER_TRACE(BROKER_ARG(what));
-  auto changed = filter->update([this, &what](auto&, auto& xs) {
+  for (auto& x : what)
+    ++subscription_counts[x];
+  filter_type added;
+  filter_type removed;
+  lamport_timestamp version;
+  auto changed = filter->update([&](auto& ts, auto& xs) {
     auto not_internal = [](const topic& x) { return !is_internal(x); };
+    auto old_xs = xs;
     if (filter_extend(xs, what, not_internal)) {
+      filter_diff(old_xs, xs, added, removed);
+      version = ++ts;
       return true;
     } else {
       return false;
     }
   });
-  // Note: this member function is the only place we call `update`. Hence, we
-  // need not worry about the filter changing again concurrently.
+  // Note: `subscribe` and `unsubscribe` are the only places we call `update`.
+  // Hence, we need not worry about the filter changing again concurrently.
   if (changed) {
-    broadcast_subscriptions();
+    broadcast_subscriptions(version, added, removed);
   } else {
     BROKER_DEBUG("already subscribed to topics:" << what);
   }
 }
 
+void core_actor_state::unsubscribe(const filter_type& what) {
+  BROKER_TRACE(BROKER_ARG(what));
+  auto dropped = size_t{0};
+  for (auto& x : what) {
+    if (auto i = subscription_counts.find(x); i != subscription_counts.end()) {
+      if (--i->second == 0) {
+        subscription_counts.erase(i);
+        ++dropped;
+      }
+    } else {
+      BROKER_DEBUG("unsubscribe from unknown topic:" << x);
+    }
+  }
+  if (dropped == 0)
+    return;
+  // The filter only stores a minimal set of prefixes, i.e., a single entry may
+  // cover several topics in `subscription_counts`. Hence, we rebuild the filter
+  // from the remaining topics.
+  filter_type added;
+  filter_type removed;
+  lamport_timestamp version;
+  auto changed = filter->update([&](auto& ts, auto& xs) {
+    filter_type ys;
+    for (auto& kvp : subscription_counts)
+      if (!is_internal(kvp.first))
+        filter_extend(ys, kvp.first);
+    filter_diff(xs, ys, added, removed);
+    if (added.empty() && removed.empty())
+      return false;
+    xs.swap(ys);
+    version = ++ts;
+    return true;
+  });
+  if (changed) {
+    broadcast_subscriptions(version, added, removed);
+  } else {
+    BROKER_DEBUG("topics remain covered by other subscriptions:" << what);
+  }
+}
+
 // -- data store management --------------------------------------------------
 
 bool core_actor_state::has_remote_master(const std::string& name) const {
@@ -1112,7 +1429,7 @@ caf::result<caf::actor> core_actor_state::attach_master(const std::string& name,
                 return make_node_message(id, endpoint_id::nil(), pack(msg));
               })
               .as_observable();
-  flow_inputs.push(in);
+  flow_inputs_for(priority_lane::high).push(in);
   // Save the handle and monitor the new actor.
   masters.emplace(name, hdl);
   self->link_to(hdl);
@@ -1162,7 +1479,7 @@ core_actor_state::attach_clone(const std::string& name, double resync_interval,
                 return make_node_message(id, endpoint_id::nil(), pack(msg));
               })
               .as_observable();
-  flow_inputs.push(in);
+  flow_inputs_for(priority_lane::high).push(in);
   // Save the handle for later.
   clones.emplace(name, hdl);
   return hdl;
@@ -1172,38 +1489,110 @@ void core_actor_state::shutdown_stores() {
   BROKER_TRACE(BROKER_ARG2("masters.size()", masters.size())
                << BROKER_ARG2("clones.size()", clones.size()));
   // TODO: consider re-implementing graceful shutdown of the store actors
-  for (auto& kvp : masters)
+  filter_type store_topics;
+  for (auto& kvp : masters) {
     self->send_exit(kvp.second, caf::exit_reason::kill);
+    store_topics.emplace_back(kvp.first / topic::master_suffix());
+  }
   masters.clear();
-  for (auto& kvp : clones)
+  for (auto& kvp : clones) {
     self->send_exit(kvp.second, caf::exit_reason::kill);
+    store_topics.emplace_back(kvp.first / topic::clone_suffix());
+  }
   clones.clear();
+  unsubscribe(store_topics);
 }
 
 // -- dispatching of messages to peers regardless of subscriptions ------------
 
+bool core_actor_state::admit_publish(const data_message& msg) {
+  if (publish_limits.empty())
+    return true;
+  auto t = clock != nullptr ? clock->now() : now();
+  return publish_limits.admit(get_topic(msg), t);
+}
+
+caf::flow::item_publisher<node_message>&
+core_actor_state::inputs_for(const node_message& msg) {
+  if (lanes.enabled && lanes.classify(msg) == priority_lane::high)
+    return priority_inputs;
+  return unsafe_inputs;
+}
+
+caf::flow::item_publisher<caf::flow::observable<node_message>>&
+core_actor_state::flow_inputs_for(priority_lane lane) {
+  if (lanes.enabled && lane == priority_lane::high)
+    return priority_flow_inputs;
+  return flow_inputs;
+}
+
 void core_actor_state::dispatch(endpoint_id receiver,
-                                const packed_message& msg) {
+                                const packed_message& msg, timestamp origin) {
   metrics_for(get_type(msg)).buffered->inc();
-  unsafe_inputs.push(make_node_message(id, receiver, msg));
+  switch (get_type(msg)) {
+    case packed_message_type::data:
+    case packed_message_type::command:
+      trace(trace_event::publish, receiver, msg);
+      break;
+    default:
+      trace(trace_event::control, receiver, msg);
+  }
+  auto nmsg = make_node_message(id, receiver, msg, origin);
+  inputs_for(nmsg).push(nmsg);
 }
 
-void core_actor_state::broadcast_subscriptions() {
-  // Serialize the filter.
-  auto fs = filter->read();
-  buf.clear();
-  caf::binary_serializer sink{nullptr, buf};
-  [[maybe_unused]] auto ok = sink.apply(fs);
-  BROKER_ASSERT(ok);
-  // Pack and send to each peer.
-  auto first = reinterpret_cast<std::byte*>(buf.data());
-  auto last = first + buf.size();
-  auto packed = packed_message{packed_message_type::routing_update, ttl,
-                               topic{std::string{topic::reserved}},
-                               std::vector<std::byte>{first, last}};
-  metrics_for(packed_message_type::routing_update).buffered->inc();
-  for (auto& kvp : peers)
-    unsafe_inputs.push(node_message(id, kvp.first, packed));
+void core_actor_state::broadcast_subscriptions(lamport_timestamp version,
+                                               const filter_type& added,
+                                               const filter_type& removed) {
+  // Serialize the delta once and the full filter only if needed, i.e., if at
+  // least one peer does not accept delta updates.
+  auto delta = make_packed_message(
+    packed_message_type::routing_update, ttl,
+    routing_update_topic(routing_update_kind::delta),
+    make_delta_routing_update(version, added, removed));
+  std::optional<packed_message> full;
+  auto push = [this](node_message msg) { inputs_for(msg).push(msg); };
+  for (auto& kvp : peers) {
+    metrics_for(packed_message_type::routing_update).buffered->inc();
+    if (kvp.second->filter_state().versioned) {
+      push(make_node_message(id, kvp.first, delta));
+    } else {
+      if (!full)
+        full = make_full_routing_update();
+      push(make_node_message(id, kvp.first, *full));
+    }
+  }
+}
+
+void core_actor_state::send_subscriptions(endpoint_id peer_id) {
+  dispatch(peer_id, make_full_routing_update());
+}
+
+void core_actor_state::request_filter_resync(endpoint_id peer_id) {
+  auto i = peers.find(peer_id);
+  if (i == peers.end())
+    return;
+  // Ask the peer for its full filter, but only once until it responds. Until
+  // then, we drop all delta updates.
+  auto& st = i->second->filter_state();
+  if (st.resync_pending)
+    return;
+  BROKER_DEBUG("request filter resync from" << peer_id);
+  st.resync_pending = true;
+  auto kind = routing_update_kind::resync;
+  dispatch(peer_id,
+           make_packed_message(packed_message_type::routing_update, ttl,
+                               routing_update_topic(kind),
+                               std::vector<std::byte>{}));
+}
+
+packed_message core_actor_state::make_full_routing_update() {
+  auto bytes = filter->read([](auto& ts, auto& xs) {
+    return internal::make_full_routing_update(xs, ts);
+  });
+  return make_packed_message(packed_message_type::routing_update, ttl,
+                             routing_update_topic(routing_update_kind::full),
+                             std::move(bytes));
 }
 
 // -- unpeering ----------------------------------------------------------------
@@ -0,0 +1,137 @@
+#include "broker/internal/dispatch_shard.hh"
+
+#include "broker/internal/logger.hh"
+#include "broker/internal/peer_selection.hh"
+#include "broker/internal/type_id.hh"
+#include "broker/internal/write_batching.hh"
+
+#include <caf/scheduled_actor/flow.hpp>
+#include <caf/send.hpp>
+
+namespace broker::internal {
+
+// -- constructors and destructors ---------------------------------------------
+
+dispatch_shard_state::dispatch_shard_state(caf::event_based_actor* self,
+                                           endpoint_id this_peer,
+                                           bool disable_forwarding,
+                                           node_consumer_res input,
+                                           caf::actor core)
+  : self(self),
+    id(this_peer),
+    disable_forwarding(disable_forwarding),
+    core(caf::actor_cast<caf::weak_actor_ptr>(core)),
+    input_res(std::move(input)),
+    lanes(priority_lanes::make(self->system())) {
+  // nop
+}
+
+dispatch_shard_state::~dispatch_shard_state() {
+  BROKER_DEBUG("dispatch_shard_state destroyed");
+}
+
+// -- initialization -----------------------------------------------------------
+
+caf::behavior dispatch_shard_state::make_behavior() {
+  input = self->make_observable()
+            .from_resource(std::move(input_res))
+            // The core closes the buffer after shutting down. No more outputs
+            // after this point.
+            .do_finally([this] {
+              BROKER_DEBUG("input from the core closed, shut down shard");
+              outputs.clear();
+              self->quit();
+            })
+            .share();
+  // Keep the filters of our peers up to date. This subscriber comes first, so
+  // it sees a routing update before the outputs see the next message.
+  input.for_each([this](const node_message& msg) {
+    if (get_type(msg) == packed_message_type::routing_update)
+      handle_routing_update(msg);
+  });
+  return {
+    [this](atom::peer, endpoint_id peer_id, const filter_type& filter,
+           node_producer_res& out_res, flow_scope_stats_ptr& stats) {
+      add_peer(peer_id, filter, std::move(out_res), std::move(stats));
+    },
+    [this](atom::unpeer, endpoint_id peer_id) { //
+      remove_peer(peer_id);
+    },
+  };
+}
+
+// -- peer management ----------------------------------------------------------
+
+void dispatch_shard_state::add_peer(endpoint_id peer_id,
+                                    const filter_type& filter,
+                                    node_producer_res out_res,
+                                    flow_scope_stats_ptr stats) {
+  BROKER_TRACE(BROKER_ARG(peer_id) << BROKER_ARG(filter));
+  if (outputs.count(peer_id) != 0) {
+    BROKER_ERROR("shard received a repeated peer:" << peer_id);
+    return;
+  }
+  auto filter_ptr = std::make_shared<filter_type>(filter);
+  auto batching = write_batching::make(self->system(), peer_id);
+  auto& out = outputs[peer_id];
+  out.filter = filter_ptr;
+  // Note: this is the same pipeline that the core uses when dispatching to
+  //       peers directly. See core_actor_state::init_new_peer.
+  out.sub = input //
+              .compose(add_peer_selection_t{
+                peer_selection{id, peer_id, disable_forwarding, filter_ptr}})
+              .compose(add_write_batching_t{self, batching})
+              .compose(add_priority_lanes_t{
+                lanes.for_peer_writer(batching.max_size)})
+              .compose(add_flow_scope_t{std::move(stats)})
+              .subscribe(std::move(out_res));
+}
+
+void dispatch_shard_state::handle_routing_update(const node_message& msg) {
+  auto sender = get_sender(msg);
+  auto i = outputs.find(sender);
+  if (i == outputs.end()) {
+    // The peer belongs to another shard. The core only connects the input of
+    // a peer after its shard has registered the output, so the owner never
+    // misses an update.
+    return;
+  }
+  auto& out = i->second;
+  switch (apply_routing_update(get_topic(msg), get_payload(msg), *out.filter,
+                               out.filter_state)) {
+    default:
+      break;
+    case routing_update_result::gap:
+      // Only the core may send messages to the peer. Report the gap once and
+      // drop deltas until the full update arrives via our input.
+      if (!out.filter_state.resync_pending) {
+        BROKER_DEBUG("detected a gap in the routing updates of" << sender);
+        out.filter_state.resync_pending = true;
+        if (auto hdl = core.lock())
+          self->send(caf::actor_cast<caf::actor>(hdl), atom::resync_v, sender);
+      }
+      break;
+    case routing_update_result::malformed:
+      BROKER_ERROR("received malformed routing update from" << sender);
+      break;
+  }
+}
+
+void dispatch_shard_state::remove_peer(endpoint_id peer_id) {
+  BROKER_TRACE(BROKER_ARG(peer_id));
+  if (auto i = outputs.find(peer_id); i != outputs.end()) {
+    i->second.sub.dispose();
+    outputs.erase(i);
+  }
+}
+
+// -- dispatch_shard_disposer --------------------------------------------------
+
+void dispatch_shard_disposer::dispose() {
+  if (!disposed_) {
+    disposed_ = true;
+    caf::anon_send(shard_, atom::unpeer_v, peer_id_);
+  }
+}
+
+} // namespace broker::internal
@@ -0,0 +1,96 @@
+#include "broker/internal/latency_tracker.hh"
+
+#include "broker/internal/metric_factory.hh"
+
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/settings.hpp>
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace broker::internal {
+
+namespace {
+
+table to_table(const latency_tracker::histogram_type& hist) {
+  table buckets;
+  int64_t total = 0;
+  for (const auto& bucket : hist.buckets()) {
+    auto n = bucket.count.value();
+    total += n;
+    buckets.emplace(bucket.upper_bound, n);
+  }
+  table result;
+  result.emplace("count"s, total);
+  result.emplace("sum"s, hist.sum());
+  result.emplace("buckets"s, std::move(buckets));
+  return result;
+}
+
+} // namespace
+
+latency_tracker::latency_tracker(caf::telemetry::metric_registry& reg,
+                                 const std::vector<std::string>& prefixes) {
+  metric_factory factory{reg};
+  entries_.reserve(prefixes.size());
+  for (const auto& prefix : prefixes) {
+    auto& entry = entries_.emplace_back();
+    entry.prefix = prefix;
+    entry.publish_to_core =
+      factory.core.publish_to_core_latency_instance(prefix);
+    entry.core_to_peer_write =
+      factory.core.core_to_peer_write_latency_instance(prefix);
+    entry.publish_to_delivery =
+      factory.core.publish_to_delivery_latency_instance(prefix);
+  }
+}
+
+latency_tracker_ptr latency_tracker::make(caf::actor_system& sys) {
+  using string_list = std::vector<std::string>;
+  auto prefixes = caf::get_or(sys.config(), "broker.metrics.latency-prefixes",
+                              string_list{});
+  if (prefixes.empty())
+    return nullptr;
+  return std::make_shared<latency_tracker>(sys.metrics(), prefixes);
+}
+
+const latency_tracker::histograms*
+latency_tracker::find(const topic& t) const noexcept {
+  // Uses the same matching rules as subscription filters.
+  const histograms* result = nullptr;
+  for (const auto& entry : entries_) {
+    if (is_prefix(t, entry.prefix)
+        && (result == nullptr || entry.prefix.size() > result->prefix.size()))
+      result = &entry;
+  }
+  return result;
+}
+
+table latency_tracker::snapshot() const {
+  table result;
+  for (const auto& entry : entries_) {
+    table hists;
+    hists.emplace("publish-to-core"s, to_table(*entry.publish_to_core));
+    hists.emplace("core-to-peer-write"s, to_table(*entry.core_to_peer_write));
+    hists.emplace("publish-to-delivery"s,
+                  to_table(*entry.publish_to_delivery));
+    result.emplace(entry.prefix, std::move(hists));
+  }
+  return result;
+}
+
+void latency_tracker::observe(const node_message& msg,
+                              histogram_type* histograms::*member) const {
+  if (get_type(msg) != packed_message_type::data || !has_origin(msg))
+    return;
+  if (auto entry = find(get_topic(msg))) {
+    fractional_seconds secs;
+    convert(now() - get_origin(msg), secs);
+    // Clock skew between hosts may result in "negative" latencies.
+    (entry->*member)->observe(std::max(secs.count(), 0.0));
+  }
+}
+
+} // namespace broker::internal
@@ -0,0 +1,170 @@
+#include "broker/internal/mapped_file.hh"
+
+#include <utility>
+
+#include "broker/error.hh"
+#include "broker/internal/logger.hh"
+
+#ifdef BROKER_WINDOWS
+
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif // WIN32_LEAN_AND_MEAN
+
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif // NOMINMAX
+
+#  include <Windows.h>
+
+namespace {
+
+std::pair<HANDLE, bool> open_file(const char* fname) {
+  auto hdl = CreateFile(fname, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  return {hdl, hdl != INVALID_HANDLE_VALUE};
+}
+
+std::pair<size_t, bool> file_size(HANDLE fd) {
+  LARGE_INTEGER result;
+  if (!GetFileSizeEx(fd, &result))
+    return {0, false};
+  return {static_cast<size_t>(result.QuadPart), true};
+}
+
+void close_file(HANDLE fd) {
+  CloseHandle(fd);
+}
+
+void* memory_map_file(HANDLE fd, size_t) {
+  return CreateFileMapping(fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+}
+
+void* make_file_view(void* mapper, size_t file_size) {
+  return MapViewOfFile(mapper, FILE_MAP_READ, 0, 0, file_size);
+}
+
+void unmap_file(void* mapper, void* addr, size_t) {
+  UnmapViewOfFile(addr);
+  CloseHandle(mapper);
+}
+
+} // namespace
+
+#else // BROKER_WINDOWS
+
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+
+namespace {
+
+std::pair<int, bool> open_file(const char* fname) {
+  auto result = open(fname, O_RDONLY);
+  return {result, result != -1};
+}
+
+std::pair<size_t, bool> file_size(int fd) {
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    return {0, false};
+  }
+  return {static_cast<size_t>(sb.st_size), true};
+}
+
+void close_file(int fd) {
+  close(fd);
+}
+
+void* memory_map_file(int fd, size_t file_size) {
+  auto result = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  return result != MAP_FAILED ? result : nullptr;
+}
+
+void* make_file_view(void* addr, size_t) {
+  // On POSIX, mmap() returns the mapped region directly.
+  return addr;
+}
+
+void unmap_file(void*, void* addr, size_t file_size) {
+  munmap(addr, file_size);
+}
+
+} // namespace
+
+#endif // BROKER_WINDOWS
+
+namespace broker::internal {
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+  : fd_(other.fd_),
+    mapper_(other.mapper_),
+    addr_(other.addr_),
+    size_(other.size_) {
+  other.mapper_ = nullptr;
+  other.addr_ = nullptr;
+  other.size_ = 0;
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+  close();
+  fd_ = other.fd_;
+  mapper_ = std::exchange(other.mapper_, nullptr);
+  addr_ = std::exchange(other.addr_, nullptr);
+  size_ = std::exchange(other.size_, 0);
+  return *this;
+}
+
+mapped_file::~mapped_file() {
+  close();
+}
+
+caf::error mapped_file::open(const std::string& fname) {
+  close();
+  // Get a file handle for the file.
+  auto [fd, fd_ok] = open_file(fname.c_str());
+  if (!fd_ok) {
+    BROKER_ERROR("unable to open file:" << fname);
+    return caf::make_error(ec::cannot_open_file, fname);
+  }
+  // Read the file size. Mapping an empty file is an error on most platforms.
+  auto [fsize, fsize_ok] = file_size(fd);
+  if (!fsize_ok || fsize == 0) {
+    BROKER_ERROR("unable to read file size or file is empty:" << fname);
+    close_file(fd);
+    return caf::make_error(ec::cannot_open_file, fname);
+  }
+  // Memory map file.
+  auto mapper = memory_map_file(fd, fsize);
+  if (mapper == nullptr) {
+    BROKER_ERROR("unable to open file (mmap failed):" << fname);
+    close_file(fd);
+    return caf::make_error(ec::cannot_open_file, fname);
+  }
+  // Create a view into the mapped file.
+  auto addr = make_file_view(mapper, fsize);
+  if (addr == nullptr) {
+    BROKER_ERROR("unable to create view into the mapped file:" << fname);
+    unmap_file(mapper, nullptr, fsize);
+    close_file(fd);
+    return caf::make_error(ec::cannot_open_file, fname);
+  }
+  fd_ = fd;
+  mapper_ = mapper;
+  addr_ = addr;
+  size_ = fsize;
+  return caf::none;
+}
+
+void mapped_file::close() noexcept {
+  if (addr_ == nullptr)
+    return;
+  unmap_file(mapper_, addr_, size_);
+  close_file(fd_);
+  mapper_ = nullptr;
+  addr_ = nullptr;
+  size_ = 0;
+}
+
+} // namespace broker::internal
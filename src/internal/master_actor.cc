@@ -17,6 +17,7 @@
 #include "broker/detail/die.hh"
 #include "broker/internal/master_actor.hh"
 #include "broker/internal/metric_factory.hh"
+#include "broker/internal/trace.hh"
 #include "broker/store.hh"
 #include "broker/time.hh"
 #include "broker/topic.hh"
@@ -63,11 +64,14 @@ master_state::master_state(
   super::init(output);
   clones_topic = store_name / topic::clone_suffix();
   backend = std::move(bp);
-  if (auto es = backend->expiries()) {
-    for (auto& [key, expire_time] : *es)
-      expirations.emplace(key, expire_time);
-  } else {
-    detail::die("failed to get master expiries while initializing");
+  // Backends with an expiry index select due entries on their own.
+  if (!backend->has_expiry_index()) {
+    if (auto es = backend->expiries()) {
+      for (auto& [key, expire_time] : *es)
+        expirations.emplace(key, expire_time);
+    } else {
+      detail::die("failed to get master expiries while initializing");
+    }
   }
   if (auto entries = backend->size(); entries && *entries > 0) {
     metrics.entries->value(static_cast<int64_t>(*entries));
@@ -175,6 +179,9 @@ void master_state::tick() {
   for (auto& kvp : inputs)
     kvp.second.tick();
   auto t = clock->now();
+  if (backend->has_expiry_index()) {
+    expire_due(t);
+  }
   for (auto i = expirations.begin(); i != expirations.end();) {
     if (t > i->second) {
       const auto& key = i->first;
@@ -195,10 +202,32 @@ void master_state::tick() {
       ++i;
     }
   }
+  if (auto result = backend->flush(); !result)
+    BROKER_ERROR("FLUSH FAILED" << to_string(result.error()));
+}
+
+void master_state::expire_due(timestamp t) {
+  auto limit = defaults::store::max_expirations_per_tick;
+  auto keys = backend->expire_due(t, limit);
+  if (!keys) {
+    BROKER_ERROR("EXPIRE DUE (FAILED)" << to_string(keys.error()));
+    return;
+  }
+  for (auto& key : *keys) {
+    BROKER_INFO("EXPIRE" << key);
+    expire_command cmd{std::move(key), id};
+    emit_expire_event(cmd);
+    broadcast(std::move(cmd));
+    metrics.entries->dec();
+  }
+  if (keys->size() == limit)
+    BROKER_DEBUG("reached the expiration limit, continue on next tick");
 }
 
 void master_state::set_expire_time(const data& key,
                                    const std::optional<timespan>& expiry) {
+  if (backend->has_expiry_index())
+    return;
   if (expiry)
     expirations.insert_or_assign(key, clock->now() + *expiry);
   else
@@ -208,6 +237,9 @@ void master_state::set_expire_time(const data& key,
 // -- callbacks for the consumer -----------------------------------------------
 
 void master_state::consume(consumer_type*, command_message& msg) {
+  const auto& inner = get_command(msg);
+  trace(trace_event::store_apply, inner.sender.endpoint, get_topic(msg),
+        inner.content.index());
   auto f = [this](auto& cmd) { consume(cmd); };
   std::visit(f, get<1>(msg.unshared()).content);
 }
@@ -553,6 +585,51 @@ caf::behavior master_state::make_behavior() {
       else
         return caf::make_message(native(x.error()), id);
     },
+    [this](atom::get, atom::scan, const data& first, const data& last,
+           count limit) -> caf::result<data> {
+      auto x = backend->scan(first, last, limit);
+      BROKER_INFO("SCAN" << first << last << limit << "->" << x);
+      return to_caf_res(std::move(x));
+    },
+    [this](atom::get, atom::scan, const data& first, const data& last,
+           count limit, request_id id) {
+      auto x = backend->scan(first, last, limit);
+      BROKER_INFO("SCAN" << first << last << limit << "with id:" << id << "->"
+                         << x);
+      if (x)
+        return caf::make_message(std::move(*x), id);
+      else
+        return caf::make_message(native(x.error()), id);
+    },
+    [this](atom::get, atom::containing,
+           const address& addr) -> caf::result<data> {
+      auto x = backend->lookup_containing(addr);
+      BROKER_INFO("LOOKUP_CONTAINING" << addr << "->" << x);
+      return to_caf_res(std::move(x));
+    },
+    [this](atom::get, atom::containing, const address& addr, request_id id) {
+      auto x = backend->lookup_containing(addr);
+      BROKER_INFO("LOOKUP_CONTAINING" << addr << "with id:" << id << "->"
+                                      << x);
+      if (x)
+        return caf::make_message(std::move(*x), id);
+      else
+        return caf::make_message(native(x.error()), id);
+    },
+    [this](atom::get, atom::covered_by,
+           const subnet& net) -> caf::result<data> {
+      auto x = backend->covered_by(net);
+      BROKER_INFO("COVERED_BY" << net << "->" << x);
+      return to_caf_res(std::move(x));
+    },
+    [this](atom::get, atom::covered_by, const subnet& net, request_id id) {
+      auto x = backend->covered_by(net);
+      BROKER_INFO("COVERED_BY" << net << "with id:" << id << "->" << x);
+      if (x)
+        return caf::make_message(std::move(*x), id);
+      else
+        return caf::make_message(native(x.error()), id);
+    },
     [this](atom::exists, const data& key) -> caf::result<data> {
       auto x = backend->exists(key);
       BROKER_INFO("EXISTS" << key << "->" << x);
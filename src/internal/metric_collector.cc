@@ -21,11 +21,16 @@ public:
 
   using super::super;
 
-  void update(metric_view mv) override {
+  bool update(metric_view mv) override {
     if (mv.type() == type_tag) {
-      value_ = get<T>(mv.value());
+      auto new_value = get<T>(mv.value());
+      if (value_ == new_value)
+        return false;
+      value_ = new_value;
+      return true;
     } else {
       BROKER_ERROR("conflicting remote metric update received!");
+      return false;
     }
   }
 
@@ -48,11 +53,16 @@ public:
 
   using super::super;
 
-  void update(metric_view mv) override {
+  bool update(metric_view mv) override {
     if (mv.type() == type_tag) {
-      value_ = get<T>(mv.value());
+      auto new_value = get<T>(mv.value());
+      if (value_ == new_value)
+        return false;
+      value_ = new_value;
+      return true;
     } else {
       BROKER_ERROR("conflicting remote metric update received!");
+      return false;
     }
   }
 
@@ -77,18 +87,23 @@ public:
 
   using native_bucket = typename ct::histogram<T>::bucket_type;
 
-  void update(metric_view mv) override {
+  bool update(metric_view mv) override {
     if (mv.type() == type_tag) {
       auto& vals = get<vector>(mv.value());
       BROKER_ASSERT(vals.size() >= 2);
+      auto new_sum = get<T>(vals.back());
+      if (!buckets_.empty() && sum_ == new_sum && unchanged_buckets(vals))
+        return false;
       buckets_.clear();
       std::for_each(vals.begin(), vals.end() - 1, [this](const auto& kvp_data) {
         auto& kvp = get<vector>(kvp_data);
         buckets_.emplace_back(get<T>(kvp[0]), get<integer>(kvp[1]));
       });
-      sum_ = get<T>(vals.back());
+      sum_ = new_sum;
+      return true;
     } else {
       BROKER_ERROR("conflicting remote metric update received!");
+      return false;
     }
   }
 
@@ -109,6 +124,18 @@ public:
   }
 
 private:
+  bool unchanged_buckets(const vector& vals) const {
+    if (vals.size() != buckets_.size() + 1)
+      return false;
+    for (size_t index = 0; index < buckets_.size(); ++index) {
+      auto& kvp = get<vector>(vals[index]);
+      if (buckets_[index].first != get<T>(kvp[0])
+          || buckets_[index].second != get<integer>(kvp[1]))
+        return false;
+    }
+    return true;
+  }
+
   std::vector<std::pair<T, int64_t>> buckets_;
   T sum_ = 0;
 };
@@ -147,16 +174,30 @@ size_t metric_collector::insert_or_update(const data& content) {
 }
 
 size_t metric_collector::insert_or_update(const vector& vec) {
+  // The meta data row either contains only the endpoint name plus timestamp
+  // or, with delta encoding, also a sequence number plus a flag for full
+  // updates.
   auto has_meta_data = [](const data& x) {
-    if (auto meta = get_if<vector>(x); meta && meta->size() == 2)
-      return is<std::string>((*meta)[0]) && is<timestamp>((*meta)[1]);
-    else
-      return false;
+    if (auto meta = get_if<vector>(x)) {
+      if (meta->size() == 2)
+        return is<std::string>((*meta)[0]) && is<timestamp>((*meta)[1]);
+      if (meta->size() == 4)
+        return is<std::string>((*meta)[0]) && is<timestamp>((*meta)[1])
+               && is<count>((*meta)[2]) && is<boolean>((*meta)[3]);
+    }
+    return false;
   };
   if (vec.size() >= 2 && has_meta_data(vec[0])) {
     auto& meta = get<vector>(vec[0]);
     auto& endpoint_name = get<std::string>(meta[0]);
     auto& ts = get<timestamp>(meta[1]);
+    // Check the timestamp first to make sure that stale updates leave the
+    // sequence numbers untouched.
+    if (meta.size() == 4
+        && (is_stale(endpoint_name, ts)
+            || !advance_sequence(endpoint_name, get<count>(meta[2]),
+                                 get<boolean>(meta[3]))))
+      return 0;
     return insert_or_update(endpoint_name, ts,
                             caf::make_span(vec.data() + 1, vec.size() - 1));
   } else {
@@ -171,31 +212,43 @@ size_t metric_collector::insert_or_update(const std::string& endpoint_name,
   auto res = size_t{0};
   if (advance_time(endpoint_name, ts))
     for (const auto& row_data : rows)
-      if (auto mv = metric_view{row_data})
-        if (auto ptr = instance(endpoint_name, mv)) {
-          ptr->update(mv);
+      if (auto mv = metric_view{row_data}) {
+        auto& scope = scope_for(mv);
+        if (auto ptr = instance(scope, endpoint_name, mv)) {
+          if (ptr->update(mv))
+            scope.dirty = true;
           ++res;
         }
+      }
   return res;
 }
 
 std::string_view metric_collector::prometheus_text() {
-  if (generator_.begin_scrape()) {
-    for (auto& [prefix, names] : prefixes_)
-      for (auto& [name, scope] : names)
+  // Only re-render families with changed instances and then stitch together
+  // the cached output of all families. Re-using the buffer from the last call
+  // avoids re-allocating the output for each call.
+  text_.clear();
+  for (auto& [prefix, names] : prefixes_) {
+    for (auto& [name, scope] : names) {
+      if (scope.dirty && scope.generator.begin_scrape()) {
         for (auto& instance : scope.instances)
-          instance->append_to(generator_);
-    generator_.end_scrape();
+          instance->append_to(scope.generator);
+        scope.generator.end_scrape();
+        scope.dirty = false;
+      }
+      auto str = scope.generator.str();
+      text_.append(str.data(), str.size());
+    }
   }
-  auto res = generator_.str();
-  return {res.data(), res.size()};
+  return text_;
 }
 
 void metric_collector::clear() {
   label_names_.clear();
   prefixes_.clear();
   last_seen_.clear();
-  generator_.reset();
+  next_seq_.clear();
+  text_.clear();
 }
 
 // -- time management ----------------------------------------------------------
@@ -213,6 +266,35 @@ bool metric_collector::advance_time(const std::string& endpoint_name,
   }
 }
 
+bool metric_collector::is_stale(const std::string& endpoint_name,
+                                timestamp ts) const {
+  auto i = last_seen_.find(endpoint_name);
+  return i != last_seen_.end() && ts <= i->second;
+}
+
+bool metric_collector::advance_sequence(const std::string& endpoint_name,
+                                        uint64_t seq, bool full) {
+  if (full) {
+    next_seq_[endpoint_name] = seq + 1;
+    return true;
+  }
+  auto i = next_seq_.find(endpoint_name);
+  if (i == next_seq_.end())
+    return false;
+  if (seq == i->second) {
+    ++i->second;
+    return true;
+  }
+  // Silently drop duplicates and treat everything else as a gap.
+  if (seq > i->second) {
+    BROKER_DEBUG("detected a gap in the metrics of" << endpoint_name
+                 << "-> wait for the next full update");
+    next_seq_.erase(i);
+    ++gaps_;
+  }
+  return false;
+}
+
 // -- lookups ----------------------------------------------------------------
 
 void metric_collector::labels_for(const std::string& endpoint_name,
@@ -274,8 +356,7 @@ constexpr metric_collector::labels_equal labels_equal_v{};
 
 } // namespace
 
-metric_collector::remote_metric*
-metric_collector::instance(const std::string& endpoint_name, metric_view mv) {
+metric_collector::metric_scope& metric_collector::scope_for(metric_view mv) {
   auto& names = prefixes_[mv.prefix()];
   auto& scope = names[mv.name()];
   if (scope.family == nullptr) {
@@ -284,12 +365,19 @@ metric_collector::instance(const std::string& endpoint_name, metric_view mv) {
                                      mv.unit(), mv.is_sum());
     scope.family.reset(ptr);
   }
+  return scope;
+}
+
+metric_collector::remote_metric*
+metric_collector::instance(metric_scope& scope,
+                           const std::string& endpoint_name, metric_view mv) {
   auto* fptr = scope.family.get();
   labels_for(endpoint_name, mv, labels_);
   auto i = scope.instances.lower_bound(labels_);
   if (i != scope.instances.end() && labels_equal_v(*i, labels_))
     return i->get();
   auto add = [&](auto* ptr) {
+    scope.dirty = true;
     auto j = scope.instances.insert(i, instance_ptr{ptr});
     BROKER_ASSERT(j->get() == ptr);
     return ptr;
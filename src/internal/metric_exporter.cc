@@ -28,6 +28,8 @@ metric_exporter_params::from(const caf::actor_system_config& cfg) {
                                   defaults::metrics::export_interval);
     if (result.interval.count() == 0)
       result.interval = defaults::metrics::export_interval;
+    result.full_interval = caf::get_or(*dict, "full-interval",
+                                       caf::timespan{0});
   }
   return result;
 }
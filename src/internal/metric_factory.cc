@@ -1,6 +1,7 @@
 #include "broker/internal/metric_factory.hh"
 
 #include <caf/actor_system.hpp>
+#include <caf/span.hpp>
 
 namespace broker::internal {
 
@@ -79,6 +80,206 @@ core_t::buffered_messages_t core_t::buffered_messages_instances() {
   };
 }
 
+int_counter_family* core_t::peer_writes_family() {
+  return reg_->counter_family("broker", "peer-writes", {"endpoint"},
+                              "Number of write operations on the socket of a "
+                              "peer.",
+                              "1", true);
+}
+
+int_counter* core_t::peer_writes_instance(std::string_view peer) {
+  return peer_writes_family()->get_or_add({{"endpoint", peer}});
+}
+
+int_counter_family* core_t::peer_written_messages_family() {
+  return reg_->counter_family("broker", "peer-written-messages", {"endpoint"},
+                              "Number of messages written to a peer.", "1",
+                              true);
+}
+
+int_counter* core_t::peer_written_messages_instance(std::string_view peer) {
+  return peer_written_messages_family()->get_or_add({{"endpoint", peer}});
+}
+
+int_counter_family* core_t::peer_reads_family() {
+  return reg_->counter_family("broker", "peer-reads", {"endpoint"},
+                              "Number of read operations on the socket of a "
+                              "peer.",
+                              "1", true);
+}
+
+int_counter* core_t::peer_reads_instance(std::string_view peer) {
+  return peer_reads_family()->get_or_add({{"endpoint", peer}});
+}
+
+int_counter_family* core_t::peer_read_messages_family() {
+  return reg_->counter_family("broker", "peer-read-messages", {"endpoint"},
+                              "Number of messages read from a peer.", "1",
+                              true);
+}
+
+int_counter* core_t::peer_read_messages_instance(std::string_view peer) {
+  return peer_read_messages_family()->get_or_add({{"endpoint", peer}});
+}
+
+int_gauge_family* core_t::priority_lane_queued_messages_family() {
+  return reg_->gauge_family("broker", "priority-lane-queued-messages", {"lane"},
+                            "Number of messages waiting in priority stages.");
+}
+
+core_t::priority_lane_queued_messages_t
+core_t::priority_lane_queued_messages_instances() {
+  auto fm = priority_lane_queued_messages_family();
+  return {
+    fm->get_or_add({{"lane", "high"}}),
+    fm->get_or_add({{"lane", "bulk"}}),
+  };
+}
+
+int_counter_family* core_t::priority_lane_processed_messages_family() {
+  return reg_->counter_family(
+    "broker", "priority-lane-processed-messages", {"lane"},
+    "Total number of messages that passed through priority stages.", "1",
+    true);
+}
+
+core_t::priority_lane_processed_messages_t
+core_t::priority_lane_processed_messages_instances() {
+  auto fm = priority_lane_processed_messages_family();
+  return {
+    fm->get_or_add({{"lane", "high"}}),
+    fm->get_or_add({{"lane", "bulk"}}),
+  };
+}
+
+int_counter_family* core_t::publish_limit_accepted_messages_family() {
+  return reg_->counter_family(
+    "broker", "publish-limit-accepted-messages", {"prefix"},
+    "Number of published messages that passed a publish limit.", "1", true);
+}
+
+int_counter*
+core_t::publish_limit_accepted_messages_instance(std::string_view prefix) {
+  return publish_limit_accepted_messages_family()->get_or_add(
+    {{"prefix", prefix}});
+}
+
+int_counter_family* core_t::publish_limit_dropped_messages_family() {
+  return reg_->counter_family(
+    "broker", "publish-limit-dropped-messages", {"prefix", "reason"},
+    "Number of published messages dropped by a publish limit.", "1", true);
+}
+
+core_t::publish_limit_dropped_messages_t
+core_t::publish_limit_dropped_messages_instances(std::string_view prefix) {
+  auto fm = publish_limit_dropped_messages_family();
+  return {
+    fm->get_or_add({{"prefix", prefix}, {"reason", "rate"}}),
+    fm->get_or_add({{"prefix", prefix}, {"reason", "sample"}}),
+    fm->get_or_add({{"prefix", prefix}, {"reason", "drop"}}),
+  };
+}
+
+dbl_gauge_family* core_t::publish_limit_rate_family() {
+  return reg_->gauge_family<double>(
+    "broker", "publish-limit-rate", {"prefix"},
+    "Configured maximum rate of a publish limit (0 = unlimited).", "1");
+}
+
+dbl_gauge* core_t::publish_limit_rate_instance(std::string_view prefix) {
+  return publish_limit_rate_family()->get_or_add({{"prefix", prefix}});
+}
+
+namespace {
+
+// Upper bounds for the latency histograms in seconds.
+constexpr double latency_buckets[] = {0.0001, 0.0005, 0.001, 0.005, 0.01,
+                                      0.05,   0.1,    0.5,   1.0,   5.0};
+
+} // namespace
+
+dbl_histogram_family* core_t::publish_to_core_latency_family() {
+  return reg_->histogram_family<double>(
+    "broker", "publish-to-core-latency", {"prefix"},
+    caf::make_span(latency_buckets),
+    "Time between publishing a message and its arrival at a remote core.",
+    "seconds");
+}
+
+dbl_histogram*
+core_t::publish_to_core_latency_instance(std::string_view prefix) {
+  return publish_to_core_latency_family()->get_or_add({{"prefix", prefix}});
+}
+
+dbl_histogram_family* core_t::core_to_peer_write_latency_family() {
+  return reg_->histogram_family<double>(
+    "broker", "core-to-peer-write-latency", {"prefix"},
+    caf::make_span(latency_buckets),
+    "Time between publishing a message and writing it to a peer.", "seconds");
+}
+
+dbl_histogram*
+core_t::core_to_peer_write_latency_instance(std::string_view prefix) {
+  return core_to_peer_write_latency_family()->get_or_add({{"prefix", prefix}});
+}
+
+dbl_histogram_family* core_t::publish_to_delivery_latency_family() {
+  return reg_->histogram_family<double>(
+    "broker", "publish-to-delivery-latency", {"prefix"},
+    caf::make_span(latency_buckets),
+    "Time between publishing a message and delivering it to subscribers.",
+    "seconds");
+}
+
+dbl_histogram*
+core_t::publish_to_delivery_latency_instance(std::string_view prefix) {
+  return publish_to_delivery_latency_family()->get_or_add({{"prefix", prefix}});
+}
+
+int_counter_family* core_t::tls_handshakes_family() {
+  return reg_->counter_family("broker", "tls-handshakes", {"type"},
+                              "Total number of TLS handshakes with peers.", "1",
+                              true);
+}
+
+core_t::tls_handshakes_t core_t::tls_handshakes_instances() {
+  auto fm = tls_handshakes_family();
+  return {
+    fm->get_or_add({{"type", "full"}}),
+    fm->get_or_add({{"type", "resumed"}}),
+  };
+}
+
+namespace {
+
+constexpr double tls_handshake_buckets[] = {0.0005, 0.001, 0.0025, 0.005,
+                                            0.01,   0.025, 0.05,   0.1,
+                                            0.25,   0.5,   1.0};
+
+} // namespace
+
+dbl_histogram_family* core_t::tls_handshake_duration_family() {
+  return reg_->histogram_family<double>(
+    "broker", "tls-handshake-duration", {"type"},
+    caf::make_span(tls_handshake_buckets),
+    "Time for completing TLS handshakes with peers.", "seconds");
+}
+
+core_t::tls_handshake_duration_t core_t::tls_handshake_duration_instances() {
+  auto fm = tls_handshake_duration_family();
+  return {
+    fm->get_or_add({{"type", "full"}}),
+    fm->get_or_add({{"type", "resumed"}}),
+  };
+}
+
+int_counter* core_t::capture_dropped_messages_instance() {
+  return reg_->counter_singleton("broker", "capture-dropped-messages",
+                                 "Number of messages dropped by the capture "
+                                 "because its buffer was full.",
+                                 "1", true);
+}
+
 // -- store metrics ------------------------------------------------------------
 
 using store_t = metric_factory::store_t;
@@ -139,6 +340,28 @@ int_gauge* store_t::unacknowledged_updates_instance(std::string_view name) {
   return unacknowledged_updates_family()->get_or_add({{"name", name}});
 }
 
+int_counter_family* store_t::combiner_inputs_family() {
+  return reg_->counter_family(
+    "broker", "store-combiner-inputs", {"name"},
+    "Number of writes that entered the combining window of a clone.", "1",
+    true);
+}
+
+int_counter* store_t::combiner_inputs_instance(std::string_view name) {
+  return combiner_inputs_family()->get_or_add({{"name", name}});
+}
+
+int_counter_family* store_t::combiner_outputs_family() {
+  return reg_->counter_family(
+    "broker", "store-combiner-outputs", {"name"},
+    "Number of commands that a clone forwarded after combining writes.", "1",
+    true);
+}
+
+int_counter* store_t::combiner_outputs_instance(std::string_view name) {
+  return combiner_outputs_family()->get_or_add({{"name", name}});
+}
+
 // --- constructors ------------------------------------------------------------
 
 metric_factory::metric_factory(caf::actor_system& sys) noexcept
@@ -74,23 +74,53 @@ bool metric_scraper::selected(const ct::metric_family* family) {
 }
 
 void metric_scraper::scrape(caf::telemetry::metric_registry& registry) {
+  scrape(registry, true);
+}
+
+void metric_scraper::scrape_changes(caf::telemetry::metric_registry& registry) {
+  scrape(registry, !delta_encoding_);
+}
+
+void metric_scraper::scrape(caf::telemetry::metric_registry& registry,
+                            bool full) {
   last_scrape_ = now();
-  if (!rows_.empty()) {
+  full_ = full;
+  if (rows_.empty())
+    rows_.emplace_back(vector{});
+  else
     rows_.resize(1);
-    BROKER_ASSERT(is<vector>(rows_[0]));
-    auto& meta = get<vector>(rows_[0]);
-    BROKER_ASSERT(meta.size() == 2);
-    BROKER_ASSERT(is<std::string>(meta[0]));
-    BROKER_ASSERT(is<timestamp>(meta[1]));
-    get<timestamp>(meta[1]) = last_scrape_;
-  } else {
-    vector meta;
-    meta.emplace_back(id_);
-    meta.emplace_back(last_scrape_);
-    rows_.emplace_back(std::move(meta));
+  BROKER_ASSERT(is<vector>(rows_[0]));
+  auto& meta = get<vector>(rows_[0]);
+  meta.clear();
+  meta.emplace_back(id_);
+  meta.emplace_back(last_scrape_);
+  if (delta_encoding_) {
+    meta.emplace_back(count{0});
+    meta.emplace_back(full_);
   }
   BROKER_ASSERT(rows_.size() == 1);
   registry.collect(*this);
+  // Only assign sequence numbers to scrapes that an exporter actually
+  // publishes. Otherwise, receivers would see gaps in the sequence.
+  if (delta_encoding_ && rows_.size() > 1)
+    get<count>(get<vector>(rows_[0])[2]) = seq_++;
+}
+
+void metric_scraper::delta_encoding(bool value) {
+  delta_encoding_ = value;
+  last_values_.clear();
+}
+
+bool metric_scraper::changed(const ct::metric* instance, const data& value) {
+  if (!delta_encoding_)
+    return true;
+  auto [i, added] = last_values_.emplace(instance, value);
+  if (added)
+    return true;
+  if (i->second == value)
+    return full_;
+  i->second = value;
+  return true;
 }
 
 void metric_scraper::id(std::string new_id) {
@@ -101,45 +131,51 @@ void metric_scraper::id(std::string new_id) {
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::dbl_counter* counter) {
-  if (selected(family))
-    add_row(family, "counter", to_table(instance->labels()), counter->value());
+  if (data value{counter->value()};
+      selected(family) && changed(instance, value))
+    add_row(family, "counter", to_table(instance->labels()), std::move(value));
 }
 
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::int_counter* counter) {
-  if (selected(family))
-    add_row(family, "counter", to_table(instance->labels()), counter->value());
+  if (data value{counter->value()};
+      selected(family) && changed(instance, value))
+    add_row(family, "counter", to_table(instance->labels()), std::move(value));
 }
 
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::dbl_gauge* gauge) {
-  if (selected(family))
-    add_row(family, "gauge", to_table(instance->labels()), gauge->value());
+  if (data value{gauge->value()}; selected(family) && changed(instance, value))
+    add_row(family, "gauge", to_table(instance->labels()), std::move(value));
 }
 
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::int_gauge* gauge) {
-  if (selected(family))
-    add_row(family, "gauge", to_table(instance->labels()), gauge->value());
+  if (data value{gauge->value()}; selected(family) && changed(instance, value))
+    add_row(family, "gauge", to_table(instance->labels()), std::move(value));
 }
 
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::dbl_histogram* histogram) {
-  if (selected(family))
+  if (!selected(family))
+    return;
+  if (data value{pack_histogram(histogram)}; changed(instance, value))
     add_row(family, "histogram", to_table(instance->labels()),
-            pack_histogram(histogram));
+            std::move(value));
 }
 
 void metric_scraper::operator()(const ct::metric_family* family,
                                 const ct::metric* instance,
                                 const ct::int_histogram* histogram) {
-  if (selected(family))
+  if (!selected(family))
+    return;
+  if (data value{pack_histogram(histogram)}; changed(instance, value))
     add_row(family, "histogram", to_table(instance->labels()),
-            pack_histogram(histogram));
+            std::move(value));
 }
 
 template <class T>
@@ -0,0 +1,24 @@
+#include "broker/internal/peer_io.hh"
+
+#include "broker/internal/metric_factory.hh"
+
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/settings.hpp>
+
+namespace broker::internal {
+
+peer_io_metrics peer_io_metrics::make(caf::actor_system& sys,
+                                      endpoint_id peer_id) {
+  peer_io_metrics result;
+  result.read_ahead = caf::get_or(sys.config(), "broker.peering.read-ahead",
+                                  defaults::peering::read_ahead);
+  metric_factory factory{sys};
+  auto label = to_string(peer_id);
+  result.writes = factory.core.peer_writes_instance(label);
+  result.reads = factory.core.peer_reads_instance(label);
+  result.read_messages = factory.core.peer_read_messages_instance(label);
+  return result;
+}
+
+} // namespace broker::internal
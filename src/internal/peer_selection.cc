@@ -0,0 +1,31 @@
+#include "broker/internal/peer_selection.hh"
+
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/internal/trace.hh"
+
+namespace broker::internal {
+
+bool peer_selection::selects(const node_message& msg) const {
+  if (get_sender(msg) == peer)
+    return false;
+  if (disable_forwarding && get_sender(msg) != this_peer)
+    return false;
+  auto f = detail::prefix_matcher{};
+  auto receiver = get_receiver(msg);
+  auto selected = receiver == peer
+                  || (!receiver && f(*filter, get_topic(msg)));
+  trace(selected ? trace_event::filter_pass : trace_event::filter_drop, peer,
+        get_packed_message(msg));
+  return selected;
+}
+
+node_message peer_selection::rewrite(const node_message& msg) const {
+  if (get_sender(msg) == this_peer)
+    return msg;
+  using std::get;
+  auto cpy = msg;
+  get<0>(cpy.unshared()) = this_peer;
+  return cpy;
+}
+
+} // namespace broker::internal
@@ -172,6 +172,19 @@ peering::setup(caf::scheduled_actor* self, node_consumer_res in_res,
     .compose(add_flow_scope_t{output_stats_})
     .compose(inject_killswitch_t{&out_})
     .subscribe(std::move(out_res));
+  return setup_input(self, std::move(in_res));
+}
+
+caf::flow::observable<node_message>
+peering::setup(caf::scheduled_actor* self, node_consumer_res in_res,
+               caf::disposable out) {
+  bye_id_ = self->new_u64_id();
+  out_ = std::move(out);
+  return setup_input(self, std::move(in_res));
+}
+
+caf::flow::observable<node_message>
+peering::setup_input(caf::scheduled_actor* self, node_consumer_res in_res) {
   // Read inputs and surround them with connect/disconnect status messages.
   return self //
     ->make_observable()
@@ -225,4 +238,9 @@ bool peering::is_subscribed_to(const topic& what) const {
   return f(*filter_, what);
 }
 
+routing_update_result peering::handle_routing_update(const node_message& msg) {
+  return apply_routing_update(get_topic(msg), get_payload(msg), *filter_,
+                              filter_state_);
+}
+
 } // namespace broker::internal
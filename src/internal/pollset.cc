@@ -0,0 +1,121 @@
+#include "broker/internal/pollset.hh"
+
+#ifdef CAF_LINUX
+#  include <unistd.h>
+#endif // CAF_LINUX
+
+namespace broker::internal {
+
+// -- poll_backend -------------------------------------------------------------
+
+void poll_backend::prepare_next_cycle() {
+  BROKER_TRACE("pending handles:" << pending_.size());
+  auto is_done = [](auto& x) { return x.events == 0; };
+  auto new_end = std::remove_if(fdset_.begin(), fdset_.end(), is_done);
+  if (new_end == fdset_.end() && pending_.empty())
+    return;
+#if CAF_LOG_LEVEL >= CAF_LOG_LEVEL_DEBUG
+  std::for_each(new_end, fdset_.end(), [](auto& x) {
+    if (x.fd != detail::invalid_native_socket)
+      BROKER_DEBUG("drop completed socket from pollset"
+                   << BROKER_ARG2("fd", x.fd));
+  });
+#endif
+  fdset_.erase(new_end, fdset_.end());
+  fdset_.insert(fdset_.end(), pending_.begin(), pending_.end());
+  pending_.clear();
+  index_.clear();
+  for (size_t i = 0; i < fdset_.size(); ++i)
+    index_[fdset_[i].fd] = i;
+}
+
+#ifdef CAF_LINUX
+
+// -- epoll_backend ------------------------------------------------------------
+
+epoll_backend::epoll_backend()
+  : epfd_(::epoll_create1(EPOLL_CLOEXEC)), events_(64) {
+  if (epfd_ < 0) {
+    BROKER_ERROR("epoll_create1() failed");
+    throw std::runtime_error("epoll_create1() failed");
+  }
+}
+
+epoll_backend::~epoll_backend() {
+  ::close(epfd_);
+}
+
+void epoll_backend::prepare_next_cycle() {
+  BROKER_TRACE("changed handles:" << changed_.size());
+  for (auto fd : changed_) {
+    auto i = entries_.find(fd);
+    if (i == entries_.end())
+      continue;
+    auto& [pfd, registered] = i->second;
+    if (pfd.events == 0) {
+      BROKER_DEBUG("drop completed socket from pollset"
+                   << BROKER_ARG2("fd", fd));
+      // Fails if the handler closed the socket, which also removes it from
+      // the epoll set. Hence, we can safely ignore the result.
+      if (registered != 0)
+        ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+      entries_.erase(i);
+    } else if (auto mask = to_epoll_mask(pfd.events); mask != registered) {
+      if (!update(fd, mask, registered != 0)) {
+        BROKER_ERROR("epoll_ctl() failed for socket" << fd);
+        entries_.erase(i);
+        continue;
+      }
+      registered = mask;
+    }
+  }
+  changed_.clear();
+}
+
+uint32_t epoll_backend::to_epoll_mask(short mask) noexcept {
+  uint32_t result = 0;
+  if (mask & POLLIN)
+    result |= EPOLLIN;
+  if (mask & POLLPRI)
+    result |= EPOLLPRI;
+  if (mask & POLLOUT)
+    result |= EPOLLOUT;
+  return result;
+}
+
+short epoll_backend::from_epoll_mask(uint32_t mask) noexcept {
+  short result = 0;
+  if (mask & EPOLLIN)
+    result |= POLLIN;
+  if (mask & EPOLLPRI)
+    result |= POLLPRI;
+  if (mask & EPOLLOUT)
+    result |= POLLOUT;
+  if (mask & EPOLLERR)
+    result |= POLLERR;
+  if (mask & EPOLLHUP)
+    result |= POLLHUP;
+  return result;
+}
+
+bool epoll_backend::update(caf::net::socket_id fd, uint32_t mask,
+                           bool registered) {
+  epoll_event ev;
+  ev.events = mask;
+  ev.data.fd = fd;
+  if (::epoll_ctl(epfd_, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev)
+      == 0)
+    return true;
+  // The OS may re-use the ID of a socket that we have closed during the last
+  // cycle. Closing the socket removed it from the epoll set. Conversely, the
+  // kernel still knows the socket if another descriptor refers to it.
+  if (registered && errno == ENOENT)
+    return ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+  if (!registered && errno == EEXIST)
+    return ::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+  return false;
+}
+
+#endif // CAF_LINUX
+
+} // namespace broker::internal
@@ -0,0 +1,61 @@
+#include "broker/internal/priority_lanes.hh"
+
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/internal/metric_factory.hh"
+#include "broker/topic.hh"
+
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/settings.hpp>
+
+namespace broker::internal {
+
+std::string to_string(priority_lane x) {
+  return x == priority_lane::high ? "high" : "bulk";
+}
+
+priority_lane priority_lanes::classify(const node_message& msg) const {
+  switch (get_type(msg)) {
+    case packed_message_type::routing_update:
+    case packed_message_type::command:
+      return priority_lane::high;
+    case packed_message_type::ping:
+    case packed_message_type::pong:
+      // The BYE handshake for unpeering uses a ping on the reserved topic. It
+      // marks the end of the output to a peer and must not overtake any data.
+      if (get_topic(msg).string() == topic::reserved)
+        return priority_lane::bulk;
+      return priority_lane::high;
+    default: {
+      const auto& what = get_topic(msg);
+      if (what.string().find(topic::reserved) != std::string::npos)
+        return priority_lane::high;
+      detail::prefix_matcher f;
+      if (!high_prefixes.empty() && f(high_prefixes, what))
+        return priority_lane::high;
+      return priority_lane::bulk;
+    }
+  }
+}
+
+priority_lanes priority_lanes::make(caf::actor_system& sys) {
+  using string_list = std::vector<std::string>;
+  priority_lanes result;
+  const auto& cfg = sys.config();
+  result.enabled = caf::get_or(cfg, "broker.priority.enabled", false);
+  for (auto& prefix : caf::get_or(cfg, "broker.priority.high-prefixes",
+                                  string_list{}))
+    result.high_prefixes.emplace_back(std::move(prefix));
+  result.buffer_size = caf::get_or(cfg, "broker.priority.buffer-size",
+                                   defaults::priority::buffer_size);
+  metric_factory factory{sys};
+  auto queued = factory.core.priority_lane_queued_messages_instances();
+  auto processed = factory.core.priority_lane_processed_messages_instances();
+  result.metrics[static_cast<size_t>(priority_lane::high)] = {queued.high,
+                                                             processed.high};
+  result.metrics[static_cast<size_t>(priority_lane::bulk)] = {queued.bulk,
+                                                             processed.bulk};
+  return result;
+}
+
+} // namespace broker::internal
@@ -6,8 +6,10 @@
 #include <caf/actor_system_config.hpp>
 #include <caf/string_algorithms.hpp>
 
+#include "broker/defaults.hh"
 #include "broker/internal/logger.hh"
 #include "broker/internal/metric_exporter.hh"
+#include "broker/internal/trace.hh"
 #include "broker/message.hh"
 
 using namespace std::literals;
@@ -27,6 +29,16 @@ constexpr string_view prom_request_start = "GET /metrics HTTP/1.";
 // A GET request for JSON-formatted status snapshots.
 constexpr string_view status_request_start = "GET /v1/status/json HTTP/1.";
 
+// A GET request for a binary dump of the trace ring buffers.
+constexpr string_view trace_dump_request_start = "GET /v1/trace/dump HTTP/1.";
+
+// POST requests for turning tracing on or off.
+constexpr string_view trace_enable_request_start =
+  "POST /v1/trace/enable HTTP/1.";
+
+constexpr string_view trace_disable_request_start =
+  "POST /v1/trace/disable HTTP/1.";
+
 // HTTP response for requests that exceed the size limit.
 constexpr string_view request_too_large =
   "HTTP/1.1 413 Request Entity Too Large\r\n"
@@ -41,6 +53,12 @@ constexpr string_view request_ok_text = "HTTP/1.1 200 OK\r\n"
                                         "Content-Type: text/plain\r\n"
                                         "Connection: Closed\r\n\r\n";
 
+// HTTP header when sending binary data.
+constexpr string_view request_ok_binary =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: application/octet-stream\r\n"
+  "Connection: Closed\r\n\r\n";
+
 // HTTP header when sending a JSON.
 constexpr string_view request_ok_json = "HTTP/1.1 200 OK\r\n"
                                         "Content-Type: application/json\r\n"
@@ -55,6 +73,8 @@ prometheus_actor::prometheus_actor(caf::actor_config& cfg,
   : super(cfg), core_(std::move(core)) {
   filter_ = caf::get_or(config(), "broker.metrics.import.topics",
                         filter_type{});
+  max_staleness_ = caf::get_or(config(), "broker.metrics.max-staleness",
+                               defaults::metrics::max_staleness);
   add_doorman(std::move(ptr));
 }
 
@@ -115,6 +135,23 @@ caf::behavior prometheus_actor::make_behavior() {
         on_status_request(msg.handle);
         return;
       }
+      if (caf::starts_with(req_str, trace_dump_request_start)) {
+        BROKER_DEBUG("serve HTTP request for /v1/trace/dump");
+        auto dump = trace_dump(trace_snapshot());
+        respond(msg.handle, caf::as_bytes(caf::make_span(request_ok_binary)),
+                caf::as_bytes(caf::make_span(dump)));
+        return;
+      }
+      if (caf::starts_with(req_str, trace_enable_request_start)
+          || caf::starts_with(req_str, trace_disable_request_start)) {
+        auto enable = caf::starts_with(req_str, trace_enable_request_start);
+        BROKER_INFO((enable ? "enable" : "disable") << "tracing via HTTP");
+        enable_tracing(enable);
+        auto text = enable ? "tracing enabled\n"sv : "tracing disabled\n"sv;
+        respond(msg.handle, caf::as_bytes(caf::make_span(request_ok_text)),
+                caf::as_bytes(caf::make_span(text)));
+        return;
+      }
       BROKER_DEBUG("reject unsupported HTTP request: "
                    << std::string{req_str.substr(0, req_str.find("\r\n"sv))});
       write(msg.handle, caf::as_bytes(caf::make_span(request_not_supported)));
@@ -146,6 +183,9 @@ caf::behavior prometheus_actor::make_behavior() {
     },
   };
   auto params = metric_exporter_params::from(config());
+  // We merge the scrape results of our exporter into the local collector only
+  // when serving a request. Hence, we always need the full state.
+  params.full_interval = caf::timespan{0};
   exporter_ = std::make_unique<exporter_state_type>(this, core_,
                                                     std::move(params));
   return bhvr.or_else(exporter_->make_behavior());
@@ -162,37 +202,62 @@ void prometheus_actor::flush_and_close(caf::io::connection_handle hdl) {
 void prometheus_actor::on_metrics_request(caf::io::connection_handle hdl) {
   // Collect metrics, ship response, and close. If the user configured
   // neither Broker-side import nor export of metrics, we fall back to the
-  // default CAF Prometheus export.
+  // default CAF Prometheus export. Concurrent scrapers may share the same
+  // output as long as it does not exceed the configured maximum staleness.
   auto hdr = caf::as_bytes(caf::make_span(request_ok_text));
   BROKER_ASSERT(exporter_ != nullptr);
-  if (!exporter_->running()) {
-    exporter_->proc_importer.update();
-    exporter_->impl.scrape(system().metrics());
+  if (!has_metrics_text_ || !fresh(metrics_rendered_)) {
+    if (!exporter_->running()) {
+      exporter_->proc_importer.update();
+      exporter_->impl.scrape(system().metrics());
+    }
+    collector_.insert_or_update(exporter_->impl.rows());
+    metrics_text_ = collector_.prometheus_text();
+    metrics_rendered_ = clock().now();
+    has_metrics_text_ = true;
   }
-  collector_.insert_or_update(exporter_->impl.rows());
-  auto text = collector_.prometheus_text();
-  auto payload = caf::as_bytes(caf::make_span(text));
-  auto& dst = wr_buf(hdl);
-  dst.insert(dst.end(), hdr.begin(), hdr.end());
-  dst.insert(dst.end(), payload.begin(), payload.end());
-  flush_and_close(hdl);
+  respond(hdl, hdr, caf::as_bytes(caf::make_span(metrics_text_)));
 }
 
 void prometheus_actor::on_status_request(caf::io::connection_handle hdl) {
+  if (has_status_json_ && fresh(status_rendered_)) {
+    auto hdr = caf::as_bytes(caf::make_span(request_ok_json));
+    respond(hdl, hdr, caf::as_bytes(caf::make_span(json_buf_)));
+    return;
+  }
   auto aid = new_u64_id();
   request(core_, 5s, atom::get_v, atom::status_v)
     .then(
       [this, hdl, aid](const table& tbl) { //
         on_status_request_cb(hdl, aid, tbl);
+        // Only cache successful responses.
+        status_rendered_ = clock().now();
+        has_status_json_ = true;
       },
       [this, hdl, aid](const caf::error& what) {
         table tbl;
         tbl.emplace(data{"error"s}, data{caf::to_string(what)});
         on_status_request_cb(hdl, aid, tbl);
+        has_status_json_ = false;
       });
   requests_[hdl].async_id = aid;
 }
 
+void prometheus_actor::respond(caf::io::connection_handle hdl,
+                               caf::span<const std::byte> hdr,
+                               caf::span<const std::byte> payload) {
+  auto& dst = wr_buf(hdl);
+  dst.reserve(dst.size() + hdr.size() + payload.size());
+  dst.insert(dst.end(), hdr.begin(), hdr.end());
+  dst.insert(dst.end(), payload.begin(), payload.end());
+  flush_and_close(hdl);
+}
+
+bool prometheus_actor::fresh(caf::actor_clock::time_point rendered) {
+  return max_staleness_.count() > 0
+         && clock().now() - rendered < max_staleness_;
+}
+
 namespace {
 
 class jsonizer {
@@ -337,6 +402,13 @@ private:
 void prometheus_actor::on_status_request_cb(caf::io::connection_handle hdl,
                                             uint64_t async_id,
                                             const table& res) {
+  // Generate JSON output. Clearing the buffer keeps its capacity from the
+  // previous response. We render the output even if the client went away in
+  // the meantime to have it available for the next request.
+  json_buf_.clear();
+  jsonizer f{json_buf_};
+  f(res);
+  json_buf_.push_back('\n');
   // Sanity checking.
   auto iter = requests_.find(hdl);
   if (iter == requests_.end())
@@ -344,18 +416,9 @@ void prometheus_actor::on_status_request_cb(caf::io::connection_handle hdl,
   auto& req = iter->second;
   if (req.async_id != async_id)
     return;
-  // Generate JSON output.
-  json_buf_.clear();
-  jsonizer f{json_buf_};
-  f(res);
-  json_buf_.push_back('\n');
   // Send result and close connection.
   auto hdr = caf::as_bytes(caf::make_span(request_ok_json));
-  auto payload = caf::as_bytes(caf::make_span(json_buf_));
-  auto& dst = wr_buf(hdl);
-  dst.insert(dst.end(), hdr.begin(), hdr.end());
-  dst.insert(dst.end(), payload.begin(), payload.end());
-  flush_and_close(hdl);
+  respond(hdl, hdr, caf::as_bytes(caf::make_span(json_buf_)));
 }
 
 } // namespace broker::internal
@@ -0,0 +1,159 @@
+#include "broker/internal/publish_limiter.hh"
+
+#include "broker/internal/logger.hh"
+#include "broker/internal/metric_factory.hh"
+
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/settings.hpp>
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace broker::internal {
+
+namespace {
+
+double burst_of(const publish_limit& limit) {
+  if (limit.burst > 0)
+    return static_cast<double>(limit.burst);
+  return std::max(limit.rate, 1.0);
+}
+
+} // namespace
+
+publish_limiter::publish_limiter(caf::telemetry::metric_registry& reg)
+  : reg_(&reg) {
+  // nop
+}
+
+publish_limiter publish_limiter::make(caf::actor_system& sys) {
+  using string_list = std::vector<std::string>;
+  publish_limiter result{sys.metrics()};
+  auto policies = caf::get_or(sys.config(), "broker.publish-limits",
+                              string_list{});
+  auto t0 = now();
+  for (const auto& policy : policies) {
+    topic prefix;
+    publish_limit limit;
+    // Note: the configuration already rejects malformed entries. We only end
+    //       up here if users bypass the check by setting the option manually.
+    if (!parse_policy(policy, prefix, limit)) {
+      BROKER_ERROR("invalid publish limit:" << policy);
+      continue;
+    }
+    result.set(prefix, limit, t0);
+  }
+  return result;
+}
+
+bool publish_limiter::parse_policy(const std::string& str, topic& prefix,
+                                   publish_limit& limit) {
+  auto sep = str.find(' ');
+  if (sep == 0 || sep == std::string::npos
+      || !convert(str.substr(sep + 1), limit))
+    return false;
+  prefix = topic{str.substr(0, sep)};
+  return true;
+}
+
+void publish_limiter::set(const topic& prefix, const publish_limit& limit,
+                          timestamp now) {
+  auto* ptr = find_exact(prefix);
+  if (ptr == nullptr) {
+    ptr = &entries_.emplace_back();
+    ptr->prefix = prefix.string();
+    metric_factory factory{*reg_};
+    auto dropped = factory.core.publish_limit_dropped_messages_instances(
+      ptr->prefix);
+    ptr->accepted =
+      factory.core.publish_limit_accepted_messages_instance(ptr->prefix);
+    ptr->dropped_by_rate = dropped.rate;
+    ptr->dropped_by_sample = dropped.sample;
+    ptr->dropped_by_policy = dropped.drop;
+    ptr->rate = factory.core.publish_limit_rate_instance(ptr->prefix);
+  }
+  ptr->limit = limit;
+  ptr->tokens = burst_of(limit);
+  ptr->last_refill = now;
+  ptr->seen = 0;
+  ptr->rate->value(limit.rate);
+}
+
+void publish_limiter::clear(const topic& prefix) {
+  if (auto* ptr = find_exact(prefix)) {
+    ptr->rate->value(0);
+    entries_.erase(entries_.begin() + (ptr - entries_.data()));
+  }
+}
+
+table publish_limiter::snapshot() const {
+  table result;
+  for (const auto& entry : entries_) {
+    table policy;
+    policy.emplace("rate"s, entry.limit.rate);
+    policy.emplace("burst"s, entry.limit.burst);
+    policy.emplace("sample"s, entry.limit.sample);
+    policy.emplace("drop"s, entry.limit.drop);
+    policy.emplace("accepted"s, entry.accepted->value());
+    policy.emplace("dropped-by-rate"s, entry.dropped_by_rate->value());
+    policy.emplace("dropped-by-sample"s, entry.dropped_by_sample->value());
+    policy.emplace("dropped-by-policy"s, entry.dropped_by_policy->value());
+    result.emplace(entry.prefix, std::move(policy));
+  }
+  return result;
+}
+
+bool publish_limiter::admit_impl(const topic& t, timestamp now) {
+  auto* ptr = find(t);
+  if (ptr == nullptr)
+    return true;
+  auto& st = *ptr;
+  if (st.limit.drop) {
+    st.dropped_by_policy->inc();
+    return false;
+  }
+  // Sampling: forward only the first message out of `sample` messages.
+  if (st.limit.sample > 1 && st.seen++ % st.limit.sample != 0) {
+    st.dropped_by_sample->inc();
+    return false;
+  }
+  // Rate limit: each message consumes one token from the bucket.
+  if (st.limit.rate > 0) {
+    if (now > st.last_refill) {
+      fractional_seconds elapsed;
+      convert(now - st.last_refill, elapsed);
+      st.tokens = std::min(st.tokens + elapsed.count() * st.limit.rate,
+                           burst_of(st.limit));
+      st.last_refill = now;
+    }
+    if (st.tokens < 1.0) {
+      st.dropped_by_rate->inc();
+      return false;
+    }
+    st.tokens -= 1.0;
+  }
+  st.accepted->inc();
+  return true;
+}
+
+publish_limiter::entry* publish_limiter::find(const topic& t) noexcept {
+  const auto& str = t.string();
+  entry* result = nullptr;
+  for (auto& entry : entries_) {
+    if (str.compare(0, entry.prefix.size(), entry.prefix) == 0
+        && (result == nullptr || entry.prefix.size() > result->prefix.size()))
+      result = &entry;
+  }
+  return result;
+}
+
+publish_limiter::entry*
+publish_limiter::find_exact(const topic& prefix) noexcept {
+  auto pred = [&prefix](const entry& x) { return x.prefix == prefix.string(); };
+  auto i = std::find_if(entries_.begin(), entries_.end(), pred);
+  return i != entries_.end() ? &*i : nullptr;
+}
+
+} // namespace broker::internal
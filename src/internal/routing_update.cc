@@ -0,0 +1,135 @@
+#include "broker/internal/routing_update.hh"
+
+#include "broker/detail/assert.hh"
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/byte_buffer.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace broker::internal {
+
+namespace {
+
+constexpr std::string_view delta_suffix = "/delta";
+
+constexpr std::string_view resync_suffix = "/resync";
+
+template <class... Ts>
+std::vector<std::byte> serialize(const Ts&... xs) {
+  caf::byte_buffer buf;
+  caf::binary_serializer sink{nullptr, buf};
+  [[maybe_unused]] auto ok = (sink.apply(xs) && ...);
+  BROKER_ASSERT(ok);
+  auto first = reinterpret_cast<const std::byte*>(buf.data());
+  return std::vector<std::byte>{first, first + buf.size()};
+}
+
+} // namespace
+
+topic routing_update_topic(routing_update_kind kind) {
+  std::string str{topic::reserved};
+  switch (kind) {
+    default:
+      break;
+    case routing_update_kind::delta:
+      str += delta_suffix;
+      break;
+    case routing_update_kind::resync:
+      str += resync_suffix;
+      break;
+  }
+  return topic{std::move(str)};
+}
+
+routing_update_kind get_routing_update_kind(const topic& x) {
+  std::string_view str = x.string();
+  auto ends_with = [str](std::string_view suffix) {
+    return str.size() == topic::reserved.size() + suffix.size()
+           && str.compare(str.size() - suffix.size(), suffix.size(), suffix)
+                == 0;
+  };
+  if (ends_with(delta_suffix))
+    return routing_update_kind::delta;
+  if (ends_with(resync_suffix))
+    return routing_update_kind::resync;
+  return routing_update_kind::full;
+}
+
+std::vector<std::byte> make_full_routing_update(const filter_type& filter,
+                                                lamport_timestamp version) {
+  return serialize(filter, version);
+}
+
+std::vector<std::byte> make_delta_routing_update(lamport_timestamp version,
+                                                 const filter_type& added,
+                                                 const filter_type& removed) {
+  return serialize(version, added, removed);
+}
+
+routing_update_result apply_routing_update(const topic& x,
+                                           const std::vector<std::byte>& bytes,
+                                           filter_type& filter,
+                                           routing_update_state& state) {
+  caf::binary_deserializer src{nullptr, bytes};
+  switch (get_routing_update_kind(x)) {
+    case routing_update_kind::full: {
+      filter_type new_filter;
+      if (!src.apply(new_filter))
+        return routing_update_result::malformed;
+      // Peers running an older version of Broker send the filter only.
+      lamport_timestamp version{0};
+      if (src.remaining() > 0 && !src.apply(version))
+        return routing_update_result::malformed;
+      filter.swap(new_filter);
+      state.version = version;
+      state.versioned = version.value > 0;
+      state.resync_pending = false;
+      return routing_update_result::applied;
+    }
+    case routing_update_kind::delta: {
+      lamport_timestamp version;
+      filter_type added;
+      filter_type removed;
+      if (!src.apply(version) || !src.apply(added) || !src.apply(removed))
+        return routing_update_result::malformed;
+      if (!state.versioned)
+        return routing_update_result::gap;
+      if (version <= state.version)
+        return routing_update_result::ignored;
+      if (version != state.version + 1)
+        return routing_update_result::gap;
+      for (const auto& y : removed)
+        if (auto i = std::find(filter.begin(), filter.end(), y);
+            i != filter.end())
+          filter.erase(i);
+      for (auto& y : added)
+        if (std::find(filter.begin(), filter.end(), y) == filter.end())
+          filter.emplace_back(std::move(y));
+      state.version = version;
+      return routing_update_result::applied;
+    }
+    default:
+      return routing_update_result::ignored;
+  }
+}
+
+void filter_diff(const filter_type& old_filter, const filter_type& new_filter,
+                 filter_type& added, filter_type& removed) {
+  auto xs = old_filter;
+  auto ys = new_filter;
+  std::sort(xs.begin(), xs.end());
+  std::sort(ys.begin(), ys.end());
+  added.clear();
+  removed.clear();
+  std::set_difference(ys.begin(), ys.end(), xs.begin(), xs.end(),
+                      std::back_inserter(added));
+  std::set_difference(xs.begin(), xs.end(), ys.begin(), ys.end(),
+                      std::back_inserter(removed));
+}
+
+} // namespace broker::internal
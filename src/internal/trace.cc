@@ -0,0 +1,309 @@
+#include "broker/internal/trace.hh"
+
+#include "broker/defaults.hh"
+#include "broker/detail/assert.hh"
+#include "broker/error.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace broker::internal {
+
+std::atomic<bool> tracing_flag;
+
+namespace {
+
+constexpr std::string_view dump_magic = "BRKTRACE";
+
+constexpr uint32_t dump_version = 1;
+
+constexpr size_t dump_header_size = 16;
+
+constexpr size_t dump_record_size = 32;
+
+/// A ring buffer with a single writer (the owning thread) and any number of
+/// concurrent readers. Each slot stores a record as four 64-bit words. The
+/// writer never blocks: readers detect records that the writer overwrote
+/// while copying and discard them.
+class trace_ring {
+public:
+  trace_ring(uint16_t id, size_t capacity)
+    : id_(id), mask_(capacity - 1), slots_(new slot[capacity]()) {
+    BROKER_ASSERT(capacity > 0 && (capacity & mask_) == 0);
+  }
+
+  uint16_t id() const noexcept {
+    return id_;
+  }
+
+  /// Tries to claim this buffer for the calling thread.
+  bool try_acquire() noexcept {
+    return !owned_.exchange(true, std::memory_order_acq_rel);
+  }
+
+  /// Makes this buffer available to other threads. Keeps the records.
+  void release() noexcept {
+    owned_.store(false, std::memory_order_release);
+  }
+
+  void push(uint64_t timestamp, trace_event event, uint32_t size,
+            uint64_t peer, uint64_t topic) noexcept {
+    auto index = head_.load(std::memory_order_relaxed);
+    // Readers that observe any of the stores below must also observe the
+    // previous value of `head_`. Otherwise, they could miss that we are about
+    // to overwrite the oldest record.
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& words = slots_[index & mask_].words;
+    words[0].store(timestamp, std::memory_order_relaxed);
+    words[1].store(static_cast<uint64_t>(event)
+                     | (static_cast<uint64_t>(id_) << 16)
+                     | (static_cast<uint64_t>(size) << 32),
+                   std::memory_order_relaxed);
+    words[2].store(peer, std::memory_order_relaxed);
+    words[3].store(topic, std::memory_order_relaxed);
+    head_.store(index + 1, std::memory_order_release);
+  }
+
+  /// Appends all valid records in this buffer to `result`.
+  void collect(std::vector<trace_record>& result) const {
+    auto capacity = mask_ + 1;
+    auto last = head_.load(std::memory_order_acquire);
+    auto first = last > capacity ? last - capacity : 0;
+    std::vector<std::pair<uint64_t, trace_record>> buf;
+    buf.reserve(last - first);
+    for (auto index = first; index < last; ++index) {
+      auto& words = slots_[index & mask_].words;
+      auto meta = words[1].load(std::memory_order_relaxed);
+      trace_record rec;
+      rec.timestamp = words[0].load(std::memory_order_relaxed);
+      rec.event = static_cast<trace_event>(meta & 0xFFFF);
+      rec.thread = static_cast<uint16_t>((meta >> 16) & 0xFFFF);
+      rec.size = static_cast<uint32_t>(meta >> 32);
+      rec.peer = words[2].load(std::memory_order_relaxed);
+      rec.topic = words[3].load(std::memory_order_relaxed);
+      buf.emplace_back(index, rec);
+    }
+    // The writer may have overwritten records while we were copying them.
+    // With `head_` at position `n`, the writer may currently modify the slot
+    // for index `n`, i.e., only records after `n - capacity` remain intact.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto head = head_.load(std::memory_order_relaxed);
+    auto valid_from = head >= capacity ? head - capacity + 1 : 0;
+    for (auto& [index, rec] : buf)
+      if (index >= valid_from)
+        result.emplace_back(rec);
+  }
+
+private:
+  struct slot {
+    std::atomic<uint64_t> words[4];
+  };
+
+  uint16_t id_;
+  size_t mask_;
+  std::unique_ptr<slot[]> slots_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<bool> owned_{false};
+};
+
+/// Keeps track of all ring buffers. Buffers remain alive after their thread
+/// terminates, since their records remain relevant for the next dump. New
+/// threads re-use buffers of terminated threads.
+struct trace_registry {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<trace_ring>> rings;
+  std::atomic<size_t> capacity{defaults::trace::buffer_size};
+  std::atomic<bool> capacity_fixed{false};
+
+  trace_ring* acquire() {
+    std::unique_lock guard{mtx};
+    for (auto& ring : rings)
+      if (ring->try_acquire())
+        return ring.get();
+    auto id = static_cast<uint16_t>(rings.size());
+    auto& ring = rings.emplace_back(std::make_unique<trace_ring>(
+      id, capacity.load(std::memory_order_relaxed)));
+    ring->try_acquire();
+    return ring.get();
+  }
+};
+
+trace_registry& registry() {
+  // Intentionally leaked: threads may still release their buffers while
+  // static objects get destroyed.
+  static auto* instance = new trace_registry;
+  return *instance;
+}
+
+/// Releases the buffer of a thread when the thread terminates.
+struct trace_ring_handle {
+  trace_ring* ptr = nullptr;
+
+  ~trace_ring_handle() {
+    if (ptr)
+      ptr->release();
+  }
+};
+
+thread_local trace_ring_handle this_thread_ring;
+
+uint64_t now_ns() noexcept {
+  auto t = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+}
+
+uint64_t fnv1a(const std::byte* first, size_t size) noexcept {
+  uint64_t result = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    result ^= static_cast<uint64_t>(first[i]);
+    result *= 0x100000001b3ull;
+  }
+  return result;
+}
+
+template <class T>
+void write_le(std::vector<std::byte>& buf, T x) {
+  for (size_t i = 0; i < sizeof(T); ++i)
+    buf.emplace_back(static_cast<std::byte>((x >> (i * 8)) & 0xFF));
+}
+
+template <class T>
+T read_le(const std::byte* first) {
+  T result = 0;
+  for (size_t i = 0; i < sizeof(T); ++i)
+    result |= static_cast<T>(static_cast<uint64_t>(first[i]) << (i * 8));
+  return result;
+}
+
+} // namespace
+
+std::string_view to_string(trace_event x) noexcept {
+  switch (x) {
+    case trace_event::publish:
+      return "publish";
+    case trace_event::merge:
+      return "merge";
+    case trace_event::filter_pass:
+      return "filter_pass";
+    case trace_event::filter_drop:
+      return "filter_drop";
+    case trace_event::peer_write:
+      return "peer_write";
+    case trace_event::store_apply:
+      return "store_apply";
+    case trace_event::channel_ack:
+      return "channel_ack";
+    case trace_event::channel_nack:
+      return "channel_nack";
+    case trace_event::control:
+      return "control";
+    default:
+      return "???";
+  }
+}
+
+uint64_t trace_hash(std::string_view str) noexcept {
+  return fnv1a(reinterpret_cast<const std::byte*>(str.data()), str.size());
+}
+
+uint64_t trace_hash(const endpoint_id& x) noexcept {
+  if (!x)
+    return 0;
+  auto& bytes = x.bytes();
+  return fnv1a(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size());
+}
+
+void enable_tracing(bool value) noexcept {
+  tracing_flag.store(value, std::memory_order_relaxed);
+}
+
+size_t set_trace_buffer_size(size_t capacity) noexcept {
+  auto& reg = registry();
+  if (reg.capacity_fixed.exchange(true, std::memory_order_relaxed))
+    return reg.capacity.load(std::memory_order_relaxed);
+  // Round up to the next power of two.
+  size_t result = 1;
+  while (result < capacity)
+    result <<= 1;
+  reg.capacity.store(result, std::memory_order_relaxed);
+  return result;
+}
+
+void trace_impl(trace_event event, uint64_t peer, uint64_t topic,
+                uint64_t size) {
+  auto& hdl = this_thread_ring;
+  if (!hdl.ptr)
+    hdl.ptr = registry().acquire();
+  auto size32 = static_cast<uint32_t>(std::min(size, uint64_t{UINT32_MAX}));
+  hdl.ptr->push(now_ns(), event, size32, peer, topic);
+}
+
+void trace_impl(trace_event event, const endpoint_id& peer,
+                const packed_message& msg) {
+  trace_impl(event, trace_hash(peer), trace_hash(get_topic(msg)),
+             get_payload(msg).size());
+}
+
+std::vector<trace_record> trace_snapshot() {
+  std::vector<trace_record> result;
+  auto& reg = registry();
+  {
+    std::unique_lock guard{reg.mtx};
+    for (auto& ring : reg.rings)
+      ring->collect(result);
+  }
+  auto by_timestamp = [](const trace_record& x, const trace_record& y) {
+    return x.timestamp < y.timestamp;
+  };
+  std::stable_sort(result.begin(), result.end(), by_timestamp);
+  return result;
+}
+
+std::vector<std::byte> trace_dump(const std::vector<trace_record>& xs) {
+  std::vector<std::byte> result;
+  result.reserve(dump_header_size + xs.size() * dump_record_size);
+  for (auto ch : dump_magic)
+    result.emplace_back(static_cast<std::byte>(ch));
+  write_le(result, dump_version);
+  write_le(result, static_cast<uint32_t>(xs.size()));
+  for (const auto& x : xs) {
+    write_le(result, x.timestamp);
+    write_le(result, static_cast<uint16_t>(x.event));
+    write_le(result, x.thread);
+    write_le(result, x.size);
+    write_le(result, x.peer);
+    write_le(result, x.topic);
+  }
+  return result;
+}
+
+expected<std::vector<trace_record>> parse_trace_dump(const std::byte* first,
+                                                     size_t size) {
+  if (size < dump_header_size
+      || memcmp(first, dump_magic.data(), dump_magic.size()) != 0)
+    return make_error(ec::invalid_data, "not a Broker trace dump");
+  if (read_le<uint32_t>(first + 8) != dump_version)
+    return make_error(ec::invalid_data, "unsupported trace dump version");
+  auto num_records = read_le<uint32_t>(first + 12);
+  if (size != dump_header_size + num_records * dump_record_size)
+    return make_error(ec::invalid_data, "truncated trace dump");
+  std::vector<trace_record> result;
+  result.reserve(num_records);
+  for (auto pos = first + dump_header_size; pos != first + size;
+       pos += dump_record_size) {
+    trace_record rec;
+    rec.timestamp = read_le<uint64_t>(pos);
+    rec.event = static_cast<trace_event>(read_le<uint16_t>(pos + 8));
+    rec.thread = read_le<uint16_t>(pos + 10);
+    rec.size = read_le<uint32_t>(pos + 12);
+    rec.peer = read_le<uint64_t>(pos + 16);
+    rec.topic = read_le<uint64_t>(pos + 24);
+    result.emplace_back(rec);
+  }
+  return result;
+}
+
+} // namespace broker::internal
@@ -1,5 +1,6 @@
 #include "broker/internal/wire_format.hh"
 
+#include "broker/internal/latency_tracker.hh"
 #include "broker/internal/logger.hh"
 #include "broker/message.hh"
 
@@ -32,7 +33,8 @@ namespace broker::internal::wire_format {
 std::pair<ec, std::string_view> check(const hello_msg& x) {
   if (x.magic != magic_number)
     return {ec::wrong_magic_number, "wrong magic number"};
-  else if (x.min_version > protocol_version || x.max_version < protocol_version)
+  else if (x.min_version > timestamped_protocol_version
+           || x.max_version < protocol_version)
     return {ec::peer_incompatible, "unsupported versions offered"};
   else
     return {ec::none, {}};
@@ -48,7 +50,8 @@ std::pair<ec, std::string_view> check(const probe_msg& x) {
 std::pair<ec, std::string_view> check(const version_select_msg& x) {
   if (x.magic != magic_number)
     return {ec::wrong_magic_number, "wrong magic number"};
-  else if (x.selected_version != protocol_version)
+  else if (x.selected_version < protocol_version
+           || x.selected_version > timestamped_protocol_version)
     return {ec::peer_incompatible, "unsupported version selected"};
   else
     return {ec::none, {}};
@@ -82,22 +85,32 @@ bool trait::convert(const node_message& msg, caf::byte_buffer& buf) {
     return sink.apply(static_cast<uint16_t>(str.size()))
            && write_bytes(caf::as_bytes(caf::make_span(str)));
   };
-  const auto& [sender, receiver, content] = msg.data();
+  // Only data messages carry an origin timestamp on the wire. We transmit the
+  // nanoseconds since the epoch with 0 representing "no timestamp".
+  auto write_origin = [&](packed_message_type type, timestamp origin) {
+    if (!with_origin_ || type != packed_message_type::data)
+      return true;
+    return sink.apply(origin.time_since_epoch().count());
+  };
+  const auto& [sender, receiver, content, origin] = msg.data();
   const auto& [msg_type, ttl, msg_topic, payload] = content.data();
   auto ok = sink.apply(sender)                                      //
             && sink.apply(receiver)                                 //
             && sink.apply(msg_type)                                 //
             && sink.apply(ttl)                                      //
+            && write_origin(msg_type, origin)                       //
             && write_topic(msg_topic)                               //
             && write_bytes(caf::as_bytes(caf::make_span(payload))); //
   if (!ok)
     last_error_ = sink.get_error();
+  else if (latency_)
+    latency_->observe_core_to_peer_write(msg);
   return ok;
 }
 
 bool trait::convert(caf::const_byte_span bytes, node_message& msg) {
   caf::binary_deserializer source{nullptr, bytes};
-  auto& [sender, receiver, content] = msg.unshared();
+  auto& [sender, receiver, content, origin] = msg.unshared();
   auto& [msg_type, ttl, msg_topic, payload] = content.unshared();
   // Extract sender, receiver, type and TTL.
   if (!source.apply(sender)      //
@@ -108,6 +121,17 @@ bool trait::convert(caf::const_byte_span bytes, node_message& msg) {
     BROKER_DEBUG("failed to parse node message fields:" << last_error_);
     return false;
   }
+  // Extract the origin timestamp if present.
+  origin = timestamp{};
+  if (with_origin_ && msg_type == packed_message_type::data) {
+    int64_t ns = 0;
+    if (!source.apply(ns)) {
+      last_error_ = source.get_error();
+      BROKER_DEBUG("failed to parse origin timestamp:" << last_error_);
+      return false;
+    }
+    origin = timestamp{timespan{ns}};
+  }
   // Extract topic.
   uint16_t topic_len = 0;
   if (!source.apply(topic_len)) {
@@ -132,6 +156,8 @@ bool trait::convert(caf::const_byte_span bytes, node_message& msg) {
   auto first = reinterpret_cast<const std::byte*>(remainder.data());
   auto last = first + remainder.size();
   payload.assign(first, last);
+  if (read_messages_)
+    read_messages_->inc();
   return true;
 }
 
@@ -0,0 +1,26 @@
+#include "broker/internal/write_batching.hh"
+
+#include "broker/internal/metric_factory.hh"
+
+#include <caf/actor_system.hpp>
+#include <caf/actor_system_config.hpp>
+#include <caf/settings.hpp>
+
+namespace broker::internal {
+
+write_batching write_batching::make(caf::actor_system& sys,
+                                    endpoint_id peer_id) {
+  write_batching result;
+  result.peer = peer_id;
+  const auto& cfg = sys.config();
+  result.max_size = caf::get_or(cfg, "broker.peering.write-batch-size",
+                                defaults::peering::write_batch_size);
+  result.max_delay = caf::get_or(cfg, "broker.peering.write-batch-delay",
+                                 defaults::peering::write_batch_delay);
+  metric_factory factory{sys};
+  auto label = to_string(peer_id);
+  result.messages = factory.core.peer_written_messages_instance(label);
+  return result;
+}
+
+} // namespace broker::internal
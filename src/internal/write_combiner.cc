@@ -0,0 +1,125 @@
+#include "broker/internal/write_combiner.hh"
+
+#include "broker/detail/appliers.hh"
+
+#include <algorithm>
+
+namespace broker::internal {
+
+namespace {
+
+/// Checks whether `x` increments a numeric value or timestamp.
+bool is_increment(const add_command& x) {
+  switch (x.init_type) {
+    case data::type::count:
+    case data::type::integer:
+    case data::type::real:
+    case data::type::timestamp:
+      break;
+    default:
+      return false;
+  }
+  switch (x.value.get_type()) {
+    case data::type::count:
+    case data::type::integer:
+    case data::type::real:
+    case data::type::timespan:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Checks whether `x` inserts a value into a set.
+bool is_set_insertion(const add_command& x) {
+  return x.init_type == data::type::set;
+}
+
+void set_expiry(internal_command_variant& x,
+                const std::optional<timespan>& expiry) {
+  if (auto put = get_if<put_command>(&x))
+    put->expiry = expiry;
+  else if (auto add = get_if<add_command>(&x))
+    add->expiry = expiry;
+}
+
+/// Tries to merge `cmd` into the buffered commands `xs` for the same key.
+bool merge(std::vector<internal_command_variant>& xs, add_command& cmd) {
+  auto& last = xs.back();
+  if (auto prev = get_if<put_command>(&last)) {
+    if (prev->publisher != cmd.publisher)
+      return false;
+    if (auto res = visit(detail::adder{cmd.value}, prev->value); !res)
+      return false;
+    prev->expiry = cmd.expiry;
+    return true;
+  }
+  auto prev = get_if<add_command>(&last);
+  if (!prev || prev->publisher != cmd.publisher)
+    return false;
+  if (is_increment(cmd)) {
+    if (!is_increment(*prev) || prev->init_type != cmd.init_type
+        || prev->value.get_type() != cmd.value.get_type())
+      return false;
+    if (auto res = visit(detail::adder{cmd.value}, prev->value); !res)
+      return false;
+    prev->expiry = cmd.expiry;
+    return true;
+  }
+  if (is_set_insertion(cmd)) {
+    auto same_insertion = [&cmd](const internal_command_variant& x) {
+      auto other = get_if<add_command>(&x);
+      return other && other->publisher == cmd.publisher
+             && is_set_insertion(*other) && other->value == cmd.value;
+    };
+    if (std::none_of(xs.begin(), xs.end(), same_insertion))
+      return false;
+    set_expiry(last, cmd.expiry);
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+bool write_combiner::add(internal_command_variant& cmd) {
+  if (auto x = get_if<put_command>(&cmd)) {
+    add(*x);
+    return true;
+  }
+  if (auto x = get_if<add_command>(&cmd)) {
+    add(*x);
+    return true;
+  }
+  return false;
+}
+
+void write_combiner::clear() {
+  keys_.clear();
+  buf_.clear();
+  size_ = 0;
+}
+
+void write_combiner::add(put_command& cmd) {
+  auto [i, added] = buf_.try_emplace(cmd.key);
+  if (added)
+    keys_.emplace_back(cmd.key);
+  auto& xs = i->second;
+  size_ -= xs.size();
+  xs.clear();
+  xs.emplace_back(std::move(cmd));
+  ++size_;
+}
+
+void write_combiner::add(add_command& cmd) {
+  auto [i, added] = buf_.try_emplace(cmd.key);
+  if (added)
+    keys_.emplace_back(cmd.key);
+  auto& xs = i->second;
+  if (!xs.empty() && merge(xs, cmd))
+    return;
+  xs.emplace_back(std::move(cmd));
+  ++size_;
+}
+
+} // namespace broker::internal
@@ -0,0 +1,93 @@
+#include "broker/publish_limit.hh"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string_view>
+
+namespace broker {
+
+namespace {
+
+bool parse_value(const std::string& str, double& x) {
+  char* end = nullptr;
+  errno = 0;
+  auto val = strtod(str.c_str(), &end);
+  if (str.empty() || *end != '\0' || errno != 0 || !std::isfinite(val)
+      || val < 0)
+    return false;
+  x = val;
+  return true;
+}
+
+bool parse_value(const std::string& str, uint64_t& x) {
+  if (str.empty() || str.front() == '-')
+    return false;
+  char* end = nullptr;
+  errno = 0;
+  auto val = strtoull(str.c_str(), &end, 10);
+  if (*end != '\0' || errno != 0)
+    return false;
+  x = static_cast<uint64_t>(val);
+  return true;
+}
+
+bool parse_value(const std::string& str, bool& x) {
+  if (str == "true") {
+    x = true;
+    return true;
+  }
+  if (str == "false") {
+    x = false;
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+bool operator==(const publish_limit& x, const publish_limit& y) noexcept {
+  return x.rate == y.rate && x.burst == y.burst && x.sample == y.sample
+         && x.drop == y.drop;
+}
+
+std::string to_string(const publish_limit& x) {
+  std::ostringstream out;
+  out << "rate=" << x.rate << " burst=" << x.burst << " sample=" << x.sample;
+  if (x.drop)
+    out << " drop=true";
+  return out.str();
+}
+
+bool convert(const std::string& str, publish_limit& x) {
+  publish_limit result;
+  std::istringstream in{str};
+  std::string token;
+  while (in >> token) {
+    auto sep = token.find('=');
+    if (sep == std::string::npos)
+      return false;
+    auto key = std::string_view{token}.substr(0, sep);
+    auto val = token.substr(sep + 1);
+    if (key == "rate") {
+      if (!parse_value(val, result.rate))
+        return false;
+    } else if (key == "burst") {
+      if (!parse_value(val, result.burst))
+        return false;
+    } else if (key == "sample") {
+      if (!parse_value(val, result.sample))
+        return false;
+    } else if (key == "drop") {
+      if (!parse_value(val, result.drop))
+        return false;
+    } else {
+      return false;
+    }
+  }
+  x = result;
+  return true;
+}
+
+} // namespace broker
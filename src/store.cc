@@ -13,6 +13,7 @@
 #include <caf/scoped_actor.hpp>
 #include <caf/send.hpp>
 
+#include "broker/detail/key_index.hh"
 #include "broker/expected.hh"
 #include "broker/internal/flare_actor.hh"
 #include "broker/internal/logger.hh"
@@ -288,6 +289,39 @@ request_id store::proxy::keys() {
   return id_;
 }
 
+request_id store::proxy::scan(data first, data last, count limit) {
+  if (!frontend_)
+    return 0;
+  send_as(native(proxy_), native(frontend_), atom::get_v, atom::scan_v,
+          std::move(first), std::move(last), limit, ++id_);
+  return id_;
+}
+
+request_id store::proxy::prefix(data prefix, count limit, data cursor) {
+  auto range = detail::prefix_range(prefix);
+  if (!range)
+    return 0;
+  if (!is<none>(cursor))
+    range->first = std::move(cursor);
+  return scan(std::move(range->first), std::move(range->second), limit);
+}
+
+request_id store::proxy::lookup_containing(address addr) {
+  if (!frontend_)
+    return 0;
+  send_as(native(proxy_), native(frontend_), atom::get_v, atom::containing_v,
+          std::move(addr), ++id_);
+  return id_;
+}
+
+request_id store::proxy::covered_by(subnet net) {
+  if (!frontend_)
+    return 0;
+  send_as(native(proxy_), native(frontend_), atom::get_v, atom::covered_by_v,
+          std::move(net), ++id_);
+  return id_;
+}
+
 worker store::frontend() const {
   return with_state_or([](state_impl& st) { return facade(st.frontend); },
                        []() { return worker{}; });
@@ -395,6 +429,28 @@ expected<data> store::keys() const {
   return fetch(atom::get_v, atom::keys_v);
 }
 
+expected<data> store::scan(data first, data last, count limit) const {
+  return fetch(atom::get_v, atom::scan_v, std::move(first), std::move(last),
+               limit);
+}
+
+expected<data> store::prefix(data prefix, count limit, data cursor) const {
+  auto range = detail::prefix_range(prefix);
+  if (!range)
+    return range.error();
+  if (!is<none>(cursor))
+    range->first = std::move(cursor);
+  return scan(std::move(range->first), std::move(range->second), limit);
+}
+
+expected<data> store::lookup_containing(address addr) const {
+  return fetch(atom::get_v, atom::containing_v, std::move(addr));
+}
+
+expected<data> store::covered_by(subnet net) const {
+  return fetch(atom::get_v, atom::covered_by_v, std::move(net));
+}
+
 bool store::initialized() const noexcept {
   return !state_.expired();
 }
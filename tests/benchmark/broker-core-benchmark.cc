@@ -0,0 +1,347 @@
+#include "broker/configuration.hh"
+#include "broker/defaults.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal/endpoint_access.hh"
+#include "broker/internal/native.hh"
+#include "broker/internal/type_id.hh"
+#include "broker/message.hh"
+
+#include <caf/async/spsc_buffer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/event_based_actor.hpp>
+#include <caf/scheduled_actor/flow.hpp>
+#include <caf/scoped_actor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Measures the throughput of the core actor alone. The benchmark attaches
+// synthetic peers and clients to the core via SPSC buffers, i.e., without any
+// networking or serialization on the transport layer, and then pushes
+// messages from an extra peer through the central merge point of the core.
+
+using namespace broker;
+using namespace std::literals;
+
+namespace atom = broker::internal::atom;
+
+namespace {
+
+// -- parameters ---------------------------------------------------------------
+
+constexpr uint64_t default_peer_count = 16;
+
+constexpr uint64_t default_client_count = 0;
+
+constexpr uint64_t default_message_count = 1'000'000;
+
+constexpr uint64_t default_topic_count = 100;
+
+constexpr uint64_t default_subscription_count = 10;
+
+constexpr uint64_t default_payload_size = 100;
+
+struct parameters {
+  uint64_t peer_count = default_peer_count;
+  uint64_t client_count = default_client_count;
+  uint64_t message_count = default_message_count;
+  uint64_t topic_count = default_topic_count;
+  uint64_t subscription_count = default_subscription_count;
+  uint64_t payload_size = default_payload_size;
+  uint64_t dispatch_shards = defaults::core::dispatch_shards;
+  uint64_t seed = 0xB7E57;
+  std::string distribution = "uniform";
+  bool sweep = false;
+};
+
+void add_options(configuration& cfg, parameters& ps) {
+  cfg.add_option(&ps.peer_count, "peer-count,p",
+                 "number of synthetic peers that receive messages");
+  cfg.add_option(&ps.client_count, "client-count,c",
+                 "number of local clients that receive messages");
+  cfg.add_option(&ps.message_count, "message-count,m", "number of messages");
+  cfg.add_option(&ps.topic_count, "topic-count,t", "number of distinct topics");
+  cfg.add_option(&ps.subscription_count, "subscription-count,s",
+                 "number of topics per peer or client filter");
+  cfg.add_option(&ps.payload_size, "payload-size",
+                 "size of the string in each message");
+  cfg.add_option(&ps.dispatch_shards, "dispatch-shards",
+                 "number of dispatch shards in the core (0 = disabled)");
+  cfg.add_option(&ps.distribution, "distribution,d",
+                 "distribution of topics in messages ('uniform' or 'zipf')");
+  cfg.add_option(&ps.seed, "seed", "seed for the random-number generator");
+  cfg.add_option(&ps.sweep, "sweep",
+                 "runs all powers of two up to peer-count and "
+                 "subscription-count");
+}
+
+// -- utility ------------------------------------------------------------------
+
+std::string topic_name(size_t index) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "/benchmark/t%06zu", index);
+  return buf;
+}
+
+// Picks topic indexes according to the configured distribution.
+class topic_picker {
+public:
+  topic_picker(const parameters& ps, std::minstd_rand& rng) : rng_(rng) {
+    // Zipf with s = 1, i.e., the probability of the k-th topic is
+    // proportional to 1/k.
+    cdf_.resize(ps.topic_count);
+    double sum = 0;
+    for (size_t k = 0; k < cdf_.size(); ++k) {
+      sum += ps.distribution == "zipf" ? 1.0 / static_cast<double>(k + 1) : 1;
+      cdf_[k] = sum;
+    }
+    for (auto& x : cdf_)
+      x /= sum;
+  }
+
+  size_t next() {
+    auto x = dist_(rng_);
+    auto i = std::lower_bound(cdf_.begin(), cdf_.end(), x);
+    return std::min(static_cast<size_t>(std::distance(cdf_.begin(), i)),
+                    cdf_.size() - 1);
+  }
+
+private:
+  std::minstd_rand& rng_;
+  std::uniform_real_distribution<double> dist_{0.0, 1.0};
+  std::vector<double> cdf_;
+};
+
+// Blocks the main thread until all synthetic receivers got their messages.
+class countdown {
+public:
+  explicit countdown(uint64_t n) : remaining_(n) {
+    // nop
+  }
+
+  void arrive() {
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::unique_lock guard{mtx_};
+      cv_.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock guard{mtx_};
+    cv_.wait(guard, [this] { return remaining_.load() == 0; });
+  }
+
+private:
+  std::atomic<uint64_t> remaining_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+using countdown_ptr = std::shared_ptr<countdown>;
+
+void peer_sink(caf::event_based_actor* self,
+               caf::async::consumer_resource<node_message> res,
+               countdown_ptr done) {
+  self->make_observable()
+    .from_resource(std::move(res))
+    .for_each([done](const node_message& msg) {
+      if (get_type(msg) == packed_message_type::data
+          && get_topic(msg).string().rfind("/benchmark/", 0) == 0)
+        done->arrive();
+    });
+}
+
+void client_sink(caf::event_based_actor* self,
+                 caf::async::consumer_resource<data_message> res,
+                 countdown_ptr done) {
+  self->make_observable()
+    .from_resource(std::move(res))
+    .for_each([done](const data_message&) { done->arrive(); });
+}
+
+void peer_source(caf::event_based_actor* self,
+                 std::vector<node_message> msgs,
+                 caf::async::producer_resource<node_message> res) {
+  self->make_observable().from_container(std::move(msgs)).subscribe(res);
+}
+
+auto make_node_buffer() {
+  return caf::async::make_spsc_buffer_resource<node_message>();
+}
+
+// -- benchmark ----------------------------------------------------------------
+
+struct run_result {
+  uint64_t deliveries;
+  std::chrono::nanoseconds elapsed;
+};
+
+run_result run(const parameters& ps, uint64_t peer_count,
+               uint64_t subscription_count) {
+  std::minstd_rand rng{static_cast<uint32_t>(ps.seed)};
+  topic_picker picker{ps, rng};
+  configuration cfg;
+  cfg.set_u64("broker.core.dispatch-shards", ps.dispatch_shards);
+  endpoint ep{std::move(cfg)};
+  auto& sys = internal::endpoint_access{&ep}.sys();
+  auto core = internal::native(ep.core());
+  // Pick the subscriptions for all receivers.
+  auto receiver_count = peer_count + ps.client_count;
+  std::vector<size_t> subscribers(ps.topic_count);
+  std::vector<filter_type> filters(receiver_count);
+  std::vector<size_t> indexes(ps.topic_count);
+  std::iota(indexes.begin(), indexes.end(), size_t{0});
+  auto n = std::min(subscription_count, ps.topic_count);
+  for (auto& filter : filters) {
+    std::shuffle(indexes.begin(), indexes.end(), rng);
+    for (size_t i = 0; i < n; ++i) {
+      filter.emplace_back(topic_name(indexes[i]));
+      ++subscribers[indexes[i]];
+    }
+  }
+  // Generate the messages and count how many deliveries we expect.
+  auto publisher_id = endpoint_id::random(static_cast<unsigned>(rng()));
+  caf::byte_buffer payload;
+  {
+    caf::binary_serializer sink{nullptr, payload};
+    std::ignore = sink.apply(data{std::string(ps.payload_size, 'x')});
+  }
+  auto payload_bytes = std::vector<std::byte>{
+    reinterpret_cast<std::byte*>(payload.data()),
+    reinterpret_cast<std::byte*>(payload.data() + payload.size())};
+  std::vector<node_message> msgs;
+  msgs.reserve(ps.message_count);
+  uint64_t deliveries = 0;
+  for (size_t i = 0; i < ps.message_count; ++i) {
+    auto index = picker.next();
+    deliveries += subscribers[index];
+    msgs.emplace_back(make_node_message(
+      publisher_id, endpoint_id::nil(),
+      make_packed_message(packed_message_type::data, defaults::ttl,
+                          topic{topic_name(index)}, payload_bytes)));
+  }
+  auto done = std::make_shared<countdown>(deliveries);
+  // Attach the receivers. We keep the unused ends of the buffers alive until
+  // the end of the run, because the core drops peers when closing them.
+  using node_consumer_res = caf::async::consumer_resource<node_message>;
+  using node_producer_res = caf::async::producer_resource<node_message>;
+  std::vector<node_consumer_res> unused_inputs;
+  std::vector<node_producer_res> unused_outputs;
+  caf::scoped_actor self{sys};
+  auto add_peer = [&](endpoint_id id, const filter_type& filter,
+                      node_consumer_res in, node_producer_res out) {
+    self
+      ->request(core, caf::infinite, atom::peer_v, id,
+                network_info{to_string(id), 42}, filter, std::move(in),
+                std::move(out))
+      .receive([] {},
+               [](const caf::error& err) {
+                 std::cerr << "*** failed to add peer: " << to_string(err)
+                           << '\n';
+                 abort();
+               });
+  };
+  for (size_t i = 0; i < receiver_count; ++i) {
+    if (i < peer_count) {
+      auto [con1, prod1] = make_node_buffer();
+      auto [con2, prod2] = make_node_buffer();
+      sys.spawn(peer_sink, con2, done);
+      add_peer(endpoint_id::random(static_cast<unsigned>(rng())), filters[i],
+               con1, prod2);
+      unused_outputs.emplace_back(prod1);
+    } else {
+      auto [con, prod] = caf::async::make_spsc_buffer_resource<data_message>();
+      sys.spawn(client_sink, con, done);
+      self->send(core, filters[i], prod);
+    }
+  }
+  // Attach the publisher with an empty filter and wait for all deliveries.
+  auto [con1, prod1] = make_node_buffer();
+  auto [con2, prod2] = make_node_buffer();
+  add_peer(publisher_id, filter_type{}, con1, prod2);
+  unused_inputs.emplace_back(con2);
+  auto start = std::chrono::steady_clock::now();
+  sys.spawn(peer_source, std::move(msgs), prod1);
+  if (deliveries > 0)
+    done->wait();
+  auto stop = std::chrono::steady_clock::now();
+  return {deliveries, stop - start};
+}
+
+void print_header() {
+  std::cout << std::setw(8) << "peers" << std::setw(8) << "clients"
+            << std::setw(8) << "subs" << std::setw(12) << "messages"
+            << std::setw(12) << "deliveries" << std::setw(14) << "msgs/s"
+            << std::setw(12) << "ns/msg" << '\n';
+}
+
+void print_row(const parameters& ps, uint64_t peer_count,
+               uint64_t subscription_count, const run_result& res) {
+  auto ns = static_cast<double>(res.elapsed.count());
+  auto msgs = static_cast<double>(ps.message_count);
+  std::cout << std::setw(8) << peer_count << std::setw(8) << ps.client_count
+            << std::setw(8) << subscription_count << std::setw(12)
+            << ps.message_count << std::setw(12) << res.deliveries
+            << std::setw(14) << std::fixed << std::setprecision(0)
+            << msgs / (ns / 1e9) << std::setw(12) << std::setprecision(1)
+            << ns / msgs << std::endl;
+}
+
+// Returns 1, 2, 4, ... up to `max` (inclusive) when sweeping or just `max`.
+std::vector<uint64_t> steps(uint64_t max, bool sweep) {
+  std::vector<uint64_t> result;
+  if (sweep) {
+    for (uint64_t i = 1; i < max; i *= 2)
+      result.emplace_back(i);
+  }
+  result.emplace_back(max);
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  endpoint::system_guard sys_guard;
+  // Parse CLI / config file.
+  configuration cfg{skip_init};
+  parameters params;
+  add_options(cfg, params);
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n";
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed())
+    return EXIT_SUCCESS;
+  if (cfg.remainder().size() > 0) {
+    std::cerr << "*** too many arguments (did not expect any)\n\n";
+    return EXIT_FAILURE;
+  }
+  if (params.topic_count == 0
+      || (params.distribution != "uniform" && params.distribution != "zipf")) {
+    std::cerr << "*** topic-count must be > 0 and distribution must be "
+                 "'uniform' or 'zipf'\n\n";
+    return EXIT_FAILURE;
+  }
+  print_header();
+  for (auto peer_count : steps(params.peer_count, params.sweep))
+    for (auto subscription_count : steps(params.subscription_count,
+                                         params.sweep))
+      print_row(params, peer_count, subscription_count,
+                run(params, peer_count, subscription_count));
+}
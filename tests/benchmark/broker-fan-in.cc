@@ -0,0 +1,263 @@
+#include "broker/configuration.hh"
+#include "broker/defaults.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal/wire_format.hh"
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/byte_buffer.hpp>
+#include <caf/net/tcp_stream_socket.hpp>
+#include <caf/uri.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures how long an endpoint takes to complete peerings with many remote
+// nodes that connect at the same time, e.g., when hundreds of workers
+// reconnect to a manager after a restart. The remote nodes are synthetic: a
+// few client threads open all connections, run the Broker handshake on each
+// of them and then keep the sockets open without sending further messages.
+
+using namespace broker;
+using namespace std::literals;
+
+namespace wire_format = broker::internal::wire_format;
+
+using caf::net::stream_socket;
+
+namespace {
+
+// -- parameters ---------------------------------------------------------------
+
+constexpr uint64_t default_peer_count = 1'000;
+
+constexpr uint64_t default_client_threads = 4;
+
+struct parameters {
+  uint64_t peer_count = default_peer_count;
+  uint64_t client_threads = default_client_threads;
+  uint64_t connector_threads = defaults::connector::threads;
+};
+
+void add_options(configuration& cfg, parameters& ps) {
+  cfg.add_option(&ps.peer_count, "peer-count,p",
+                 "number of synthetic peers that connect to the endpoint");
+  cfg.add_option(&ps.client_threads, "client-threads,t",
+                 "number of threads for driving the synthetic peers");
+  cfg.add_option(&ps.connector_threads, "connector-threads,c",
+                 "number of connector threads in the endpoint");
+}
+
+// -- synthetic peers ----------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+template <class T>
+bool send_msg(stream_socket fd, const T& msg) {
+  caf::byte_buffer buf;
+  caf::binary_serializer sink{nullptr, buf};
+  uint32_t len = 0;
+  if (!sink.apply(len) || !wire_format::encode(sink, msg))
+    return false;
+  len = static_cast<uint32_t>(buf.size() - 4);
+  sink.seek(0);
+  if (!sink.apply(len))
+    return false;
+  return caf::net::write(fd, buf) == static_cast<ptrdiff_t>(buf.size());
+}
+
+bool read_all(stream_socket fd, caf::byte_buffer& buf) {
+  size_t pos = 0;
+  while (pos < buf.size()) {
+    auto res = caf::net::read(fd, caf::make_span(buf).subspan(pos));
+    if (res <= 0)
+      return false;
+    pos += static_cast<size_t>(res);
+  }
+  return true;
+}
+
+wire_format::var_msg read_msg(stream_socket fd) {
+  caf::byte_buffer buf;
+  buf.resize(4);
+  if (!read_all(fd, buf))
+    return wire_format::make_var_msg_error(ec::socket_disconnected,
+                                           "failed to read from socket");
+  uint32_t len = 0;
+  caf::binary_deserializer src{nullptr, buf};
+  if (!src.apply(len) || len == 0)
+    return wire_format::make_var_msg_error(ec::invalid_message,
+                                           "invalid message size");
+  buf.resize(len);
+  if (!read_all(fd, buf))
+    return wire_format::make_var_msg_error(ec::socket_disconnected,
+                                           "failed to read from socket");
+  return wire_format::decode(buf);
+}
+
+/// A remote node that peers with the endpoint under test.
+struct synthetic_peer {
+  endpoint_id id;
+  stream_socket fd;
+  bool done = false;
+
+  /// Reads messages until the peer needs to wait for the next response of
+  /// the endpoint after sending a message.
+  /// @returns `false` on error, `true` otherwise.
+  bool advance() {
+    for (;;) {
+      auto msg = read_msg(fd);
+      switch (msg.index()) {
+        case wire_format::probe_index:
+        case wire_format::version_select_index:
+          // Keep reading.
+          break;
+        case wire_format::hello_index:
+          // The endpoint has the smaller ID and waits for us to proceed as
+          // originator.
+          return send_msg(fd, wire_format::make_version_select_msg(id))
+                 && send_msg(fd, wire_format::v1::make_originator_syn_msg({}));
+        case wire_format::originator_syn_index:
+          return send_msg(fd,
+                          wire_format::v1::make_responder_syn_ack_msg({}));
+        case wire_format::responder_syn_ack_index:
+          done = true;
+          return send_msg(fd, wire_format::v1::make_originator_ack_msg());
+        case wire_format::originator_ack_index:
+          done = true;
+          return true;
+        default:
+          std::cerr << "*** handshake failed: " << wire_format::stringify(msg)
+                    << '\n';
+          return false;
+      }
+    }
+  }
+};
+
+/// Connects all `peers` to `port` and runs the handshakes. Drives all peers
+/// in lockstep to keep all handshakes of this thread in flight at the same
+/// time.
+bool run_peers(std::vector<synthetic_peer>& peers, uint16_t port) {
+  caf::uri::authority_type authority;
+  authority.host = "127.0.0.1"s;
+  authority.port = port;
+  for (auto& peer : peers) {
+    auto fd = caf::net::make_connected_tcp_stream_socket(authority);
+    if (!fd) {
+      std::cerr << "*** failed to connect: " << to_string(fd.error())
+                << " (raise the file descriptor limit?)\n";
+      return false;
+    }
+    peer.fd = *fd;
+    if (!send_msg(peer.fd, wire_format::make_hello_msg(peer.id)))
+      return false;
+  }
+  auto pending = peers.size();
+  while (pending > 0) {
+    for (auto& peer : peers) {
+      if (peer.done)
+        continue;
+      if (!peer.advance())
+        return false;
+      if (peer.done)
+        --pending;
+    }
+  }
+  return true;
+}
+
+// -- benchmark ----------------------------------------------------------------
+
+using fractional_ms = std::chrono::duration<double, std::milli>;
+
+int run(configuration cfg, const parameters& ps) {
+  cfg.set_u64("broker.connector.threads", ps.connector_threads);
+  endpoint ep{std::move(cfg)};
+  auto port = ep.listen("127.0.0.1", 0);
+  if (port == 0) {
+    std::cerr << "*** failed to open a local port\n";
+    return EXIT_FAILURE;
+  }
+  // Assign the peers to the client threads.
+  auto num_threads = std::max(ps.client_threads, uint64_t{1});
+  std::vector<std::vector<synthetic_peer>> groups;
+  groups.resize(num_threads);
+  for (uint64_t i = 0; i < ps.peer_count; ++i)
+    groups[i % num_threads].push_back(synthetic_peer{endpoint_id::random()});
+  // Fire off all connections at once.
+  std::atomic<bool> failed = false;
+  std::atomic<int64_t> handshakes_done_ns = 0;
+  auto t0 = clock_type::now();
+  std::vector<std::thread> threads;
+  for (auto& group : groups) {
+    threads.emplace_back([&, port] {
+      if (!run_peers(group, port)) {
+        failed = true;
+        return;
+      }
+      auto t = (clock_type::now() - t0).count();
+      auto prev = handshakes_done_ns.load();
+      while (prev < t && !handshakes_done_ns.compare_exchange_weak(prev, t))
+        ; // nop
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  if (failed) {
+    std::cerr << "*** synthetic peers failed to connect\n";
+    return EXIT_FAILURE;
+  }
+  // Wait until the endpoint has added all peers to its routing table.
+  for (auto& group : groups) {
+    for (auto& peer : group) {
+      if (!ep.await_peer(peer.id, 60s)) {
+        std::cerr << "*** endpoint failed to peer with " << peer.id << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  auto t1 = clock_type::now();
+  auto handshakes = clock_type::duration{handshakes_done_ns.load()};
+  printf("%12s %12s %16s %16s\n", "peers", "connectors", "handshakes (ms)",
+         "peered (ms)");
+  printf("%12llu %12llu %16.2f %16.2f\n",
+         static_cast<unsigned long long>(ps.peer_count),
+         static_cast<unsigned long long>(ps.connector_threads),
+         fractional_ms{handshakes}.count(), fractional_ms{t1 - t0}.count());
+  for (auto& group : groups)
+    for (auto& peer : group)
+      caf::net::close(peer.fd);
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  endpoint::system_guard sys_guard;
+  // Parse CLI / config file.
+  configuration cfg{skip_init};
+  parameters params;
+  add_options(cfg, params);
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << "\n\n";
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed())
+    return EXIT_SUCCESS;
+  if (cfg.remainder().size() > 0) {
+    std::cerr << "*** too many arguments (did not expect any)\n\n";
+    return EXIT_FAILURE;
+  }
+  return run(std::move(cfg), params);
+}
@@ -0,0 +1,107 @@
+#define SUITE arena_data
+
+#include "broker/arena_data.hh"
+
+#include "test.hh"
+
+#include <caf/binary_serializer.hpp>
+
+#include <string>
+#include <vector>
+
+#include "broker/data_view.hh"
+#include "broker/defaults.hh"
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+struct fixture {
+  arena_message decode(const data& x) {
+    caf::byte_buffer buf;
+    caf::binary_serializer sink{nullptr, buf};
+    if (!sink.apply(x))
+      FAIL("failed to serialize " << x);
+    auto msg = make_packed_message(packed_message_type::data, defaults::ttl,
+                                   "foo/bar"_t, std::move(buf));
+    auto res = arena_message::make(std::move(msg));
+    if (!res)
+      FAIL("failed to decode " << x);
+    return std::move(*res);
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(arena_data_tests, fixture)
+
+TEST(arena messages decode the entire content) {
+  auto addr = address{};
+  CHECK(convert("10.0.0.1"s, addr));
+  auto x = data{vector{
+    data{},
+    true,
+    count{1},
+    integer{-1},
+    real{0.25},
+    "str"s,
+    addr,
+    subnet{addr, 8},
+    port{53, port::protocol::udp},
+    timestamp{timespan{1}},
+    timespan{2},
+    enum_value{"e"},
+    set{"a", "b"},
+    table{{1, "one"}, {2, vector{"two"}}},
+    vector{vector{}, set{}, table{}, ""s},
+  }};
+  auto msg = decode(x);
+  CHECK_EQUAL(msg.get_topic(), "foo/bar"_t);
+  CHECK_EQUAL(msg.value().to_data(), x);
+  CHECK_EQUAL(get_data(msg.to_data_message()), x);
+  CHECK_EQUAL(to_string(msg.value()), to_string(x));
+}
+
+TEST(arena data grants random access to container elements) {
+  auto msg = decode(vector{1, "two", table{{"k", count{3}}}});
+  auto xs = get_if<arena_vector>(msg.value());
+  REQUIRE(xs != nullptr);
+  REQUIRE_EQUAL(xs->size(), 3u);
+  CHECK_EQUAL(*get_if<integer>((*xs)[0]), 1);
+  CHECK(*get_if<std::string_view>((*xs)[1]) == "two"sv);
+  auto tbl = get_if<arena_table>((*xs)[2]);
+  REQUIRE(tbl != nullptr);
+  REQUIRE_EQUAL(tbl->size(), 1u);
+  for (auto [key, val] : *tbl) {
+    CHECK(*get_if<std::string_view>(key) == "k"sv);
+    CHECK_EQUAL(*get_if<count>(val), 3u);
+  }
+}
+
+TEST(arena messages use a single block for large messages) {
+  vector xs;
+  for (int i = 0; i < 1000; ++i)
+    xs.emplace_back(std::string(100, 'x'));
+  auto msg = decode(xs);
+  CHECK_GREATER_EQUAL(msg.arena_size(), 1000u * 100u);
+  CHECK_EQUAL(msg.value().to_data(), data{xs});
+}
+
+TEST(copies share the arena) {
+  auto msg1 = decode(vector{"hello"s});
+  auto msg2 = msg1;
+  msg1 = arena_message{};
+  CHECK(!msg1);
+  REQUIRE(msg2);
+  CHECK_EQUAL(msg2.value().to_data(), data{vector{"hello"s}});
+}
+
+TEST(decoding rejects malformed input) {
+  std::vector<std::byte> bytes{std::byte{0xFF}};
+  auto msg = make_packed_message(packed_message_type::data, defaults::ttl,
+                                 "foo"_t, bytes);
+  CHECK(!arena_message::make(std::move(msg)));
+}
+
+FIXTURE_SCOPE_END()
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -22,9 +23,11 @@
 #include "broker/detail/abstract_backend.hh"
 #include "broker/detail/assert.hh"
 #include "broker/detail/filesystem.hh"
+#include "broker/detail/key_index.hh"
 #include "broker/detail/make_backend.hh"
 #include "broker/detail/memory_backend.hh"
 #include "broker/detail/sqlite_backend.hh"
+#include "broker/detail/wal_backend.hh"
 #include "broker/error.hh"
 #include "broker/expected.hh"
 #include "broker/snapshot.hh"
@@ -49,6 +52,9 @@ public:
     path += ".sqlite";
     paths_.push_back(path);
     backends_.push_back(detail::make_backend(backend::sqlite, opts));
+    path += ".wal";
+    paths_.push_back(path);
+    backends_.push_back(detail::make_backend(backend::wal, opts));
   }
 
   ~meta_backend() {
@@ -93,6 +99,13 @@ public:
     });
   }
 
+  expected<std::vector<data>> expire_due(timestamp current_time,
+                                         size_t limit) override {
+    return perform<std::vector<data>>([&](detail::abstract_backend& backend) {
+      return backend.expire_due(current_time, limit);
+    });
+  }
+
   expected<data> get(const data& key) const override {
     return perform<data>(
       [&](detail::abstract_backend& backend) { return backend.get(key); });
@@ -109,6 +122,25 @@ public:
       [&](detail::abstract_backend& backend) { return backend.keys(); });
   }
 
+  expected<data> scan(const data& first, const data& last,
+                      count limit) const override {
+    return perform<data>([&](detail::abstract_backend& backend) {
+      return backend.scan(first, last, limit);
+    });
+  }
+
+  expected<data> lookup_containing(const address& addr) const override {
+    return perform<data>([&](detail::abstract_backend& backend) {
+      return backend.lookup_containing(addr);
+    });
+  }
+
+  expected<data> covered_by(const subnet& net) const override {
+    return perform<data>([&](detail::abstract_backend& backend) {
+      return backend.covered_by(net);
+    });
+  }
+
   expected<bool> exists(const data& key) const override {
     return perform<bool>(
       [&](detail::abstract_backend& backend) { return backend.exists(key); });
@@ -291,6 +323,24 @@ TEST(expiration without expiry) {
   REQUIRE(!*expire); // no expiry with key associated
 }
 
+TEST(expire_due removes due entries in the order of their expiry) {
+  using namespace std::chrono;
+  auto t0 = broker::now();
+  RUN(backend->put("a", 1, t0 - seconds{1}));
+  RUN(backend->put("b", 2, t0 - seconds{3}));
+  RUN(backend->put("c", 3, t0 - seconds{2}));
+  RUN(backend->put("d", 4, t0 + seconds{10}));
+  RUN(backend->put("e", 5));
+  CHECK_EQUAL(RUN(backend->expire_due(t0, 2)),
+              std::vector<data>({data{"b"}, data{"c"}}));
+  CHECK_EQUAL(RUN(backend->expire_due(t0, 10)), std::vector<data>{data{"a"}});
+  CHECK_EQUAL(RUN(backend->expire_due(t0, 10)), std::vector<data>{});
+  CHECK_EQUAL(RUN(backend->size()), 2u);
+  MESSAGE("entries become due once their expiry passes");
+  CHECK_EQUAL(RUN(backend->expire_due(t0 + seconds{10}, 10)),
+              std::vector<data>{data{"d"}});
+}
+
 TEST(size / snapshot) {
   using namespace std::chrono;
   auto put = backend->put("foo", "bar");
@@ -308,4 +358,242 @@ TEST(size / snapshot) {
   CHECK_EQUAL(ss->count("foo"), 1u);
 }
 
+TEST(scan) {
+  for (count i = 0; i < 10; ++i) {
+    RUN(backend->put(i, i * 10));
+    RUN(backend->put("key-" + std::to_string(i), i));
+  }
+  RUN(backend->put(integer{-1}, "negative"));
+  MESSAGE("scans stay within the type of the first key");
+  CHECK_EQUAL(RUN(backend->scan(count{7}, nil, 10)),
+              data(vector{table{{count{7}, count{70}},
+                                {count{8}, count{80}},
+                                {count{9}, count{90}}},
+                          nil}));
+  CHECK_EQUAL(RUN(backend->scan(integer{-5}, nil, 10)),
+              data(vector{table{{integer{-1}, "negative"}}, nil}));
+  MESSAGE("the last key is exclusive");
+  CHECK_EQUAL(RUN(backend->scan(count{2}, count{4}, 10)),
+              data(vector{table{{count{2}, count{20}},
+                                {count{3}, count{30}}},
+                          nil}));
+  MESSAGE("the cursor resumes the scan");
+  auto next_page = [this](data first, size_t expected_size) {
+    auto page = RUN(backend->scan(first, nil, 4));
+    auto& xs = get<vector>(page);
+    REQUIRE_EQUAL(xs.size(), 2u);
+    CHECK_EQUAL(get<table>(xs[0]).size(), expected_size);
+    return xs[1];
+  };
+  auto cursor = next_page("key-", 4);
+  CHECK_EQUAL(cursor, data{"key-4"});
+  cursor = next_page(cursor, 4);
+  CHECK_EQUAL(cursor, data{"key-8"});
+  cursor = next_page(cursor, 2);
+  CHECK_EQUAL(cursor, data{});
+  MESSAGE("a limit of zero selects nothing and ends the scan");
+  CHECK_EQUAL(RUN(backend->scan(count{7}, nil, 0)),
+              data(vector{table{}, nil}));
+  MESSAGE("erased keys disappear from the index");
+  RUN(backend->erase(count{8}));
+  CHECK_EQUAL(RUN(backend->scan(count{7}, nil, 10)),
+              data(vector{table{{count{7}, count{70}},
+                                {count{9}, count{90}}},
+                          nil}));
+}
+
+TEST(prefix ranges) {
+  auto prefix = [](data x) { return *detail::prefix_range(x); };
+  CHECK_EQUAL(prefix("foo").second, data{"fop"});
+  CHECK_EQUAL(prefix("").second, nil);
+  CHECK_EQUAL(prefix("a\xFF").second, data{"b"});
+  auto net = *to<subnet>("10.0.0.0/8");
+  CHECK_EQUAL(prefix(net).first, data{*to<address>("10.0.0.0")});
+  CHECK_EQUAL(prefix(net).second, data{*to<address>("11.0.0.0")});
+  CHECK_EQUAL(detail::prefix_range(42).error(), ec::type_clash);
+  MESSAGE("subnet prefixes select all addresses in the subnet");
+  for (auto addr : {"10.0.0.1", "10.1.2.3", "11.0.0.1", "9.255.255.255"})
+    RUN(backend->put(*to<address>(addr), addr));
+  auto [first, last] = prefix(net);
+  CHECK_EQUAL(RUN(backend->scan(first, last, 10)),
+              data(vector{table{{*to<address>("10.0.0.1"), "10.0.0.1"},
+                                {*to<address>("10.1.2.3"), "10.1.2.3"}},
+                          nil}));
+}
+
+TEST(subnet lookups) {
+  auto addr = [](const char* str) { return *to<address>(str); };
+  auto net = [](const char* str) { return *to<subnet>(str); };
+  for (auto str : {"10.0.0.0/8", "10.1.0.0/16", "10.1.2.0/24", "192.168.0.0/16",
+                   "2001:db8::/32"})
+    RUN(backend->put(net(str), str));
+  RUN(backend->put(addr("10.1.2.3"), "not a subnet"));
+  MESSAGE("lookups select the most specific subnet");
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("10.1.2.3"))),
+              data(vector{net("10.1.2.0/24"), "10.1.2.0/24"}));
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("10.1.3.1"))),
+              data(vector{net("10.1.0.0/16"), "10.1.0.0/16"}));
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("10.200.0.1"))),
+              data(vector{net("10.0.0.0/8"), "10.0.0.0/8"}));
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("2001:db8::1"))),
+              data(vector{net("2001:db8::/32"), "2001:db8::/32"}));
+  CHECK_EQUAL(backend->lookup_containing(addr("11.0.0.1")).error(),
+              ec::no_such_key);
+  MESSAGE("covered_by selects all subsets of a subnet");
+  CHECK_EQUAL(RUN(backend->covered_by(net("10.1.0.0/16"))),
+              data(table{{net("10.1.0.0/16"), "10.1.0.0/16"},
+                         {net("10.1.2.0/24"), "10.1.2.0/24"}}));
+  CHECK_EQUAL(RUN(backend->covered_by(net("192.0.0.0/2"))),
+              data(table{{net("192.168.0.0/16"), "192.168.0.0/16"}}));
+  CHECK_EQUAL(RUN(backend->covered_by(net("10.1.2.128/25"))), data(table{}));
+  MESSAGE("erased subnets disappear from the index");
+  RUN(backend->erase(net("10.1.2.0/24")));
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("10.1.2.3"))),
+              data(vector{net("10.1.0.0/16"), "10.1.0.0/16"}));
+  RUN(backend->erase(net("10.1.0.0/16")));
+  CHECK_EQUAL(RUN(backend->lookup_containing(addr("10.1.2.3"))),
+              data(vector{net("10.0.0.0/8"), "10.0.0.0/8"}));
+  RUN(backend->clear());
+  CHECK_EQUAL(backend->lookup_containing(addr("10.1.2.3")).error(),
+              ec::no_such_key);
+}
+
+FIXTURE_SCOPE_END()
+
+namespace {
+
+struct wal_fixture {
+  wal_fixture() {
+    directory = detail::make_temp_file_name();
+    detail::remove(directory);
+  }
+
+  ~wal_fixture() {
+    detail::remove_all(directory);
+  }
+
+  auto make_wal_backend(count compact_bytes = 1024 * 1024,
+                        count commit_bytes = 1024 * 1024) {
+    backend_options opts;
+    opts["path"] = directory;
+    opts["compact_bytes"] = compact_bytes;
+    opts["commit_bytes"] = commit_bytes;
+    return std::make_unique<detail::wal_backend>(std::move(opts));
+  }
+
+  std::string directory;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(wal_backend_tests, wal_fixture)
+
+TEST(the WAL backend restores its state after a restart) {
+  {
+    auto uut = make_wal_backend();
+    REQUIRE(!uut->init_failed());
+    REQUIRE(uut->put("foo", 1));
+    REQUIRE(uut->put("bar", set{1, 2}));
+    REQUIRE(uut->add("foo", 41, data::type::integer));
+    REQUIRE(uut->subtract("bar", 2));
+    REQUIRE(uut->put("baz", "unused"));
+    REQUIRE(uut->erase("baz"));
+  }
+  auto uut = make_wal_backend();
+  REQUIRE(!uut->init_failed());
+  CHECK_EQUAL(value_of(uut->get("foo")), data{42});
+  CHECK_EQUAL(value_of(uut->get("bar")), data{set{1}});
+  CHECK_EQUAL(*uut->exists("baz"), false);
+  CHECK_EQUAL(*uut->size(), 2u);
+  MESSAGE("the backend starts a new log on each startup");
+  CHECK_EQUAL(uut->generation(), 1u);
+}
+
+TEST(the WAL backend restores its state from snapshot plus log) {
+  {
+    auto uut = make_wal_backend(0);
+    REQUIRE(!uut->init_failed());
+    for (count i = 0; i < 100; ++i)
+      REQUIRE(uut->put(i, i));
+    REQUIRE(uut->compact());
+    CHECK(detail::is_file(
+      detail::wal_backend::format::snapshot_file_name(directory)));
+    CHECK(!detail::is_file(
+      detail::wal_backend::format::log_file_name(directory, 0)));
+    REQUIRE(uut->erase(count{0}));
+  }
+  auto uut = make_wal_backend();
+  REQUIRE(!uut->init_failed());
+  CHECK_EQUAL(*uut->size(), 99u);
+  CHECK_EQUAL(*uut->exists(count{0}), false);
+  CHECK_EQUAL(value_of(uut->get(count{99})), data{count{99}});
+}
+
+TEST(the WAL backend compacts the log only on flush) {
+  {
+    auto uut = make_wal_backend(1, 1);
+    REQUIRE(!uut->init_failed());
+    REQUIRE(uut->put("foo", 1));
+    REQUIRE(uut->put("bar", 2));
+    CHECK(!detail::is_file(
+      detail::wal_backend::format::snapshot_file_name(directory)));
+    CHECK_EQUAL(uut->generation(), 0u);
+    REQUIRE(uut->flush());
+    CHECK(detail::is_file(
+      detail::wal_backend::format::snapshot_file_name(directory)));
+    CHECK(uut->generation() > 0);
+  }
+  auto uut = make_wal_backend();
+  REQUIRE(!uut->init_failed());
+  CHECK_EQUAL(*uut->size(), 2u);
+  CHECK_EQUAL(value_of(uut->get("foo")), data{1});
+  CHECK_EQUAL(value_of(uut->get("bar")), data{2});
+}
+
+TEST(the WAL backend logs only changes that it applied) {
+  {
+    auto uut = make_wal_backend();
+    REQUIRE(!uut->init_failed());
+    REQUIRE(uut->put("foo", "bar"));
+    CHECK(!uut->add("foo", 1, data::type::integer));
+    CHECK(!uut->subtract("foo", 1));
+    auto expired = uut->expire("foo", broker::now());
+    CHECK(expired && !*expired);
+    REQUIRE(uut->put("baz", 1));
+  }
+  auto uut = make_wal_backend();
+  REQUIRE(!uut->init_failed());
+  CHECK_EQUAL(*uut->size(), 2u);
+  CHECK_EQUAL(value_of(uut->get("foo")), data{"bar"});
+  CHECK_EQUAL(value_of(uut->get("baz")), data{1});
+}
+
+TEST(the WAL backend ignores a truncated record at the end of a log) {
+  std::string fname;
+  {
+    auto uut = make_wal_backend();
+    REQUIRE(!uut->init_failed());
+    REQUIRE(uut->put("foo", 1));
+    REQUIRE(uut->put("bar", 2));
+    fname = detail::wal_backend::format::log_file_name(directory,
+                                                        uut->generation());
+  }
+  // Simulate a crash in the middle of writing the next record.
+  auto out = std::fopen(fname.c_str(), "ab");
+  REQUIRE(out != nullptr);
+  const char partial_header[] = {0x20, 0, 0};
+  std::fwrite(partial_header, 1, sizeof(partial_header), out);
+  std::fclose(out);
+  {
+    auto uut = make_wal_backend();
+    REQUIRE(!uut->init_failed());
+    CHECK_EQUAL(value_of(uut->get("foo")), data{1});
+    CHECK_EQUAL(value_of(uut->get("bar")), data{2});
+    REQUIRE(uut->put("baz", 3));
+  }
+  auto uut = make_wal_backend();
+  REQUIRE(!uut->init_failed());
+  CHECK_EQUAL(*uut->size(), 3u);
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,188 @@
+#define SUITE data_view
+
+#include "broker/data_view.hh"
+
+#include "test.hh"
+
+#include <caf/binary_serializer.hpp>
+
+#include <string>
+#include <vector>
+
+#include "broker/defaults.hh"
+#include "broker/zeek.hh"
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::byte> serialize(const data& x) {
+  caf::byte_buffer buf;
+  caf::binary_serializer sink{nullptr, buf};
+  if (!sink.apply(x))
+    FAIL("failed to serialize " << x);
+  return buf;
+}
+
+// Serializes `depth` nested vectors with a single element each around `none`.
+std::vector<std::byte> make_nested_vectors(size_t depth) {
+  std::vector<std::byte> result;
+  for (size_t i = 0; i < depth; ++i) {
+    result.emplace_back(static_cast<std::byte>(data::type::vector));
+    result.emplace_back(std::byte{1});
+  }
+  result.emplace_back(static_cast<std::byte>(data::type::none));
+  return result;
+}
+
+struct fixture {
+  data_envelope make_envelope(const data& x) {
+    auto res = data_envelope::make("foo/bar"_t, serialize(x));
+    if (!res)
+      FAIL("failed to create an envelope for " << x);
+    return std::move(*res);
+  }
+
+  // Round-trips `x` through an envelope.
+  data round_trip(const data& x) {
+    return make_envelope(x).to_data();
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(data_view_tests, fixture)
+
+TEST(views to primitive values return the serialized value) {
+  CHECK(make_envelope(data{}).value().is_none());
+  CHECK_EQUAL(make_envelope(true).value().to_boolean(), true);
+  CHECK_EQUAL(make_envelope(count{42}).value().to_count(), 42u);
+  CHECK_EQUAL(make_envelope(integer{-42}).value().to_integer(), -42);
+  CHECK_EQUAL(make_envelope(real{4.2}).value().to_real(), 4.2);
+  CHECK(make_envelope("hello"s).value().to_string_view() == "hello"sv);
+  auto addr = address{};
+  CHECK(convert("192.168.1.1"s, addr));
+  CHECK_EQUAL(make_envelope(addr).value().to_address(), addr);
+  auto sn = subnet{addr, 16};
+  CHECK_EQUAL(make_envelope(sn).value().to_subnet(), sn);
+  auto pt = port{8080, port::protocol::tcp};
+  CHECK_EQUAL(make_envelope(pt).value().to_port(), pt);
+  auto ts = timestamp{timespan{123456789}};
+  CHECK_EQUAL(make_envelope(ts).value().to_timestamp(), ts);
+  CHECK_EQUAL(make_envelope(timespan{-5}).value().to_timespan(), timespan{-5});
+  CHECK(make_envelope(enum_value{"foo"}).value().to_enum_name() == "foo"sv);
+}
+
+TEST(get_if returns nullopt for mismatched types) {
+  auto env = make_envelope(count{42});
+  auto val = env.value();
+  CHECK(is<count>(val));
+  CHECK(!is<integer>(val));
+  CHECK_EQUAL(get_if<count>(val), std::optional<count>{42});
+  CHECK(!get_if<integer>(val));
+  CHECK(!get_if<std::string>(val));
+}
+
+TEST(views iterate vectors sets and tables in place) {
+  auto xs = vector{1, "two", 3.0, vector{4, 5}};
+  auto xs_env = make_envelope(xs);
+  auto xs_view = xs_env.value().to_vector();
+  REQUIRE_EQUAL(xs_view.size(), 4u);
+  CHECK_EQUAL(xs_view[0].to_integer(), 1);
+  CHECK(xs_view[1].to_string_view() == "two"sv);
+  CHECK_EQUAL(xs_view[2].to_real(), 3.0);
+  CHECK_EQUAL(xs_view[3].to_vector().size(), 2u);
+  vector materialized;
+  for (auto x : xs_view)
+    materialized.emplace_back(x.to_data());
+  CHECK_EQUAL(materialized, xs);
+  auto ys = set{count{1}, count{2}, count{3}};
+  auto ys_env = make_envelope(ys);
+  count sum = 0;
+  for (auto y : ys_env.value().to_set())
+    sum += y.to_count();
+  CHECK_EQUAL(sum, 6u);
+  auto zs = table{{"a", 1}, {"b", vector{2, 3}}, {"c", table{{"d", 4}}}};
+  auto zs_env = make_envelope(zs);
+  auto zs_view = zs_env.value().to_table();
+  REQUIRE_EQUAL(zs_view.size(), 3u);
+  std::vector<std::string> keys;
+  for (auto [key, val] : zs_view) {
+    keys.emplace_back(key.to_string_view());
+    CHECK_EQUAL(val.to_data(), zs[key.to_data()]);
+  }
+  CHECK_EQUAL(keys, std::vector<std::string>({"a", "b", "c"}));
+}
+
+TEST(converting views to owned data restores the original value) {
+  auto addr = address{};
+  CHECK(convert("2001:db8::1"s, addr));
+  auto x = data{vector{
+    data{},
+    true,
+    count{1},
+    integer{-1},
+    real{-0.5},
+    "str"s,
+    addr,
+    subnet{addr, 64},
+    port{53, port::protocol::udp},
+    timestamp{timespan{1}},
+    timespan{2},
+    enum_value{"e"},
+    set{1, 2},
+    table{{1, "one"}, {2, "two"}},
+    vector{vector{}, set{}, table{}},
+  }};
+  CHECK_EQUAL(round_trip(x), x);
+  CHECK_EQUAL(to_string(make_envelope(x).value()), to_string(x));
+}
+
+TEST(envelopes reject malformed input) {
+  auto bytes = serialize(vector{1, "two", 3});
+  CHECK(is_valid_data_encoding(bytes));
+  // Missing bytes at the end.
+  auto truncated = bytes;
+  truncated.pop_back();
+  CHECK(!data_envelope::make("foo"_t, truncated));
+  // Trailing bytes.
+  auto padded = bytes;
+  padded.push_back(std::byte{0});
+  CHECK(!data_envelope::make("foo"_t, padded));
+  // Invalid type tag.
+  auto bad_tag = bytes;
+  bad_tag[0] = std::byte{0xFF};
+  CHECK(!data_envelope::make("foo"_t, bad_tag));
+  // Empty input.
+  CHECK(!data_envelope::make("foo"_t, std::vector<std::byte>{}));
+  // Wrong message type.
+  auto cmd = make_packed_message(packed_message_type::command, defaults::ttl,
+                                 "foo"_t, bytes);
+  CHECK(!data_envelope::make(cmd));
+}
+
+TEST(envelopes limit the nesting depth of containers) {
+  CHECK(is_valid_data_encoding(make_nested_vectors(max_data_view_depth)));
+  CHECK(!is_valid_data_encoding(make_nested_vectors(max_data_view_depth + 1)));
+  MESSAGE("deeply nested input fails without exhausting the stack");
+  CHECK(!data_envelope::make("foo"_t, make_nested_vectors(1'000'000)));
+}
+
+TEST(zeek event views access events without materializing them) {
+  auto args = vector{1, "s", port(42, port::protocol::tcp)};
+  zeek::Event ev("test", args, timestamp{timespan{12}});
+  auto env = make_envelope(ev.as_data());
+  zeek::EventView view{env.value()};
+  CHECK_EQUAL(zeek::Message::type(env.value()), zeek::Message::Type::Event);
+  REQUIRE(view.valid());
+  CHECK(view.name() == "test"sv);
+  CHECK_EQUAL(view.args().size(), 3u);
+  CHECK(view.args()[1].to_string_view() == "s"sv);
+  CHECK_EQUAL(view.ts(), timestamp{timespan{12}});
+  CHECK_EQUAL(view.to_event().as_data(), ev.as_data());
+  auto other_env = make_envelope(vector{1, 2});
+  CHECK(!zeek::EventView{other_env.value()}.valid());
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,92 @@
+#define SUITE detail.flare
+
+#include "broker/detail/flare.hh"
+
+#include "test.hh"
+
+#include <thread>
+
+#ifdef BROKER_WINDOWS
+#  include <Winsock2.h>
+#else
+#  include <poll.h>
+#endif
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+struct fixture {
+  detail::flare uut;
+
+  // Checks whether the file descriptor of the flare is readable.
+  bool readable() {
+    pollfd p = {uut.fd(), POLLIN, 0};
+#ifdef BROKER_WINDOWS
+    return WSAPoll(&p, 1, 0) == 1;
+#else
+    return ::poll(&p, 1, 0) == 1;
+#endif
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(flare_tests, fixture)
+
+TEST(a new flare is not ready) {
+  CHECK(!uut.ready());
+  CHECK(!readable());
+  CHECK(!uut.extinguish_one());
+  CHECK_EQUAL(uut.extinguish(), 0u);
+}
+
+TEST(firing a flare makes its file descriptor readable) {
+  uut.fire();
+  CHECK(uut.ready());
+  CHECK(readable());
+  CHECK_EQUAL(uut.extinguish(), 1u);
+  CHECK(!uut.ready());
+  CHECK(!readable());
+}
+
+TEST(the flare counts how many times it was fired) {
+  uut.fire();
+  uut.fire();
+  uut.fire(3);
+  CHECK(readable());
+  CHECK(uut.extinguish_one());
+  CHECK_EQUAL(uut.extinguish_some(2), 2u);
+  CHECK(readable());
+  CHECK_EQUAL(uut.extinguish_some(10), 2u);
+  CHECK(!uut.ready());
+  CHECK(!readable());
+  CHECK(!uut.extinguish_one());
+}
+
+TEST(the flare becomes ready again after extinguishing it) {
+  for (int i = 0; i < 3; ++i) {
+    uut.fire();
+    CHECK(readable());
+    CHECK(uut.extinguish_one());
+    CHECK(!readable());
+  }
+}
+
+TEST(await_one returns false on timeout) {
+  CHECK(!uut.await_one(clock::now() + 10ms));
+}
+
+TEST(await_one returns once another thread fires the flare) {
+  std::thread t{[this] {
+    std::this_thread::sleep_for(10ms);
+    uut.fire();
+  }};
+  uut.await_one();
+  CHECK(uut.ready());
+  t.join();
+  CHECK(uut.await_one(clock::now() + 10ms));
+}
+
+FIXTURE_SCOPE_END()
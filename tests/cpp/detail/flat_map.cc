@@ -0,0 +1,58 @@
+#define SUITE detail.flat_map
+
+#include "broker/detail/flat_map.hh"
+
+#include "test.hh"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+using str_map = detail::flat_map<std::string, int>;
+
+std::vector<std::string> keys(const str_map& xs) {
+  std::vector<std::string> result;
+  for (const auto& [key, val] : xs)
+    result.emplace_back(key);
+  return result;
+}
+
+} // namespace
+
+TEST(flat maps keep their keys sorted and unique) {
+  str_map xs;
+  CHECK(xs.emplace("b", 2).second);
+  CHECK(xs.emplace("a", 1).second);
+  CHECK(!xs.emplace("a", 10).second);
+  CHECK_EQUAL(xs.at("a"), 1);
+  xs.insert({{"d", 4}, {"c", 3}, {"c", 30}});
+  CHECK_EQUAL(keys(xs), std::vector<std::string>({"a", "b", "c", "d"}));
+  CHECK_EQUAL(xs.at("c"), 3);
+}
+
+TEST(flat maps support the element access API of std map) {
+  str_map xs;
+  xs["foo"] = 1;
+  xs["bar"] += 2;
+  CHECK_EQUAL(xs.at("foo"), 1);
+  CHECK_EQUAL(xs.at("bar"), 2);
+  CHECK(!xs.try_emplace("foo", 10).second);
+  CHECK_EQUAL(xs.at("foo"), 1);
+  CHECK(!xs.insert_or_assign("foo", 10).second);
+  CHECK_EQUAL(xs.at("foo"), 10);
+  xs.find("bar")->second = 20;
+  CHECK_EQUAL(xs.at("bar"), 20);
+  CHECK_EQUAL(xs.erase("bar"), 1u);
+  CHECK(!xs.contains("bar"));
+  CHECK_EQUAL(xs.size(), 1u);
+}
+
+TEST(flat maps compare like std map) {
+  CHECK_EQUAL(str_map({{"a", 1}, {"b", 2}}), str_map({{"b", 2}, {"a", 1}}));
+  CHECK_NOT_EQUAL(str_map({{"a", 1}}), str_map({{"a", 2}}));
+  CHECK_LESS(str_map({{"a", 1}}), str_map({{"a", 2}}));
+}
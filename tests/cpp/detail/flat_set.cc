@@ -0,0 +1,62 @@
+#define SUITE detail.flat_set
+
+#include "broker/detail/flat_set.hh"
+
+#include "test.hh"
+
+#include <string>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+using int_set = detail::flat_set<int>;
+
+std::vector<int> to_vector(const int_set& xs) {
+  return {xs.begin(), xs.end()};
+}
+
+} // namespace
+
+TEST(flat sets keep their elements sorted and unique) {
+  int_set xs;
+  CHECK(xs.insert(3).second);
+  CHECK(xs.insert(1).second);
+  CHECK(xs.insert(2).second);
+  CHECK(!xs.insert(2).second);
+  CHECK_EQUAL(to_vector(xs), std::vector<int>({1, 2, 3}));
+  xs.insert({5, 4, 4, 0});
+  CHECK_EQUAL(to_vector(xs), std::vector<int>({0, 1, 2, 3, 4, 5}));
+}
+
+TEST(flat sets support the lookup API of std set) {
+  int_set xs{1, 3, 5};
+  CHECK(xs.contains(3));
+  CHECK(!xs.contains(4));
+  CHECK_EQUAL(xs.count(5), 1u);
+  CHECK_EQUAL(xs.count(6), 0u);
+  CHECK(xs.find(2) == xs.end());
+  CHECK_EQUAL(*xs.lower_bound(2), 3);
+  CHECK_EQUAL(*xs.upper_bound(3), 5);
+  CHECK_EQUAL(xs.erase(3), 1u);
+  CHECK_EQUAL(xs.erase(3), 0u);
+  CHECK_EQUAL(to_vector(xs), std::vector<int>({1, 5}));
+}
+
+TEST(flat sets ignore wrong insertion hints) {
+  int_set xs{1, 5};
+  // Correct hint.
+  xs.insert(xs.find(5), 3);
+  // Wrong hints.
+  xs.insert(xs.begin(), 7);
+  xs.insert(xs.end(), 0);
+  xs.insert(xs.end(), 3);
+  CHECK_EQUAL(to_vector(xs), std::vector<int>({0, 1, 3, 5, 7}));
+}
+
+TEST(flat sets compare like std set) {
+  CHECK_EQUAL(int_set({1, 2}), int_set({2, 1}));
+  CHECK_NOT_EQUAL(int_set({1, 2}), int_set({1, 2, 3}));
+  CHECK_LESS(int_set({1, 2}), int_set({1, 3}));
+}
@@ -0,0 +1,147 @@
+#define SUITE detail.subnet_index
+
+#include "broker/detail/subnet_index.hh"
+
+#include "test.hh"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  using map_type = std::map<data, data>;
+
+  map_type entries;
+
+  detail::subnet_index uut;
+
+  fixture() {
+    uut.enable(entries);
+  }
+
+  void insert(const subnet& net) {
+    auto i = entries.emplace(net, data{}).first;
+    uut.insert(i->first);
+  }
+
+  void erase(const subnet& net) {
+    if (auto i = entries.find(net); i != entries.end()) {
+      uut.erase(i->first);
+      entries.erase(i);
+    }
+  }
+
+  // Computes the longest match by testing each subnet.
+  data brute_force_match(const address& addr) {
+    const subnet* result = nullptr;
+    for (auto& kvp : entries) {
+      auto& net = get<subnet>(kvp.first);
+      if (net.contains(addr)
+          && (!result
+              || detail::full_length(*result) < detail::full_length(net)))
+        result = &net;
+    }
+    return result ? data{*result} : data{};
+  }
+
+  data match(const address& addr) {
+    if (auto ptr = uut.longest_match(addr))
+      return *ptr;
+    return data{};
+  }
+
+  std::vector<subnet> covered_by(const subnet& net) {
+    std::vector<subnet> result;
+    uut.covered_by(net, [&result](const data& key) {
+      result.emplace_back(get<subnet>(key));
+    });
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+};
+
+subnet operator""_sn(const char* str, size_t) {
+  return *to<subnet>(str);
+}
+
+address operator""_addr(const char* str, size_t) {
+  return *to<address>(str);
+}
+
+} // namespace
+
+FIXTURE_SCOPE(subnet_index_tests, fixture)
+
+TEST(the index selects the longest matching prefix) {
+  CHECK_EQUAL(match("10.0.0.1"_addr), data{});
+  insert("10.0.0.0/8"_sn);
+  insert("10.1.0.0/16"_sn);
+  insert("10.1.2.0/24"_sn);
+  insert("0.0.0.0/0"_sn);
+  CHECK_EQUAL(uut.size(), 4u);
+  CHECK_EQUAL(match("10.1.2.3"_addr), data{"10.1.2.0/24"_sn});
+  CHECK_EQUAL(match("10.1.3.3"_addr), data{"10.1.0.0/16"_sn});
+  CHECK_EQUAL(match("10.2.3.3"_addr), data{"10.0.0.0/8"_sn});
+  CHECK_EQUAL(match("11.2.3.3"_addr), data{"0.0.0.0/0"_sn});
+  CHECK_EQUAL(match("2001:db8::1"_addr), data{});
+  MESSAGE("host routes are valid subnets");
+  insert("10.1.2.3/32"_sn);
+  CHECK_EQUAL(match("10.1.2.3"_addr), data{"10.1.2.3/32"_sn});
+  CHECK_EQUAL(match("10.1.2.4"_addr), data{"10.1.2.0/24"_sn});
+}
+
+TEST(the index selects all covered subnets) {
+  insert("10.0.0.0/8"_sn);
+  insert("10.1.0.0/16"_sn);
+  insert("10.1.2.0/24"_sn);
+  insert("10.2.0.0/16"_sn);
+  insert("192.168.0.0/16"_sn);
+  using list = std::vector<subnet>;
+  CHECK_EQUAL(covered_by("10.1.0.0/16"_sn),
+              list({"10.1.0.0/16"_sn, "10.1.2.0/24"_sn}));
+  CHECK_EQUAL(covered_by("10.0.0.0/14"_sn),
+              list({"10.1.0.0/16"_sn, "10.1.2.0/24"_sn, "10.2.0.0/16"_sn}));
+  CHECK_EQUAL(covered_by("0.0.0.0/0"_sn).size(), 5u);
+  CHECK_EQUAL(covered_by("10.1.2.0/25"_sn), list{});
+  CHECK_EQUAL(covered_by("172.16.0.0/12"_sn), list{});
+}
+
+TEST(erasing subnets keeps the trie consistent) {
+  std::minstd_rand rng{42};
+  std::vector<subnet> nets;
+  for (int i = 0; i < 500; ++i) {
+    auto bits = static_cast<uint32_t>(rng());
+    auto addr = address{&bits, address::family::ipv4,
+                        address::byte_order::host};
+    nets.emplace_back(addr, static_cast<uint8_t>(8 + rng() % 25));
+  }
+  for (auto& net : nets)
+    insert(net);
+  CHECK_EQUAL(uut.size(), entries.size());
+  auto check_all = [&] {
+    std::minstd_rand probes{7};
+    for (int i = 0; i < 500; ++i) {
+      auto bits = static_cast<uint32_t>(probes());
+      auto addr = address{&bits, address::family::ipv4,
+                          address::byte_order::host};
+      if (match(addr) != brute_force_match(addr)) {
+        FAIL("mismatch for " << to_string(addr));
+      }
+    }
+  };
+  check_all();
+  for (size_t i = 0; i < nets.size(); i += 2)
+    erase(nets[i]);
+  CHECK_EQUAL(uut.size(), entries.size());
+  check_all();
+  for (auto& net : nets)
+    erase(net);
+  CHECK_EQUAL(uut.size(), 0u);
+  CHECK_EQUAL(match("10.0.0.1"_addr), data{});
+}
+
+FIXTURE_SCOPE_END()
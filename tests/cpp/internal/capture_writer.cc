@@ -0,0 +1,122 @@
+#define SUITE internal.capture_writer
+
+#include "broker/internal/capture_writer.hh"
+
+#include "test.hh"
+
+#include "broker/defaults.hh"
+#include "broker/detail/filesystem.hh"
+#include "broker/internal/capture_reader.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    // Use the unique file name as directory for the segment files.
+    directory = detail::make_temp_file_name();
+    detail::remove(directory);
+  }
+
+  ~fixture() {
+    detail::remove_all(directory);
+  }
+
+  static node_message make_msg(packed_message_type type, topic t,
+                               size_t payload_size) {
+    std::vector<std::byte> payload(payload_size, std::byte{0x2A});
+    return make_node_message(endpoint_id::random(1), endpoint_id::nil(),
+                             make_packed_message(type, defaults::ttl,
+                                                 std::move(t),
+                                                 std::move(payload)));
+  }
+
+  std::string directory;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(capture_writer_tests, fixture)
+
+TEST(the reader returns all records in the order of the writer) {
+  auto t0 = broker::now();
+  std::vector<node_message> msgs;
+  msgs.emplace_back(make_msg(packed_message_type::data, "foo/bar"_t, 10));
+  msgs.emplace_back(make_msg(packed_message_type::command, "foo/baz"_t, 20));
+  msgs.emplace_back(make_msg(packed_message_type::data, "foo/bar"_t, 30));
+  {
+    auto out = internal::make_capture_writer(directory, 4096);
+    REQUIRE(out != nullptr);
+    for (size_t i = 0; i < msgs.size(); ++i)
+      REQUIRE(!out->write(t0 + std::chrono::milliseconds(i), msgs[i]));
+    CHECK_EQUAL(out->records(), 3u);
+    CHECK_EQUAL(out->segments(), 1u);
+  }
+  auto in = internal::make_capture_reader(directory);
+  REQUIRE(in != nullptr);
+  internal::capture_record rec;
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    REQUIRE(!in->read(rec));
+    CHECK(rec.captured == t0 + std::chrono::milliseconds(i));
+    CHECK_EQUAL(get_type(rec.msg), get_type(msgs[i]));
+    CHECK_EQUAL(get_topic(rec.msg), get_topic(msgs[i]));
+    CHECK(get_payload(rec.msg) == get_payload(msgs[i]));
+  }
+  CHECK_EQUAL(in->read(rec), ec::end_of_file);
+  CHECK_EQUAL(in->records(), 3u);
+}
+
+TEST(the writer starts a new segment when the current one is full) {
+  auto t0 = broker::now();
+  {
+    auto out = internal::make_capture_writer(directory, 4096);
+    REQUIRE(out != nullptr);
+    // Each record takes more than 1 KiB, i.e., a segment fits 3 of them.
+    for (size_t i = 0; i < 10; ++i)
+      REQUIRE(!out->write(t0, make_msg(packed_message_type::data, "a/b"_t,
+                                       1024)));
+    // Records larger than the segment size get a segment of their own.
+    REQUIRE(!out->write(t0, make_msg(packed_message_type::data, "a/b"_t,
+                                     8192)));
+    CHECK_EQUAL(out->segments(), 5u);
+  }
+  CHECK(detail::is_file(
+    internal::capture_writer::format::segment_file_name(directory, 4)));
+  auto in = internal::make_capture_reader(directory);
+  REQUIRE(in != nullptr);
+  internal::capture_record rec;
+  while (!in->read(rec))
+    ; // Read until the end.
+  CHECK_EQUAL(in->records(), 11u);
+  CHECK_EQUAL(get_payload(rec.msg).size(), 8192u);
+  // Rewinding starts at the first segment again.
+  in->rewind();
+  REQUIRE(!in->read(rec));
+  CHECK_EQUAL(get_payload(rec.msg).size(), 1024u);
+}
+
+TEST(the writer refuses directories with a previous capture) {
+  auto t0 = broker::now();
+  {
+    auto out = internal::make_capture_writer(directory, 4096);
+    REQUIRE(out != nullptr);
+    for (size_t i = 0; i < 10; ++i)
+      REQUIRE(!out->write(t0, make_msg(packed_message_type::data, "a/b"_t,
+                                       1024)));
+  }
+  CHECK(internal::make_capture_writer(directory, 4096) == nullptr);
+  MESSAGE("the previous capture remains intact");
+  auto in = internal::make_capture_reader(directory);
+  REQUIRE(in != nullptr);
+  internal::capture_record rec;
+  for (size_t i = 0; i < 10; ++i)
+    REQUIRE(!in->read(rec));
+  CHECK_EQUAL(in->read(rec), ec::end_of_file);
+}
+
+TEST(the reader rejects directories without a capture) {
+  CHECK(internal::make_capture_reader(directory) == nullptr);
+}
+
+FIXTURE_SCOPE_END()
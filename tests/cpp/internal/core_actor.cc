@@ -4,11 +4,18 @@
 
 #include "test.hh"
 
+#include <caf/async/spsc_buffer.hpp>
 #include <caf/scheduled_actor/flow.hpp>
+#include <caf/send.hpp>
 
 #include "broker/configuration.hh"
 #include "broker/endpoint.hh"
 #include "broker/internal/logger.hh"
+#include "broker/internal/routing_update.hh"
+#include "broker/internal/trace.hh"
+#include "broker/internal/type_id.hh"
+
+#include <future>
 
 using namespace broker;
 
@@ -96,6 +103,22 @@ struct fixture : test_coordinator_fixture<config> {
   auto& state(const endpoint_state& ep) {
     return deref<internal::core_actor>(ep.hdl).state;
   }
+  filter_type local_filter(const endpoint_state& ep) {
+    auto result = state(ep).filter->read();
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  filter_type peer_filter(const endpoint_state& ep, endpoint_id peer) {
+    auto& peers = state(ep).peers;
+    if (auto i = peers.find(peer); i != peers.end()) {
+      auto result = i->second->filter();
+      std::sort(result.begin(), result.end());
+      return result;
+    }
+    return {};
+  }
+
   auto peer_ids(const endpoint_state& ep) {
     auto result = state(ep).peer_ids();
     std::sort(result.begin(), result.end());
@@ -155,4 +178,109 @@ TEST(peers forward local data to any peer with forwarding paths) {
   CHECK_EQUAL(*buf, test_data);
 }
 
+TEST(peers retract topics once the last subscriber unsubscribes) {
+  using internal::atom::subscribe_v;
+  using internal::atom::unsubscribe_v;
+  MESSAGE("spin up two endpoints: ep1 and ep2");
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type{});
+  MESSAGE("subscribe to 'a' twice and to 'a/b' and 'b' once");
+  caf::anon_send(ep1.hdl, subscribe_v, filter_type{"a", "b"});
+  caf::anon_send(ep1.hdl, subscribe_v, filter_type{"a", "a/b"});
+  run();
+  CHECK_EQUAL(local_filter(ep1), filter_type({"a", "b"}));
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type({"a", "b"}));
+  MESSAGE("dropping one reference to 'a' keeps the topic");
+  caf::anon_send(ep1.hdl, unsubscribe_v, filter_type{"a"});
+  run();
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type({"a", "b"}));
+  MESSAGE("dropping the last reference to 'a' uncovers 'a/b'");
+  caf::anon_send(ep1.hdl, unsubscribe_v, filter_type{"a"});
+  run();
+  CHECK_EQUAL(local_filter(ep1), filter_type({"a/b", "b"}));
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type({"a/b", "b"}));
+  MESSAGE("dropping all remaining topics retracts them from the peer");
+  caf::anon_send(ep1.hdl, unsubscribe_v, filter_type{"a/b", "b"});
+  run();
+  CHECK_EQUAL(local_filter(ep1), filter_type{});
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type{});
+}
+
+TEST(terminated subscriber flows release their topics) {
+  MESSAGE("spin up two endpoints: ep1 and ep2");
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  MESSAGE("attach a subscriber for 'a' to ep1");
+  auto [con, prod] = caf::async::make_spsc_buffer_resource<data_message>();
+  caf::anon_send(ep1.hdl, std::make_shared<filter_type>(filter_type{"a"}),
+                 std::move(prod));
+  run();
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type({"a"}));
+  MESSAGE("cancel the subscriber");
+  if (auto buf = con.try_open())
+    buf->cancel();
+  run();
+  CHECK_EQUAL(local_filter(ep1), filter_type{});
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type{});
+}
+
+TEST(terminated subscriber flows ignore late filter updates) {
+  MESSAGE("spin up two endpoints: ep1 and ep2");
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  MESSAGE("attach a subscriber for 'a' to ep1 and cancel it");
+  auto fptr = std::make_shared<filter_type>(filter_type{"a"});
+  auto [con, prod] = caf::async::make_spsc_buffer_resource<data_message>();
+  caf::anon_send(ep1.hdl, fptr, std::move(prod));
+  run();
+  if (auto buf = con.try_open())
+    buf->cancel();
+  run();
+  MESSAGE("adding a topic after the flow terminated has no effect");
+  caf::anon_send(ep1.hdl, fptr, topic{"b"}, true,
+                 std::shared_ptr<std::promise<void>>{nullptr});
+  run();
+  CHECK_EQUAL(local_filter(ep1), filter_type{});
+  CHECK_EQUAL(peer_filter(ep2, ep1.id), filter_type{});
+}
+
+TEST(the core traces publishers and control messages) {
+  using internal::trace_event;
+  auto count = [](trace_event event, std::string_view str) {
+    auto hash = internal::trace_hash(str);
+    auto snapshot = internal::trace_snapshot();
+    return std::count_if(snapshot.begin(), snapshot.end(), [&](auto& rec) {
+      return rec.event == event && rec.topic == hash;
+    });
+  };
+  internal::enable_tracing(true);
+  auto abc = filter_type{"a", "b", "c"};
+  ep1.filter = abc;
+  ep2.filter = abc;
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  MESSAGE("routing updates are control messages");
+  auto full = internal::routing_update_topic(
+    internal::routing_update_kind::full);
+  CHECK_GREATER(count(trace_event::control, full.string()), 0);
+  CHECK_EQUAL(count(trace_event::publish, full.string()), 0);
+  MESSAGE("messages from a publisher flow emit a publish event");
+  auto [con, prod] = caf::async::make_spsc_buffer_resource<data_message>();
+  caf::anon_send(ep1.hdl, std::move(con));
+  sys.spawn([prod{std::move(prod)}](caf::event_based_actor* self) {
+    self->make_observable()
+      .from_container(std::vector{make_data_message("a/trace", 1),
+                                  make_data_message("a/trace", 2)})
+      .subscribe(prod);
+  });
+  run();
+  internal::enable_tracing(false);
+  CHECK_EQUAL(count(trace_event::publish, "a/trace"), 2);
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,213 @@
+#define SUITE internal.dispatch_shard
+
+#include "broker/internal/dispatch_shard.hh"
+
+#include "test.hh"
+
+#include <caf/scheduled_actor/flow.hpp>
+
+#include "broker/configuration.hh"
+#include "broker/defaults.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal/core_actor.hh"
+#include "broker/internal/routing_update.hh"
+
+using namespace broker;
+
+namespace {
+
+struct config : public caf::actor_system_config {
+  config() {
+    set("broker.core.dispatch-shards", 2);
+  }
+};
+
+struct fixture : test_coordinator_fixture<config> {
+  using endpoint_state = base_fixture::endpoint_state;
+
+  endpoint_state ep1;
+
+  endpoint_state ep2;
+
+  endpoint_state ep3;
+
+  std::vector<caf::actor> bridges;
+
+  using data_message_list = std::vector<data_message>;
+
+  data_message_list test_data = data_message_list({
+    make_data_message("a", 0),
+    make_data_message("b", true),
+    make_data_message("a", 1),
+    make_data_message("a", 2),
+    make_data_message("b", false),
+    make_data_message("b", true),
+    make_data_message("a", 3),
+    make_data_message("b", false),
+    make_data_message("a", 4),
+    make_data_message("a", 5),
+  });
+
+  fixture() {
+    ep1.id = endpoint_id::random(1);
+    ep2.id = endpoint_id::random(2);
+    ep3.id = endpoint_id::random(3);
+  }
+
+  template <class... Ts>
+  void spin_up(endpoint_state& ep, Ts&... xs) {
+    ep.hdl = sys.spawn<internal::core_actor>(ep.id, ep.filter);
+    MESSAGE(ep.id << " is running at " << ep.hdl);
+    if constexpr (sizeof...(Ts) == 0)
+      run();
+    else
+      spin_up(xs...);
+  }
+
+  ~fixture() {
+    for (auto& hdl : bridges)
+      caf::anon_send_exit(hdl, caf::exit_reason::user_shutdown);
+    caf::anon_send_exit(ep1.hdl, caf::exit_reason::user_shutdown);
+    caf::anon_send_exit(ep2.hdl, caf::exit_reason::user_shutdown);
+    caf::anon_send_exit(ep3.hdl, caf::exit_reason::user_shutdown);
+  }
+
+  caf::actor bridge(const endpoint_state& left, const endpoint_state& right) {
+    auto res = base_fixture::bridge(left, right);
+    bridges.emplace_back(res);
+    return res;
+  }
+
+  std::shared_ptr<std::vector<data_message>>
+  collect_data(const endpoint_state& ep, filter_type filter) {
+    auto res = base_fixture::collect_data(ep.hdl, std::move(filter));
+    run();
+    return res;
+  }
+
+  void push_data(const endpoint_state& ep, data_message_list xs) {
+    base_fixture::push_data(ep.hdl, xs);
+  }
+
+  auto& state(const endpoint_state& ep) {
+    return deref<internal::core_actor>(ep.hdl).state;
+  }
+
+  auto& shard_state(const endpoint_state& ep, size_t index) {
+    auto& hdl = state(ep).dispatch_shards[index];
+    return deref<internal::dispatch_shard_actor>(hdl).state;
+  }
+
+  static node_message make_full_update(endpoint_id sender,
+                                       const filter_type& filter,
+                                       uint64_t version) {
+    using namespace internal;
+    auto kind = routing_update_kind::full;
+    auto bytes = make_full_routing_update(filter, lamport_timestamp{version});
+    auto packed = make_packed_message(packed_message_type::routing_update,
+                                      defaults::ttl, routing_update_topic(kind),
+                                      std::move(bytes));
+    return make_node_message(sender, endpoint_id::nil(), std::move(packed));
+  }
+
+  static node_message make_delta_update(endpoint_id sender, uint64_t version) {
+    using namespace internal;
+    auto kind = routing_update_kind::delta;
+    auto bytes = make_delta_routing_update(lamport_timestamp{version},
+                                           filter_type{"x"}, filter_type{});
+    auto packed = make_packed_message(packed_message_type::routing_update,
+                                      defaults::ttl, routing_update_topic(kind),
+                                      std::move(bytes));
+    return make_node_message(sender, endpoint_id::nil(), std::move(packed));
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(dispatch_shard_tests, fixture)
+
+TEST(the core spawns the configured number of dispatch shards) {
+  spin_up(ep1);
+  CHECK_EQUAL(state(ep1).dispatch_shards.size(), 2u);
+  CHECK_EQUAL(state(ep1).dispatch_shard_loads, std::vector<size_t>({0, 0}));
+}
+
+TEST(peers receive data through dispatch shards) {
+  MESSAGE("spin up ep1, ep2 and ep3");
+  auto abc = filter_type{"a", "b", "c"};
+  ep1.filter = abc;
+  ep2.filter = abc;
+  ep3.filter = abc;
+  spin_up(ep1, ep2, ep3);
+  bridge(ep1, ep2);
+  bridge(ep2, ep3);
+  run();
+  MESSAGE("ep2 assigns its two peers to different shards");
+  CHECK_EQUAL(state(ep2).dispatch_shard_loads, std::vector<size_t>({1, 1}));
+  MESSAGE("subscribe to data messages on ep3");
+  auto buf = collect_data(ep3, abc);
+  MESSAGE("publish data on ep1 and expect it in order on ep3");
+  push_data(ep1, test_data);
+  run();
+  CHECK_EQUAL(*buf, test_data);
+}
+
+TEST(shards ignore routing updates from peers of other shards) {
+  spin_up(ep1);
+  auto& st = shard_state(ep1, 0);
+  MESSAGE("the shard receives a full update from an unknown peer");
+  st.handle_routing_update(make_full_update(ep2.id, filter_type{"x"}, 1));
+  CHECK_EQUAL(st.outputs.count(ep2.id), 0u);
+  MESSAGE("the shard keeps no state for the unknown peer");
+  auto resources = caf::async::make_spsc_buffer_resource<node_message>();
+  auto& [con, prod] = resources;
+  st.add_peer(ep2.id, filter_type{"a"}, prod,
+              std::make_shared<internal::flow_scope_stats>());
+  REQUIRE_EQUAL(st.outputs.count(ep2.id), 1u);
+  CHECK_EQUAL(*st.outputs[ep2.id].filter, filter_type{"a"});
+  CHECK(!st.outputs[ep2.id].filter_state.versioned);
+  st.remove_peer(ep2.id);
+}
+
+TEST(only the owning shard keeps state for a peer) {
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  auto index = state(ep1).peer_shards.at(ep2.id);
+  CHECK_EQUAL(shard_state(ep1, index).outputs.count(ep2.id), 1u);
+  CHECK_EQUAL(shard_state(ep1, 1 - index).outputs.count(ep2.id), 0u);
+}
+
+TEST(shards report gaps in routing updates to the core) {
+  spin_up(ep1, ep2);
+  bridge(ep1, ep2);
+  run();
+  auto index = state(ep1).peer_shards.at(ep2.id);
+  auto shard = state(ep1).dispatch_shards[index];
+  auto& st = shard_state(ep1, index);
+  REQUIRE_EQUAL(st.outputs.count(ep2.id), 1u);
+  auto version = st.outputs[ep2.id].filter_state.version.value;
+  MESSAGE("the shard receives a delta update that skips a version");
+  st.handle_routing_update(make_delta_update(ep2.id, version + 2));
+  expect((internal::atom::resync, endpoint_id),
+         from(shard).to(ep1.hdl).with(_, ep2.id));
+  CHECK(state(ep1).peers[ep2.id]->filter_state().resync_pending);
+  MESSAGE("the shard reports the gap only once");
+  st.handle_routing_update(make_delta_update(ep2.id, version + 3));
+  disallow((internal::atom::resync, endpoint_id), from(shard).to(ep1.hdl));
+  MESSAGE("the full update from the peer ends the resync");
+  run();
+  CHECK(!st.outputs[ep2.id].filter_state.resync_pending);
+  CHECK(!state(ep1).peers[ep2.id]->filter_state().resync_pending);
+}
+
+TEST(the core shuts down if a dispatch shard terminates with an error) {
+  spin_up(ep1);
+  auto terminated = std::make_shared<bool>(false);
+  ep1.hdl->attach_functor([terminated] { *terminated = true; });
+  caf::anon_send_exit(state(ep1).dispatch_shards[0], caf::exit_reason::kill);
+  run();
+  CHECK(*terminated);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,153 @@
+#define SUITE internal.latency_tracker
+
+#include "broker/internal/latency_tracker.hh"
+
+#include "test.hh"
+
+#include <caf/byte_buffer.hpp>
+#include <caf/telemetry/metric_registry.hpp>
+
+#include "broker/defaults.hh"
+#include "broker/internal/wire_format.hh"
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+struct fixture {
+  caf::telemetry::metric_registry reg;
+
+  internal::latency_tracker tracker{reg, {"zeek/", "zeek/events/"}};
+
+  static node_message make_msg(packed_message_type type, topic t,
+                               timestamp origin) {
+    auto packed = make_packed_message(type, defaults::ttl, std::move(t),
+                                      std::vector<std::byte>{std::byte{0}});
+    return make_node_message(endpoint_id::random(1), endpoint_id::nil(),
+                             std::move(packed), origin);
+  }
+
+  static int64_t count(const internal::latency_tracker::histogram_type* hist) {
+    int64_t result = 0;
+    for (const auto& bucket : hist->buckets())
+      result += bucket.count.value();
+    return result;
+  }
+
+  node_message round_trip(const node_message& msg, bool with_origin) {
+    internal::wire_format::v1::trait trait{with_origin, nullptr};
+    caf::byte_buffer buf;
+    if (!trait.convert(msg, buf))
+      FAIL("failed to serialize node message");
+    node_message result;
+    if (!trait.convert(buf, result))
+      FAIL("failed to deserialize node message");
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(latency_tracker_tests, fixture)
+
+TEST(the tracker selects the longest matching prefix) {
+  auto hists = tracker.find("zeek/events/foo"_t);
+  REQUIRE(hists != nullptr);
+  CHECK_EQUAL(hists->prefix, "zeek/events/");
+  hists = tracker.find("zeek/logs"_t);
+  REQUIRE(hists != nullptr);
+  CHECK_EQUAL(hists->prefix, "zeek/");
+  CHECK(!tracker.tracks("foo/bar"_t));
+}
+
+TEST(the tracker matches prefixes like subscription filters) {
+  for (auto str : {"zeek", "zeek/", "zeek/events", "zeek/events/x", "zeeky"}) {
+    auto t = topic{str};
+    auto hists = tracker.find(t);
+    auto expected = static_cast<const char*>(nullptr);
+    for (auto prefix : {"zeek/", "zeek/events/"})
+      if (topic{prefix}.prefix_of(t))
+        expected = prefix;
+    if (expected == nullptr)
+      CHECK(hists == nullptr);
+    else
+      CHECK(hists != nullptr && hists->prefix == expected);
+  }
+}
+
+TEST(the tracker only observes data messages with origin timestamps) {
+  auto hists = tracker.find("zeek/logs"_t);
+  REQUIRE(hists != nullptr);
+  auto origin = broker::now() - 5ms;
+  tracker.observe_publish_to_core(
+    make_msg(packed_message_type::data, "zeek/logs"_t, origin));
+  tracker.observe_publish_to_core(
+    make_msg(packed_message_type::data, "zeek/logs"_t, timestamp{}));
+  tracker.observe_publish_to_core(
+    make_msg(packed_message_type::command, "zeek/logs"_t, origin));
+  tracker.observe_publish_to_core(
+    make_msg(packed_message_type::data, "foo/bar"_t, origin));
+  CHECK_EQUAL(count(hists->publish_to_core), 1);
+  CHECK_GREATER_EQUAL(hists->publish_to_core->sum(), 0.005);
+  CHECK_EQUAL(count(hists->core_to_peer_write), 0);
+  CHECK_EQUAL(count(hists->publish_to_delivery), 0);
+}
+
+TEST(snapshots contain all histograms per prefix) {
+  auto origin = broker::now();
+  tracker.observe_publish_to_delivery(
+    make_msg(packed_message_type::data, "zeek/events/x"_t, origin));
+  auto snapshot = tracker.snapshot();
+  REQUIRE_EQUAL(snapshot.size(), 2u);
+  auto i = snapshot.find("zeek/events/"s);
+  REQUIRE(i != snapshot.end());
+  auto hists = get_if<table>(i->second);
+  REQUIRE(hists != nullptr);
+  CHECK_EQUAL(hists->size(), 3u);
+  auto j = hists->find("publish-to-delivery"s);
+  REQUIRE(j != hists->end());
+  auto vals = get_if<table>(j->second);
+  REQUIRE(vals != nullptr);
+  CHECK_EQUAL(vals->at("count"s), data{integer{1}});
+}
+
+TEST(the wire format transmits origin timestamps only when negotiated) {
+  auto origin = broker::now();
+  auto msg = make_msg(packed_message_type::data, "zeek/logs"_t, origin);
+  auto with = round_trip(msg, true);
+  CHECK(get_origin(with) == origin);
+  CHECK_EQUAL(get_topic(with), "zeek/logs"_t);
+  CHECK(get_payload(with) == get_payload(msg));
+  auto without = round_trip(msg, false);
+  CHECK(get_origin(without) == timestamp{});
+  CHECK(get_payload(without) == get_payload(msg));
+}
+
+TEST(the wire format omits origin timestamps for other message types) {
+  auto msg = make_msg(packed_message_type::command, "zeek/logs"_t,
+                      broker::now());
+  internal::wire_format::v1::trait with{true, nullptr};
+  internal::wire_format::v1::trait without{false, nullptr};
+  caf::byte_buffer buf1;
+  caf::byte_buffer buf2;
+  REQUIRE(with.convert(msg, buf1));
+  REQUIRE(without.convert(msg, buf2));
+  CHECK(buf1 == buf2);
+}
+
+TEST(handshake messages accept both protocol versions) {
+  using namespace internal::wire_format;
+  auto old_hello = make_hello_msg(endpoint_id::random(1));
+  auto new_hello = make_hello_msg(endpoint_id::random(2),
+                                  timestamped_protocol_version);
+  CHECK_EQUAL(check(old_hello).first, ec::none);
+  CHECK_EQUAL(check(new_hello).first, ec::none);
+  auto vselect = make_version_select_msg(endpoint_id::random(1),
+                                         timestamped_protocol_version);
+  CHECK_EQUAL(check(vselect).first, ec::none);
+  vselect.selected_version = uint8_t{timestamped_protocol_version + 1};
+  CHECK_EQUAL(check(vselect).first, ec::peer_incompatible);
+}
+
+FIXTURE_SCOPE_END()
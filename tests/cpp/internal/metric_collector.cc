@@ -5,6 +5,7 @@
 #include "test.hh"
 
 #include "broker/internal/metric_exporter.hh"
+#include "broker/internal/metric_scraper.hh"
 
 namespace atom = broker::internal::atom;
 
@@ -176,4 +177,70 @@ TEST(a collector consumes the output of an exporter) {
     R"(foo_h2_seconds_count{endpoint="exporter-1",sys="broker"} 1)");
 }
 
+TEST(a collector applies delta-encoded metrics in place) {
+  internal::metric_scraper scraper{std::vector<std::string>{"foo"},
+                                   "exporter-2"};
+  scraper.delta_encoding(true);
+  foo_g1->inc(1);
+  foo_c1->inc(4);
+  MESSAGE("the first scrape always contains all metrics");
+  scraper.scrape(sys.metrics());
+  CHECK_EQUAL(scraper.rows().size(), 7u);
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 6u);
+  MESSAGE("subsequent scrapes only contain the changed metrics");
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  CHECK_EQUAL(scraper.rows().size(), 2u);
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 1u);
+  auto prom_txt = collector.prometheus_text();
+  PROM_CONTAINS(R"(foo_g1{endpoint="exporter-2"} 2)");
+  PROM_CONTAINS(R"(foo_c1{endpoint="exporter-2"} 4)");
+  MESSAGE("collectors ignore duplicates");
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 0u);
+  CHECK_EQUAL(collector.gaps(), 0u);
+}
+
+TEST(a collector drops deltas after a gap until the next full update) {
+  internal::metric_scraper scraper{std::vector<std::string>{"foo"},
+                                   "exporter-2"};
+  scraper.delta_encoding(true);
+  scraper.scrape(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 6u);
+  MESSAGE("lose a delta on the way to the collector");
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 0u);
+  CHECK_EQUAL(collector.gaps(), 1u);
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 0u);
+  MESSAGE("the next full update brings the collector back in sync");
+  scraper.scrape(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 6u);
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 1u);
+  auto prom_txt = collector.prometheus_text();
+  PROM_CONTAINS(R"(foo_g1{endpoint="exporter-2"} 4)");
+}
+
+TEST(stale updates leave the sequence numbers untouched) {
+  internal::metric_scraper scraper{std::vector<std::string>{"foo"},
+                                   "exporter-2"};
+  scraper.delta_encoding(true);
+  scraper.scrape(sys.metrics());
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 6u);
+  foo_g1->inc(1);
+  scraper.scrape_changes(sys.metrics());
+  MESSAGE("an outdated copy of the next delta has no effect");
+  auto stale = scraper.rows();
+  get<vector>(stale[0])[1] = timestamp{};
+  CHECK_EQUAL(collector.insert_or_update(stale), 0u);
+  MESSAGE("the collector still accepts the actual delta");
+  CHECK_EQUAL(collector.insert_or_update(scraper.rows()), 1u);
+  CHECK_EQUAL(collector.gaps(), 0u);
+}
+
 FIXTURE_SCOPE_END()
@@ -228,4 +228,45 @@ TEST(the exporter allows changing the prefix selection at runtime) {
   CHECK_EQUAL(rows().size(), 4u);
 }
 
+TEST(the exporter only publishes changes between two full updates) {
+  auto meta_data = [this](size_t field) {
+    return get<vector>(row(0)).at(field);
+  };
+  anon_send_exit(aut, caf::exit_reason::user_shutdown);
+  sched.run();
+  aut = sys.spawn<internal::metric_exporter_actor>(
+    core, std::vector<std::string>{"foo"}, caf::timespan{2s},
+    "all/them/metrics", "exporter-1", caf::timespan{6s});
+  sched.run();
+  MESSAGE("the first update contains all metrics");
+  sched.advance_time(2s);
+  expect((caf::tick_atom), to(aut));
+  expect((atom::publish, data_message), from(aut).to(core));
+  CHECK_EQUAL(rows().size(), 3u);
+  auto seq = get<count>(meta_data(2));
+  CHECK_EQUAL(meta_data(3), data{true});
+  MESSAGE("the exporter only publishes changed metrics until the next full");
+  foo_bar->inc();
+  sched.advance_time(2s);
+  expect((caf::tick_atom), to(aut));
+  expect((atom::publish, data_message), from(aut).to(core));
+  if (CHECK_EQUAL(rows().size(), 2u)) {
+    CHECK_EQUAL(row(1), (metric_row{"foo", "bar", "gauge", "1", "FooBar!",
+                                    false, table{}, data{1}}));
+    CHECK_EQUAL(meta_data(2), data{count{seq + 1}});
+    CHECK_EQUAL(meta_data(3), data{false});
+  }
+  MESSAGE("the exporter publishes nothing if no metric changed");
+  sched.advance_time(2s);
+  expect((caf::tick_atom), to(aut));
+  disallow((atom::publish, data_message), from(aut).to(core));
+  MESSAGE("the exporter publishes all metrics again after the full interval");
+  sched.advance_time(2s);
+  expect((caf::tick_atom), to(aut));
+  expect((atom::publish, data_message), from(aut).to(core));
+  CHECK_EQUAL(rows().size(), 3u);
+  CHECK_EQUAL(meta_data(2), data{count{seq + 2}});
+  CHECK_EQUAL(meta_data(3), data{true});
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,146 @@
+#define SUITE internal.peer_io
+
+#include "broker/internal/peer_io.hh"
+
+#include "test.hh"
+
+#include <caf/byte_buffer.hpp>
+#include <caf/detail/network_order.hpp>
+#include <caf/net/stream_socket.hpp>
+#include <caf/net/stream_transport.hpp>
+#include <caf/telemetry/metric_registry.hpp>
+
+#include "broker/defaults.hh"
+#include "broker/internal/wire_format.hh"
+
+#include <tuple>
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+using policy_t = peer_io_policy<caf::net::default_stream_transport_policy>;
+
+struct fixture {
+  caf::telemetry::metric_registry reg;
+
+  peer_io_metrics metrics;
+
+  caf::net::stream_socket rd;
+
+  caf::net::stream_socket wr;
+
+  wire_format::v1::trait trait;
+
+  fixture() {
+    metrics.writes = reg.counter_singleton("test", "writes", "Writes.");
+    metrics.reads = reg.counter_singleton("test", "reads", "Reads.");
+    auto fds = caf::net::make_stream_socket_pair();
+    if (!fds)
+      FAIL("failed to create a socket pair: " << fds.error());
+    std::tie(rd, wr) = *fds;
+  }
+
+  ~fixture() {
+    caf::net::close(rd);
+    caf::net::close(wr);
+  }
+
+  static node_message make_msg(int i) {
+    auto packed = make_packed_message(packed_message_type::data, defaults::ttl,
+                                      topic{"foo/" + std::to_string(i)},
+                                      std::vector<std::byte>{std::byte{0}});
+    return make_node_message(endpoint_id::random(1), endpoint_id::nil(),
+                             std::move(packed));
+  }
+
+  /// Serializes `n` messages with a four-byte length prefix each into a
+  /// single buffer, i.e., the same way the framing of the transport fills its
+  /// write buffer.
+  caf::byte_buffer make_batch(int n) {
+    caf::byte_buffer buf;
+    for (int i = 0; i < n; ++i) {
+      auto offset = buf.size();
+      buf.resize(offset + sizeof(uint32_t));
+      if (!trait.convert(make_msg(i), buf))
+        FAIL("failed to serialize node message");
+      auto len = static_cast<uint32_t>(buf.size() - offset - sizeof(uint32_t));
+      len = caf::detail::to_network_order(len);
+      memcpy(buf.data() + offset, &len, sizeof(uint32_t));
+    }
+    return buf;
+  }
+
+  /// Reads `n` frames from `rd` by reading each header and each payload
+  /// separately, i.e., the same way the framing of the transport configures
+  /// its reads.
+  int read_frames(policy_t& policy, int n) {
+    auto read_exactly = [&](caf::byte_buffer& buf, size_t len) {
+      buf.resize(len);
+      auto pos = size_t{0};
+      while (pos < len) {
+        auto res = policy.read(rd, caf::make_span(buf.data() + pos, len - pos));
+        if (res <= 0)
+          return false;
+        pos += static_cast<size_t>(res);
+      }
+      return true;
+    };
+    auto result = 0;
+    caf::byte_buffer hdr;
+    caf::byte_buffer payload;
+    for (int i = 0; i < n; ++i) {
+      if (!read_exactly(hdr, sizeof(uint32_t)))
+        break;
+      uint32_t len = 0;
+      memcpy(&len, hdr.data(), sizeof(uint32_t));
+      len = caf::detail::from_network_order(len);
+      node_message msg;
+      if (!read_exactly(payload, len) || !trait.convert(payload, msg))
+        break;
+      ++result;
+    }
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(peer_io_tests, fixture)
+
+TEST(the policy counts writes and reads a batch at once) {
+  auto batch = make_batch(10);
+  policy_t writer{{}, metrics};
+  CHECK_EQUAL(writer.write(wr, batch),
+              static_cast<ptrdiff_t>(batch.size()));
+  CHECK_EQUAL(metrics.writes->value(), 1);
+  policy_t reader{{}, metrics};
+  CHECK_EQUAL(read_frames(reader, 10), 10);
+  CHECK_EQUAL(metrics.reads->value(), 1);
+  CHECK_EQUAL(reader.buffered(), 0u);
+}
+
+TEST(without read-ahead each header and payload takes a read) {
+  metrics.read_ahead = 0;
+  auto batch = make_batch(10);
+  policy_t writer{{}, metrics};
+  CHECK_EQUAL(writer.write(wr, batch),
+              static_cast<ptrdiff_t>(batch.size()));
+  policy_t reader{{}, metrics};
+  CHECK_EQUAL(read_frames(reader, 10), 10);
+  CHECK_EQUAL(metrics.reads->value(), 20);
+}
+
+TEST(the policy reports bytes that it has read ahead) {
+  auto batch = make_batch(2);
+  policy_t writer{{}, metrics};
+  writer.write(wr, batch);
+  policy_t reader{{}, metrics};
+  caf::byte_buffer hdr;
+  hdr.resize(sizeof(uint32_t));
+  CHECK_EQUAL(reader.read(rd, hdr), 4);
+  CHECK_EQUAL(reader.buffered(), batch.size() - 4);
+}
+
+FIXTURE_SCOPE_END()
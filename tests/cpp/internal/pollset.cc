@@ -0,0 +1,125 @@
+#define SUITE internal.pollset
+
+#include "broker/internal/pollset.hh"
+
+#include "test.hh"
+
+#include <caf/byte.hpp>
+#include <caf/net/stream_socket.hpp>
+#include <caf/span.hpp>
+
+#include <tuple>
+#include <vector>
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+struct socket_pair {
+  caf::net::stream_socket rd;
+
+  caf::net::stream_socket wr;
+
+  socket_pair() {
+    auto fds = caf::net::make_stream_socket_pair();
+    if (!fds)
+      FAIL("failed to create a socket pair: " << fds.error());
+    std::tie(rd, wr) = *fds;
+  }
+
+  ~socket_pair() {
+    close();
+  }
+
+  void close() {
+    if (rd.id != caf::net::invalid_socket_id) {
+      caf::net::close(rd);
+      rd = caf::net::stream_socket{};
+    }
+    if (wr.id != caf::net::invalid_socket_id) {
+      caf::net::close(wr);
+      wr = caf::net::stream_socket{};
+    }
+  }
+
+  void send_byte() {
+    caf::byte buf[] = {caf::byte{42}};
+    if (caf::net::write(wr, caf::make_span(buf)) != 1)
+      FAIL("failed to write to the socket pair");
+  }
+};
+
+// Runs a single cycle and returns the IDs of all sockets with activity.
+template <class Backend>
+std::vector<caf::net::socket_id> cycle(Backend& fds) {
+  std::vector<caf::net::socket_id> result;
+  fds.prepare_next_cycle();
+  fds.wait(100, [&result](pollfd& pfd) { result.emplace_back(pfd.fd); });
+  return result;
+}
+
+using ids = std::vector<caf::net::socket_id>;
+
+} // namespace
+
+TEST(the poll backend reports readable sockets) {
+  socket_pair sp;
+  poll_backend fds;
+  fds.add(sp.rd.id, POLLIN);
+  CHECK_EQUAL(cycle(fds), ids{});
+  sp.send_byte();
+  CHECK_EQUAL(cycle(fds), ids{sp.rd.id});
+  MESSAGE("clearing the event mask drops the entry in the next cycle");
+  fds.find(sp.rd.id)->events = 0;
+  CHECK_EQUAL(cycle(fds), ids{});
+  CHECK_EQUAL(fds.size(), 0u);
+}
+
+#ifdef CAF_LINUX
+
+TEST(the epoll backend reports readable sockets) {
+  socket_pair sp;
+  epoll_backend fds;
+  fds.add(sp.rd.id, POLLIN);
+  CHECK_EQUAL(cycle(fds), ids{});
+  sp.send_byte();
+  CHECK_EQUAL(cycle(fds), ids{sp.rd.id});
+  MESSAGE("clearing the event mask drops the entry in the next cycle");
+  fds.find(sp.rd.id)->events = 0;
+  CHECK_EQUAL(cycle(fds), ids{});
+  CHECK_EQUAL(fds.size(), 0u);
+}
+
+TEST(the epoll backend picks up event mask changes of handlers) {
+  socket_pair sp;
+  epoll_backend fds;
+  fds.add(sp.wr.id, POLLIN);
+  CHECK_EQUAL(cycle(fds), ids{});
+  fds.find(sp.wr.id)->events = POLLIN | POLLOUT;
+  CHECK_EQUAL(cycle(fds), ids{sp.wr.id});
+}
+
+TEST(the epoll backend registers sockets that re-use the ID of a closed one) {
+  epoll_backend fds;
+  socket_pair sp1;
+  auto id = sp1.rd.id;
+  fds.add(id, POLLIN);
+  CHECK_EQUAL(cycle(fds), ids{});
+  // Closing the socket removes it from the epoll set without the backend
+  // noticing. The OS then re-uses the lowest free ID for the next socket.
+  sp1.close();
+  socket_pair sp2;
+  if (sp2.rd.id != id && sp2.wr.id != id) {
+    MESSAGE("the OS did not re-use the socket ID, skip test");
+    return;
+  }
+  auto& sock = sp2.rd.id == id ? sp2.rd : sp2.wr;
+  auto& other = sp2.rd.id == id ? sp2.wr : sp2.rd;
+  fds.add(id, POLLIN);
+  caf::byte buf[] = {caf::byte{42}};
+  REQUIRE_EQUAL(caf::net::write(other, caf::make_span(buf)), 1);
+  CHECK_EQUAL(cycle(fds), ids{sock.id});
+}
+
+#endif // CAF_LINUX
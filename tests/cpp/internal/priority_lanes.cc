@@ -0,0 +1,208 @@
+#define SUITE internal.priority_lanes
+
+#include "broker/internal/priority_lanes.hh"
+
+#include "test.hh"
+
+#include <caf/flow/scoped_coordinator.hpp>
+
+#include "broker/defaults.hh"
+#include "broker/internal/routing_update.hh"
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+struct fixture {
+  priority_lanes lanes;
+
+  fixture() {
+    lanes.enabled = true;
+    lanes.high_prefixes.emplace_back("zeek/control/"_t);
+  }
+
+  static node_message make_msg(packed_message_type type, topic t) {
+    auto packed = make_packed_message(type, defaults::ttl, std::move(t),
+                                      std::vector<std::byte>{std::byte{0}});
+    return make_node_message(endpoint_id::random(1), endpoint_id::nil(),
+                             std::move(packed));
+  }
+
+  static node_message make_data(topic t) {
+    return make_msg(packed_message_type::data, std::move(t));
+  }
+
+  /// Returns the tag of `msg`, i.e., its TTL field.
+  static int64_t tag_of(const node_message& msg) {
+    return static_cast<int64_t>(get_ttl(msg));
+  }
+
+  /// Creates a data message that carries `tag` in its TTL field.
+  static node_message make_tagged(topic t, uint16_t tag) {
+    auto packed = make_packed_message(packed_message_type::data, tag,
+                                      std::move(t), std::vector<std::byte>{});
+    return make_node_message(endpoint_id::random(1), endpoint_id::nil(),
+                             std::move(packed));
+  }
+};
+
+/// Collects all items and only requests items when the test says so.
+class manual_observer : public caf::ref_counted,
+                        public caf::flow::observer_impl<node_message> {
+public:
+  void ref_coordinated() const noexcept final {
+    this->ref();
+  }
+
+  void deref_coordinated() const noexcept final {
+    this->deref();
+  }
+
+  void on_next(const node_message& item) override {
+    tags.emplace_back(static_cast<int64_t>(get_ttl(item)));
+  }
+
+  void on_complete() override {
+    completed = true;
+  }
+
+  void on_error(const caf::error&) override {
+    completed = true;
+  }
+
+  void on_subscribe(caf::flow::subscription in) override {
+    sub = std::move(in);
+  }
+
+  caf::flow::subscription sub;
+
+  std::vector<int64_t> tags;
+
+  bool completed = false;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(priority_lanes_tests, fixture)
+
+TEST(control traffic uses the high lane) {
+  auto kind = routing_update_kind::delta;
+  CHECK(lanes.classify(make_msg(packed_message_type::routing_update,
+                                routing_update_topic(kind)))
+        == priority_lane::high);
+  CHECK(lanes.classify(make_msg(packed_message_type::command,
+                                "foo"_t / topic::master_suffix()))
+        == priority_lane::high);
+  CHECK(lanes.classify(make_msg(packed_message_type::ping, "foo"_t))
+        == priority_lane::high);
+  CHECK(lanes.classify(make_msg(packed_message_type::pong, "foo"_t))
+        == priority_lane::high);
+}
+
+TEST(the BYE handshake stays behind data) {
+  auto reserved = topic{std::string{topic::reserved}};
+  CHECK(lanes.classify(make_msg(packed_message_type::ping, reserved))
+        == priority_lane::bulk);
+  CHECK(lanes.classify(make_msg(packed_message_type::pong, reserved))
+        == priority_lane::bulk);
+}
+
+TEST(data messages use the high lane for internal or configured topics) {
+  CHECK(lanes.classify(make_data("zeek/control/cmd"_t)) == priority_lane::high);
+  CHECK(lanes.classify(make_data("foo"_t / topic::clone_suffix()))
+        == priority_lane::high);
+  CHECK(lanes.classify(make_data("zeek/logs/conn"_t)) == priority_lane::bulk);
+  lanes.high_prefixes.clear();
+  CHECK(lanes.classify(make_data("zeek/control/cmd"_t)) == priority_lane::bulk);
+}
+
+TEST(peer writers buffer at least one full write batch) {
+  lanes.buffer_size = 32;
+  CHECK_EQUAL(lanes.for_peer_writer(1).buffer_size, 32u);
+  CHECK_EQUAL(lanes.for_peer_writer(100).buffer_size, 100u);
+  CHECK(lanes.for_peer_writer(100).enabled);
+  lanes.buffer_size = 0;
+  CHECK_EQUAL(lanes.for_peer_writer(0).buffer_size, 1u);
+}
+
+TEST(priority merges deliver all items and keep the order per lane) {
+  lanes.buffer_size = 2;
+  auto ctx = caf::flow::scoped_coordinator::make();
+  std::vector<node_message> high_msgs;
+  std::vector<node_message> bulk_msgs;
+  for (uint16_t i = 0; i < 10; ++i) {
+    high_msgs.emplace_back(make_tagged("zeek/control/cmd"_t, i));
+    bulk_msgs.emplace_back(make_tagged("zeek/logs/conn"_t, 100 + i));
+  }
+  std::vector<int64_t> high_tags;
+  std::vector<int64_t> bulk_tags;
+  auto completed = false;
+  auto high = ctx->make_observable().from_container(high_msgs).as_observable();
+  auto bulk = ctx->make_observable().from_container(bulk_msgs).as_observable();
+  make_priority_merge(std::move(high), std::move(bulk), lanes)
+    .do_on_complete([&completed] { completed = true; })
+    .for_each([&](const node_message& msg) {
+      if (lanes.classify(msg) == priority_lane::high)
+        high_tags.emplace_back(tag_of(msg));
+      else
+        bulk_tags.emplace_back(tag_of(msg));
+    });
+  ctx->run();
+  CHECK(completed);
+  CHECK_EQUAL(high_tags,
+              std::vector<int64_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  CHECK_EQUAL(bulk_tags, std::vector<int64_t>({100, 101, 102, 103, 104, 105,
+                                               106, 107, 108, 109}));
+}
+
+TEST(high items overtake queued bulk data at priority stages) {
+  lanes.buffer_size = 16;
+  auto ctx = caf::flow::scoped_coordinator::make();
+  std::vector<node_message> msgs;
+  for (uint16_t i = 0; i < 10; ++i)
+    msgs.emplace_back(make_tagged("zeek/logs/conn"_t, 100 + i));
+  msgs.emplace_back(make_tagged("zeek/control/cmd"_t, 0));
+  msgs.emplace_back(make_tagged("zeek/control/cmd"_t, 1));
+  auto obs = caf::make_counted<manual_observer>();
+  ctx->make_observable()
+    .from_container(msgs)
+    .compose(add_priority_lanes_t{lanes})
+    .subscribe(caf::flow::observer<node_message>{obs});
+  ctx->run();
+  MESSAGE("the stage buffers all items until the output has demand");
+  REQUIRE(obs->sub);
+  CHECK(obs->tags.empty());
+  obs->sub.request(3);
+  ctx->run();
+  CHECK_EQUAL(obs->tags, std::vector<int64_t>({0, 1, 100}));
+  obs->sub.request(20);
+  ctx->run();
+  CHECK_EQUAL(obs->tags, std::vector<int64_t>({0, 1, 100, 101, 102, 103, 104,
+                                               105, 106, 107, 108, 109}));
+  CHECK(obs->completed);
+}
+
+TEST(high items of the bulk input overtake queued bulk data at merges) {
+  lanes.buffer_size = 16;
+  auto ctx = caf::flow::scoped_coordinator::make();
+  std::vector<node_message> bulk_msgs;
+  for (uint16_t i = 0; i < 4; ++i)
+    bulk_msgs.emplace_back(make_tagged("zeek/logs/conn"_t, 100 + i));
+  bulk_msgs.emplace_back(make_tagged("zeek/control/cmd"_t, 1));
+  auto high_msgs = std::vector<node_message>{
+    make_tagged("zeek/control/cmd"_t, 0)};
+  auto obs = caf::make_counted<manual_observer>();
+  auto high = ctx->make_observable().from_container(high_msgs).as_observable();
+  auto bulk = ctx->make_observable().from_container(bulk_msgs).as_observable();
+  make_priority_merge(std::move(high), std::move(bulk), lanes)
+    .subscribe(caf::flow::observer<node_message>{obs});
+  ctx->run();
+  REQUIRE(obs->sub);
+  obs->sub.request(10);
+  ctx->run();
+  CHECK_EQUAL(obs->tags, std::vector<int64_t>({0, 1, 100, 101, 102, 103}));
+  CHECK(obs->completed);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,107 @@
+#define SUITE internal.publish_limiter
+
+#include "broker/internal/publish_limiter.hh"
+
+#include "test.hh"
+
+#include <caf/telemetry/metric_registry.hpp>
+
+#include "broker/internal/metric_factory.hh"
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+struct fixture {
+  caf::telemetry::metric_registry reg;
+
+  internal::publish_limiter limiter{reg};
+
+  timestamp t0 = timestamp{timespan{1'000'000'000}};
+
+  /// Counts how many of `n` messages on topic `t` pass at time `t`.
+  size_t admitted(const topic& what, size_t n, timestamp t) {
+    size_t result = 0;
+    for (size_t i = 0; i < n; ++i)
+      if (limiter.admit(what, t))
+        ++result;
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(publish_limiter_tests, fixture)
+
+TEST(publish limits parse from strings) {
+  publish_limit limit;
+  CHECK(convert("rate=100 burst=200 sample=10", limit));
+  CHECK_EQUAL(limit, (publish_limit{100, 200, 10}));
+  CHECK_EQUAL(to_string(limit), "rate=100 burst=200 sample=10");
+  CHECK(convert("sample=5", limit));
+  CHECK_EQUAL(limit, (publish_limit{0, 0, 5}));
+  CHECK(!convert("rate=fast", limit));
+  CHECK(!convert("rate=-1", limit));
+  CHECK(!convert("speed=100", limit));
+  CHECK_EQUAL(limit, (publish_limit{0, 0, 5}));
+  CHECK(convert("drop=true", limit));
+  CHECK_EQUAL(limit, (publish_limit{0, 0, 1, true}));
+  CHECK_EQUAL(to_string(limit), "rate=0 burst=0 sample=1 drop=true");
+  CHECK(!convert("drop=yes", limit));
+}
+
+TEST(the configuration format requires a prefix and a valid limit) {
+  using internal::publish_limiter;
+  topic prefix;
+  publish_limit limit;
+  CHECK(publish_limiter::parse_policy("zeek/logs/ rate=10", prefix, limit));
+  CHECK_EQUAL(prefix, "zeek/logs/"_t);
+  CHECK_EQUAL(limit, (publish_limit{10, 0, 1}));
+  CHECK(!publish_limiter::parse_policy("zeek/logs/", prefix, limit));
+  CHECK(!publish_limiter::parse_policy(" rate=10", prefix, limit));
+  CHECK(!publish_limiter::parse_policy("zeek/ rate=x", prefix, limit));
+}
+
+TEST(messages without matching policy always pass) {
+  CHECK(limiter.empty());
+  CHECK_EQUAL(admitted("zeek/logs"_t, 100, t0), 100u);
+  limiter.set("zeek/logs/"_t, publish_limit{10, 0, 1}, t0);
+  CHECK_EQUAL(admitted("zeek/events"_t, 100, t0), 100u);
+}
+
+TEST(the token bucket limits the rate) {
+  limiter.set("zeek/logs/"_t, publish_limit{10, 20, 1}, t0);
+  MESSAGE("the bucket starts full");
+  CHECK_EQUAL(admitted("zeek/logs/conn"_t, 100, t0), 20u);
+  MESSAGE("the bucket refills at the configured rate");
+  CHECK_EQUAL(admitted("zeek/logs/conn"_t, 100, t0 + 500ms), 5u);
+  CHECK_EQUAL(admitted("zeek/logs/conn"_t, 100, t0 + 10s), 20u);
+  auto dropped = internal::metric_factory{reg}
+                   .core.publish_limit_dropped_messages_instances("zeek/logs/");
+  CHECK_EQUAL(dropped.rate->value(), 255);
+}
+
+TEST(sampling forwards one in N messages) {
+  limiter.set("zeek/"_t, publish_limit{0, 0, 10}, t0);
+  CHECK_EQUAL(admitted("zeek/logs/conn"_t, 100, t0), 10u);
+  MESSAGE("the longest prefix wins");
+  limiter.set("zeek/logs/"_t, publish_limit{}, t0);
+  CHECK_EQUAL(admitted("zeek/logs/conn"_t, 100, t0), 100u);
+  CHECK_EQUAL(admitted("zeek/events"_t, 100, t0), 10u);
+  MESSAGE("clearing a policy removes the limit");
+  limiter.clear("zeek/"_t);
+  CHECK_EQUAL(admitted("zeek/events"_t, 100, t0), 100u);
+}
+
+TEST(drop policies reject all messages) {
+  limiter.set("debug/"_t, publish_limit{0, 0, 1, true}, t0);
+  CHECK_EQUAL(admitted("debug/x"_t, 100, t0), 0u);
+  CHECK_EQUAL(admitted("zeek/logs"_t, 100, t0), 100u);
+  auto dropped = internal::metric_factory{reg}
+                   .core.publish_limit_dropped_messages_instances("debug/");
+  CHECK_EQUAL(dropped.drop->value(), 100);
+  CHECK_EQUAL(dropped.rate->value(), 0);
+}
+
+FIXTURE_SCOPE_END()
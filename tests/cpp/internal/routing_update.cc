@@ -0,0 +1,111 @@
+#define SUITE internal.routing_update
+
+#include "broker/internal/routing_update.hh"
+
+#include "test.hh"
+
+#include <caf/binary_serializer.hpp>
+#include <caf/byte_buffer.hpp>
+
+#include <algorithm>
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+struct fixture {
+  filter_type filter;
+
+  routing_update_state state;
+
+  static topic full_topic() {
+    return routing_update_topic(routing_update_kind::full);
+  }
+
+  static topic delta_topic() {
+    return routing_update_topic(routing_update_kind::delta);
+  }
+
+  routing_update_result full(const filter_type& xs, uint64_t version) {
+    auto bytes = make_full_routing_update(xs, lamport_timestamp{version});
+    return apply_routing_update(full_topic(), bytes, filter, state);
+  }
+
+  routing_update_result delta(uint64_t version, const filter_type& added,
+                              const filter_type& removed) {
+    auto bytes = make_delta_routing_update(lamport_timestamp{version}, added,
+                                           removed);
+    return apply_routing_update(delta_topic(), bytes, filter, state);
+  }
+
+  filter_type sorted_filter() const {
+    auto result = filter;
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(routing_update_tests, fixture)
+
+TEST(the topic encodes the kind of an update) {
+  using kind = routing_update_kind;
+  CHECK_EQUAL(full_topic(), topic{std::string{topic::reserved}});
+  CHECK(get_routing_update_kind(full_topic()) == kind::full);
+  CHECK(get_routing_update_kind(delta_topic()) == kind::delta);
+  CHECK(get_routing_update_kind(routing_update_topic(kind::resync))
+        == kind::resync);
+}
+
+TEST(full updates from older peers carry no version) {
+  caf::byte_buffer buf;
+  caf::binary_serializer sink{nullptr, buf};
+  REQUIRE(sink.apply(filter_type{"a", "b"}));
+  auto first = reinterpret_cast<const std::byte*>(buf.data());
+  auto bytes = std::vector<std::byte>{first, first + buf.size()};
+  CHECK(apply_routing_update(full_topic(), bytes, filter, state)
+        == routing_update_result::applied);
+  CHECK_EQUAL(sorted_filter(), filter_type({"a", "b"}));
+  CHECK(!state.versioned);
+  MESSAGE("without a version, we cannot apply deltas");
+  CHECK(delta(2, {"c"}, {}) == routing_update_result::gap);
+  CHECK_EQUAL(sorted_filter(), filter_type({"a", "b"}));
+}
+
+TEST(deltas apply in order and gaps require a full update) {
+  CHECK(full({"a", "b"}, 5) == routing_update_result::applied);
+  CHECK(state.versioned);
+  CHECK_EQUAL(state.version.value, 5u);
+  CHECK(delta(6, {"c"}, {"a"}) == routing_update_result::applied);
+  CHECK_EQUAL(sorted_filter(), filter_type({"b", "c"}));
+  MESSAGE("outdated deltas have no effect");
+  CHECK(delta(6, {"a"}, {}) == routing_update_result::ignored);
+  CHECK_EQUAL(sorted_filter(), filter_type({"b", "c"}));
+  MESSAGE("skipping a version results in a gap");
+  CHECK(delta(8, {"d"}, {}) == routing_update_result::gap);
+  CHECK_EQUAL(sorted_filter(), filter_type({"b", "c"}));
+  CHECK(full({"b", "c", "d", "e"}, 8) == routing_update_result::applied);
+  CHECK_EQUAL(state.version.value, 8u);
+  CHECK(delta(9, {}, {"e"}) == routing_update_result::applied);
+  CHECK_EQUAL(sorted_filter(), filter_type({"b", "c", "d"}));
+}
+
+TEST(malformed updates leave the filter unchanged) {
+  CHECK(full({"a"}, 1) == routing_update_result::applied);
+  auto bytes = std::vector<std::byte>{std::byte{0xFF}};
+  CHECK(apply_routing_update(delta_topic(), bytes, filter, state)
+        == routing_update_result::malformed);
+  CHECK_EQUAL(filter, filter_type({"a"}));
+}
+
+TEST(filter diffs contain added and removed topics) {
+  filter_type added;
+  filter_type removed;
+  filter_diff({"a/b", "c", "d"}, {"d", "a", "c"}, added, removed);
+  CHECK_EQUAL(added, filter_type({"a"}));
+  CHECK_EQUAL(removed, filter_type({"a/b"}));
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,116 @@
+#define SUITE internal.trace
+
+#include "broker/internal/trace.hh"
+
+#include "test.hh"
+
+#include <atomic>
+#include <thread>
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    enable_tracing(false);
+  }
+
+  ~fixture() {
+    enable_tracing(false);
+  }
+
+  /// Returns all records with the hash of `str` as topic.
+  static std::vector<trace_record> records_for(std::string_view str) {
+    auto hash = trace_hash(str);
+    std::vector<trace_record> result;
+    for (auto& rec : trace_snapshot())
+      if (rec.topic == hash)
+        result.emplace_back(rec);
+    return result;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(trace_tests, fixture)
+
+TEST(trace points only record while tracing is enabled) {
+  auto what = topic{"/trace/toggle"};
+  auto pid = endpoint_id::random(42);
+  trace(trace_event::publish, pid, what, 1);
+  CHECK(records_for(what.string()).empty());
+  enable_tracing(true);
+  trace(trace_event::publish, pid, what, 2);
+  enable_tracing(false);
+  trace(trace_event::publish, pid, what, 3);
+  auto records = records_for(what.string());
+  REQUIRE_EQUAL(records.size(), 1u);
+  CHECK(records[0].event == trace_event::publish);
+  CHECK_EQUAL(records[0].peer, trace_hash(pid));
+  CHECK_EQUAL(records[0].size, 2u);
+}
+
+TEST(ring buffers keep the most recent records) {
+  auto hash = trace_hash(std::string_view{"/trace/overflow"});
+  constexpr uint64_t num_records = 100'000;
+  std::thread writer{[hash] {
+    for (uint64_t i = 0; i < num_records; ++i)
+      trace_impl(trace_event::merge, 0, hash, i);
+  }};
+  writer.join();
+  auto records = records_for("/trace/overflow");
+  REQUIRE(!records.empty());
+  CHECK_LESS(records.size(), num_records);
+  CHECK_EQUAL(records.back().size, num_records - 1);
+  for (size_t i = 1; i < records.size(); ++i)
+    CHECK_EQUAL(records[i].size, records[i - 1].size + 1);
+}
+
+TEST(readers never observe partially written records) {
+  auto hash = trace_hash(std::string_view{"/trace/concurrent"});
+  std::atomic<bool> done = false;
+  std::thread writer{[hash, &done] {
+    for (uint64_t i = 0; i < 1'000'000; ++i)
+      trace_impl(trace_event::peer_write, i, hash, i);
+    done = true;
+  }};
+  size_t broken = 0;
+  while (!done)
+    for (auto& rec : records_for("/trace/concurrent"))
+      if (rec.peer != rec.size || rec.event != trace_event::peer_write)
+        ++broken;
+  writer.join();
+  CHECK_EQUAL(broken, 0u);
+}
+
+TEST(dumps preserve all records) {
+  std::vector<trace_record> xs;
+  xs.push_back({1, trace_event::publish, 0, 10, 0xAAAA, 0xBBBB});
+  xs.push_back({2, trace_event::channel_nack, 7, 3, 0xCCCC, 0});
+  auto dump = trace_dump(xs);
+  CHECK_EQUAL(dump.size(), 16u + 2 * 32u);
+  auto ys = parse_trace_dump(dump.data(), dump.size());
+  REQUIRE(ys);
+  CHECK(*ys == xs);
+  MESSAGE("the decoder rejects truncated dumps");
+  CHECK(!parse_trace_dump(dump.data(), dump.size() - 1));
+  MESSAGE("the decoder rejects inputs without magic number");
+  dump[0] = std::byte{'X'};
+  CHECK(!parse_trace_dump(dump.data(), dump.size()));
+}
+
+TEST(only the first call sets the size of the ring buffers) {
+  auto size = set_trace_buffer_size(100);
+  CHECK_EQUAL(set_trace_buffer_size(2 * size), size);
+}
+
+TEST(the hash function is stable) {
+  // FNV-1a test vectors.
+  CHECK_EQUAL(trace_hash(std::string_view{}), 0xcbf29ce484222325ull);
+  CHECK_EQUAL(trace_hash(std::string_view{"a"}), 0xaf63dc4c8601ec8cull);
+  CHECK_EQUAL(trace_hash(endpoint_id{}), 0u);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,180 @@
+#define SUITE internal.write_combiner
+
+#include "broker/internal/write_combiner.hh"
+
+#include "test.hh"
+
+#include "broker/detail/memory_backend.hh"
+
+using namespace broker;
+using namespace broker::internal;
+using namespace std::literals;
+
+namespace {
+
+struct fixture {
+  entity_id alice{endpoint_id::random(1), 1};
+
+  entity_id bob{endpoint_id::random(2), 2};
+
+  write_combiner uut;
+
+  /// Stores all commands that we passed to the combiner.
+  std::vector<internal_command_variant> inputs;
+
+  internal_command_variant put(data key, data value,
+                               std::optional<timespan> expiry = {}) {
+    return put_command{std::move(key), std::move(value), expiry, alice};
+  }
+
+  internal_command_variant increment(data key, data amount,
+                                     std::optional<timespan> expiry = {},
+                                     entity_id publisher = {}) {
+    auto init_type = amount.get_type();
+    return add_command{std::move(key), std::move(amount), init_type, expiry,
+                       publisher ? publisher : alice};
+  }
+
+  internal_command_variant insert_into(data key, data value,
+                                       entity_id publisher = {}) {
+    return add_command{std::move(key), std::move(value), data::type::set,
+                       std::nullopt, publisher ? publisher : alice};
+  }
+
+  void add(internal_command_variant cmd) {
+    inputs.emplace_back(cmd);
+    CHECK(uut.add(cmd));
+  }
+
+  std::vector<internal_command_variant> flush() {
+    std::vector<internal_command_variant> result;
+    uut.flush([&result](internal_command_variant&& x) {
+      result.emplace_back(std::move(x));
+    });
+    return result;
+  }
+
+  /// Applies `xs` to an empty memory backend and returns its content.
+  static data apply(const std::vector<internal_command_variant>& xs) {
+    detail::memory_backend backend;
+    for (const auto& x : xs) {
+      if (auto put = get_if<put_command>(&x))
+        backend.put(put->key, put->value, std::nullopt);
+      else if (auto add = get_if<add_command>(&x))
+        backend.add(add->key, add->value, add->init_type, std::nullopt);
+    }
+    table result;
+    if (auto snapshot = backend.snapshot())
+      result.insert(snapshot->begin(), snapshot->end());
+    return data{std::move(result)};
+  }
+
+  /// Flushes the combiner and checks whether applying the output yields the
+  /// same store content as applying the original commands.
+  std::vector<internal_command_variant> flush_and_compare() {
+    auto outputs = flush();
+    CHECK(uut.empty());
+    CHECK_EQUAL(apply(outputs), apply(inputs));
+    inputs.clear();
+    return outputs;
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(write_combiner_tests, fixture)
+
+TEST(the combiner only accepts puts and adds) {
+  internal_command_variant cmd = erase_command{data{"a"}, alice};
+  CHECK(!uut.add(cmd));
+  cmd = clear_command{alice};
+  CHECK(!uut.add(cmd));
+  CHECK(uut.empty());
+}
+
+TEST(increments add up) {
+  for (int i = 0; i < 100; ++i)
+    add(increment("hits", count{1}));
+  add(increment("temp", real{1.5}));
+  add(increment("temp", real{2.5}));
+  CHECK_EQUAL(uut.size(), 2u);
+  auto outputs = flush_and_compare();
+  REQUIRE_EQUAL(outputs.size(), 2u);
+  auto hits = get_if<add_command>(&outputs[0]);
+  REQUIRE(hits != nullptr);
+  CHECK_EQUAL(hits->value, data{count{100}});
+  auto temp = get_if<add_command>(&outputs[1]);
+  REQUIRE(temp != nullptr);
+  CHECK_EQUAL(temp->value, data{real{4.0}});
+}
+
+TEST(the last put wins) {
+  add(increment("x", count{1}));
+  add(put("x", count{5}));
+  add(put("x", count{7}));
+  auto outputs = flush_and_compare();
+  REQUIRE_EQUAL(outputs.size(), 1u);
+  auto cmd = get_if<put_command>(&outputs[0]);
+  REQUIRE(cmd != nullptr);
+  CHECK_EQUAL(cmd->value, data{count{7}});
+}
+
+TEST(adds following a put modify the value of the put) {
+  add(put("x", count{5}));
+  add(increment("x", count{2}));
+  add(put("s", set{}));
+  add(insert_into("s", "a"));
+  add(insert_into("s", "b"));
+  auto outputs = flush_and_compare();
+  REQUIRE_EQUAL(outputs.size(), 2u);
+  auto x = get_if<put_command>(&outputs[0]);
+  REQUIRE(x != nullptr);
+  CHECK_EQUAL(x->value, data{count{7}});
+  auto s = get_if<put_command>(&outputs[1]);
+  REQUIRE(s != nullptr);
+  CHECK_EQUAL(s->value, data{set{"a", "b"}});
+}
+
+TEST(set insertions skip values that are already buffered) {
+  for (int i = 0; i < 10; ++i) {
+    add(insert_into("hosts", "10.0.0.1"));
+    add(insert_into("hosts", "10.0.0.2"));
+  }
+  CHECK_EQUAL(uut.size(), 2u);
+  flush_and_compare();
+}
+
+TEST(merged commands carry the expiry of the last command) {
+  add(increment("x", count{1}, 10s));
+  add(increment("x", count{1}, 20s));
+  add(put("y", count{1}, 10s));
+  add(increment("y", count{1}));
+  auto outputs = flush_and_compare();
+  REQUIRE_EQUAL(outputs.size(), 2u);
+  auto x = get_if<add_command>(&outputs[0]);
+  REQUIRE(x != nullptr);
+  CHECK(x->expiry == std::optional<timespan>{20s});
+  auto y = get_if<put_command>(&outputs[1]);
+  REQUIRE(y != nullptr);
+  CHECK(!y->expiry);
+}
+
+TEST(the combiner only merges commands of the same publisher) {
+  add(increment("x", count{1}));
+  add(increment("x", count{1}, std::nullopt, bob));
+  add(insert_into("s", "a"));
+  add(insert_into("s", "a", bob));
+  CHECK_EQUAL(uut.size(), 4u);
+  flush_and_compare();
+}
+
+TEST(the combiner keeps commands with mismatched types) {
+  add(increment("x", count{1}));
+  add(increment("x", integer{1}));
+  add(put("y", "foo"));
+  add(increment("y", count{1}));
+  CHECK_EQUAL(uut.size(), 4u);
+  flush_and_compare();
+}
+
+FIXTURE_SCOPE_END()
@@ -260,6 +260,10 @@ TEST(master_with_clone) {
   CHECK_EQUAL(value_of(ds_mars.get("test")), data{123});
   mars.sched.inline_next_enqueue();
   CHECK_EQUAL(value_of(ds_mars.get("user")), data{"neverlord"});
+  MESSAGE("clones answer prefix queries locally");
+  mars.sched.inline_next_enqueue();
+  CHECK_EQUAL(value_of(ds_mars.prefix("te")),
+              data(vector{table{{"test", 123}}, data{}}));
   MESSAGE("put_unique propagates the status back to the store object");
   mars.sched.after_next_enqueue(run_until_idle);
   CHECK_EQUAL(value_of(ds_mars.put_unique("bar", "baz")), data{true});
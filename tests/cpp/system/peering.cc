@@ -60,10 +60,11 @@ static constexpr bool disable_ssl = true;
 static constexpr bool enable_ssl = false;
 
 configuration make_config(const char* test_name, size_t endpoint_nr,
-                          bool disable_ssl) {
+                          bool disable_ssl, size_t connector_threads = 1) {
   broker_options opts;
   opts.disable_forwarding = true;
   opts.disable_ssl = disable_ssl;
+  opts.connector_threads = connector_threads;
   configuration cfg{opts};
   cfg.set("caf.scheduler.max-threads", 2);
   cfg.set("caf.logger.console.verbosity", "quiet");
@@ -94,23 +95,6 @@ void println(const Ts&... xs) {
   (std::cout << ... << xs) << '\n';
 }
 
-struct fixture {
-  fixture() {
-    for (auto& ptr : ep_logs)
-      ptr = std::make_shared<data_message_list>();
-    for (auto& ptr : ep_values)
-      ptr = std::make_shared<data_list>();
-    for (auto& ptr : ep_ids)
-      ptr = std::make_shared<endpoint_id>();
-  }
-
-  std::array<std::shared_ptr<data_message_list>, num_endpoints> ep_logs;
-  std::array<std::shared_ptr<data_list>, num_endpoints> ep_values;
-  std::array<std::atomic<uint16_t>, num_endpoints> ports;
-  std::array<std::thread, num_endpoints> threads;
-  std::array<std::shared_ptr<endpoint_id>, num_endpoints> ep_ids;
-};
-
 struct alternative {
   std::string a;
   std::string b;
@@ -186,85 +170,111 @@ std::vector<std::string> grep_hello(std::vector<data_message> xs) {
   return result;
 }
 
-} // namespace
+struct fixture {
+  fixture() {
+    for (auto& ptr : ep_logs)
+      ptr = std::make_shared<data_message_list>();
+    for (auto& ptr : ep_values)
+      ptr = std::make_shared<data_list>();
+    for (auto& ptr : ep_ids)
+      ptr = std::make_shared<endpoint_id>();
+  }
 
-FIXTURE_SCOPE(system_peering_tests, fixture)
+  std::array<std::shared_ptr<data_message_list>, num_endpoints> ep_logs;
+  std::array<std::shared_ptr<data_list>, num_endpoints> ep_values;
+  std::array<std::atomic<uint16_t>, num_endpoints> ports;
+  std::array<std::thread, num_endpoints> threads;
+  std::array<std::shared_ptr<endpoint_id>, num_endpoints> ep_ids;
 
-// Spins up four Broker endpoints, listens for peering events on all of them and
-// then form a full mesh. All endpoints wait on a barrier before calling `peer`
-// on the endpoints to maximize conflict potential during handshaking.
-TEST(a full mesh emits endpoint_discovered and peer_added for all nodes) {
-  MESSAGE("initialize state");
-  barrier listening{num_endpoints};
-  barrier peered{num_endpoints};
-  barrier send_and_received{num_endpoints};
-  MESSAGE("spin up threads");
-  for (size_t index = 0; index != num_endpoints; ++index) {
-    threads[index] = std::thread{[&, index] {
-      auto log_ptr = ep_logs[index];
-      endpoint ep{make_config("peering-events", index, disable_ssl)};
-      *ep_ids[index] = ep.node_id();
-      barrier got_hellos{2};
-      ep.subscribe(
-        {topic::statuses(), "foo/bar"}, [](caf::unit_t&) {},
-        [log_ptr, n{0}, &got_hellos](caf::unit_t&, data_message msg) mutable {
-          if (get_topic(msg).string() == "foo/bar" && ++n == 3)
-            got_hellos.arrive_and_wait();
-          log_ptr->emplace_back(std::move(msg));
-        },
-        [](caf::unit_t&, const error&) {});
-      auto port = ep.listen();
-      if (port == 0)
-        hard_error("endpoint ", to_string(ep.node_id()),
-                   " failed to open a port");
-      ports[index] = port;
-      std::map<endpoint_id, std::future<bool>> peer_results;
-      listening.arrive_and_wait();
-      for (size_t i = 0; i != num_endpoints; ++i) {
-        if (i != index) {
-          auto p = ports[i].load();
-          peer_results.emplace(*ep_ids[i], ep.peer_async("localhost", p, 1s));
+  // Spins up four Broker endpoints, listens for peering events on all of them
+  // and then form a full mesh. All endpoints wait on a barrier before calling
+  // `peer` on the endpoints to maximize conflict potential during handshaking.
+  void run_full_mesh(const char* test_name, size_t connector_threads) {
+    MESSAGE("initialize state");
+    barrier listening{num_endpoints};
+    barrier peered{num_endpoints};
+    barrier send_and_received{num_endpoints};
+    MESSAGE("spin up threads");
+    for (size_t index = 0; index != num_endpoints; ++index) {
+      threads[index] = std::thread{[&, index] {
+        auto log_ptr = ep_logs[index];
+        endpoint ep{make_config(test_name, index, disable_ssl,
+                                connector_threads)};
+        *ep_ids[index] = ep.node_id();
+        barrier got_hellos{2};
+        ep.subscribe(
+          {topic::statuses(), "foo/bar"}, [](caf::unit_t&) {},
+          [log_ptr, n{0}, &got_hellos](caf::unit_t&, data_message msg) mutable {
+            if (get_topic(msg).string() == "foo/bar" && ++n == 3)
+              got_hellos.arrive_and_wait();
+            log_ptr->emplace_back(std::move(msg));
+          },
+          [](caf::unit_t&, const error&) {});
+        auto port = ep.listen();
+        if (port == 0)
+          hard_error("endpoint ", to_string(ep.node_id()),
+                     " failed to open a port");
+        ports[index] = port;
+        std::map<endpoint_id, std::future<bool>> peer_results;
+        listening.arrive_and_wait();
+        for (size_t i = 0; i != num_endpoints; ++i) {
+          if (i != index) {
+            auto p = ports[i].load();
+            peer_results.emplace(*ep_ids[i], ep.peer_async("localhost", p, 1s));
+          }
         }
-      }
-      for (auto& [other_id, res] : peer_results) {
-        if (!res.get()) {
-          SYNC_CHECK_FAILED("endpoint ", to_string(ep.node_id()),
-                            " failed to connect to ", to_string(other_id));
+        for (auto& [other_id, res] : peer_results) {
+          if (!res.get()) {
+            SYNC_CHECK_FAILED("endpoint ", to_string(ep.node_id()),
+                              " failed to connect to ", to_string(other_id));
+          }
         }
-      }
-      peered.arrive_and_wait();
-      ep.publish("foo/bar", "hello from " + std::to_string(index));
-      got_hellos.arrive_and_wait();
-      send_and_received.arrive_and_wait();
-      // std::this_thread::sleep_for(10s);
-    }};
-  }
-  MESSAGE("wait for all threads to complete");
-  for (auto& hdl : threads)
-    hdl.join();
-  MESSAGE("check results");
-  std::vector<std::vector<std::string>> normalized_logs;
-  for (auto& ep_log : ep_logs)
-    normalized_logs.emplace_back(normalize_status_log(*ep_log, true));
-  std::vector<std::vector<std::string>> hellos;
-  for (size_t index = 0; index != num_endpoints; ++index) {
-    std::vector<std::string> lines;
-    for (size_t i = 0; i != num_endpoints; ++i)
-      if (i != index)
-        lines.emplace_back("hello from " + std::to_string(i));
-    hellos.emplace_back(lines);
-  }
-  auto sequence =
-    std::vector<alternative>{"endpoint_discovered"_a, "peer_added"_a,
-                             alternative{"peer_lost", "peer_removed"},
-                             "endpoint_unreachable"_a};
-  // Check all endpoints.
-  for (size_t index = 0; index != num_endpoints; ++index) {
-    for (size_t i = 0; i != num_endpoints; ++i)
-      if (i != index)
-        CHECK_EQUAL(grep_id(normalized_logs[index], *ep_ids[i]), sequence);
-    CHECK_EQUAL(sort(grep_hello(*ep_logs[index])), hellos[index]);
+        peered.arrive_and_wait();
+        ep.publish("foo/bar", "hello from " + std::to_string(index));
+        got_hellos.arrive_and_wait();
+        send_and_received.arrive_and_wait();
+        // std::this_thread::sleep_for(10s);
+      }};
+    }
+    MESSAGE("wait for all threads to complete");
+    for (auto& hdl : threads)
+      hdl.join();
+    MESSAGE("check results");
+    std::vector<std::vector<std::string>> normalized_logs;
+    for (auto& ep_log : ep_logs)
+      normalized_logs.emplace_back(normalize_status_log(*ep_log, true));
+    std::vector<std::vector<std::string>> hellos;
+    for (size_t index = 0; index != num_endpoints; ++index) {
+      std::vector<std::string> lines;
+      for (size_t i = 0; i != num_endpoints; ++i)
+        if (i != index)
+          lines.emplace_back("hello from " + std::to_string(i));
+      hellos.emplace_back(lines);
+    }
+    auto sequence =
+      std::vector<alternative>{"endpoint_discovered"_a, "peer_added"_a,
+                               alternative{"peer_lost", "peer_removed"},
+                               "endpoint_unreachable"_a};
+    // Check all endpoints.
+    for (size_t index = 0; index != num_endpoints; ++index) {
+      for (size_t i = 0; i != num_endpoints; ++i)
+        if (i != index)
+          CHECK_EQUAL(grep_id(normalized_logs[index], *ep_ids[i]), sequence);
+      CHECK_EQUAL(sort(grep_hello(*ep_logs[index])), hellos[index]);
+    }
   }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(system_peering_tests, fixture)
+
+TEST(a full mesh emits endpoint_discovered and peer_added for all nodes) {
+  run_full_mesh("peering-events", 1);
+}
+
+TEST(a full mesh forms when distributing handshakes to connector threads) {
+  run_full_mesh("peering-threads", 4);
 }
 
 TEST(multiple clones can attach to a single master) {
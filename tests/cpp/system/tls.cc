@@ -0,0 +1,116 @@
+// Checks that reconnecting peers resume their TLS session instead of
+// performing a full handshake.
+
+#define SUITE system.tls
+
+#include "test.hh"
+
+#include "broker/configuration.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal/endpoint_access.hh"
+#include "broker/internal/metric_factory.hh"
+#include "broker/subscriber.hh"
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+std::string cert_path(const std::string& file_name) {
+  auto test_dir = getenv("BROKER_TEST_DIR");
+  if (test_dir == nullptr)
+    FAIL("environment variable BROKER_TEST_DIR not set");
+  return std::string{test_dir} + "/cpp/certs/" + file_name;
+}
+
+configuration make_config(const std::string& cert_id) {
+  configuration cfg{broker_options{}};
+  cfg.set("caf.logger.console.verbosity", "quiet");
+  cfg.openssl_cafile(cert_path("ca.pem"));
+  cfg.openssl_certificate(cert_path("cert." + cert_id + ".pem"));
+  cfg.openssl_key(cert_path("key." + cert_id + ".pem"));
+  return cfg;
+}
+
+struct fixture {
+  endpoint ep1{make_config("1")};
+
+  endpoint ep2{make_config("2")};
+
+  subscriber sub1 = ep1.make_subscriber({"/test"});
+
+  subscriber sub2 = ep2.make_subscriber({"/test"});
+
+  /// Returns the `broker.tls-handshakes` counters of `ep`.
+  static auto tls_handshakes(endpoint& ep) {
+    auto& sys = internal::endpoint_access{&ep}.sys();
+    return internal::metric_factory{sys}.core.tls_handshakes_instances();
+  }
+
+  /// Returns the number of full TLS handshakes of `ep`.
+  static int64_t full_handshakes(endpoint& ep) {
+    return tls_handshakes(ep).full->value();
+  }
+
+  /// Returns the number of resumed TLS handshakes of `ep`.
+  static int64_t resumed_handshakes(endpoint& ep) {
+    return tls_handshakes(ep).resumed->value();
+  }
+
+  /// Exchanges a message in each direction. This also makes sure that the
+  /// client reads the session ticket that TLS 1.3 servers send after the
+  /// handshake.
+  void ping_pong() {
+    ep1.publish("/test", data{"ping"});
+    auto ping = sub2.get(5s);
+    REQUIRE(ping);
+    CHECK_EQUAL(get_data(*ping), data{"ping"});
+    ep2.publish("/test", data{"pong"});
+    auto pong = sub1.get(5s);
+    REQUIRE(pong);
+    CHECK_EQUAL(get_data(*pong), data{"pong"});
+  }
+
+  /// Blocks until `ep` has no peers left or fails after five seconds.
+  static void await_no_peers(endpoint& ep) {
+    for (int i = 0; i < 500; ++i) {
+      if (ep.peers().empty())
+        return;
+      std::this_thread::sleep_for(10ms);
+    }
+    FAIL("endpoint still has peers after five seconds");
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(tls_tests, fixture)
+
+TEST(reconnecting peers resume their TLS session) {
+  auto port = ep1.listen("127.0.0.1", 0);
+  REQUIRE_NOT_EQUAL(port, 0u);
+  MESSAGE("the first connection requires a full handshake");
+  REQUIRE(ep2.peer("127.0.0.1", port, 0s));
+  ping_pong();
+  for (auto* ep : {&ep1, &ep2}) {
+    CHECK_EQUAL(full_handshakes(*ep), 1);
+    CHECK_EQUAL(resumed_handshakes(*ep), 0);
+  }
+  MESSAGE("disconnect ep2 from ep1");
+  REQUIRE(ep2.unpeer("127.0.0.1", port));
+  await_no_peers(ep1);
+  await_no_peers(ep2);
+  MESSAGE("the second connection resumes the TLS session");
+  REQUIRE(ep2.peer("127.0.0.1", port, 0s));
+  ping_pong();
+  for (auto* ep : {&ep1, &ep2}) {
+    CHECK_EQUAL(full_handshakes(*ep), 1);
+    CHECK_EQUAL(resumed_handshakes(*ep), 1);
+  }
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,99 @@
+// Checks that the core groups outgoing messages into batches and that the
+// transport writes each batch with a single write operation.
+
+#define SUITE system.write_batching
+
+#include "test.hh"
+
+#include "broker/configuration.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal/endpoint_access.hh"
+#include "broker/internal/metric_factory.hh"
+#include "broker/subscriber.hh"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t batch_size = 100;
+
+configuration make_config() {
+  broker_options opts;
+  opts.disable_ssl = true;
+  configuration cfg{opts};
+  cfg.set("caf.logger.console.verbosity", "quiet");
+  cfg.set("broker.peering.write-batch-size", batch_size);
+  // Only full batches may leave the core within the runtime of the test. The
+  // delay still allows the endpoints to shut down in reasonable time.
+  cfg.set("broker.peering.write-batch-delay", timespan{5s});
+  return cfg;
+}
+
+struct fixture {
+  endpoint ep1{make_config()};
+
+  endpoint ep2{make_config()};
+
+  subscriber sub2 = ep2.make_subscriber({"/test"});
+
+  /// Returns the `broker.peer-writes` counter of `ep` for `peer`.
+  static int64_t peer_writes(endpoint& ep, endpoint& peer) {
+    auto& sys = internal::endpoint_access{&ep}.sys();
+    auto label = to_string(peer.node_id());
+    return internal::metric_factory{sys}
+      .core.peer_writes_instance(label)
+      ->value();
+  }
+
+  /// Returns the `broker.peer-written-messages` counter of `ep` for `peer`.
+  static int64_t peer_written_messages(endpoint& ep, endpoint& peer) {
+    auto& sys = internal::endpoint_access{&ep}.sys();
+    auto label = to_string(peer.node_id());
+    return internal::metric_factory{sys}
+      .core.peer_written_messages_instance(label)
+      ->value();
+  }
+};
+
+} // namespace
+
+FIXTURE_SCOPE(write_batching_tests, fixture)
+
+TEST(each batch from the core takes a single write to the socket) {
+  auto port = ep2.listen("127.0.0.1", 0);
+  REQUIRE_NOT_EQUAL(port, 0u);
+  REQUIRE(ep1.peer("127.0.0.1", port, 0s));
+  MESSAGE("wait until ep1 knows the subscriptions of ep2");
+  auto known = [this] {
+    auto xs = ep1.peer_subscriptions();
+    return std::find(xs.begin(), xs.end(), topic{"/test"}) != xs.end();
+  };
+  for (int i = 0; i < 500 && !known(); ++i)
+    std::this_thread::sleep_for(10ms);
+  REQUIRE(known());
+  auto writes = peer_writes(ep1, ep2);
+  auto messages = peer_written_messages(ep1, ep2);
+  MESSAGE("publish two batches");
+  // The batching stage may still hold the initial routing update for ep2, so
+  // the last few messages stay in the core until the next full batch.
+  std::vector<data_message> xs;
+  for (size_t i = 0; i < 2 * batch_size; ++i)
+    xs.emplace_back(make_data_message("/test", static_cast<count>(i)));
+  ep1.publish(std::move(xs));
+  auto ys = sub2.get(2 * batch_size, 2s);
+  REQUIRE_GREATER(ys.size(), batch_size);
+  CHECK_EQUAL(peer_written_messages(ep1, ep2) - messages,
+              static_cast<int64_t>(2 * batch_size));
+  MESSAGE("the transport may combine the batches but never splits them");
+  auto delta = peer_writes(ep1, ep2) - writes;
+  CHECK_GREATER_EQUAL(delta, 1);
+  CHECK_LESS_EQUAL(delta, 2);
+}
+
+FIXTURE_SCOPE_END()
@@ -348,3 +348,9 @@ private:
 };
 
 void run_streaming_benchmark();
+
+/// Returns the number of calls to the global `operator new` so far.
+size_t num_allocations() noexcept;
+
+/// Returns the number of bytes requested via the global `operator new` so far.
+size_t num_allocated_bytes() noexcept;
@@ -0,0 +1,178 @@
+#include "main.hh"
+
+#include "broker/data.hh"
+#include "broker/detail/flat_map.hh"
+#include "broker/detail/flat_set.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <caf/binary_serializer.hpp>
+
+#include <map>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+using node_set = std::set<data>;
+
+using node_table = std::map<data, data>;
+
+using flat_set = detail::flat_set<data>;
+
+using flat_table = detail::flat_map<data, data>;
+
+// Generates `n` random string keys of length 10.
+std::vector<data> make_keys(size_t n) {
+  generator g;
+  std::vector<data> result;
+  result.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    result.emplace_back(g.next_string(10));
+  return result;
+}
+
+template <class Container>
+void insert(Container& xs, const data& key) {
+  if constexpr (std::is_same_v<typename Container::value_type, data>)
+    xs.emplace(key);
+  else
+    xs.emplace(key, key);
+}
+
+template <class Container>
+Container make_container(const std::vector<data>& keys) {
+  Container result;
+  for (const auto& key : keys)
+    insert(result, key);
+  return result;
+}
+
+// Generates the input for the range constructor of `Container`.
+template <class Container>
+auto make_values(const std::vector<data>& keys) {
+  if constexpr (std::is_same_v<typename Container::value_type, data>) {
+    return keys;
+  } else {
+    std::vector<std::pair<data, data>> result;
+    result.reserve(keys.size());
+    for (const auto& key : keys)
+      result.emplace_back(key, key);
+    return result;
+  }
+}
+
+void report_memory(benchmark::State& state, size_t allocs, size_t bytes) {
+  auto n = static_cast<double>(state.range(0));
+  auto iterations = static_cast<double>(state.iterations());
+  state.counters["allocs_per_elem"] = static_cast<double>(allocs)
+                                      / iterations / n;
+  state.counters["bytes_per_elem"] = static_cast<double>(bytes) / iterations
+                                     / n;
+}
+
+} // namespace
+
+// -- construction -------------------------------------------------------------
+
+// Inserts elements one by one in random order. Also reports the memory usage
+// of the container, since the container allocates all of its memory here.
+template <class Container>
+void BM_container_construct(benchmark::State& state) {
+  auto keys = make_keys(static_cast<size_t>(state.range(0)));
+  auto allocs_before = num_allocations();
+  auto bytes_before = num_allocated_bytes();
+  for (auto _ : state) {
+    auto xs = make_container<Container>(keys);
+    benchmark::DoNotOptimize(xs);
+  }
+  report_memory(state, num_allocations() - allocs_before,
+                num_allocated_bytes() - bytes_before);
+}
+
+BENCHMARK_TEMPLATE(BM_container_construct, node_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct, flat_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct, node_table)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct, flat_table)->Range(8, 8 << 10);
+
+// Inserts all elements at once via the range constructor.
+template <class Container>
+void BM_container_construct_range(benchmark::State& state) {
+  auto keys = make_keys(static_cast<size_t>(state.range(0)));
+  auto values = make_values<Container>(keys);
+  for (auto _ : state) {
+    Container xs{values.begin(), values.end()};
+    benchmark::DoNotOptimize(xs);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_container_construct_range, node_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct_range, flat_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct_range, node_table)
+  ->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_construct_range, flat_table)
+  ->Range(8, 8 << 10);
+
+// -- lookup -------------------------------------------------------------------
+
+template <class Container>
+void BM_container_lookup(benchmark::State& state) {
+  auto keys = make_keys(static_cast<size_t>(state.range(0)));
+  auto xs = make_container<Container>(keys);
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (const auto& key : keys)
+      hits += xs.count(key);
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_container_lookup, node_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_lookup, flat_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_lookup, node_table)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_lookup, flat_table)->Range(8, 8 << 10);
+
+// -- iteration ----------------------------------------------------------------
+
+template <class Container>
+void BM_container_iterate(benchmark::State& state) {
+  auto keys = make_keys(static_cast<size_t>(state.range(0)));
+  auto xs = make_container<Container>(keys);
+  for (auto _ : state) {
+    size_t num_elements = 0;
+    for (const auto& x : xs) {
+      benchmark::DoNotOptimize(x);
+      ++num_elements;
+    }
+    benchmark::DoNotOptimize(num_elements);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_container_iterate, node_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_iterate, flat_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_iterate, node_table)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_iterate, flat_table)->Range(8, 8 << 10);
+
+// -- serialization ------------------------------------------------------------
+
+template <class Container>
+void BM_container_serialize(benchmark::State& state) {
+  auto keys = make_keys(static_cast<size_t>(state.range(0)));
+  auto xs = make_container<Container>(keys);
+  caf::byte_buffer buf;
+  caf::binary_serializer sink{nullptr, buf};
+  for (auto _ : state) {
+    sink.seek(0);
+    std::ignore = sink.apply(xs);
+    benchmark::DoNotOptimize(buf);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_container_serialize, node_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_serialize, flat_set)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_serialize, node_table)->Range(8, 8 << 10);
+BENCHMARK_TEMPLATE(BM_container_serialize, flat_table)->Range(8, 8 << 10);
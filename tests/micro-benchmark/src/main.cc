@@ -7,7 +7,9 @@
 
 #include <caf/init_global_meta_objects.hpp>
 
+#include <atomic>
 #include <cstdlib>
+#include <new>
 
 using namespace broker;
 using namespace std::literals;
@@ -249,6 +251,42 @@ data generator::next_data(size_t event_type) {
   return data{std::move(result)};
 }
 
+// -- allocation tracking ------------------------------------------------------
+
+namespace {
+
+std::atomic<size_t> num_allocations_counter;
+
+std::atomic<size_t> num_allocated_bytes_counter;
+
+} // namespace
+
+size_t num_allocations() noexcept {
+  return num_allocations_counter.load();
+}
+
+size_t num_allocated_bytes() noexcept {
+  return num_allocated_bytes_counter.load();
+}
+
+void* operator new(size_t size) {
+  num_allocations_counter.fetch_add(1, std::memory_order_relaxed);
+  num_allocated_bytes_counter.fetch_add(size, std::memory_order_relaxed);
+  if (auto ptr = malloc(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+// -- main ---------------------------------------------------------------------
+
 int main(int argc, char** argv) {
   caf::init_global_meta_objects<caf::id_block::micro_benchmarks>();
   configuration::init_global_state();
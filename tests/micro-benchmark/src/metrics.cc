@@ -0,0 +1,151 @@
+#include "broker/internal/metric_collector.hh"
+
+#include "broker/data.hh"
+#include "broker/time.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+// -- benchmark parameters -----------------------------------------------------
+
+constexpr size_t num_endpoints = 10;
+
+constexpr size_t num_families = 50;
+
+void instance_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"instances"});
+  for (int64_t n = 100; n <= 100'000; n *= 10)
+    b->Arg(n);
+  b->Unit(benchmark::kMicrosecond);
+}
+
+// -- fixture ------------------------------------------------------------------
+
+// Fills a collector with remote metrics from `num_endpoints` endpoints, each
+// publishing gauges in `num_families` metric families.
+class collector : public benchmark::Fixture {
+public:
+  using benchmark::Fixture::SetUp;
+
+  using benchmark::Fixture::TearDown;
+
+  void SetUp(benchmark::State& state) override {
+    auto n = static_cast<size_t>(state.range(0));
+    uut = std::make_unique<internal::metric_collector>();
+    scrapes.clear();
+    scrapes.resize(num_endpoints);
+    auto t0 = broker::now();
+    for (size_t i = 0; i < num_endpoints; ++i)
+      scrapes[i].emplace_back(
+        vector{data{"endpoint-" + std::to_string(i)}, data{t0}});
+    for (size_t i = 0; i < n; ++i) {
+      auto family = "family_" + std::to_string(i % num_families);
+      table labels;
+      labels.emplace(data{"index"}, data{std::to_string(i)});
+      vector row;
+      row.reserve(8);
+      row.emplace_back("bench");
+      row.emplace_back(std::move(family));
+      row.emplace_back("gauge");
+      row.emplace_back("1");
+      row.emplace_back("Help!");
+      row.emplace_back(false);
+      row.emplace_back(std::move(labels));
+      row.emplace_back(integer{0});
+      scrapes[i % num_endpoints].emplace_back(std::move(row));
+    }
+    for (auto& xs : scrapes)
+      uut->insert_or_update(xs);
+    std::ignore = uut->prometheus_text();
+  }
+
+  void TearDown(benchmark::State&) override {
+    uut.reset();
+    scrapes.clear();
+  }
+
+  // Advances the timestamp of a scrape to have the collector accept it again.
+  static void touch(vector& scrape) {
+    auto& meta = get<vector>(scrape[0]);
+    get<timestamp>(meta[1]) += timespan{1};
+  }
+
+  // Increments the value of a single metric in a scrape.
+  static void bump(vector& scrape, size_t index) {
+    auto& row = get<vector>(scrape[index + 1]);
+    get<integer>(row.back()) += 1;
+  }
+
+  std::unique_ptr<internal::metric_collector> uut;
+
+  std::vector<vector> scrapes;
+};
+
+} // namespace
+
+// -- rendering ----------------------------------------------------------------
+
+// Renders the Prometheus output again without any change in between.
+BENCHMARK_DEFINE_F(collector, render_unchanged)(benchmark::State& state) {
+  for (auto _ : state) {
+    auto res = uut->prometheus_text();
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(collector, render_unchanged)->Apply(instance_args);
+
+// Receives a full scrape from one endpoint with a single changed value and
+// then renders the Prometheus output.
+BENCHMARK_DEFINE_F(collector, render_one_changed)(benchmark::State& state) {
+  auto& scrape = scrapes[0];
+  for (auto _ : state) {
+    touch(scrape);
+    bump(scrape, 0);
+    uut->insert_or_update(scrape);
+    auto res = uut->prometheus_text();
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(collector, render_one_changed)->Apply(instance_args);
+
+// Receives full scrapes from all endpoints with all values changed and then
+// renders the Prometheus output.
+BENCHMARK_DEFINE_F(collector, render_all_changed)(benchmark::State& state) {
+  for (auto _ : state) {
+    for (auto& scrape : scrapes) {
+      touch(scrape);
+      for (size_t i = 0; i + 1 < scrape.size(); ++i)
+        bump(scrape, i);
+      uut->insert_or_update(scrape);
+    }
+    auto res = uut->prometheus_text();
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(collector, render_all_changed)->Apply(instance_args);
+
+// -- ingestion ----------------------------------------------------------------
+
+// Receives full scrapes from all endpoints without any changed value.
+BENCHMARK_DEFINE_F(collector, insert_unchanged)(benchmark::State& state) {
+  for (auto _ : state) {
+    for (auto& scrape : scrapes) {
+      touch(scrape);
+      auto res = uut->insert_or_update(scrape);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(collector, insert_unchanged)->Apply(instance_args);
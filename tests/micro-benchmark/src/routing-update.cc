@@ -0,0 +1,118 @@
+#include "broker/internal/routing_update.hh"
+
+#include "broker/filter_type.hh"
+#include "broker/topic.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using namespace broker;
+using namespace broker::internal;
+
+namespace {
+
+// -- benchmark parameters -----------------------------------------------------
+
+constexpr size_t num_peers = 100;
+
+void topic_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"topics"});
+  for (int64_t n = 10; n <= 10'000; n *= 10)
+    b->Arg(n);
+  b->Unit(benchmark::kMicrosecond);
+}
+
+// -- fixture ------------------------------------------------------------------
+
+// Simulates an endpoint with `num_peers` peers that subscribes to and
+// unsubscribes from a single topic in turns. Each iteration covers the cost of
+// encoding the update once plus decoding it on every peer.
+class routing_update : public benchmark::Fixture {
+public:
+  using benchmark::Fixture::SetUp;
+
+  using benchmark::Fixture::TearDown;
+
+  void SetUp(benchmark::State& state) override {
+    auto n = static_cast<size_t>(state.range(0));
+    filter.clear();
+    for (size_t i = 0; i < n; ++i)
+      filter.emplace_back("zeek/events/topic-" + std::to_string(i));
+    version = lamport_timestamp{1};
+    auto bytes = make_full_routing_update(filter, version);
+    peers.clear();
+    peers.resize(num_peers);
+    for (auto& peer : peers)
+      apply_routing_update(full_topic, bytes, peer.filter, peer.state);
+  }
+
+  void TearDown(benchmark::State&) override {
+    peers.clear();
+    filter.clear();
+  }
+
+  // Adds or removes the churn topic and returns the previous filter.
+  filter_type churn() {
+    auto old_filter = filter;
+    if (filter.back() == churn_topic)
+      filter.pop_back();
+    else
+      filter.emplace_back(churn_topic);
+    ++version;
+    return old_filter;
+  }
+
+  struct peer_state {
+    filter_type filter;
+    routing_update_state state;
+  };
+
+  topic full_topic = routing_update_topic(routing_update_kind::full);
+
+  topic delta_topic = routing_update_topic(routing_update_kind::delta);
+
+  topic churn_topic = "zeek/events/churn";
+
+  filter_type filter;
+
+  lamport_timestamp version;
+
+  std::vector<peer_state> peers;
+};
+
+} // namespace
+
+// Sends the full filter to all peers after each change.
+BENCHMARK_DEFINE_F(routing_update, full)(benchmark::State& state) {
+  for (auto _ : state) {
+    churn();
+    auto bytes = make_full_routing_update(filter, version);
+    for (auto& peer : peers) {
+      auto res = apply_routing_update(full_topic, bytes, peer.filter,
+                                      peer.state);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(routing_update, full)->Apply(topic_args);
+
+// Sends only the added and removed topics to all peers after each change.
+BENCHMARK_DEFINE_F(routing_update, delta)(benchmark::State& state) {
+  filter_type added;
+  filter_type removed;
+  for (auto _ : state) {
+    auto old_filter = churn();
+    filter_diff(old_filter, filter, added, removed);
+    auto bytes = make_delta_routing_update(version, added, removed);
+    for (auto& peer : peers) {
+      auto res = apply_routing_update(delta_topic, bytes, peer.filter,
+                                      peer.state);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(routing_update, delta)->Apply(topic_args);
@@ -1,6 +1,9 @@
 #include "main.hh"
 
 #include "broker/alm/multipath.hh"
+#include "broker/arena_data.hh"
+#include "broker/data_view.hh"
+#include "broker/defaults.hh"
 #include "broker/endpoint.hh"
 #include "broker/fwd.hh"
 #include "broker/message.hh"
@@ -46,6 +49,11 @@ public:
       dmsg[index] = make_data_message("/micro/benchmark",
                                       g.next_data(index + 1));
       to_bytes(dmsg[index], dmsg_buf[index]);
+      to_bytes(get_data(dmsg[index]), data_buf[index]);
+      data_pmsg[index] = make_packed_message(packed_message_type::data,
+                                             defaults::ttl,
+                                             topic{"/micro/benchmark"},
+                                             data_buf[index]);
       nmsg[index] = make_node_message(dmsg[index], alm::multipath{dst});
       to_bytes(nmsg[index], nmsg_buf[index]);
       legacy_nmsg[index] = legacy_node_message{dmsg[index], 20};
@@ -75,6 +83,12 @@ public:
   // Serialized versions of dmsg;
   array_t<buffer_type> dmsg_buf;
 
+  // Serialized versions of the content of dmsg;
+  array_t<buffer_type> data_buf;
+
+  // Packed versions of the content of dmsg;
+  array_t<packed_message> data_pmsg;
+
   // One node message per type.
   array_t<node_message> nmsg;
 
@@ -139,6 +153,48 @@ public:
   }
 };
 
+// Visits all values in `x` to simulate a consumer that reads each field once.
+size_t touch_all(const data& x) {
+  auto f = [](const auto& val) -> size_t {
+    using val_type = std::decay_t<decltype(val)>;
+    if constexpr (std::is_same_v<val_type, broker::set>
+                  || std::is_same_v<val_type, broker::vector>) {
+      size_t result = 0;
+      for (const auto& y : val)
+        result += touch_all(y);
+      return result;
+    } else if constexpr (std::is_same_v<val_type, broker::table>) {
+      size_t result = 0;
+      for (const auto& [key, y] : val)
+        result += touch_all(key) + touch_all(y);
+      return result;
+    } else {
+      return 1;
+    }
+  };
+  return visit(f, x);
+}
+
+size_t touch_all(const data_view& x) {
+  switch (x.get_type()) {
+    default:
+      return 1;
+    case data::type::set:
+    case data::type::vector: {
+      size_t result = 0;
+      for (auto y : x.is_set() ? x.to_set() : x.to_vector())
+        result += touch_all(y);
+      return result;
+    }
+    case data::type::table: {
+      size_t result = 0;
+      for (auto [key, y] : x.to_table())
+        result += touch_all(key) + touch_all(y);
+      return result;
+    }
+  }
+}
+
 } // namespace
 
 // -- saving and loading data messages -----------------------------------------
@@ -186,3 +242,82 @@ BENCHMARK_DEFINE_F(serialization, load_legacy_node_message)
 
 BENCHMARK_REGISTER_F(serialization, load_legacy_node_message)
   ->DenseRange(0, 2, 1);
+
+// -- owned decoding vs. zero-copy views ---------------------------------------
+
+BENCHMARK_DEFINE_F(serialization, load_data)(benchmark::State& state) {
+  const auto& buf = data_buf[static_cast<size_t>(state.range(0))];
+  for (auto _ : state) {
+    data x;
+    caf::binary_deserializer source{nullptr, buf};
+    std::ignore = source.apply(x);
+    benchmark::DoNotOptimize(touch_all(x));
+  }
+}
+
+BENCHMARK_REGISTER_F(serialization, load_data)->DenseRange(0, 2, 1);
+
+BENCHMARK_DEFINE_F(serialization, view_data)(benchmark::State& state) {
+  const auto& buf = data_buf[static_cast<size_t>(state.range(0))];
+  for (auto _ : state) {
+    if (is_valid_data_encoding(buf)) {
+      auto x = data_view{buf.data()};
+      benchmark::DoNotOptimize(touch_all(x));
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(serialization, view_data)->DenseRange(0, 2, 1);
+
+BENCHMARK_DEFINE_F(serialization, view_data_to_data)
+(benchmark::State& state) {
+  const auto& buf = data_buf[static_cast<size_t>(state.range(0))];
+  for (auto _ : state) {
+    if (is_valid_data_encoding(buf)) {
+      auto x = data_view{buf.data()}.to_data();
+      benchmark::DoNotOptimize(x);
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(serialization, view_data_to_data)->DenseRange(0, 2, 1);
+
+// -- owned decoding vs. arena decoding ----------------------------------------
+
+BENCHMARK_DEFINE_F(serialization, decode_owned_data)
+(benchmark::State& state) {
+  const auto& buf = data_buf[static_cast<size_t>(state.range(0))];
+  auto allocs_before = num_allocations();
+  for (auto _ : state) {
+    data x;
+    caf::binary_deserializer source{nullptr, buf};
+    std::ignore = source.apply(x);
+    benchmark::DoNotOptimize(x);
+  }
+  auto allocs = num_allocations() - allocs_before;
+  state.counters["allocs_per_msg"] =
+    benchmark::Counter(static_cast<double>(allocs),
+                       benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+                          * static_cast<int64_t>(buf.size()));
+}
+
+BENCHMARK_REGISTER_F(serialization, decode_owned_data)->DenseRange(0, 2, 1);
+
+BENCHMARK_DEFINE_F(serialization, decode_arena_data)
+(benchmark::State& state) {
+  const auto& msg = data_pmsg[static_cast<size_t>(state.range(0))];
+  auto allocs_before = num_allocations();
+  for (auto _ : state) {
+    auto x = arena_message::make(msg);
+    benchmark::DoNotOptimize(x);
+  }
+  auto allocs = num_allocations() - allocs_before;
+  state.counters["allocs_per_msg"] =
+    benchmark::Counter(static_cast<double>(allocs),
+                       benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+                          * static_cast<int64_t>(get_payload(msg).size()));
+}
+
+BENCHMARK_REGISTER_F(serialization, decode_arena_data)->DenseRange(0, 2, 1);
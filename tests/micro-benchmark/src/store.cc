@@ -0,0 +1,446 @@
+#include "main.hh"
+
+#include "broker/backend.hh"
+#include "broker/backend_options.hh"
+#include "broker/data.hh"
+#include "broker/detail/abstract_backend.hh"
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/make_backend.hh"
+#include "broker/internal_command.hh"
+#include "broker/snapshot.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace broker;
+using namespace std::literals;
+
+namespace {
+
+// -- benchmark parameters -----------------------------------------------------
+
+// Selects the key/value shape of the store entries.
+enum class entry_shape : int64_t {
+  // Numeric keys and values.
+  count_count,
+  // Short string keys and mid-sized string values.
+  string_string,
+  // Short string keys and vectors that resemble a row in a log file.
+  string_record,
+};
+
+constexpr int64_t num_entry_shapes = 3;
+
+// Selects the backend and its options.
+enum class backend_config : int64_t {
+  memory,
+  // SQLite with the default journal mode (DELETE) and synchronous (FULL).
+  sqlite_delete_full,
+  // SQLite in WAL mode with synchronous=NORMAL.
+  sqlite_wal_normal,
+  // SQLite in WAL mode with synchronous=OFF.
+  sqlite_wal_off,
+  // In-memory state plus a write-ahead log with the default group commit.
+  memory_wal,
+};
+
+constexpr int64_t num_backend_configs = 5;
+
+const char* backend_label(backend_config cfg) {
+  switch (cfg) {
+    default:
+      return "memory";
+    case backend_config::sqlite_delete_full:
+      return "sqlite/DELETE/FULL";
+    case backend_config::sqlite_wal_normal:
+      return "sqlite/WAL/NORMAL";
+    case backend_config::sqlite_wal_off:
+      return "sqlite/WAL/OFF";
+    case backend_config::memory_wal:
+      return "memory+WAL";
+  }
+}
+
+// Limits the key count for SQLite, since loading and cleaning up larger
+// databases dominates the runtime of the entire benchmark suite.
+constexpr int64_t max_sqlite_keys = 1'000'000;
+
+bool is_sqlite(backend_config cfg) {
+  switch (cfg) {
+    case backend_config::sqlite_delete_full:
+    case backend_config::sqlite_wal_normal:
+    case backend_config::sqlite_wal_off:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Registers all combinations of key count, entry shape and backend.
+void store_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"keys", "shape", "backend"});
+  for (int64_t cfg = 0; cfg < num_backend_configs; ++cfg) {
+    auto max_keys = is_sqlite(static_cast<backend_config>(cfg))
+                      ? max_sqlite_keys
+                      : int64_t{10'000'000};
+    for (int64_t shape = 0; shape < num_entry_shapes; ++shape)
+      for (int64_t n = 1'000; n <= max_keys; n *= 10)
+        b->Args({n, shape, cfg});
+  }
+  b->Unit(benchmark::kMicrosecond);
+}
+
+// -- fixture ------------------------------------------------------------------
+
+// Fills a backend with `keys` entries of the selected shape before running the
+// benchmark. The fixture keeps the backend for repeated runs with the same
+// arguments and removes the files of persistent backends when switching to
+// other arguments.
+class store_backend : public benchmark::Fixture {
+public:
+  static constexpr size_t container_size = 100;
+
+  using benchmark::Fixture::SetUp;
+
+  using benchmark::Fixture::TearDown;
+
+  ~store_backend() override {
+    reset();
+  }
+
+  void SetUp(benchmark::State& state) override {
+    auto args = std::array{state.range(0), state.range(1), state.range(2)};
+    if (backend != nullptr && args == loaded_args)
+      return;
+    reset();
+    loaded_args = args;
+    auto n = static_cast<size_t>(state.range(0));
+    auto shape = static_cast<entry_shape>(state.range(1));
+    cfg = static_cast<backend_config>(state.range(2));
+    generator g;
+    keys.clear();
+    values.clear();
+    keys.reserve(n);
+    values.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      switch (shape) {
+        case entry_shape::count_count:
+          keys.emplace_back(count{i});
+          values.emplace_back(g.next_count());
+          break;
+        case entry_shape::string_string:
+          keys.emplace_back(g.next_string(10));
+          values.emplace_back(g.next_string(32));
+          break;
+        default:
+          keys.emplace_back(g.next_string(10));
+          values.emplace_back(vector{g.next_timestamp(), g.next_string(10),
+                                     g.next_count(), g.next_count(),
+                                     g.next_string(5), true});
+      }
+    }
+    for (size_t i = 0; i < container_size; ++i)
+      elements.emplace_back(g.next_string(10));
+    load();
+  }
+
+  // Fills a new backend with all entries. Persistent backends load the entries
+  // without syncing to disk and then re-open the files with the options under
+  // test. Otherwise, loading would sync once per entry.
+  void load() {
+    if (cfg == backend_config::memory) {
+      backend = make_backend();
+      for (size_t i = 0; i < keys.size(); ++i)
+        std::ignore = backend->put(keys[i], values[i]);
+      return;
+    }
+    path = detail::make_temp_file_name();
+    detail::remove(path);
+    backend_options opts;
+    opts["path"] = path;
+    if (cfg == backend_config::memory_wal) {
+      opts["synchronous"] = false;
+      backend = detail::make_backend(broker::backend::wal, std::move(opts));
+    } else {
+      opts["journal_mode"] = enum_value{"Broker::SQLITE_JOURNAL_MODE_WAL"};
+      opts["synchronous"] = enum_value{"Broker::SQLITE_SYNCHRONOUS_OFF"};
+      backend = detail::make_backend(broker::backend::sqlite, std::move(opts));
+    }
+    for (size_t i = 0; i < keys.size(); ++i)
+      std::ignore = backend->put(keys[i], values[i]);
+    backend.reset();
+    backend = make_backend();
+  }
+
+  // Destroys the backend and removes its files.
+  void reset() {
+    backend.reset();
+    if (detail::is_directory(path)) {
+      detail::remove_all(path);
+      path.clear();
+    } else if (!path.empty()) {
+      for (auto suffix : {""s, "-wal"s, "-shm"s, "-journal"s})
+        if (auto fname = path + suffix; detail::is_file(fname))
+          detail::remove(fname);
+      path.clear();
+    }
+    keys.clear();
+    values.clear();
+    elements.clear();
+  }
+
+  // Opens the backend under test, re-using the files at `path` if present.
+  std::unique_ptr<detail::abstract_backend> make_backend() {
+    if (cfg == backend_config::memory)
+      return detail::make_backend(broker::backend::memory, {});
+    backend_options opts;
+    opts["path"] = path;
+    if (cfg == backend_config::memory_wal)
+      return detail::make_backend(broker::backend::wal, std::move(opts));
+    switch (cfg) {
+      default:
+        // The database remains in WAL mode after loading unless we switch back
+        // explicitly.
+        opts["journal_mode"] = enum_value{"Broker::SQLITE_JOURNAL_MODE_DELETE"};
+        opts["synchronous"] = enum_value{"Broker::SQLITE_SYNCHRONOUS_FULL"};
+        break;
+      case backend_config::sqlite_wal_normal:
+        opts["journal_mode"] = enum_value{"Broker::SQLITE_JOURNAL_MODE_WAL"};
+        opts["synchronous"] = enum_value{"Broker::SQLITE_SYNCHRONOUS_NORMAL"};
+        break;
+      case backend_config::sqlite_wal_off:
+        opts["journal_mode"] = enum_value{"Broker::SQLITE_JOURNAL_MODE_WAL"};
+        opts["synchronous"] = enum_value{"Broker::SQLITE_SYNCHRONOUS_OFF"};
+        break;
+    }
+    return detail::make_backend(broker::backend::sqlite, std::move(opts));
+  }
+
+  // Picks the next index for cycling through all keys.
+  size_t next_index(size_t& i) const noexcept {
+    auto result = i;
+    if (++i == keys.size())
+      i = 0;
+    return result;
+  }
+
+  std::array<int64_t, 3> loaded_args = {};
+  backend_config cfg = backend_config::memory;
+  std::string path;
+  std::vector<data> keys;
+  std::vector<data> values;
+  std::vector<data> elements;
+  std::unique_ptr<detail::abstract_backend> backend;
+};
+
+} // namespace
+
+// -- basic operations ---------------------------------------------------------
+
+// Overrides existing entries in the store.
+BENCHMARK_DEFINE_F(store_backend, put)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  size_t i = 0;
+  for (auto _ : state) {
+    auto index = next_index(i);
+    auto res = backend->put(keys[index], values[index]);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, put)->Apply(store_args);
+
+BENCHMARK_DEFINE_F(store_backend, get)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  size_t i = 0;
+  for (auto _ : state) {
+    auto res = backend->get(keys[next_index(i)]);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, get)->Apply(store_args);
+
+// Erases entries from the store. Puts all entries back after erasing the last
+// one (excluded from the measurement).
+BENCHMARK_DEFINE_F(store_backend, erase)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  size_t i = 0;
+  for (auto _ : state) {
+    auto index = next_index(i);
+    auto res = backend->erase(keys[index]);
+    benchmark::DoNotOptimize(res);
+    if (i == 0) {
+      state.PauseTiming();
+      for (size_t j = 0; j < keys.size(); ++j)
+        std::ignore = backend->put(keys[j], values[j]);
+      state.ResumeTiming();
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, erase)->Apply(store_args);
+
+// -- modifying containers -----------------------------------------------------
+
+// Adds an element to a set with 100 elements and removes it again.
+BENCHMARK_DEFINE_F(store_backend, add_subtract_set)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  auto key = data{"bench-set"s};
+  std::ignore = backend->put(key, set(elements.begin(), elements.end()));
+  auto element = data{"new-element"s};
+  for (auto _ : state) {
+    auto res1 = backend->add(key, element, data::type::set);
+    auto res2 = backend->subtract(key, element);
+    benchmark::DoNotOptimize(res1);
+    benchmark::DoNotOptimize(res2);
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, add_subtract_set)->Apply(store_args);
+
+// Adds a key-value pair to a table with 100 entries and removes it again.
+BENCHMARK_DEFINE_F(store_backend, add_subtract_table)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  auto key = data{"bench-table"s};
+  table xs;
+  for (const auto& x : elements)
+    xs.emplace(x, x);
+  std::ignore = backend->put(key, std::move(xs));
+  auto element = data{vector{data{"new-key"s}, data{"new-value"s}}};
+  auto element_key = data{"new-key"s};
+  for (auto _ : state) {
+    auto res1 = backend->add(key, element, data::type::table);
+    auto res2 = backend->subtract(key, element_key);
+    benchmark::DoNotOptimize(res1);
+    benchmark::DoNotOptimize(res2);
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, add_subtract_table)->Apply(store_args);
+
+// -- expiration ---------------------------------------------------------------
+
+// Expires 1% of all entries by calling `expire` for each due key, i.e., the
+// loop that masters run for backends without an expiry index. Only measures
+// the backend, not a `master_state`. Re-inserts the expired entries after each
+// iteration (excluded from the measurement).
+BENCHMARK_DEFINE_F(store_backend, expire_each)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  auto t0 = broker::now();
+  auto due = t0 - 1s;
+  auto later = t0 + 24h;
+  std::unordered_map<data, timestamp> expirations;
+  std::vector<size_t> due_indexes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto expiry = i % 100 == 0 ? due : later;
+    std::ignore = backend->put(keys[i], values[i], expiry);
+    expirations.emplace(keys[i], expiry);
+    if (expiry == due)
+      due_indexes.emplace_back(i);
+  }
+  for (auto _ : state) {
+    size_t expired = 0;
+    for (auto i = expirations.begin(); i != expirations.end();) {
+      if (t0 > i->second) {
+        if (auto res = backend->expire(i->first, t0); res && *res)
+          ++expired;
+        i = expirations.erase(i);
+      } else {
+        ++i;
+      }
+    }
+    benchmark::DoNotOptimize(expired);
+    state.PauseTiming();
+    for (auto index : due_indexes) {
+      std::ignore = backend->put(keys[index], values[index], due);
+      expirations.emplace(keys[index], due);
+    }
+    state.ResumeTiming();
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, expire_each)->Apply(store_args);
+
+// Same setup as `expire_each`, but lets the backend select due entries via
+// `expire_due` (like masters do for backends with an expiry index).
+BENCHMARK_DEFINE_F(store_backend, expire_due)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  auto t0 = broker::now();
+  auto due = t0 - 1s;
+  auto later = t0 + 24h;
+  std::vector<size_t> due_indexes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto expiry = i % 100 == 0 ? due : later;
+    std::ignore = backend->put(keys[i], values[i], expiry);
+    if (expiry == due)
+      due_indexes.emplace_back(i);
+  }
+  for (auto _ : state) {
+    auto res = backend->expire_due(t0, std::numeric_limits<size_t>::max());
+    benchmark::DoNotOptimize(res);
+    state.PauseTiming();
+    for (auto index : due_indexes)
+      std::ignore = backend->put(keys[index], values[index], due);
+    state.ResumeTiming();
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, expire_due)->Apply(store_args);
+
+// -- snapshots and clone resync -----------------------------------------------
+
+BENCHMARK_DEFINE_F(store_backend, snapshot)(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  for (auto _ : state) {
+    auto res = backend->snapshot();
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(store_backend, snapshot)->Apply(store_args);
+
+// Takes a snapshot, serializes it as `ack_clone` command, deserializes the
+// command again and compares the snapshot to another map with 10% stale
+// entries. Approximates the payload handling for bringing a clone back in sync
+// with its master, but does not involve a `master_state` or `clone_state`.
+BENCHMARK_DEFINE_F(store_backend, ack_clone_round_trip)
+(benchmark::State& state) {
+  state.SetLabel(backend_label(cfg));
+  auto clone_store = *backend->snapshot();
+  for (size_t i = 0; i < keys.size(); i += 10)
+    clone_store[keys[i]] = data{"stale"s};
+  caf::binary_serializer::container_type buf;
+  for (auto _ : state) {
+    // Master side.
+    buf.clear();
+    caf::binary_serializer sink{nullptr, buf};
+    auto ss = backend->snapshot();
+    auto cmd = internal_command{0, entity_id{}, entity_id{},
+                                ack_clone_command{0, 5, std::move(*ss)}};
+    std::ignore = sink.apply(cmd);
+    // Clone side.
+    internal_command received;
+    caf::binary_deserializer source{nullptr, buf};
+    std::ignore = source.apply(received);
+    auto& x = std::get<ack_clone_command>(received.content).state;
+    size_t updated = 0;
+    for (const auto& [key, value] : clone_store)
+      if (auto i = x.find(key); i == x.end() || i->second != value)
+        ++updated;
+    benchmark::DoNotOptimize(updated);
+  }
+  state.counters["bytes"] = static_cast<double>(buf.size());
+}
+
+BENCHMARK_REGISTER_F(store_backend, ack_clone_round_trip)->Apply(store_args);
@@ -0,0 +1,113 @@
+#include "broker/detail/subnet_index.hh"
+
+#include "broker/address.hh"
+#include "broker/data.hh"
+#include "broker/subnet.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace broker;
+
+namespace {
+
+// -- benchmark parameters -----------------------------------------------------
+
+constexpr size_t num_prefixes = 1'000'000;
+
+constexpr size_t num_probes = 1'024;
+
+address random_address(std::minstd_rand& rng) {
+  auto bits = static_cast<uint32_t>(rng());
+  return address{&bits, address::family::ipv4, address::byte_order::host};
+}
+
+// -- fixture ------------------------------------------------------------------
+
+// Fills a map with one million random IPv4 prefixes with a length between 8 and
+// 32 bits, i.e., the same layout as the store of a memory backend.
+class subnet_index : public benchmark::Fixture {
+public:
+  using benchmark::Fixture::SetUp;
+
+  using benchmark::Fixture::TearDown;
+
+  void SetUp(benchmark::State&) override {
+    if (!entries.empty())
+      return;
+    std::minstd_rand rng{0xC0FFEE};
+    entries.reserve(num_prefixes);
+    while (entries.size() < num_prefixes) {
+      auto len = static_cast<uint8_t>(8 + rng() % 25);
+      entries.emplace(subnet{random_address(rng), len}, data{});
+    }
+    for (size_t i = 0; i < num_probes; ++i)
+      probes.emplace_back(random_address(rng));
+    index.enable(entries);
+  }
+
+  std::unordered_map<data, data> entries;
+
+  std::vector<address> probes;
+
+  detail::subnet_index index;
+};
+
+} // namespace
+
+// Builds the index for all prefixes.
+BENCHMARK_DEFINE_F(subnet_index, build)(benchmark::State& state) {
+  for (auto _ : state) {
+    detail::subnet_index uut;
+    uut.enable(entries);
+    benchmark::DoNotOptimize(uut.size());
+  }
+}
+
+BENCHMARK_REGISTER_F(subnet_index, build)->Unit(benchmark::kMillisecond);
+
+// Looks up the longest match for an address via the index.
+BENCHMARK_DEFINE_F(subnet_index, longest_match)(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    auto res = index.longest_match(probes[i++ % num_probes]);
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(subnet_index, longest_match);
+
+// Looks up the longest match for an address by testing each key, i.e., what
+// users had to do before via `keys()` and `subnet::contains`.
+BENCHMARK_DEFINE_F(subnet_index, linear_scan)(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    auto& addr = probes[i++ % num_probes];
+    const subnet* res = nullptr;
+    for (auto& kvp : entries) {
+      auto& net = get<subnet>(kvp.first);
+      if (net.contains(addr) && (!res || res->length() < net.length()))
+        res = &net;
+    }
+    benchmark::DoNotOptimize(res);
+  }
+}
+
+BENCHMARK_REGISTER_F(subnet_index, linear_scan)
+  ->Unit(benchmark::kMillisecond);
+
+// Selects all prefixes in a /16.
+BENCHMARK_DEFINE_F(subnet_index, covered_by)(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    auto net = subnet{probes[i++ % num_probes], 16};
+    size_t n = 0;
+    index.covered_by(net, [&n](const data&) { ++n; });
+    benchmark::DoNotOptimize(n);
+  }
+}
+
+BENCHMARK_REGISTER_F(subnet_index, covered_by);
@@ -1,4 +1,5 @@
 
+import asyncio
 import unittest
 import multiprocessing
 import sys
@@ -127,6 +128,56 @@ class TestCommunication(unittest.TestCase):
             self.assertEqual(msgs[1], ("/test", ("a", "b", "c")))
             self.assertEqual(msgs[2], ("/test", (True, False)))
 
+    def test_publish_limit(self):
+        with broker.Endpoint() as ep1, \
+             broker.Endpoint() as ep2, \
+             ep1.make_subscriber("/test") as s1:
+
+            port = ep1.listen("127.0.0.1", 0)
+            self.assertTrue(ep2.peer("127.0.0.1", port, 1.0))
+
+            ep1.await_peer(ep2.node_id())
+            ep2.await_peer(ep1.node_id())
+
+            ep2.set_publish_limit("/test/sampled", sample=10)
+            for i in range(100):
+                ep2.publish("/test/sampled", i)
+            ep2.clear_publish_limit("/test/sampled")
+            ep2.publish("/test/sampled", 100)
+
+            msgs = s1.get(11)
+            self.assertEqual(msgs, [("/test/sampled", i)
+                                    for i in range(0, 101, 10)])
+
+    def test_asyncio(self):
+        with broker.Endpoint() as ep1, \
+             broker.Endpoint() as ep2, \
+             ep1.make_subscriber("/test") as s1, \
+             ep2.make_publisher("/test") as p2:
+
+            port = ep1.listen("127.0.0.1", 0)
+            self.assertTrue(ep2.peer("127.0.0.1", port, 1.0))
+
+            ep1.await_peer(ep2.node_id())
+            ep2.await_peer(ep1.node_id())
+
+            # --asyncio-start
+            async def receive(n):
+                result = []
+                while len(result) < n:
+                    result += await s1.get_async(max_count=100)
+                return result
+
+            async def run():
+                receiver = asyncio.ensure_future(receive(1000))
+                await p2.publish_async([i for i in range(1000)])
+                return await asyncio.wait_for(receiver, 10)
+            # --asyncio-end
+
+            msgs = asyncio.run(run())
+            self.assertFalse(s1.available())
+            self.assertEqual(msgs, [("/test", i) for i in range(1000)])
+
     def test_status_subscriber(self):
         # --status-start
         with broker.Endpoint() as ep1, \